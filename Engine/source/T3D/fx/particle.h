@@ -153,6 +153,8 @@ struct Particle
 
    F32              spinSpeed;
    Particle *       next;
+   U32              sortStamp;  // last depth sort pass that saw this particle
+   U32              batchIndex; // lane in the emitter's ParticleBatch, if it has one
    Point3F  pos_local;
    F32      t_last;
    Point3F  radial_v;   // radial vector for concentric effects
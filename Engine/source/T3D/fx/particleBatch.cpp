@@ -0,0 +1,309 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "T3D/fx/particleBatch.h"
+
+#ifdef PARTICLE_BATCH_SSE
+#include <xmmintrin.h>
+#endif
+
+
+void ParticleBatch::_getArrays( Vector<F32> *arrays[ NumArrays ] )
+{
+   Vector<F32> *all[ NumArrays ] =
+   {
+      &posX, &posY, &posZ,
+      &velX, &velY, &velZ,
+      &accX, &accY, &accZ,
+      &drag, &wind, &gravity,
+      &age,
+      &colorR, &colorG, &colorB, &colorA,
+      &size,
+   };
+
+   for ( U32 i = 0; i < NumArrays; i++ )
+      arrays[i] = all[i];
+}
+
+void ParticleBatch::setCount( U32 numParts )
+{
+   count = numParts;
+
+   if ( !count )
+      dataBlock = NULL;
+
+   const U32 padded = getPaddedCount();
+
+   parts.setSize( padded );
+
+   Vector<F32> *arrays[ NumArrays ];
+   _getArrays( arrays );
+
+   for ( U32 i = 0; i < NumArrays; i++ )
+   {
+      arrays[i]->setSize( padded );
+
+      // Keep the padding lanes finite.
+      for ( U32 j = count; j < padded; j++ )
+         ( *arrays[i] )[j] = 0.0f;
+   }
+
+   for ( U32 j = count; j < padded; j++ )
+      parts[j] = NULL;
+}
+
+void ParticleBatch::add( Particle *part )
+{
+   if ( !count )
+      dataBlock = part->dataBlock;
+   else if ( part->dataBlock != dataBlock )
+      dataBlock = NULL;
+
+   const U32 i = count;
+   setCount( count + 1 );
+
+   parts[i] = part;
+   part->batchIndex = i;
+
+   posX[i] = part->pos_local.x;
+   posY[i] = part->pos_local.y;
+   posZ[i] = part->pos_local.z;
+   velX[i] = part->vel.x;
+   velY[i] = part->vel.y;
+   velZ[i] = part->vel.z;
+   accX[i] = part->acc.x;
+   accY[i] = part->acc.y;
+   accZ[i] = part->acc.z;
+
+   drag[i] = part->dataBlock->dragCoefficient;
+   wind[i] = part->dataBlock->windCoefficient;
+   gravity[i] = part->dataBlock->gravityCoefficient;
+
+   age[i] = 0.0f;
+   colorR[i] = part->color.red;
+   colorG[i] = part->color.green;
+   colorB[i] = part->color.blue;
+   colorA[i] = part->color.alpha;
+   size[i] = part->size;
+}
+
+void ParticleBatch::remove( Particle *part )
+{
+   if ( !contains( part ) )
+      return;
+
+   const U32 i = part->batchIndex;
+   const U32 last = count - 1;
+
+   if ( i != last )
+   {
+      Vector<F32> *arrays[ NumArrays ];
+      _getArrays( arrays );
+
+      for ( U32 j = 0; j < NumArrays; j++ )
+         ( *arrays[j] )[i] = ( *arrays[j] )[last];
+
+      parts[i] = parts[last];
+      parts[i]->batchIndex = i;
+   }
+
+   setCount( last );
+}
+
+void ParticleKeyTable::set(   const ParticleData *dataBlock,
+                              const LinearColorF *emitterColors,
+                              const F32 *emitterSizes,
+                              F32 colorFade,
+                              F32 alphaFade,
+                              F32 sizeFade )
+{
+   const LinearColorF *colors = emitterColors ? emitterColors : dataBlock->colors;
+
+   for ( U32 i = 0; i < ParticleData::PDC_NUM_KEYS; i++ )
+   {
+      times[i] = dataBlock->times[i];
+
+      F32 span = i > 0 ? times[i] - times[i-1] : 0.0f;
+      invSpans[i] = span > 0.0f ? 1.0f / span : 0.0f;
+
+      r[i] = colors[i].red * colorFade;
+      g[i] = colors[i].green * colorFade;
+      b[i] = colors[i].blue * colorFade;
+      a[i] = colors[i].alpha * alphaFade;
+
+      if ( emitterSizes )
+         size[i] = emitterSizes[i] * sizeFade;
+      else
+         size[i] = dataBlock->sizes[i] * dataBlock->sizeBias * sizeFade;
+   }
+}
+
+#ifdef PARTICLE_BATCH_SSE
+
+void integrateParticles_SSE( ParticleBatch &batch, F32 dt, const Point3F &windVelocity )
+{
+   const U32 padded = batch.getPaddedCount();
+
+   const __m128 t = _mm_set1_ps( dt );
+   const __m128 windX = _mm_set1_ps( windVelocity.x );
+   const __m128 windY = _mm_set1_ps( windVelocity.y );
+   const __m128 windZ = _mm_set1_ps( windVelocity.z );
+   const __m128 gravity = _mm_set1_ps( -9.81f );
+
+   for ( U32 i = 0; i < padded; i += ParticleBatch::Width )
+   {
+      __m128 drag = _mm_loadu_ps( &batch.drag[i] );
+      __m128 wind = _mm_loadu_ps( &batch.wind[i] );
+
+      __m128 velX = _mm_loadu_ps( &batch.velX[i] );
+      __m128 velY = _mm_loadu_ps( &batch.velY[i] );
+      __m128 velZ = _mm_loadu_ps( &batch.velZ[i] );
+
+      // a = acc - vel * drag + wind * windCoefficient
+      __m128 aX = _mm_add_ps( _mm_sub_ps( _mm_loadu_ps( &batch.accX[i] ), _mm_mul_ps( velX, drag ) ), _mm_mul_ps( windX, wind ) );
+      __m128 aY = _mm_add_ps( _mm_sub_ps( _mm_loadu_ps( &batch.accY[i] ), _mm_mul_ps( velY, drag ) ), _mm_mul_ps( windY, wind ) );
+      __m128 aZ = _mm_add_ps( _mm_sub_ps( _mm_loadu_ps( &batch.accZ[i] ), _mm_mul_ps( velZ, drag ) ), _mm_mul_ps( windZ, wind ) );
+      aZ = _mm_add_ps( aZ, _mm_mul_ps( gravity, _mm_loadu_ps( &batch.gravity[i] ) ) );
+
+      velX = _mm_add_ps( velX, _mm_mul_ps( aX, t ) );
+      velY = _mm_add_ps( velY, _mm_mul_ps( aY, t ) );
+      velZ = _mm_add_ps( velZ, _mm_mul_ps( aZ, t ) );
+
+      _mm_storeu_ps( &batch.velX[i], velX );
+      _mm_storeu_ps( &batch.velY[i], velY );
+      _mm_storeu_ps( &batch.velZ[i], velZ );
+
+      _mm_storeu_ps( &batch.posX[i], _mm_add_ps( _mm_loadu_ps( &batch.posX[i] ), _mm_mul_ps( velX, t ) ) );
+      _mm_storeu_ps( &batch.posY[i], _mm_add_ps( _mm_loadu_ps( &batch.posY[i] ), _mm_mul_ps( velY, t ) ) );
+      _mm_storeu_ps( &batch.posZ[i], _mm_add_ps( _mm_loadu_ps( &batch.posZ[i] ), _mm_mul_ps( velZ, t ) ) );
+   }
+}
+
+/// Returns mask ? a : b.
+static inline __m128 _select( __m128 mask, __m128 a, __m128 b )
+{
+   return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+}
+
+/// Returns k0 + ( k1 - k0 ) * f.
+static inline __m128 _lerp( F32 k0, F32 k1, __m128 f )
+{
+   return _mm_add_ps( _mm_set1_ps( k0 ), _mm_mul_ps( _mm_set1_ps( k1 - k0 ), f ) );
+}
+
+void interpolateParticleKeys_SSE( ParticleBatch &batch, const ParticleKeyTable &keys )
+{
+   const U32 padded = batch.getPaddedCount();
+
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps( 1.0f );
+
+   for ( U32 i = 0; i < padded; i += ParticleBatch::Width )
+   {
+      const __m128 t = _mm_loadu_ps( &batch.age[i] );
+
+      __m128 r = _mm_loadu_ps( &batch.colorR[i] );
+      __m128 g = _mm_loadu_ps( &batch.colorG[i] );
+      __m128 b = _mm_loadu_ps( &batch.colorB[i] );
+      __m128 a = _mm_loadu_ps( &batch.colorA[i] );
+      __m128 s = _mm_loadu_ps( &batch.size[i] );
+
+      // Each lane takes the first key segment ending at or after its
+      // age.  Walk all the segments and blend in the ones that match.
+      __m128 done = zero;
+
+      for ( U32 k = 1; k < ParticleData::PDC_NUM_KEYS; k++ )
+      {
+         __m128 mask = _mm_andnot_ps( done, _mm_cmple_ps( t, _mm_set1_ps( keys.times[k] ) ) );
+         if ( !_mm_movemask_ps( mask ) )
+            continue;
+
+         done = _mm_or_ps( done, mask );
+
+         // Sizes extrapolate, colors clamp like LinearColorF::interpolate.
+         __m128 f = _mm_mul_ps( _mm_sub_ps( t, _mm_set1_ps( keys.times[k-1] ) ), _mm_set1_ps( keys.invSpans[k] ) );
+         __m128 cf = _mm_min_ps( _mm_max_ps( f, zero ), one );
+
+         r = _select( mask, _lerp( keys.r[k-1], keys.r[k], cf ), r );
+         g = _select( mask, _lerp( keys.g[k-1], keys.g[k], cf ), g );
+         b = _select( mask, _lerp( keys.b[k-1], keys.b[k], cf ), b );
+         a = _select( mask, _lerp( keys.a[k-1], keys.a[k], cf ), a );
+         s = _select( mask, _lerp( keys.size[k-1], keys.size[k], f ), s );
+
+         if ( _mm_movemask_ps( done ) == 0xF )
+            break;
+      }
+
+      _mm_storeu_ps( &batch.colorR[i], r );
+      _mm_storeu_ps( &batch.colorG[i], g );
+      _mm_storeu_ps( &batch.colorB[i], b );
+      _mm_storeu_ps( &batch.colorA[i], a );
+      _mm_storeu_ps( &batch.size[i], s );
+   }
+}
+
+#endif // PARTICLE_BATCH_SSE
+
+void integrateParticles_C( ParticleBatch &batch, F32 dt, const Point3F &windVelocity )
+{
+   for ( U32 i = 0; i < batch.count; i++ )
+   {
+      F32 aX = batch.accX[i] - batch.velX[i] * batch.drag[i] + windVelocity.x * batch.wind[i];
+      F32 aY = batch.accY[i] - batch.velY[i] * batch.drag[i] + windVelocity.y * batch.wind[i];
+      F32 aZ = batch.accZ[i] - batch.velZ[i] * batch.drag[i] + windVelocity.z * batch.wind[i];
+      aZ += -9.81f * batch.gravity[i];
+
+      batch.velX[i] += aX * dt;
+      batch.velY[i] += aY * dt;
+      batch.velZ[i] += aZ * dt;
+
+      batch.posX[i] += batch.velX[i] * dt;
+      batch.posY[i] += batch.velY[i] * dt;
+      batch.posZ[i] += batch.velZ[i] * dt;
+   }
+}
+
+void interpolateParticleKeys_C( ParticleBatch &batch, const ParticleKeyTable &keys )
+{
+   for ( U32 i = 0; i < batch.count; i++ )
+   {
+      const F32 t = batch.age[i];
+
+      for ( U32 k = 1; k < ParticleData::PDC_NUM_KEYS; k++ )
+      {
+         if ( keys.times[k] < t )
+            continue;
+
+         // Sizes extrapolate, colors clamp like LinearColorF::interpolate.
+         F32 f = ( t - keys.times[k-1] ) * keys.invSpans[k];
+         F32 cf = mClampF( f, 0.0f, 1.0f );
+
+         batch.colorR[i] = keys.r[k-1] + ( keys.r[k] - keys.r[k-1] ) * cf;
+         batch.colorG[i] = keys.g[k-1] + ( keys.g[k] - keys.g[k-1] ) * cf;
+         batch.colorB[i] = keys.b[k-1] + ( keys.b[k] - keys.b[k-1] ) * cf;
+         batch.colorA[i] = keys.a[k-1] + ( keys.a[k] - keys.a[k-1] ) * cf;
+         batch.size[i] = keys.size[k-1] + ( keys.size[k] - keys.size[k-1] ) * f;
+         break;
+      }
+   }
+}
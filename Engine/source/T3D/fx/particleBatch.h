@@ -0,0 +1,166 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _PARTICLEBATCH_H_
+#define _PARTICLEBATCH_H_
+
+#ifndef _PARTICLE_H_
+#include "T3D/fx/particle.h"
+#endif
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
+
+#if (defined( TORQUE_CPU_X86 ) || defined( TORQUE_CPU_X64 ))
+#define PARTICLE_BATCH_SSE
+#endif
+
+/// Structure of arrays copy of the particle state touched while
+/// updating an emitter.
+///
+/// Each emitter keeps its batch across updates.  Particles get a lane
+/// when ParticleEmitter::update() first sees them and lose it when they
+/// die, so the integrated state lives here and is never gathered back
+/// from the linked list.  The results the renderers and AFX read are
+/// still written out to the particles after each update.
+///
+/// All arrays are padded to a multiple of four entries.
+struct ParticleBatch
+{
+   enum { Width = 4 };
+
+   /// Number of live particles in the batch.
+   U32 count;
+
+   /// The datablock all particles in the batch share or NULL if they
+   /// don't.  Only reset once the batch runs empty.
+   ParticleData *dataBlock;
+
+   Vector<Particle*> parts;
+
+   Vector<F32> posX, posY, posZ;
+   Vector<F32> velX, velY, velZ;
+   Vector<F32> accX, accY, accZ;
+
+   /// Per particle datablock coefficients.
+   Vector<F32> drag, wind, gravity;
+
+   /// Normalized age (currentAge / totalLifetime).
+   Vector<F32> age;
+
+   /// Interpolated key outputs.  These must hold the current
+   /// values on input as particles past the last key keep them.
+   Vector<F32> colorR, colorG, colorB, colorA;
+   Vector<F32> size;
+
+   ParticleBatch() : count( 0 ), dataBlock( NULL ) {}
+
+   /// Sizes the arrays for numParts particles and zeroes the padding.
+   /// Lanes below numParts keep their contents.
+   void setCount( U32 numParts );
+
+   /// Returns the count rounded up to the SIMD width.
+   U32 getPaddedCount() const { return ( count + Width - 1 ) & ~( Width - 1 ); }
+
+   /// Returns true if the particle has a lane in this batch.
+   bool contains( const Particle *part ) const
+   {
+      return part->batchIndex < count && parts[ part->batchIndex ] == part;
+   }
+
+   /// Adds a lane for the particle, initialized from its current state.
+   void add( Particle *part );
+
+   /// Removes the particle's lane, if it has one, by moving the last
+   /// lane into its place.
+   void remove( Particle *part );
+
+private:
+
+   enum { NumArrays = 18 };
+
+   /// Fills in pointers to all the per lane F32 arrays.
+   void _getArrays( Vector<F32> *arrays[ NumArrays ] );
+};
+
+/// Color and size keys with the emitter overrides and fades applied,
+/// shared by every particle of a batch.
+struct ParticleKeyTable
+{
+   F32 times[ ParticleData::PDC_NUM_KEYS ];
+   F32 invSpans[ ParticleData::PDC_NUM_KEYS ];
+
+   F32 r[ ParticleData::PDC_NUM_KEYS ];
+   F32 g[ ParticleData::PDC_NUM_KEYS ];
+   F32 b[ ParticleData::PDC_NUM_KEYS ];
+   F32 a[ ParticleData::PDC_NUM_KEYS ];
+   F32 size[ ParticleData::PDC_NUM_KEYS ];
+
+   /// Fills the table.  If emitterColors or emitterSizes are non-null
+   /// they replace the datablock keys.  The color and size fades are
+   /// linear so they are folded into the keys.
+   void set( const ParticleData *dataBlock,
+             const LinearColorF *emitterColors,
+             const F32 *emitterSizes,
+             F32 colorFade,
+             F32 alphaFade,
+             F32 sizeFade );
+};
+
+/// @name Batch kernels
+/// The _C versions are the portable reference, the _SSE versions process
+/// four particles at a time.  Use the undecorated names, which pick the
+/// best version for the target.
+/// @{
+
+/// Integrates velocity and position over dt for every particle in the batch.
+void integrateParticles_C( ParticleBatch &batch, F32 dt, const Point3F &windVelocity );
+
+/// Interpolates color and size from the keys for every particle in the batch.
+void interpolateParticleKeys_C( ParticleBatch &batch, const ParticleKeyTable &keys );
+
+#ifdef PARTICLE_BATCH_SSE
+void integrateParticles_SSE( ParticleBatch &batch, F32 dt, const Point3F &windVelocity );
+void interpolateParticleKeys_SSE( ParticleBatch &batch, const ParticleKeyTable &keys );
+#endif
+
+inline void integrateParticles( ParticleBatch &batch, F32 dt, const Point3F &windVelocity )
+{
+#ifdef PARTICLE_BATCH_SSE
+   integrateParticles_SSE( batch, dt, windVelocity );
+#else
+   integrateParticles_C( batch, dt, windVelocity );
+#endif
+}
+
+inline void interpolateParticleKeys( ParticleBatch &batch, const ParticleKeyTable &keys )
+{
+#ifdef PARTICLE_BATCH_SSE
+   interpolateParticleKeys_SSE( batch, keys );
+#else
+   interpolateParticleKeys_C( batch, keys );
+#endif
+}
+
+/// @}
+
+#endif // _PARTICLEBATCH_H_
@@ -0,0 +1,148 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/platform.h"
+#include "T3D/fx/particleDepthSort.h"
+
+#include "core/util/tVector.h"
+#include "math/mMathFn.h"
+
+
+S32 QSORT_CALLBACK cmpSortParticles(const void* p1, const void* p2)
+{
+   const SortParticle* sp1 = (const SortParticle*)p1;
+   const SortParticle* sp2 = (const SortParticle*)p2;
+
+   if (sp2->k > sp1->k)
+      return 1;
+   else if (sp2->k == sp1->k)
+      return 0;
+   else
+      return -1;
+}
+
+namespace ParticleDepthSort
+{
+
+static Vector<SortParticle> sScratchParts( __FILE__, __LINE__ );
+static Vector<U16> sKeys( __FILE__, __LINE__ );
+static Vector<U16> sScratchKeys( __FILE__, __LINE__ );
+
+void radixSort( SortParticle *parts, U32 count )
+{
+   if ( count < 2 )
+      return;
+
+   F32 minK = parts[0].k;
+   F32 maxK = parts[0].k;
+   for ( U32 i = 1; i < count; i++ )
+   {
+      minK = getMin( minK, parts[i].k );
+      maxK = getMax( maxK, parts[i].k );
+   }
+
+   // Everything at the same depth.
+   if ( !( maxK > minK ) )
+      return;
+
+   sScratchParts.setSize( count );
+   sKeys.setSize( count );
+   sScratchKeys.setSize( count );
+
+   // Quantize so that the farthest particle gets key 0.
+   const F32 scale = 65535.0f / ( maxK - minK );
+
+   U32 histLo[256];
+   U32 histHi[256];
+   dMemset( histLo, 0, sizeof( histLo ) );
+   dMemset( histHi, 0, sizeof( histHi ) );
+
+   for ( U32 i = 0; i < count; i++ )
+   {
+      U16 key = (U16)mClampF( ( maxK - parts[i].k ) * scale, 0.0f, 65535.0f );
+      sKeys[i] = key;
+      histLo[ key & 0xFF ]++;
+      histHi[ key >> 8 ]++;
+   }
+
+   // Turn the histograms into offsets.
+   U32 sumLo = 0;
+   U32 sumHi = 0;
+   for ( U32 i = 0; i < 256; i++ )
+   {
+      U32 lo = histLo[i];
+      histLo[i] = sumLo;
+      sumLo += lo;
+
+      U32 hi = histHi[i];
+      histHi[i] = sumHi;
+      sumHi += hi;
+   }
+
+   // Low byte into the scratch arrays...
+   for ( U32 i = 0; i < count; i++ )
+   {
+      U32 dest = histLo[ sKeys[i] & 0xFF ]++;
+      sScratchParts[ dest ] = parts[i];
+      sScratchKeys[ dest ] = sKeys[i];
+   }
+
+   // ...and the high byte back out.
+   for ( U32 i = 0; i < count; i++ )
+   {
+      U32 dest = histHi[ sScratchKeys[i] >> 8 ]++;
+      parts[ dest ] = sScratchParts[i];
+   }
+}
+
+bool insertionSort( SortParticle *parts, U32 count, U32 maxMoves )
+{
+   U32 moves = 0;
+
+   for ( U32 i = 1; i < count; i++ )
+   {
+      if ( parts[i].k <= parts[i-1].k )
+         continue;
+
+      SortParticle part = parts[i];
+      U32 j = i;
+      for ( ; j > 0 && parts[j-1].k < part.k; j-- )
+         parts[j] = parts[j-1];
+      parts[j] = part;
+
+      moves += i - j;
+      if ( moves > maxMoves )
+         return false;
+   }
+
+   return true;
+}
+
+void coherentSort( SortParticle *parts, U32 count )
+{
+   // Allow the insertion sort about as much work as a
+   // radix pass would be before giving up on it.
+   if ( !insertionSort( parts, count, count * 2 ) )
+      radixSort( parts, count );
+}
+
+} // namespace ParticleDepthSort
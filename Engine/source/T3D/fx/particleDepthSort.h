@@ -0,0 +1,64 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _PARTICLEDEPTHSORT_H_
+#define _PARTICLEDEPTHSORT_H_
+
+#ifndef _PLATFORM_H_
+#include "platform/platform.h"
+#endif
+
+struct Particle;
+
+/// A particle and its view depth sort key.
+struct SortParticle
+{
+   Particle* p;
+   F32       k;
+};
+
+/// qsort callback sorting particles far to near (descending key).
+S32 QSORT_CALLBACK cmpSortParticles(const void* p1, const void* p2);
+
+/// Far to near (descending key) particle sorting for ParticleEmitter.
+///
+/// The sorts use persistent scratch storage, so they don't allocate once
+/// that has grown to the largest particle count seen.  They must only be
+/// called from the main thread.
+namespace ParticleDepthSort
+{
+   /// Stable LSD radix sort on the keys quantized to 16 bits over
+   /// their range.  Particles in the same bucket keep their order.
+   void radixSort( SortParticle *parts, U32 count );
+
+   /// Insertion sort on the exact keys that gives up after maxMoves
+   /// element moves.  Returns false if it gave up, in which case the
+   /// particles are partly sorted.
+   bool insertionSort( SortParticle *parts, U32 count, U32 maxMoves );
+
+   /// Sorts particles which are expected to be close to sorted already,
+   /// such as last frame's order.  An insertion sort pass is tried first
+   /// and the radix sort finishes the job if too much has moved.
+   void coherentSort( SortParticle *parts, U32 count );
+}
+
+#endif // _PARTICLEDEPTHSORT_H_
@@ -27,6 +27,7 @@
 
 #include "platform/platform.h"
 #include "T3D/fx/particleEmitter.h"
+#include "T3D/fx/particleDepthSort.h"
 
 #include "scene/sceneManager.h"
 #include "scene/sceneRenderState.h"
@@ -42,12 +43,14 @@
 #include "T3D/gameBase/gameProcess.h"
 #include "lighting/lightInfo.h"
 #include "console/engineAPI.h"
+#include "platform/profiler.h"
 
 #if defined(AFX_CAP_PARTICLE_POOLS) 
 #include "afx/util/afxParticlePool.h"
 #endif 
 
 Point3F ParticleEmitter::mWindVelocity( 0.0, 0.0, 0.0 );
+
 const F32 ParticleEmitter::AgedSpinToRadians = (1.0f/1000.0f) * (1.0f/360.0f) * M_PI_F * 2.0f;
 
 IMPLEMENT_CO_DATABLOCK_V1(ParticleEmitterData);
@@ -991,6 +994,7 @@ ParticleEmitter::ParticleEmitter()
    part_list_head.next = NULL;
    n_part_capacity = 0;
    n_parts = 0;
+   mSortStamp = 0;
 
    mThetaOld = 0;
    mPhiOld = 0;
@@ -1126,6 +1130,8 @@ bool ParticleEmitter::onNewDataBlock( GameBaseData *dptr, bool reload )
       store_block[n_part_capacity-1].next = NULL;
       part_list_head.next = NULL;
       n_parts = 0;
+      mLastSortOrder.clear();
+      mBatch.setCount(0);
    }
    if (mDataBlock->isTempClone())
    {
@@ -1722,6 +1728,7 @@ void ParticleEmitter::advanceTime(F32 dt)
      part->currentAge += numMSToUpdate;
      if (part->currentAge > part->totalLifetime)
      {
+       mBatch.remove(part);
        n_parts--;
        last_part->next = part->next;
        part->next = part_freelist;
@@ -1823,55 +1830,102 @@ void ParticleEmitter::updateKeyData( Particle *part )
 // AFX CODE BLOCK (enhanced-emitter) <<
 void ParticleEmitter::update( U32 ms )
 {
+   PROFILE_SCOPE( ParticleEmitter_update );
+
    F32 t = F32(ms)/1000.0f; // AFX -- moved outside loop, no need to recalculate this for every particle
 
-   for (Particle* part = part_list_head.next; part != NULL; part = part->next)
+   // The batch keeps the particles' state between updates, so only the
+   // ones added since the last update have to be brought in.  The keys
+   // can be done in bulk as well when all particles share a datablock,
+   // which is the usual case.
+   ParticleBatch &batch = mBatch;
+   syncBatch();
+
+   ParticleData *sharedDataBlock = batch.dataBlock;
+   const U32 n = batch.count;
+
+   integrateParticles( batch, t, mWindVelocity );
+
+   for (U32 i = 0; i < n; i++)
    {
-      Point3F a = part->acc;
-      a -= part->vel * part->dataBlock->dragCoefficient;
-      a += mWindVelocity * part->dataBlock->windCoefficient;
-      a.z += -9.81f*part->dataBlock->gravityCoefficient; // AFX -- as long as gravity is a constant, this is faster
+      Particle *part = batch.parts[i];
 
-      part->vel += a * t;
-      part->pos_local += part->vel * t; 
+      part->vel.set( batch.velX[i], batch.velY[i], batch.velZ[i] );
+      part->pos_local.set( batch.posX[i], batch.posY[i], batch.posZ[i] );
 
       // AFX -- allow subclasses to adjust the particle params here
       sub_particleUpdate(part);
 
+      // The subclass may have moved it.
+      batch.posX[i] = part->pos_local.x;
+      batch.posY[i] = part->pos_local.y;
+      batch.posZ[i] = part->pos_local.z;
+
       if (part->dataBlock->constrain_pos)
         part->pos = part->pos_local + this->pos_pe;
       else
         part->pos = part->pos_local;
 
-      updateKeyData( part );
+      if ( !sharedDataBlock )
+      {
+         updateKeyData( part );
+         continue;
+      }
+
+      // Same clamping as updateKeyData().
+      if( part->totalLifetime < 1 )
+         part->totalLifetime = 1;
+      if (part->currentAge > part->totalLifetime)
+         part->currentAge = part->totalLifetime;
+
+      batch.age[i] = (F32)part->currentAge / (F32)part->totalLifetime;
    }
-}
 
-//-----------------------------------------------------------------------------
-// Copy particles to vertex buffer
-//-----------------------------------------------------------------------------
+   if ( !sharedDataBlock )
+      return;
 
-// structure used for particle sorting.
-struct SortParticle
-{
-   Particle* p;
-   F32       k;
-};
+   ParticleKeyTable keys;
+   keys.set(   sharedDataBlock,
+               mDataBlock->useEmitterColors ? colors : NULL,
+               mDataBlock->useEmitterSizes ? sizes : NULL,
+               mDataBlock->fade_color ? fade_amt : 1.0f,
+               mDataBlock->fade_alpha ? fade_amt : 1.0f,
+               mDataBlock->fade_size ? fade_amt : 1.0f );
+
+   interpolateParticleKeys( batch, keys );
+
+   for (U32 i = 0; i < n; i++)
+   {
+      Particle *part = batch.parts[i];
+      part->color.set( batch.colorR[i], batch.colorG[i], batch.colorB[i], batch.colorA[i] );
+      part->size = batch.size[i];
+   }
+}
 
-// qsort callback function for particle sorting
-S32 QSORT_CALLBACK cmpSortParticles(const void* p1, const void* p2)
+void ParticleEmitter::syncBatch()
 {
-   const SortParticle* sp1 = (const SortParticle*)p1;
-   const SortParticle* sp2 = (const SortParticle*)p2;
+   // Particles are only ever added at the head of the list, so the
+   // ones added since the last update are the run at the front that
+   // doesn't have a lane yet.  Dead ones were removed in advanceTime().
+   for (Particle* part = part_list_head.next; part != NULL && !mBatch.contains(part); part = part->next)
+      mBatch.add(part);
 
-   if (sp2->k > sp1->k)
-      return 1;
-   else if (sp2->k == sp1->k)
-      return 0;
-   else
-      return -1;
+   if ((S32)mBatch.count == n_parts)
+      return;
+
+   // Something took particles out of the list behind our back.
+   // Start over from the list.
+   AssertWarn( false, "ParticleEmitter::syncBatch - particle count doesn't match the list, rebuilding the batch." );
+
+   mBatch.setCount(0);
+   for (Particle* part = part_list_head.next; part != NULL; part = part->next)
+      mBatch.add(part);
 }
 
+//-----------------------------------------------------------------------------
+// Copy particles to vertex buffer
+//-----------------------------------------------------------------------------
+
 void ParticleEmitter::copyToVB( const Point3F &camPos, const LinearColorF &ambientColor )
 {
    static Vector<SortParticle> orderedVector(__FILE__, __LINE__);
@@ -1887,16 +1941,43 @@ void ParticleEmitter::copyToVB( const Point3F &camPos, const LinearColorF &ambie
      MatrixF modelview = GFX->getWorldMatrix();
      Point3F viewvec; modelview.getRow(1, &viewvec);
 
-     // add each particle and a distance based sort key to orderedVector
+     // Start from last frame's order so the sort only has to fix up
+     // what moved.  Stamp the live particles, keep the ones from the
+     // last order that are still alive, then add the new ones.
+     const U32 liveStamp = ++mSortStamp;
+     const U32 keptStamp = ++mSortStamp;
+
      for (Particle* pp = part_list_head.next; pp != NULL; pp = pp->next)
+       pp->sortStamp = liveStamp;
+
+     for (U32 i = 0; i < mLastSortOrder.size(); i++)
      {
+       Particle* pp = mLastSortOrder[i];
+       if (pp->sortStamp != liveStamp)
+         continue;
+
+       pp->sortStamp = keptStamp;
        orderedVector.increment();
        orderedVector.last().p = pp;
        orderedVector.last().k = mDot(pp->pos, viewvec);
      }
 
-     // qsort the list into far to near ordering
-     dQsort(orderedVector.address(), orderedVector.size(), sizeof(SortParticle), cmpSortParticles);
+     for (Particle* pp = part_list_head.next; pp != NULL; pp = pp->next)
+     {
+       if (pp->sortStamp != liveStamp)
+         continue;
+
+       orderedVector.increment();
+       orderedVector.last().p = pp;
+       orderedVector.last().k = mDot(pp->pos, viewvec);
+     }
+
+     // sort the list into far to near ordering
+     ParticleDepthSort::coherentSort(orderedVector.address(), orderedVector.size());
+
+     mLastSortOrder.setSize(orderedVector.size());
+     for (U32 i = 0; i < orderedVector.size(); i++)
+       mLastSortOrder[i] = orderedVector[i].p;
    }
    PROFILE_END();
 
@@ -43,6 +43,9 @@
 #ifndef _PARTICLE_H_
 #include "T3D/fx/particle.h"
 #endif
+#ifndef _PARTICLEBATCH_H_
+#include "T3D/fx/particleBatch.h"
+#endif
 
 class RenderPassManager;
 class ParticleData;
@@ -278,6 +281,9 @@ class ParticleEmitter : public GameBase
    // protected and private scope statements have been inserted inline with the original
    // code to expose the necessary members and methods.
    void update( U32 ms );
+
+   /// Gives the particles added since the last update a lane in mBatch.
+   void syncBatch();
 protected:
     void updateKeyData( Particle *part );
  
@@ -327,6 +333,14 @@ protected:
    Particle   part_list_head;
    S32        n_part_capacity;
    S32        n_parts;
+
+   /// Particles in the order of the last depth sort, used to
+   /// seed the next one as the order rarely changes much.
+   Vector<Particle*> mLastSortOrder;
+   U32        mSortStamp;
+
+   /// The live particles' update state in structure of arrays form.
+   ParticleBatch mBatch;
 private:    
    S32       mCurBuffSize;
 
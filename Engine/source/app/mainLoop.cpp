@@ -57,6 +57,7 @@
 
 #include "util/sampler.h"
 #include "platform/threads/threadPool.h"
+#include "platform/threads/jobSystem.h"
 
 // For the TickMs define... fix this for T2D...
 #include "T3D/gameBase/processList.h"
@@ -199,10 +200,14 @@ void processTimeEvent(S32 elapsedTime)
    
    gFPS.update();
 
-   // Give the texture manager a chance to cleanup any
-   // textures that haven't been referenced for a bit.
+   // Give the texture manager a chance to upload async loaded
+   // textures and to cleanup any textures that haven't been
+   // referenced for a bit.
    if( GFX )
+   {
+      TEXMGR->processAsyncLoads( GFXTextureManager::smAsyncUploadBudget * 1024 );
       TEXMGR->cleanupCache( 5 );
+   }
 
    PROFILE_END();
    
@@ -263,6 +268,7 @@ void StandardMainLoop::init()
    Platform::initConsole();
    
    ThreadPool::GlobalThreadPool::createSingleton();
+   JobSystem::GlobalJobSystem::createSingleton();
 
    // Set engineAPI initialized to true
    engineAPI::gIsInitialized = true;
@@ -351,6 +357,8 @@ void StandardMainLoop::shutdown()
    
    EngineModuleManager::shutdownSystem();
    
+   JobSystem::GLOBAL().shutdown();
+   JobSystem::GlobalJobSystem::deleteSingleton();
    ThreadPool::GlobalThreadPool::deleteSingleton();
 
 #ifdef TORQUE_ENABLE_VFS
@@ -69,6 +69,37 @@ char* ConsoleValue::convertToBuffer() const
    return buffer;
 }
 
+void ConsoleValue::appendString(const char* val, S32 len, char separator)
+{
+   const S32 extra = len + (separator ? 1 : 0);
+   if (extra == 0)
+      return;
+
+   char* buffer;
+   S32 oldLen;
+   if (type == ConsoleValueType::cvString)
+   {
+      oldLen = dStrlen(s);
+      buffer = (char*)dRealloc(s, static_cast<dsize_t>(oldLen + extra) + 1);
+   }
+   else
+   {
+      const char* oldString = getString();
+      oldLen = dStrlen(oldString);
+      buffer = (char*)dMalloc(static_cast<dsize_t>(oldLen + extra) + 1);
+      dMemcpy(buffer, oldString, oldLen);
+      cleanupData();
+   }
+
+   if (separator)
+      buffer[oldLen++] = separator;
+   dMemcpy(buffer + oldLen, val, len);
+   buffer[oldLen + len] = '\0';
+
+   type = ConsoleValueType::cvString;
+   s = buffer;
+}
+
 const char* ConsoleValue::getConsoleData() const
 {
    return Con::getData(ct->consoleType, ct->dataPtr, 0, ct->enumTable);
@@ -78,6 +109,7 @@ ConsoleDocFragment* ConsoleDocFragment::smFirst;
 U32 gAnonFunctionID = 0;
 ConsoleConstructor *ConsoleConstructor::mFirst = NULL;
 bool gWarnUndefinedScriptVariables;
+S32 gScriptOptimizeLevel = 1;
 
 static char scratchBuffer[4096];
 
@@ -391,6 +423,12 @@ void init()
       "failures based on a missing copy object and does not report an error..\n"
       "@ingroup Console\n");
    addVariable("Con::scriptWarningsAsAsserts", TypeBool, &scriptWarningsAsAsserts, "If true, script warnings (outside of syntax errors) will be treated as fatal asserts.");
+   addVariable("Con::optimizeLevel", TypeS32, &gScriptOptimizeLevel,
+      "@brief How aggressively scripts are optimized when they are compiled.\n\n"
+      "0 disables optimization. 1 (the default) folds constant expressions, threads jumps and appends to "
+      "local strings in place. 2 also removes stores to local variables that are never read, which can "
+      "hide them from the script debugger.\n"
+      "@ingroup Console\n");
 
    // Current script file name and root
    addVariable( "Con::File", TypeString, &gCurrentFile, "The currently executing script file.\n"
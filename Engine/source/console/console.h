@@ -60,6 +60,13 @@ template< typename T > S32 TYPEID();
 /// @note This is set and controlled by script.
 extern bool gWarnUndefinedScriptVariables;
 
+/// How aggressively the script compiler optimizes. 0 disables optimization,
+/// 1 (the default) enables constant folding, jump threading and in-place
+/// string appends, and 2 additionally drops stores to locals that are never read.
+///
+/// @note This is set and controlled by script.
+extern S32 gScriptOptimizeLevel;
+
 enum StringTableConstants
 {
    StringTagPrefixByte = 0x01 ///< Magic value prefixed to tagged strings.
@@ -312,6 +319,10 @@ public:
       dStrcpy(s, val, static_cast<dsize_t>(len) + 1);
    }
 
+   /// Appends a separator character (if not 0) and a string to this value.
+   /// A string this value already owns is grown in place rather than copied.
+   void appendString(const char* val, S32 len, char separator);
+
    TORQUE_FORCEINLINE void setStringRef(const char* ref, S32 len)
    {
       cleanupData();
@@ -511,7 +522,10 @@ namespace Con
       /// 10/07/17 - JTH - 48->49 Added opcode for function pointers and revamp of interpreter 
       ///                         from switch to function calls.
       /// 09/04/21 - JTH - 49->50 Rewrite of interpreter
-      DSOVersion = 50,
+      /// 10/16/26 - 50->51 Added inline cache slot operand to OP_CALLFUNC
+      /// 10/16/26 - 51->52 Added superinstructions for global loads and local float math
+      /// 10/16/26 - 52->53 Added OP_APPEND_LOCAL_STR
+      DSOVersion = 53,
 
       MaxLineLength = 512,  ///< Maximum length of a line of console input.
       MaxDataTypes = 256    ///< Maximum number of registered data types.
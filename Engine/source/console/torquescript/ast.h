@@ -48,7 +48,11 @@ enum ExprNodeName
    NameExprNode,
    NameFloatNode,
    NameIntNode,
-   NameVarNode
+   NameVarNode,
+   NameStrConstNode,
+   NameConstantNode,
+   NameStrcatExprNode,
+   NameFuncCallExprNode
 };
 
 /// Representation of a node for the scripting language parser.
@@ -129,6 +133,10 @@ struct ExprNode : StmtNode
 
    U32 compileStmt(CodeStream& codeStream, U32 ip);
 
+   /// Tries to replace this expression with a cheaper equivalent. On success
+   /// the replacement is left in optimizedNode and true is returned.
+   virtual bool optimize() { return false; }
+
    virtual U32 compile(CodeStream& codeStream, U32 ip, TypeReq type) = 0;
    virtual TypeReq getPreferredType() = 0;
    virtual ExprNodeName getExprNodeNameEnum() const { return NameExprNode; }
@@ -266,8 +274,11 @@ struct StrcatExprNode : BinaryExprNode
    S32 appendChar;
    static StrcatExprNode* alloc(S32 lineNumber, ExprNode* left, ExprNode* right, S32 appendChar);
 
+   bool optimize();
+
    U32 compile(CodeStream& codeStream, U32 ip, TypeReq type);
    TypeReq getPreferredType();
+   virtual ExprNodeName getExprNodeNameEnum() const { return NameStrcatExprNode; }
    DBG_STMT_TYPE(StrcatExprNode);
 };
 
@@ -289,6 +300,8 @@ struct IntUnaryExprNode : ExprNode
 
    static IntUnaryExprNode* alloc(S32 lineNumber, S32 op, ExprNode* expr);
 
+   bool optimize();
+
    U32 compile(CodeStream& codeStream, U32 ip, TypeReq type);
    TypeReq getPreferredType();
    DBG_STMT_TYPE(IntUnaryExprNode);
@@ -357,6 +370,7 @@ struct StrConstNode : ExprNode
 
    U32 compile(CodeStream& codeStream, U32 ip, TypeReq type);
    TypeReq getPreferredType();
+   virtual ExprNodeName getExprNodeNameEnum() const { return NameStrConstNode; }
    DBG_STMT_TYPE(StrConstNode);
 };
 
@@ -370,6 +384,7 @@ struct ConstantNode : ExprNode
 
    U32 compile(CodeStream& codeStream, U32 ip, TypeReq type);
    TypeReq getPreferredType();
+   virtual ExprNodeName getExprNodeNameEnum() const { return NameConstantNode; }
    DBG_STMT_TYPE(ConstantNode);
 };
 
@@ -382,6 +397,10 @@ struct AssignExprNode : ExprNode
 
    static AssignExprNode* alloc(S32 lineNumber, StringTableEntry varName, ExprNode* arrayIndex, ExprNode* expr);
 
+   /// Compiles %var = %var @ a @ b ... as in-place appends to the local, if
+   /// that is safe. Returns false, emitting nothing, if it isn't.
+   bool compileLocalAppend(CodeStream& codeStream, TypeReq type);
+
    U32 compile(CodeStream& codeStream, U32 ip, TypeReq type);
    TypeReq getPreferredType();
    DBG_STMT_TYPE(AssignExprNode);
@@ -462,6 +481,7 @@ struct FuncCallExprNode : ExprNode
 
    U32 compile(CodeStream& codeStream, U32 ip, TypeReq type);
    TypeReq getPreferredType();
+   virtual ExprNodeName getExprNodeNameEnum() const { return NameFuncCallExprNode; }
    DBG_STMT_TYPE(FuncCallExprNode);
 };
 
@@ -586,6 +606,10 @@ struct FunctionDeclStmtNode : StmtNode
    U32 endOffset;
    U32 argc;
 
+   /// The locals read in the body.
+   StringTableEntry* localReads;
+   U32 numLocalReads;
+
    static FunctionDeclStmtNode* alloc(S32 lineNumber, StringTableEntry fnName, StringTableEntry nameSpace, VarNode* args, StmtNode* stmts);
 
    U32 compileStmt(CodeStream& codeStream, U32 ip);
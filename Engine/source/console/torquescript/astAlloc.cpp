@@ -206,6 +206,8 @@ VarNode* VarNode::alloc(S32 lineNumber, StringTableEntry varName, ExprNode* arra
    ret->optimizedNode = NULL;
    ret->varName = varName;
    ret->arrayIndex = arrayIndex;
+
+   noteLocalVarRead(varName);
    return ret;
 }
 
@@ -293,6 +295,9 @@ AssignOpExprNode* AssignOpExprNode::alloc(S32 lineNumber, StringTableEntry varNa
    ret->expr = expr;
    ret->arrayIndex = arrayIndex;
    ret->op = op;
+
+   // Compound assignments read the variable too.
+   noteLocalVarRead(varName);
    return ret;
 }
 
@@ -452,5 +457,9 @@ FunctionDeclStmtNode* FunctionDeclStmtNode::alloc(S32 lineNumber, StringTableEnt
    ret->stmts = stmts;
    ret->nameSpace = nameSpace;
    ret->package = NULL;
+
+   // Functions don't nest, so everything read since the last
+   // declaration includes all the reads in this body.
+   ret->numLocalReads = takeLocalVarReads(&ret->localReads);
    return ret;
 }
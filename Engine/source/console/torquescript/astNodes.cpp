@@ -65,6 +65,50 @@ inline FuncVars* getFuncVars(S32 lineNumber)
    return gFuncVars;
 }
 
+/// Returns true while compiling the body of a function.  Locals outside of
+/// one live in gEvalFuncVars, which the console and every eval() share
+/// across separate compiles.
+inline bool isInFunctionBody()
+{
+   return gFuncVars != NULL && gFuncVars != &gGlobalScopeFuncVars && gFuncVars != &gEvalFuncVars;
+}
+
+/// Emits the superinstruction that fuses loading a local float variable with
+/// the binary float operation that consumes it. Returns false, emitting
+/// nothing, if the expression is not a plain local or the op has no fused form.
+static bool compileLocalFloatOp(CodeStream& codeStream, ExprNode* expr, U32 operand)
+{
+   if (expr->getExprNodeNameEnum() != NameVarNode)
+      return false;
+
+   VarNode* var = static_cast<VarNode*>(expr);
+   if (var->arrayIndex || var->varName[0] == '$')
+      return false;
+
+   U32 fusedOperand;
+   switch (operand)
+   {
+   case OP_ADD:   fusedOperand = OP_ADD_LOCAL_FLT;   break;
+   case OP_SUB:   fusedOperand = OP_SUB_LOCAL_FLT;   break;
+   case OP_MUL:   fusedOperand = OP_MUL_LOCAL_FLT;   break;
+   case OP_DIV:   fusedOperand = OP_DIV_LOCAL_FLT;   break;
+   case OP_CMPEQ: fusedOperand = OP_CMPEQ_LOCAL_FLT; break;
+   case OP_CMPGR: fusedOperand = OP_CMPGR_LOCAL_FLT; break;
+   case OP_CMPGE: fusedOperand = OP_CMPGE_LOCAL_FLT; break;
+   case OP_CMPLT: fusedOperand = OP_CMPLT_LOCAL_FLT; break;
+   case OP_CMPLE: fusedOperand = OP_CMPLE_LOCAL_FLT; break;
+   case OP_CMPNE: fusedOperand = OP_CMPNE_LOCAL_FLT; break;
+   default:
+      return false;
+   }
+
+   precompileIdent(var->varName);
+
+   codeStream.emit(fusedOperand);
+   codeStream.emit(getFuncVars(var->dbgLineNumber)->lookup(var->varName, var->dbgLineNumber));
+   return true;
+}
+
 //-----------------------------------------------------------------------------
 
 void StmtNode::addBreakLine(CodeStream& code)
@@ -220,15 +264,15 @@ U32 IfStmtNode::compileStmt(CodeStream& codeStream, U32 ip)
       endifIp = codeStream.emit(0);
       endifOffset = compileBlock(elseBlock, codeStream, ip);
 
-      codeStream.patch(endifIp, endifOffset);
-      codeStream.patch(elseIp, elseOffset);
+      codeStream.patchJump(endifIp, endifOffset);
+      codeStream.patchJump(elseIp, elseOffset);
    }
    else
    {
       endifIp = codeStream.emit(0);
       endifOffset = compileBlock(ifBlock, codeStream, ip);
 
-      codeStream.patch(endifIp, endifOffset);
+      codeStream.patchJump(endifIp, endifOffset);
    }
 
    // Resolve fixes
@@ -385,9 +429,9 @@ U32 ConditionalExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
    ip = trueExpr->compile(codeStream, ip, type);
    codeStream.emit(OP_JMP);
    U32 jumpEndIp = codeStream.emit(0);
-   codeStream.patch(jumpElseIp, codeStream.tell());
+   codeStream.patchJump(jumpElseIp, codeStream.tell());
    ip = falseExpr->compile(codeStream, ip, type);
-   codeStream.patch(jumpEndIp, codeStream.tell());
+   codeStream.patchJump(jumpEndIp, codeStream.tell());
 
    return codeStream.tell();
 }
@@ -412,8 +456,6 @@ U32 FloatBinaryExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
       return codeStream.tell();
    }
 
-   ip = right->compile(codeStream, ip, TypeReqFloat);
-   ip = left->compile(codeStream, ip, TypeReqFloat);
    U32 operand = OP_INVALID;
    switch (op)
    {
@@ -430,7 +472,16 @@ U32 FloatBinaryExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
       operand = OP_MUL;
       break;
    }
-   codeStream.emit(operand);
+
+   ip = right->compile(codeStream, ip, TypeReqFloat);
+
+   // The left operand is evaluated last, so a local on the left can be
+   // loaded by the operation itself.
+   if (!compileLocalFloatOp(codeStream, left, operand))
+   {
+      ip = left->compile(codeStream, ip, TypeReqFloat);
+      codeStream.emit(operand);
+   }
    return codeStream.tell();
 }
 
@@ -500,7 +551,10 @@ void IntBinaryExprNode::getSubTypeOperand()
 U32 IntBinaryExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
 {
    if (optimize())
-      right = optimizedNode;
+   {
+      ip = optimizedNode->compile(codeStream, ip, type);
+      return codeStream.tell();
+   }
 
    getSubTypeOperand();
 
@@ -510,13 +564,16 @@ U32 IntBinaryExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
       codeStream.emit(operand == OP_OR ? OP_JMPIF_NP : OP_JMPIFNOT_NP);
       U32 jmpIp = codeStream.emit(0);
       ip = right->compile(codeStream, ip, subType);
-      codeStream.patch(jmpIp, ip);
+      codeStream.patchJump(jmpIp, ip);
    }
    else
    {
       ip = right->compile(codeStream, ip, subType);
-      ip = left->compile(codeStream, ip, subType);
-      codeStream.emit(operand);
+      if (subType != TypeReqFloat || !compileLocalFloatOp(codeStream, left, operand))
+      {
+         ip = left->compile(codeStream, ip, subType);
+         codeStream.emit(operand);
+      }
    }
    return codeStream.tell();
 }
@@ -553,6 +610,12 @@ TypeReq StreqExprNode::getPreferredType()
 
 U32 StrcatExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
 {
+   if (optimize())
+   {
+      ip = optimizedNode->compile(codeStream, ip, type);
+      return codeStream.tell();
+   }
+
    ip = left->compile(codeStream, ip, TypeReqString);
    if (appendChar)
    {
@@ -597,6 +660,12 @@ TypeReq CommaCatExprNode::getPreferredType()
 
 U32 IntUnaryExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
 {
+   if (optimize())
+   {
+      ip = optimizedNode->compile(codeStream, ip, type);
+      return codeStream.tell();
+   }
+
    integer = true;
    TypeReq prefType = expr->getPreferredType();
    if (op == '!' && (prefType == TypeReqFloat || prefType == TypeReqString))
@@ -644,31 +713,30 @@ U32 VarNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
    // OP_SETCURVAR_ARRAY
    // OP_LOADVAR (type)
 
-   // else
-   // OP_SETCURVAR
+   // else if this is a global...
+   // OP_SETCURVAR_LOADVAR (type)
    // varName
-   // OP_LOADVAR (type)
+
+   // else
+   // OP_LOAD_LOCAL_VAR (type)
+   // register
 
    if (type == TypeReqNone)
       return codeStream.tell();
 
    precompileIdent(varName);
 
-   bool oldVariables = arrayIndex || varName[0] == '$';
-
-   if (oldVariables)
+   if (arrayIndex)
    {
-      codeStream.emit(arrayIndex ? OP_LOADIMMED_IDENT : OP_SETCURVAR);
+      codeStream.emit(OP_LOADIMMED_IDENT);
       codeStream.emitSTE(varName);
 
-      if (arrayIndex)
-      {
-         //codeStream.emit(OP_ADVANCE_STR);
-         ip = arrayIndex->compile(codeStream, ip, TypeReqString);
-         codeStream.emit(OP_REWIND_STR);
-         codeStream.emit(OP_SETCURVAR_ARRAY);
-         codeStream.emit(OP_POP_STK);
-      }
+      //codeStream.emit(OP_ADVANCE_STR);
+      ip = arrayIndex->compile(codeStream, ip, TypeReqString);
+      codeStream.emit(OP_REWIND_STR);
+      codeStream.emit(OP_SETCURVAR_ARRAY);
+      codeStream.emit(OP_POP_STK);
+
       switch (type)
       {
       case TypeReqUInt:
@@ -686,6 +754,17 @@ U32 VarNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
          break;
       }
    }
+   else if (varName[0] == '$')
+   {
+      switch (type)
+      {
+      case TypeReqUInt:   codeStream.emit(OP_SETCURVAR_LOADVAR_UINT); break;
+      case TypeReqFloat:  codeStream.emit(OP_SETCURVAR_LOADVAR_FLT); break;
+      case TypeReqString: codeStream.emit(OP_SETCURVAR_LOADVAR_STR); break;
+      default:            codeStream.emit(OP_SETCURVAR);
+      }
+      codeStream.emitSTE(varName);
+   }
    else
    {
       switch (type)
@@ -873,6 +952,93 @@ TypeReq ConstantNode::getPreferredType()
 
 //------------------------------------------------------------
 
+/// Returns true if evaluating the expression can neither read nor write the
+/// given local variable. Unknown node types are assumed to touch it.
+static bool isIndependentOf(ExprNode* node, StringTableEntry varName)
+{
+   switch (node->getExprNodeNameEnum())
+   {
+   case NameIntNode:
+   case NameFloatNode:
+   case NameStrConstNode:
+   case NameConstantNode:
+      return true;
+
+   case NameVarNode:
+   {
+      VarNode* var = static_cast<VarNode*>(node);
+      return var->varName != varName && (!var->arrayIndex || isIndependentOf(var->arrayIndex, varName));
+   }
+
+   case NameStrcatExprNode:
+   {
+      StrcatExprNode* cat = static_cast<StrcatExprNode*>(node);
+      return isIndependentOf(cat->left, varName) && isIndependentOf(cat->right, varName);
+   }
+
+   case NameFuncCallExprNode:
+   {
+      // The callee runs with its own locals, so only the arguments matter.
+      FuncCallExprNode* call = static_cast<FuncCallExprNode*>(node);
+      for (ExprNode* arg = call->args; arg; arg = (ExprNode*)arg->getNext())
+      {
+         if (!isIndependentOf(arg, varName))
+            return false;
+      }
+      return true;
+   }
+
+   default:
+      return false;
+   }
+}
+
+bool AssignExprNode::compileLocalAppend(CodeStream& codeStream, TypeReq type)
+{
+   // %s = %s @ a @ b parses as ((%s @ a) @ b), so walk down the left side of
+   // the chain to find the variable being appended to.
+   Vector<StrcatExprNode*> chain;
+   ExprNode* walk = expr;
+   while (walk->getExprNodeNameEnum() == NameStrcatExprNode)
+   {
+      StrcatExprNode* cat = static_cast<StrcatExprNode*>(walk);
+
+      // The pieces are appended one at a time, so none of them may look at
+      // the partially built string.
+      if (!isIndependentOf(cat->right, varName))
+         return false;
+
+      chain.push_back(cat);
+      walk = cat->left;
+   }
+
+   if (chain.empty() || walk->getExprNodeNameEnum() != NameVarNode)
+      return false;
+
+   VarNode* var = static_cast<VarNode*>(walk);
+   if (var->varName != varName || var->arrayIndex)
+      return false;
+
+   getFuncVars(var->dbgLineNumber)->lookup(varName, var->dbgLineNumber);
+   const S32 reg = getFuncVars(dbgLineNumber)->assign(varName, TypeReqString, dbgLineNumber);
+
+   for (S32 i = chain.size() - 1; i >= 0; i--)
+   {
+      chain[i]->right->compile(codeStream, codeStream.tell(), TypeReqString);
+      codeStream.emit(OP_APPEND_LOCAL_STR);
+      codeStream.emit(reg);
+      codeStream.emit(chain[i]->appendChar);
+   }
+
+   if (type != TypeReqNone)
+   {
+      codeStream.emit(OP_LOAD_LOCAL_VAR_STR);
+      codeStream.emit(reg);
+   }
+
+   return true;
+}
+
 U32 AssignExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
 {
    subType = expr->getPreferredType();
@@ -899,12 +1065,23 @@ U32 AssignExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
    // varname
    // OP_SAVEVAR
 
-   precompileIdent(varName);
+   // or, for a local string being appended to (%var = %var @ a @ b)
+   // eval a
+   // OP_APPEND_LOCAL_STR
+   // register
+   // appendChar
+   // eval b
+   // ...
 
-   ip = expr->compile(codeStream, ip, subType);
+   precompileIdent(varName);
 
    bool oldVariables = arrayIndex || varName[0] == '$';
 
+   if (!oldVariables && isOptimizeLevel(1) && compileLocalAppend(codeStream, type))
+      return codeStream.tell();
+
+   ip = expr->compile(codeStream, ip, subType);
+
    if (oldVariables)
    {
       if (arrayIndex)
@@ -934,6 +1111,13 @@ U32 AssignExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
       case TypeReqFloat:  codeStream.emit(OP_SAVEVAR_FLT);  break;
       }
    }
+   else if (type == TypeReqNone && isOptimizeLevel(2) && isInFunctionBody() && !getFuncVars(dbgLineNumber)->isLocalRead(varName))
+   {
+      // Nothing in the function body reads the variable, so the value is only
+      // evaluated for its side effects and popped below.  Only done in
+      // function bodies; outside of them a later compile may read it.
+      getFuncVars(dbgLineNumber)->assign(varName, subType, dbgLineNumber);
+   }
    else
    {
       switch (subType)
@@ -1139,6 +1323,7 @@ U32 FuncCallExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
    // function
    // namespace
    // isDot
+   // call site cache index
 
    precompileIdent(funcName);
    precompileIdent(nameSpace);
@@ -1164,6 +1349,7 @@ U32 FuncCallExprNode::compile(CodeStream& codeStream, U32 ip, TypeReq type)
    codeStream.emitSTE(funcName);
    codeStream.emitSTE(nameSpace);
    codeStream.emit(callType);
+   codeStream.emit(codeStream.allocCallSite());
 
    if (type == TypeReqNone)
       codeStream.emit(OP_POP_STK);
@@ -1500,6 +1686,7 @@ U32 FunctionDeclStmtNode::compileStmt(CodeStream& codeStream, U32 ip)
    setCurrentFloatTable(&getFunctionFloatTable());
 
    FuncVars vars;
+   vars.setLocalReads(localReads, numLocalReads);
    gFuncVars = &vars;
 
    argc = 0;
@@ -59,6 +59,8 @@ CodeBlock::CodeBlock()
    fullPath = NULL;
    modPath = NULL;
    codeSize = 0;
+   callSiteCount = 0;
+   callSites = NULL;
    lineBreakPairCount = 0;
    nextFile = NULL;
 }
@@ -79,6 +81,7 @@ CodeBlock::~CodeBlock()
    delete[] globalFloats;
    delete[] functionFloats;
    delete[] code;
+   freeCallSites();
 }
 
 //-------------------------------------------------------------------------
@@ -451,6 +454,9 @@ bool CodeBlock::read(StringTableEntry fileName, Stream &st)
       }
    }
 
+   st.read(&callSiteCount);
+   allocCallSites();
+
    if (lineBreakPairCount)
       calcBreakList();
 
@@ -559,6 +565,7 @@ bool CodeBlock::compile(const char *codeFileName, StringTableEntry fileName, con
       st.write(code[i]);
 
    getIdentTable().write(st);
+   st.write(codeStream.getNumCallSites());
 
    consoleAllocReset();
    st.close();
@@ -650,6 +657,9 @@ Con::EvalResult CodeBlock::compileExec(StringTableEntry fileName, const char *in
    codeStream.emit(OP_RETURN_VOID);
    codeStream.emitCodeStream(&codeSize, &code, &lineBreakPairs);
 
+   callSiteCount = codeStream.getNumCallSites();
+   allocCallSites();
+
    S32 localRegisterCount = gIsEvalCompile ? gEvalFuncVars.count() : gGlobalScopeFuncVars.count();
 
    consoleAllocReset();
@@ -1251,6 +1261,7 @@ void CodeBlock::dumpInstructions(U32 startIp, bool upToReturn)
          StringTableEntry fnNamespace = CodeToSTE(code, ip + 2);
          StringTableEntry fnName = CodeToSTE(code, ip);
          U32 callType = code[ip + 4];
+         U32 callSite = code[ip + 5];
 
          StringTableEntry callTypeName;
          switch (callType)
@@ -1262,9 +1273,9 @@ void CodeBlock::dumpInstructions(U32 startIp, bool upToReturn)
          default:                             callTypeName = "INVALID"; break;
          }
 
-         Con::printf("%i: OP_CALLFUNC stk=+1 name=%s nspace=%s callType=%s", ip - 1, fnName, fnNamespace, callTypeName);
+         Con::printf("%i: OP_CALLFUNC stk=+1 name=%s nspace=%s callType=%s callSite=%i", ip - 1, fnName, fnNamespace, callTypeName, callSite);
 
-         ip += 5;
+         ip += 6;
          break;
       }
 
@@ -1389,6 +1400,110 @@ void CodeBlock::dumpInstructions(U32 startIp, bool upToReturn)
          break;
       }
 
+      case OP_SETCURVAR_LOADVAR_UINT:
+      {
+         StringTableEntry var = CodeToSTE(code, ip);
+
+         Con::printf("%i: OP_SETCURVAR_LOADVAR_UINT stk=+1 var=%s", ip - 1, var);
+         ip += 2;
+         break;
+      }
+
+      case OP_SETCURVAR_LOADVAR_FLT:
+      {
+         StringTableEntry var = CodeToSTE(code, ip);
+
+         Con::printf("%i: OP_SETCURVAR_LOADVAR_FLT stk=+1 var=%s", ip - 1, var);
+         ip += 2;
+         break;
+      }
+
+      case OP_SETCURVAR_LOADVAR_STR:
+      {
+         StringTableEntry var = CodeToSTE(code, ip);
+
+         Con::printf("%i: OP_SETCURVAR_LOADVAR_STR stk=+1 var=%s", ip - 1, var);
+         ip += 2;
+         break;
+      }
+
+      case OP_ADD_LOCAL_FLT:
+      {
+         Con::printf("%i: OP_ADD_LOCAL_FLT stk=0 reg=%i", ip - 1, code[ip]);
+         ++ip;
+         break;
+      }
+
+      case OP_SUB_LOCAL_FLT:
+      {
+         Con::printf("%i: OP_SUB_LOCAL_FLT stk=0 reg=%i", ip - 1, code[ip]);
+         ++ip;
+         break;
+      }
+
+      case OP_MUL_LOCAL_FLT:
+      {
+         Con::printf("%i: OP_MUL_LOCAL_FLT stk=0 reg=%i", ip - 1, code[ip]);
+         ++ip;
+         break;
+      }
+
+      case OP_DIV_LOCAL_FLT:
+      {
+         Con::printf("%i: OP_DIV_LOCAL_FLT stk=0 reg=%i", ip - 1, code[ip]);
+         ++ip;
+         break;
+      }
+
+      case OP_CMPEQ_LOCAL_FLT:
+      {
+         Con::printf("%i: OP_CMPEQ_LOCAL_FLT stk=0 reg=%i", ip - 1, code[ip]);
+         ++ip;
+         break;
+      }
+
+      case OP_CMPGR_LOCAL_FLT:
+      {
+         Con::printf("%i: OP_CMPGR_LOCAL_FLT stk=0 reg=%i", ip - 1, code[ip]);
+         ++ip;
+         break;
+      }
+
+      case OP_CMPGE_LOCAL_FLT:
+      {
+         Con::printf("%i: OP_CMPGE_LOCAL_FLT stk=0 reg=%i", ip - 1, code[ip]);
+         ++ip;
+         break;
+      }
+
+      case OP_CMPLT_LOCAL_FLT:
+      {
+         Con::printf("%i: OP_CMPLT_LOCAL_FLT stk=0 reg=%i", ip - 1, code[ip]);
+         ++ip;
+         break;
+      }
+
+      case OP_CMPLE_LOCAL_FLT:
+      {
+         Con::printf("%i: OP_CMPLE_LOCAL_FLT stk=0 reg=%i", ip - 1, code[ip]);
+         ++ip;
+         break;
+      }
+
+      case OP_CMPNE_LOCAL_FLT:
+      {
+         Con::printf("%i: OP_CMPNE_LOCAL_FLT stk=0 reg=%i", ip - 1, code[ip]);
+         ++ip;
+         break;
+      }
+
+      case OP_APPEND_LOCAL_STR:
+      {
+         Con::printf("%i: OP_APPEND_LOCAL_STR stk=-1 reg=%i appendChar=%i", ip - 1, code[ip], code[ip + 1]);
+         ip += 2;
+         break;
+      }
+
       default:
          Con::printf("%i: !!INVALID!!", ip - 1);
          break;
@@ -49,6 +49,7 @@ struct CompilerLocalVariableToRegisterMappingTable
 
 class Stream;
 class ConsoleValue;
+struct CallSiteCache;
 
 /// Core TorqueScript code management class.
 ///
@@ -88,6 +89,11 @@ public:
    U32 codeSize;
    U32 *code;
 
+   /// Inline caches of the OP_CALLFUNC sites in code, indexed by the
+   /// instruction's last operand.
+   U32 callSiteCount;
+   CallSiteCache *callSites;
+
    CompilerLocalVariableToRegisterMappingTable variableRegisterTable;
 
    U32 refCount;
@@ -103,6 +109,10 @@ public:
    void setAllBreaks() override;
    void dumpInstructions(U32 startIp = 0, bool upToReturn = false);
 
+   /// Allocate empty inline caches for callSiteCount call sites.
+   void allocCallSites();
+   void freeCallSites();
+
    /// Returns the first breakable line or 0 if none was found.
    /// @param lineNumber The one based line number.
    U32 findFirstBreakLine(U32 lineNumber) override;
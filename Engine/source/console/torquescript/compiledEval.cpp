@@ -100,6 +100,83 @@ struct IterStackRecord
    } mData;
 };
 
+/// Inline cache of an OP_CALLFUNC site.
+///
+/// Remembers the entries the call resolved to for the last few namespaces it
+/// was made on so that hot call sites skip the namespace hash probe.  Method
+/// calls on objects of different classes each get an entry of their own.
+/// Everything is dropped once Namespace::mCacheSequence moves on, which
+/// happens whenever a function is defined, a package is (de)activated or a
+/// namespace is relinked; i.e. exactly when Namespace::lookup() rebuilds its
+/// hash tables.
+struct CallSiteCache
+{
+   enum { NumEntries = 4 };
+
+   U32 sequence;
+   U32 numEntries;
+   U32 nextEntry;
+
+   Namespace* namespaces[NumEntries];
+   Namespace::Entry* entries[NumEntries];
+
+   /// Return true if the cache holds entries from the current sequence.
+   bool isValid() const
+   {
+      return sequence == Namespace::mCacheSequence && numEntries > 0;
+   }
+
+   /// Look up fnName in ns, going through the cache.
+   Namespace::Entry* lookup(Namespace* ns, StringTableEntry fnName)
+   {
+      if (sequence != Namespace::mCacheSequence)
+      {
+         sequence = Namespace::mCacheSequence;
+         numEntries = 0;
+         nextEntry = 0;
+      }
+
+      for (U32 i = 0; i < numEntries; i++)
+      {
+         if (namespaces[i] == ns)
+            return entries[i];
+      }
+
+      Namespace::Entry* entry = ns->lookup(fnName);
+
+      // Fill up, then replace round robin.
+      U32 index;
+      if (numEntries < NumEntries)
+         index = numEntries++;
+      else
+      {
+         index = nextEntry;
+         nextEntry = (nextEntry + 1) % NumEntries;
+      }
+
+      namespaces[index] = ns;
+      entries[index] = entry;
+      return entry;
+   }
+};
+
+void CodeBlock::allocCallSites()
+{
+   freeCallSites();
+
+   if (callSiteCount)
+   {
+      callSites = (CallSiteCache*)dMalloc(sizeof(CallSiteCache) * callSiteCount);
+      dMemset(callSites, 0, sizeof(CallSiteCache) * callSiteCount);
+   }
+}
+
+void CodeBlock::freeCallSites()
+{
+   dFree(callSites);
+   callSites = NULL;
+}
+
 ConsoleValueStack<4096> gCallStack;
 
 StringStack STR;
@@ -471,6 +548,50 @@ TORQUE_FORCEINLINE void doFloatMathOperation()
    }
 }
 
+/// Body of the OP_*_LOCAL_FLT superinstructions. Behaves exactly like an
+/// OP_LOAD_LOCAL_VAR_FLT of the register followed by the math opcode, but
+/// works on the value in place instead of pushing it first.
+template<FloatOperation Op>
+TORQUE_FORCEINLINE void doLocalFloatMathOperation(S32 reg)
+{
+   ConsoleValue& b = stack[_STK];
+
+   if (b.getType() == ConsoleValueType::cvFloat)
+   {
+      const F64 a = Script::gEvalState.getLocalFloatVariable(reg);
+
+      // Arithmetic
+      if constexpr (Op == FloatOperation::Add)
+         b.setFastFloat(a + b.getFastFloat());
+      if constexpr (Op == FloatOperation::Sub)
+         b.setFastFloat(a - b.getFastFloat());
+      if constexpr (Op == FloatOperation::Mul)
+         b.setFastFloat(a * b.getFastFloat());
+      if constexpr (Op == FloatOperation::Div)
+         b.setFastFloat(a / b.getFastFloat());
+
+      // Logical
+      if constexpr (Op == FloatOperation::LT)
+         b.setFastInt(a < b.getFastFloat());
+      if constexpr (Op == FloatOperation::LE)
+         b.setFastInt(a <= b.getFastFloat());
+      if constexpr (Op == FloatOperation::GR)
+         b.setFastInt(a > b.getFastFloat());
+      if constexpr (Op == FloatOperation::GE)
+         b.setFastInt(a >= b.getFastFloat());
+      if constexpr (Op == FloatOperation::EQ)
+         b.setFastInt(a == b.getFastFloat());
+      if constexpr (Op == FloatOperation::NE)
+         b.setFastInt(a != b.getFastFloat());
+   }
+   else
+   {
+      stack[_STK + 1].setFloat(Script::gEvalState.getLocalFloatVariable(reg));
+      _STK++;
+      doSlowMathOp<Op>();
+   }
+}
+
 //-----------------------------------------------------------------------------
 
 enum class IntegerOperation
@@ -548,6 +669,45 @@ TORQUE_FORCEINLINE void doIntOperation()
 
 //-----------------------------------------------------------------------------
 
+// GCC and Clang can take the address of a label, which lets the interpreter
+// jump straight from the end of one instruction to the handler of the next
+// (threaded code) rather than bouncing through the top of the switch. Every
+// handler then gets its own indirect branch, which predicts much better than
+// the single shared one. Other compilers, or builds that define
+// TORQUE_SCRIPT_NO_COMPUTED_GOTO, use the plain switch.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(TORQUE_SCRIPT_NO_COMPUTED_GOTO)
+#define TORQUE_SCRIPT_COMPUTED_GOTO
+#endif
+
+/// The opcodes with a threaded handler. These are the small, hot instructions;
+/// everything else is still reached through the switch in either mode.
+#define TORQUE_SCRIPT_THREADED_OPS(X) \
+   X(OP_JMPIFFNOT) X(OP_JMPIFNOT) X(OP_JMPIFF) X(OP_JMPIF) X(OP_JMPIFNOT_NP) X(OP_JMPIF_NP) X(OP_JMP) \
+   X(OP_CMPEQ) X(OP_CMPGR) X(OP_CMPGE) X(OP_CMPLT) X(OP_CMPLE) X(OP_CMPNE) \
+   X(OP_XOR) X(OP_BITAND) X(OP_BITOR) X(OP_NOT) X(OP_NOTF) X(OP_ONESCOMPLEMENT) \
+   X(OP_SHR) X(OP_SHL) X(OP_AND) X(OP_OR) \
+   X(OP_ADD) X(OP_SUB) X(OP_MUL) X(OP_DIV) X(OP_MOD) X(OP_NEG) X(OP_INC) \
+   X(OP_SETCURVAR) X(OP_SETCURVAR_CREATE) \
+   X(OP_LOADVAR_UINT) X(OP_LOADVAR_FLT) X(OP_LOADVAR_STR) \
+   X(OP_SAVEVAR_UINT) X(OP_SAVEVAR_FLT) X(OP_SAVEVAR_STR) \
+   X(OP_LOAD_LOCAL_VAR_UINT) X(OP_LOAD_LOCAL_VAR_FLT) X(OP_LOAD_LOCAL_VAR_STR) \
+   X(OP_SAVE_LOCAL_VAR_UINT) X(OP_SAVE_LOCAL_VAR_FLT) X(OP_SAVE_LOCAL_VAR_STR) \
+   X(OP_POP_STK) X(OP_LOADIMMED_UINT) X(OP_LOADIMMED_FLT) X(OP_LOADIMMED_STR) \
+   X(OP_SETCURVAR_LOADVAR_UINT) X(OP_SETCURVAR_LOADVAR_FLT) X(OP_SETCURVAR_LOADVAR_STR) \
+   X(OP_ADD_LOCAL_FLT) X(OP_SUB_LOCAL_FLT) X(OP_MUL_LOCAL_FLT) X(OP_DIV_LOCAL_FLT) \
+   X(OP_CMPEQ_LOCAL_FLT) X(OP_CMPGR_LOCAL_FLT) X(OP_CMPGE_LOCAL_FLT) \
+   X(OP_CMPLT_LOCAL_FLT) X(OP_CMPLE_LOCAL_FLT) X(OP_CMPNE_LOCAL_FLT) \
+   X(OP_APPEND_LOCAL_STR)
+
+#ifdef TORQUE_SCRIPT_COMPUTED_GOTO
+#define OPCODE(op) case op: lbl_##op
+#define DISPATCH_INSTRUCTION() goto *(instruction < MAX_OP_CODELEN ? dispatchTable[instruction] : &&dispatchSwitch)
+#define NEXT_INSTRUCTION instruction = code[ip++]; DISPATCH_INSTRUCTION()
+#else
+#define OPCODE(op) case op
+#define NEXT_INSTRUCTION break
+#endif
+
 U32 gExecCount = 0;
 Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thisNamespace, U32 argc, ConsoleValue* argv, bool noCalls, StringTableEntry packageName, S32 setFrame)
 {
@@ -705,9 +865,30 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
    static S32 VAL_BUFFER_SIZE = 1024;
    FrameTemp<char> valBuffer(VAL_BUFFER_SIZE);
 
+#ifdef TORQUE_SCRIPT_COMPUTED_GOTO
+   // Anything without a threaded handler is routed into the switch.
+   static void* dispatchTable[MAX_OP_CODELEN];
+   static bool dispatchTableInitialized = false;
+   if (!dispatchTableInitialized)
+   {
+      for (U32 i = 0; i < MAX_OP_CODELEN; i++)
+         dispatchTable[i] = &&dispatchSwitch;
+
+#define SET_THREADED_OP(op) dispatchTable[op] = &&lbl_##op;
+      TORQUE_SCRIPT_THREADED_OPS(SET_THREADED_OP)
+#undef SET_THREADED_OP
+
+      dispatchTableInitialized = true;
+   }
+#endif
+
    for (;;)
    {
       U32 instruction = code[ip++];
+#ifdef TORQUE_SCRIPT_COMPUTED_GOTO
+      DISPATCH_INSTRUCTION();
+   dispatchSwitch:
+#endif
    breakContinue:
       switch (instruction)
       {
@@ -1130,39 +1311,39 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          break;
       }
 
-      case OP_JMPIFFNOT:
+      OPCODE(OP_JMPIFFNOT):
          if (stack[_STK--].getFloat())
          {
             ip++;
             break;
          }
          ip = code[ip];
-         break;
-      case OP_JMPIFNOT:
+         NEXT_INSTRUCTION;
+      OPCODE(OP_JMPIFNOT):
          if (stack[_STK--].getInt())
          {
             ip++;
             break;
          }
          ip = code[ip];
-         break;
-      case OP_JMPIFF:
+         NEXT_INSTRUCTION;
+      OPCODE(OP_JMPIFF):
          if (!stack[_STK--].getFloat())
          {
             ip++;
             break;
          }
          ip = code[ip];
-         break;
-      case OP_JMPIF:
+         NEXT_INSTRUCTION;
+      OPCODE(OP_JMPIF):
          if (!stack[_STK--].getFloat())
          {
             ip++;
             break;
          }
          ip = code[ip];
-         break;
-      case OP_JMPIFNOT_NP:
+         NEXT_INSTRUCTION;
+      OPCODE(OP_JMPIFNOT_NP):
          if (stack[_STK].getInt())
          {
             _STK--;
@@ -1170,8 +1351,8 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
             break;
          }
          ip = code[ip];
-         break;
-      case OP_JMPIF_NP:
+         NEXT_INSTRUCTION;
+      OPCODE(OP_JMPIF_NP):
          if (!stack[_STK].getInt())
          {
             _STK--;
@@ -1179,10 +1360,10 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
             break;
          }
          ip = code[ip];
-         break;
-      case OP_JMP:
+         NEXT_INSTRUCTION;
+      OPCODE(OP_JMP):
          ip = code[ip];
-         break;
+         NEXT_INSTRUCTION;
 
       case OP_RETURN_VOID:
       {
@@ -1249,87 +1430,87 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
 
          goto execFinished;
 
-      case OP_CMPEQ:
+      OPCODE(OP_CMPEQ):
          doFloatMathOperation<FloatOperation::EQ>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_CMPGR:
+      OPCODE(OP_CMPGR):
          doFloatMathOperation<FloatOperation::GR>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_CMPGE:
+      OPCODE(OP_CMPGE):
          doFloatMathOperation<FloatOperation::GE>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_CMPLT:
+      OPCODE(OP_CMPLT):
          doFloatMathOperation<FloatOperation::LT>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_CMPLE:
+      OPCODE(OP_CMPLE):
          doFloatMathOperation<FloatOperation::LE>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_CMPNE:
+      OPCODE(OP_CMPNE):
          doFloatMathOperation<FloatOperation::NE>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_XOR:
+      OPCODE(OP_XOR):
          doIntOperation<IntegerOperation::Xor>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_BITAND:
+      OPCODE(OP_BITAND):
          doIntOperation<IntegerOperation::BitAnd>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_BITOR:
+      OPCODE(OP_BITOR):
          doIntOperation<IntegerOperation::BitOr>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_NOT:
+      OPCODE(OP_NOT):
          stack[_STK].setBool(!stack[_STK].getInt());
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_NOTF:
+      OPCODE(OP_NOTF):
          stack[_STK].setInt(!stack[_STK].getFloat());
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_ONESCOMPLEMENT:
+      OPCODE(OP_ONESCOMPLEMENT):
          stack[_STK].setInt(~stack[_STK].getInt());
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SHR:
+      OPCODE(OP_SHR):
          doIntOperation<IntegerOperation::RShift>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SHL:
+      OPCODE(OP_SHL):
          doIntOperation<IntegerOperation::LShift>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_AND:
+      OPCODE(OP_AND):
          doIntOperation<IntegerOperation::LogicalAnd>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_OR:
+      OPCODE(OP_OR):
          doIntOperation<IntegerOperation::LogicalOr>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_ADD:
+      OPCODE(OP_ADD):
          doFloatMathOperation<FloatOperation::Add>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SUB:
+      OPCODE(OP_SUB):
          doFloatMathOperation<FloatOperation::Sub>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_MUL:
+      OPCODE(OP_MUL):
          doFloatMathOperation<FloatOperation::Mul>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_DIV:
+      OPCODE(OP_DIV):
          doFloatMathOperation<FloatOperation::Div>();
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_MOD:
+      OPCODE(OP_MOD):
       {
          S64 divisor = stack[_STK - 1].getInt();
          if (divisor != 0)
@@ -1337,20 +1518,20 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          else
             stack[_STK - 1].setInt(0);
          _STK--;
-         break;
+         NEXT_INSTRUCTION;
       }
 
-      case OP_NEG:
+      OPCODE(OP_NEG):
          stack[_STK].setFloat(-stack[_STK].getFloat());
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_INC:
+      OPCODE(OP_INC):
          reg = code[ip++];
          currentRegister = reg;
          Script::gEvalState.setLocalFloatVariable(reg, Script::gEvalState.getLocalFloatVariable(reg) + 1.0);
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SETCURVAR:
+      OPCODE(OP_SETCURVAR):
          var = CodeToSTE(code, ip);
          ip += 2;
 
@@ -1372,9 +1553,9 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          // won't inappropriately carry forward to following function decls.
          curFNDocBlock = NULL;
          curNSDocBlock = NULL;
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SETCURVAR_CREATE:
+      OPCODE(OP_SETCURVAR_CREATE):
          var = CodeToSTE(code, ip);
          ip += 2;
 
@@ -1392,7 +1573,7 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          // See OP_SETCURVAR for why we do this.
          curFNDocBlock = NULL;
          curNSDocBlock = NULL;
-         break;
+         NEXT_INSTRUCTION;
 
       case OP_SETCURVAR_ARRAY:
          var = StringTable->insert(stack[_STK].getString());
@@ -1432,37 +1613,37 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          curNSDocBlock = NULL;
          break;
 
-      case OP_LOADVAR_UINT:
+      OPCODE(OP_LOADVAR_UINT):
          currentRegister = -1;
          stack[_STK + 1].setInt(Script::gEvalState.getIntVariable());
          _STK++;
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_LOADVAR_FLT:
+      OPCODE(OP_LOADVAR_FLT):
          currentRegister = -1;
          stack[_STK + 1].setFloat(Script::gEvalState.getFloatVariable());
          _STK++;
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_LOADVAR_STR:
+      OPCODE(OP_LOADVAR_STR):
          currentRegister = -1;
          stack[_STK + 1].setString(Script::gEvalState.getStringVariable());
          _STK++;
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SAVEVAR_UINT:
+      OPCODE(OP_SAVEVAR_UINT):
          Script::gEvalState.setIntVariable(stack[_STK].getInt());
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SAVEVAR_FLT:
+      OPCODE(OP_SAVEVAR_FLT):
          Script::gEvalState.setFloatVariable(stack[_STK].getFloat());
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SAVEVAR_STR:
+      OPCODE(OP_SAVEVAR_STR):
          Script::gEvalState.setStringVariable(stack[_STK].getString());
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_LOAD_LOCAL_VAR_UINT:
+      OPCODE(OP_LOAD_LOCAL_VAR_UINT):
          reg = code[ip++];
          currentRegister = reg;
 
@@ -1473,9 +1654,9 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
 
          stack[_STK + 1].setInt(Script::gEvalState.getLocalIntVariable(reg));
          _STK++;
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_LOAD_LOCAL_VAR_FLT:
+      OPCODE(OP_LOAD_LOCAL_VAR_FLT):
          reg = code[ip++];
          currentRegister = reg;
 
@@ -1486,9 +1667,9 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
 
          stack[_STK + 1].setFloat(Script::gEvalState.getLocalFloatVariable(reg));
          _STK++;
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_LOAD_LOCAL_VAR_STR:
+      OPCODE(OP_LOAD_LOCAL_VAR_STR):
          reg = code[ip++];
          currentRegister = reg;
 
@@ -1500,9 +1681,9 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          val = Script::gEvalState.getLocalStringVariable(reg);
          stack[_STK + 1].setString(val);
          _STK++;
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SAVE_LOCAL_VAR_UINT:
+      OPCODE(OP_SAVE_LOCAL_VAR_UINT):
          reg = code[ip++];
          currentRegister = reg;
 
@@ -1512,9 +1693,9 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          curObject = NULL;
 
          Script::gEvalState.setLocalIntVariable(reg, stack[_STK].getInt());
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SAVE_LOCAL_VAR_FLT:
+      OPCODE(OP_SAVE_LOCAL_VAR_FLT):
          reg = code[ip++];
          currentRegister = reg;
 
@@ -1524,9 +1705,9 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          curObject = NULL;
 
          Script::gEvalState.setLocalFloatVariable(reg, stack[_STK].getFloat());
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_SAVE_LOCAL_VAR_STR:
+      OPCODE(OP_SAVE_LOCAL_VAR_STR):
          reg = code[ip++];
          val = stack[_STK].getString();
          currentRegister = reg;
@@ -1537,7 +1718,194 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          curObject = NULL;
 
          Script::gEvalState.setLocalStringVariable(reg, val, (S32)dStrlen(val));
-         break;
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_SETCURVAR_LOADVAR_UINT):
+         var = CodeToSTE(code, ip);
+         ip += 2;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+         currentRegister = -1;
+         Script::gEvalState.setCurVarName(var);
+         curFNDocBlock = NULL;
+         curNSDocBlock = NULL;
+
+         stack[_STK + 1].setInt(Script::gEvalState.getIntVariable());
+         _STK++;
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_SETCURVAR_LOADVAR_FLT):
+         var = CodeToSTE(code, ip);
+         ip += 2;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+         currentRegister = -1;
+         Script::gEvalState.setCurVarName(var);
+         curFNDocBlock = NULL;
+         curNSDocBlock = NULL;
+
+         stack[_STK + 1].setFloat(Script::gEvalState.getFloatVariable());
+         _STK++;
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_SETCURVAR_LOADVAR_STR):
+         var = CodeToSTE(code, ip);
+         ip += 2;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+         currentRegister = -1;
+         Script::gEvalState.setCurVarName(var);
+         curFNDocBlock = NULL;
+         curNSDocBlock = NULL;
+
+         stack[_STK + 1].setString(Script::gEvalState.getStringVariable());
+         _STK++;
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_ADD_LOCAL_FLT):
+         reg = code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         doLocalFloatMathOperation<FloatOperation::Add>(reg);
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_SUB_LOCAL_FLT):
+         reg = code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         doLocalFloatMathOperation<FloatOperation::Sub>(reg);
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_MUL_LOCAL_FLT):
+         reg = code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         doLocalFloatMathOperation<FloatOperation::Mul>(reg);
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_DIV_LOCAL_FLT):
+         reg = code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         doLocalFloatMathOperation<FloatOperation::Div>(reg);
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_CMPEQ_LOCAL_FLT):
+         reg = code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         doLocalFloatMathOperation<FloatOperation::EQ>(reg);
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_CMPGR_LOCAL_FLT):
+         reg = code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         doLocalFloatMathOperation<FloatOperation::GR>(reg);
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_CMPGE_LOCAL_FLT):
+         reg = code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         doLocalFloatMathOperation<FloatOperation::GE>(reg);
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_CMPLT_LOCAL_FLT):
+         reg = code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         doLocalFloatMathOperation<FloatOperation::LT>(reg);
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_CMPLE_LOCAL_FLT):
+         reg = code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         doLocalFloatMathOperation<FloatOperation::LE>(reg);
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_CMPNE_LOCAL_FLT):
+         reg = code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         doLocalFloatMathOperation<FloatOperation::NE>(reg);
+         NEXT_INSTRUCTION;
+
+      OPCODE(OP_APPEND_LOCAL_STR):
+      {
+         reg = code[ip++];
+         const char separator = (char)code[ip++];
+         currentRegister = reg;
+
+         // See OP_SETCURVAR
+         prevField = NULL;
+         prevObject = NULL;
+         curObject = NULL;
+
+         val = stack[_STK--].getString();
+         Script::gEvalState.appendLocalStringVariable(reg, val, (S32)dStrlen(val), separator);
+         NEXT_INSTRUCTION;
+      }
 
       case OP_SETCUROBJECT:
          // Save the previous object for parsing vector fields.
@@ -1687,19 +2055,19 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          }
          break;
 
-      case OP_POP_STK:
+      OPCODE(OP_POP_STK):
          _STK--;
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_LOADIMMED_UINT:
+      OPCODE(OP_LOADIMMED_UINT):
          stack[_STK + 1].setInt(code[ip++]);
          _STK++;
-         break;
+         NEXT_INSTRUCTION;
 
-      case OP_LOADIMMED_FLT:
+      OPCODE(OP_LOADIMMED_FLT):
          stack[_STK + 1].setFloat(curFloatTable[code[ip++]]);
          _STK++;
-         break;
+         NEXT_INSTRUCTION;
 
       case OP_TAG_TO_STR:
          code[ip - 1] = OP_LOADIMMED_STR;
@@ -1712,10 +2080,10 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          }
          TORQUE_CASE_FALLTHROUGH;
 
-      case OP_LOADIMMED_STR:
+      OPCODE(OP_LOADIMMED_STR):
          stack[_STK + 1].setString(curStringTable + code[ip++]);
          _STK ++;
-         break;
+         NEXT_INSTRUCTION;
 
       case OP_DOCBLOCK_STR:
       {
@@ -1763,6 +2131,7 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          fnName = CodeToSTE(code, ip);
          fnNamespace = CodeToSTE(code, ip + 2);
          U32 callType = code[ip + 4];
+         CallSiteCache& callSite = callSites[code[ip + 5]];
 
          //if this is called from inside a function, append the ip and codeptr
          if (!Script::gEvalState.stack.empty())
@@ -1771,7 +2140,7 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
             Script::gEvalState.getCurrentFrame().ip = ip - 1;
          }
 
-         ip += 5;
+         ip += 6;
          gCallStack.argvc(fnName, callArgc, &callArgv);
 
          if (callType == FuncCallExprNode::FunctionCall)
@@ -1780,12 +2149,12 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
             // activatePackage() is called, it swaps the namespaceEntry into the global namespace
             // (and reverts it when deactivatePackage is called). Method or Static related ones work
             // as expected, as the namespace is resolved on the fly.
-            nsEntry = Namespace::global()->lookup(fnName);
+            nsEntry = callSite.lookup(Namespace::global(), fnName);
             if (!nsEntry)
             {
                Con::warnf(ConsoleLogEntry::General,
                   "%s: Unable to find function %s",
-                  getFileLine(ip - 4), fnName);
+                  getFileLine(ip - 5), fnName);
 
                gCallStack.popFrame();
                stack[_STK + 1].setEmptyString();
@@ -1795,14 +2164,15 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          }
          else if (callType == FuncCallExprNode::StaticCall)
          {
-            // Try to look it up.
-            ns = Namespace::find(fnNamespace);
-            nsEntry = ns->lookup(fnName);
+            // Try to look it up.  The namespace of a static call never
+            // changes, so a valid cache already knows it.
+            ns = callSite.isValid() ? callSite.namespaces[0] : Namespace::find(fnNamespace);
+            nsEntry = callSite.lookup(ns, fnName);
             if (!nsEntry)
             {
                Con::warnf(ConsoleLogEntry::General,
                   "%s: Unable to find function %s%s%s",
-                  getFileLine(ip - 4), fnNamespace ? fnNamespace : "",
+                  getFileLine(ip - 5), fnNamespace ? fnNamespace : "",
                   fnNamespace ? "::" : "", fnName);
 
                gCallStack.popFrame();
@@ -1821,7 +2191,7 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
                Con::warnf(
                   ConsoleLogEntry::General,
                   "%s: Unable to find object: '%s' attempting to call function '%s'",
-                  getFileLine(ip - 6),
+                  getFileLine(ip - 7),
                   simObjectLookupValue.getString(),
                   fnName
                );
@@ -1834,7 +2204,7 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
 
             ns = thisObject->getNamespace();
             if (ns)
-               nsEntry = ns->lookup(fnName);
+               nsEntry = callSite.lookup(ns, fnName);
             else
                nsEntry = NULL;
          }
@@ -1848,7 +2218,7 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
                Con::warnf(
                   ConsoleLogEntry::General,
                   "%s: Unable to find object: '%s' attempting to call function '%s'",
-                  getFileLine(ip - 6),
+                  getFileLine(ip - 7),
                   simObjectLookupValue.getString(),
                   fnName
                );
@@ -1863,7 +2233,7 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
             {
                ns = thisNamespace->mParent;
                if (ns)
-                  nsEntry = ns->lookup(fnName);
+                  nsEntry = callSite.lookup(ns, fnName);
                else
                   nsEntry = NULL;
             }
@@ -1878,7 +2248,7 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
          {
             if (!noCalls)
             {
-               Con::warnf(ConsoleLogEntry::General, "%s: Unknown command %s.", getFileLine(ip - 4), fnName);
+               Con::warnf(ConsoleLogEntry::General, "%s: Unknown command %s.", getFileLine(ip - 5), fnName);
                if (callType == FuncCallExprNode::MethodCall)
                {
                   Con::warnf(ConsoleLogEntry::General, "  Object %s(%d) %s",
@@ -1909,8 +2279,8 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
             if ((nsEntry->mMinArgs && S32(callArgc) < nsEntry->mMinArgs) || (nsEntry->mMaxArgs && S32(callArgc) > nsEntry->mMaxArgs))
             {
                const char* nsName = ns ? ns->mName : "";
-               Con::warnf(ConsoleLogEntry::Script, "%s: %s::%s - wrong number of arguments.", getFileLine(ip - 4), nsName, fnName);
-               Con::warnf(ConsoleLogEntry::Script, "%s: usage: %s", getFileLine(ip - 4), nsEntry->mUsage);
+               Con::warnf(ConsoleLogEntry::Script, "%s: %s::%s - wrong number of arguments.", getFileLine(ip - 5), nsName, fnName);
+               Con::warnf(ConsoleLogEntry::Script, "%s: usage: %s", getFileLine(ip - 5), nsEntry->mUsage);
                gCallStack.popFrame();
                stack[_STK + 1].setEmptyString();
                _STK++;
@@ -1970,7 +2340,7 @@ Con::EvalResult CodeBlock::exec(U32 ip, const char* functionName, Namespace* thi
 
                   if (Con::getBoolVariable("$Con::warnVoidAssignment", true))
                   {
-                     Con::warnf(ConsoleLogEntry::General, "%s: Call to %s in %s uses result of void function call.", getFileLine(ip - 4), fnName, functionName);
+                     Con::warnf(ConsoleLogEntry::General, "%s: Call to %s in %s uses result of void function call.", getFileLine(ip - 5), fnName, functionName);
                   }
 
                   stack[_STK + 1].setEmptyString();
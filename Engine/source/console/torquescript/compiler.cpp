@@ -127,8 +127,38 @@ namespace Compiler
       gFuncVars = gIsEvalCompile ? &gEvalFuncVars : &gGlobalScopeFuncVars;
    }
 
+   /// Locals read by the nodes parsed since the last function declaration,
+   /// which takes them with takeLocalVarReads().
+   static Vector<StringTableEntry> gLocalVarReads;
+
    void *consoleAlloc(U32 size) { return gConsoleAllocator.alloc(size); }
-   void consoleAllocReset() { gConsoleAllocator.freeBlocks(); }
+   void consoleAllocReset()
+   {
+      gConsoleAllocator.freeBlocks();
+      gLocalVarReads.clear();
+   }
+
+   bool isOptimizeLevel(S32 level) { return gScriptOptimizeLevel >= level; }
+
+   void noteLocalVarRead(StringTableEntry varName)
+   {
+      if (varName[0] != '$')
+         gLocalVarReads.push_back_unique(varName);
+   }
+
+   U32 takeLocalVarReads(StringTableEntry** reads)
+   {
+      const U32 count = gLocalVarReads.size();
+      *reads = NULL;
+      if (count)
+      {
+         *reads = (StringTableEntry*)consoleAlloc(count * sizeof(StringTableEntry));
+         dMemcpy(*reads, gLocalVarReads.address(), count * sizeof(StringTableEntry));
+      }
+
+      gLocalVarReads.clear();
+      return count;
+   }
 
    void scriptErrorHandler(const char* str)
    {
@@ -209,6 +239,25 @@ void FuncVars::clear()
    vars.clear();
    variableNameMap.clear();
    counter = 0;
+   localReads = NULL;
+   numLocalReads = 0;
+}
+
+void FuncVars::setLocalReads(const StringTableEntry* reads, U32 count)
+{
+   localReads = reads;
+   numLocalReads = count;
+}
+
+bool FuncVars::isLocalRead(StringTableEntry var) const
+{
+   for (U32 i = 0; i < numLocalReads; i++)
+   {
+      if (localReads[i] == var)
+         return true;
+   }
+
+   return false;
 }
 
 //-------------------------------------------------------------------------
@@ -495,7 +544,7 @@ void CodeStream::fixLoop(U32 loopBlockStart, U32 breakPoint, U32 continuePoint)
 
       if (valid)
       {
-         patch(mFixList[i], fixedIp);
+         patchJump(mFixList[i], fixedIp);
       }
    }
 }
@@ -530,6 +579,22 @@ void CodeStream::emitCodeStream(U32 *size, U32 **stream, U32 **lineBreaks)
       PatchEntry &e = mPatchList[i];
       (*stream)[e.addr] = e.value;
    }
+
+   // Jump threading: a jump that lands on an OP_JMP can go straight to where
+   // that one ends up. This mostly collapses the chains of jumps-to-endif
+   // produced by nested if/else blocks. The hop limit guards against cycles.
+   if (isOptimizeLevel(1))
+   {
+      U32 *code = *stream;
+      for (U32 i = 0; i < mJumpList.size(); i++)
+      {
+         U32 target = code[mJumpList[i]];
+         for (U32 hops = 0; hops < 16 && target + 1 < mCodePos && code[target] == OP_JMP; hops++)
+            target = code[target + 1];
+
+         code[mJumpList[i]] = target;
+      }
+   }
 }
 
 //-------------------------------------------------------------------------
@@ -541,6 +606,7 @@ void CodeStream::reset()
    mFixLoopStack.clear();
    mFixList.clear();
    mBreakLines.clear();
+   mJumpList.clear();
 
    // Pop down to one code block
    CodeData *itr = mCode ? mCode->next : NULL;
@@ -165,7 +165,32 @@ namespace Compiler
       OP_ITER,             ///< Enter foreach loop.
       OP_ITER_END,         ///< End foreach loop.
 
-      OP_INVALID,   // 90
+      /// @name Superinstructions
+      ///
+      /// Fused forms of the most common opcode pairs, emitted by the compiler
+      /// so the interpreter pays for one dispatch instead of two.
+      /// @{
+
+      OP_SETCURVAR_LOADVAR_UINT, ///< OP_SETCURVAR + OP_LOADVAR_UINT
+      OP_SETCURVAR_LOADVAR_FLT,  ///< OP_SETCURVAR + OP_LOADVAR_FLT
+      OP_SETCURVAR_LOADVAR_STR,  ///< OP_SETCURVAR + OP_LOADVAR_STR
+
+      OP_ADD_LOCAL_FLT,    ///< OP_LOAD_LOCAL_VAR_FLT + OP_ADD
+      OP_SUB_LOCAL_FLT,    ///< OP_LOAD_LOCAL_VAR_FLT + OP_SUB
+      OP_MUL_LOCAL_FLT,    ///< OP_LOAD_LOCAL_VAR_FLT + OP_MUL
+      OP_DIV_LOCAL_FLT,    ///< OP_LOAD_LOCAL_VAR_FLT + OP_DIV
+      OP_CMPEQ_LOCAL_FLT,  ///< OP_LOAD_LOCAL_VAR_FLT + OP_CMPEQ
+      OP_CMPGR_LOCAL_FLT,  ///< OP_LOAD_LOCAL_VAR_FLT + OP_CMPGR
+      OP_CMPGE_LOCAL_FLT,  ///< OP_LOAD_LOCAL_VAR_FLT + OP_CMPGE
+      OP_CMPLT_LOCAL_FLT,  ///< OP_LOAD_LOCAL_VAR_FLT + OP_CMPLT
+      OP_CMPLE_LOCAL_FLT,  ///< OP_LOAD_LOCAL_VAR_FLT + OP_CMPLE
+      OP_CMPNE_LOCAL_FLT,  ///< OP_LOAD_LOCAL_VAR_FLT + OP_CMPNE
+
+      /// @}
+
+      OP_APPEND_LOCAL_STR, ///< Append to a local string in place (%s = %s @ x).
+
+      OP_INVALID,   // 101
 
       MAX_OP_CODELEN ///< The amount of op codes.
    };
@@ -279,6 +304,24 @@ namespace Compiler
 
    void scriptErrorHandler(const char* str);
 
+   /// @name Optimizer
+   /// @{
+
+   /// Returns true if optimizations of the given level should be applied,
+   /// according to $Con::optimizeLevel.
+   bool isOptimizeLevel(S32 level);
+
+   /// Records that a local variable is read by the code being parsed.
+   /// Called by the parser for every variable reference.
+   void noteLocalVarRead(StringTableEntry varName);
+
+   /// Hands the locals read since the last call to a function declaration
+   /// as an array in the console allocator and starts a new list.
+   /// @return The number of locals in the array.
+   U32 takeLocalVarReads(StringTableEntry** reads);
+
+   /// @}
+
    extern bool gSyntaxError;
    extern bool gIsEvalCompile;
 };
@@ -306,9 +349,19 @@ public:
 
    void clear();
 
+   /// Sets the locals read in the function body being compiled.
+   /// @see Compiler::takeLocalVarReads
+   void setLocalReads(const StringTableEntry* reads, U32 count);
+
+   /// Returns true if the function body reads the local; stores
+   /// to locals which are never read can be dropped.
+   bool isLocalRead(StringTableEntry var) const;
+
 private:
    std::unordered_map<StringTableEntry, Var> vars;
    S32 counter = 0;
+   const StringTableEntry* localReads = NULL;
+   U32 numLocalReads = 0;
 };
 
 /// Utility class to emit and patch bytecode
@@ -360,13 +413,16 @@ protected:
    Vector<U32> mFixStack;
    Vector<bool> mFixLoopStack;
    Vector<PatchEntry> mPatchList;
+   Vector<U32> mJumpList; ///< Addresses of patched jump targets
    /// }
 
    Vector<U32> mBreakLines; ///< Line numbers
 
+   U32 mNumCallSites; ///< Number of OP_CALLFUNC inline cache slots handed out
+
 public:
 
-   CodeStream() : mCode(0), mCodeHead(NULL), mCodePos(0)
+   CodeStream() : mCode(0), mCodeHead(NULL), mCodePos(0), mNumCallSites(0)
    {
    }
 
@@ -401,6 +457,14 @@ public:
       mPatchList.push_back(PatchEntry(addr, code));
    }
 
+   /// Patch the target of a jump instruction. Unlike plain patches, these are
+   /// known to be jump targets and may be threaded by emitCodeStream.
+   inline void patchJump(U32 addr, U32 target)
+   {
+      patch(addr, target);
+      mJumpList.push_back(addr);
+   }
+
    inline U32 emitSTE(const char *code)
    {
       U64 *ptr = (U64*)allocCode(8);
@@ -472,6 +536,17 @@ public:
       return mBreakLines.size() / 2;
    }
 
+   /// Reserve an inline cache slot for an OP_CALLFUNC.
+   inline U32 allocCallSite()
+   {
+      return mNumCallSites++;
+   }
+
+   inline U32 getNumCallSites()
+   {
+      return mNumCallSites;
+   }
+
    void emitCodeStream(U32 *size, U32 **stream, U32 **lineBreaks);
 
    void reset();
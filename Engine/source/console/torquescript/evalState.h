@@ -76,6 +76,11 @@ public:
       currentRegisterArray->values[reg].setString(val, len);
    }
 
+   TORQUE_FORCEINLINE void appendLocalStringVariable(S32 reg, const char* val, S32 len, char separator)
+   {
+      currentRegisterArray->values[reg].appendString(val, len, separator);
+   }
+
    TORQUE_FORCEINLINE void setLocalStringTableEntryVariable(S32 reg, StringTableEntry val)
    {
       currentRegisterArray->values[reg].setStringTableEntry(val);
@@ -22,6 +22,44 @@
 //-----------------------------------------------------------------------------
 
 #include "codeBlock.h"
+#include "compiler.h"
+
+template< typename T >
+struct Token
+{
+   T value;
+   S32 lineNumber;
+};
+#include "cmdgram.h"
+
+using namespace Compiler;
+
+// Folded constants are compiled as IntNodes and FloatNodes, which don't
+// always behave like the runtime value they replace: OP_LOADIMMED_UINT
+// zero-extends, and float literals are stringified with "%g" while the
+// interpreter uses "%.9g". Only fold results that round-trip exactly.
+
+static bool isFoldableInt(S64 value)
+{
+   return value >= 0 && value <= S32_MAX;
+}
+
+static bool isFoldableFloat(F64 value)
+{
+   if (!(value >= 0.0 && value <= S32_MAX))
+      return false;
+
+   char literal[64], runtime[64];
+   dSprintf(literal, sizeof(literal), "%g", value);
+   dSprintf(runtime, sizeof(runtime), "%.9g", value);
+   return dStrcmp(literal, runtime) == 0;
+}
+
+/// Optimizes a child expression first, so constants fold from the leaves up.
+static ExprNode* optimizeChild(ExprNode* node)
+{
+   return node->optimize() ? node->optimizedNode : node;
+}
 
 static bool isLiteralNumber(ExprNode* node)
 {
@@ -36,15 +74,23 @@ static F64 getFloatValue(ExprNode* node)
    return (F64)static_cast<IntNode*>(node)->value;
 }
 
-static S32 getIntValue(ExprNode* node)
+static bool isPlainString(ExprNode* node)
 {
-   if (node->getExprNodeNameEnum() == NameFloatNode)
-      return (S32)static_cast<FloatNode*>(node)->value;
-   return static_cast<IntNode*>(node)->value;
+   if (node->getExprNodeNameEnum() != NameStrConstNode)
+      return false;
+
+   StrConstNode* str = static_cast<StrConstNode*>(node);
+   return !str->tag && !str->doc;
 }
 
 bool FloatBinaryExprNode::optimize()
 {
+   if (!isOptimizeLevel(1))
+      return false;
+
+   left = optimizeChild(left);
+   right = optimizeChild(right);
+
    // Perform constant folding
    if (isLiteralNumber(right) && isLiteralNumber(left))
    {
@@ -64,11 +110,15 @@ bool FloatBinaryExprNode::optimize()
          result = leftValue * rightValue;
          break;
       case '/':
-         if (rightValue != 0.0)
-            result = leftValue / rightValue;
+         result = leftValue / rightValue;
          break;
+      default:
+         return false;
       }
 
+      if (!isFoldableFloat(result))
+         return false;
+
       optimizedNode = FloatNode::alloc(dbgLineNumber, result);
       return true;
    }
@@ -78,26 +128,124 @@ bool FloatBinaryExprNode::optimize()
 
 bool IntBinaryExprNode::optimize()
 {
-   if (op == '%' && left->getExprNodeNameEnum() == NameVarNode && isLiteralNumber(right))
+   if (!isOptimizeLevel(1))
+      return false;
+
+   left = optimizeChild(left);
+   right = optimizeChild(right);
+
+   if (!isLiteralNumber(left) || !isLiteralNumber(right))
+      return false;
+
+   // Comparisons are done on floats, so any literal will do.
+   const F64 leftFloat = getFloatValue(left);
+   const F64 rightFloat = getFloatValue(right);
+   switch (op)
    {
-      // %a % intconst
-      S32 val = getIntValue(right);
-      switch (val)
-      {
-      case 2:
-         op = '&';
-         optimizedNode = IntNode::alloc(dbgLineNumber, 1);
-         return true;
-      case 4:
-         op = '&';
-         optimizedNode = IntNode::alloc(dbgLineNumber, 3);
-         return true;
-      case 8:
-         op = '&';
-         optimizedNode = IntNode::alloc(dbgLineNumber, 7);
-         return true;
-      }
+   case '<':  optimizedNode = IntNode::alloc(dbgLineNumber, leftFloat < rightFloat);  return true;
+   case '>':  optimizedNode = IntNode::alloc(dbgLineNumber, leftFloat > rightFloat);  return true;
+   case opLE: optimizedNode = IntNode::alloc(dbgLineNumber, leftFloat <= rightFloat); return true;
+   case opGE: optimizedNode = IntNode::alloc(dbgLineNumber, leftFloat >= rightFloat); return true;
+   case opEQ: optimizedNode = IntNode::alloc(dbgLineNumber, leftFloat == rightFloat); return true;
+   case opNE: optimizedNode = IntNode::alloc(dbgLineNumber, leftFloat != rightFloat); return true;
    }
 
-   return false;
+   // The rest convert their operands to integers; leave float literals alone
+   // rather than second guess that conversion.
+   if (left->getExprNodeNameEnum() != NameIntNode || right->getExprNodeNameEnum() != NameIntNode)
+      return false;
+
+   const S64 leftValue = static_cast<IntNode*>(left)->value;
+   const S64 rightValue = static_cast<IntNode*>(right)->value;
+   S64 result;
+
+   switch (op)
+   {
+   case '^':
+      result = leftValue ^ rightValue;
+      break;
+   case '%':
+      result = rightValue != 0 ? leftValue % rightValue : 0;
+      break;
+   case '&':
+      result = leftValue & rightValue;
+      break;
+   case '|':
+      result = leftValue | rightValue;
+      break;
+   case opSHR:
+   case opSHL:
+      if (rightValue < 0 || rightValue > 31)
+         return false;
+      result = op == opSHL ? leftValue << rightValue : leftValue >> rightValue;
+      break;
+   case opOR:
+      // || and && leave the deciding operand itself on the stack.
+      result = leftValue ? leftValue : rightValue;
+      break;
+   case opAND:
+      result = leftValue ? rightValue : leftValue;
+      break;
+   default:
+      return false;
+   }
+
+   if (!isFoldableInt(result))
+      return false;
+
+   optimizedNode = IntNode::alloc(dbgLineNumber, (S32)result);
+   return true;
+}
+
+bool IntUnaryExprNode::optimize()
+{
+   if (!isOptimizeLevel(1))
+      return false;
+
+   expr = optimizeChild(expr);
+   if (!isLiteralNumber(expr))
+      return false;
+
+   S64 result;
+   if (op == '!')
+      result = getFloatValue(expr) == 0.0;
+   else if (op == '~' && expr->getExprNodeNameEnum() == NameIntNode)
+      result = ~(S64)static_cast<IntNode*>(expr)->value;
+   else
+      return false;
+
+   if (!isFoldableInt(result))
+      return false;
+
+   optimizedNode = IntNode::alloc(dbgLineNumber, (S32)result);
+   return true;
+}
+
+bool StrcatExprNode::optimize()
+{
+   if (!isOptimizeLevel(1))
+      return false;
+
+   left = optimizeChild(left);
+   right = optimizeChild(right);
+
+   if (!isPlainString(left) || !isPlainString(right))
+      return false;
+
+   const char* leftStr = static_cast<StrConstNode*>(left)->str;
+   const char* rightStr = static_cast<StrConstNode*>(right)->str;
+   const U32 leftLen = dStrlen(leftStr);
+   const U32 rightLen = dStrlen(rightStr);
+
+   char* buffer = (char*)consoleAlloc(leftLen + rightLen + 2);
+   char* walk = buffer;
+   dMemcpy(walk, leftStr, leftLen);
+   walk += leftLen;
+   if (appendChar)
+      *walk++ = (char)appendChar;
+   dMemcpy(walk, rightStr, rightLen);
+   walk[rightLen] = '\0';
+
+   optimizedNode = StrConstNode::alloc(dbgLineNumber, buffer, false);
+   return true;
 }
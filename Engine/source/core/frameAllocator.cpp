@@ -22,16 +22,166 @@
 
 #include "core/frameAllocator.h"
 #include "console/engineAPI.h"
+#include "platform/threads/thread.h"
+#include "platform/platformIntrinsics.h"
 
-U8*   FrameAllocator::smBuffer = NULL;
-U32   FrameAllocator::smWaterMark = 0;
-U32   FrameAllocator::smHighWaterMark = 0;
+thread_local FrameAllocator::Arena* FrameAllocator::smThreadArena = NULL;
+FrameAllocator::Arena* volatile FrameAllocator::smArenas = NULL;
+U32   FrameAllocator::smThreadFrameSize = 0;
 
-#ifdef TORQUE_DEBUG
-U32   FrameAllocator::smMaxFrameAllocation = 0;
+namespace
+{
+   /// Frees up the calling thread's arena when the thread exits.
+   struct ArenaRelease
+   {
+      FrameAllocator::Arena* arena;
+
+      ~ArenaRelease()
+      {
+         if (arena)
+         {
+            arena->waterMark = 0;
+            dCompareAndSwap(arena->inUse, 1, 0);
+         }
+      }
+   };
+
+   thread_local ArenaRelease tArenaRelease;
+}
 
-DefineEngineFunction(getMaxFrameAllocation, S32, (),,"")
+FrameAllocator::Arena* FrameAllocator::_acquireArena(const U32 size)
 {
-   return FrameAllocator::getMaxFrameAllocation();
+   AssertFatal(smThreadFrameSize != 0, "FrameAllocator::_acquireArena - not initialized");
+
+   const dsize_t threadId = ThreadManager::getCurrentThreadId();
+
+   // Reuse the arena of a thread that has exited.
+   Arena* arena = NULL;
+   for (Arena* walk = smArenas; walk != NULL; walk = walk->next)
+   {
+      if (!walk->inUse && dCompareAndSwap(walk->inUse, 0, 1))
+      {
+         arena = walk;
+         break;
+      }
+   }
+
+   if (!arena)
+   {
+      arena = new Arena;
+      arena->buffer = NULL;
+      arena->size = 0;
+      arena->inUse = 1;
+
+      Arena* head;
+      do
+      {
+         head = smArenas;
+         arena->next = head;
+      }
+      while (!dCompareAndSwap(smArenas, head, arena));
+   }
+
+   if (arena->size < size)
+   {
+      delete [] arena->buffer;
+      arena->buffer = new U8[size];
+      arena->size = size;
+   }
+
+   arena->threadId = threadId;
+   arena->waterMark = 0;
+   arena->peakWaterMark = 0;
+
+   tArenaRelease.arena = arena;
+   return arena;
 }
+
+void FrameAllocator::init(const U32 frameSize, const U32 threadFrameSize)
+{
+#ifdef FRAMEALLOCATOR_DEBUG_GUARD
+   AssertISV( false, "FRAMEALLOCATOR_DEBUG_GUARD has been removed because it allows non-contiguous memory allocation by the FrameAllocator, and this is *not* ok." );
 #endif
+
+   AssertFatal(smThreadFrameSize == 0, "Error, already initialized");
+   smThreadFrameSize = threadFrameSize;
+
+   // The main thread gets the big arena.
+   AssertFatal(smThreadArena == NULL, "Error, already initialized");
+   smThreadArena = _acquireArena(frameSize);
+}
+
+void FrameAllocator::destroy()
+{
+   AssertFatal(smThreadFrameSize != 0, "Error, not initialized");
+
+   // Only the buffers go away; threads still holding on to an arena
+   // will assert on their next allocation.
+   for (Arena* arena = smArenas; arena != NULL; arena = arena->next)
+   {
+      delete [] arena->buffer;
+      arena->buffer = NULL;
+      arena->size = 0;
+      arena->waterMark = 0;
+   }
+
+   if (smThreadArena)
+   {
+      smThreadArena->inUse = 0;
+      smThreadArena = NULL;
+      tArenaRelease.arena = NULL;
+   }
+
+   smThreadFrameSize = 0;
+}
+
+U32 FrameAllocator::getMaxFrameAllocation()
+{
+   Arena* arena = smThreadArena;
+   return arena ? arena->peakWaterMark : 0;
+}
+
+void FrameAllocator::dumpStats()
+{
+   Con::printf("FrameAllocator arenas:");
+   for (Arena* arena = smArenas; arena != NULL; arena = arena->next)
+   {
+      const char* state = "";
+      if (!arena->inUse)
+         state = " (free)";
+      else if (ThreadManager::compare(arena->threadId, ThreadManager::getMainThreadId()))
+         state = " (main)";
+
+      Con::printf("   thread %8llu%s: size %8d, watermark %8d, peak %8d (%.1f%%)",
+         (unsigned long long)arena->threadId, state,
+         arena->size, arena->waterMark, arena->peakWaterMark,
+         arena->size ? 100.0f * F32(arena->peakWaterMark) / F32(arena->size) : 0.0f);
+   }
+}
+
+void FrameAllocator::resetStats()
+{
+   for (Arena* arena = smArenas; arena != NULL; arena = arena->next)
+      arena->peakWaterMark = arena->waterMark;
+}
+
+DefineEngineFunction(getMaxFrameAllocation, S32, (),,
+   "@brief Return the peak FrameAllocator usage of the main thread in bytes.\n\n"
+   "@ingroup Debugging\n")
+{
+   return FrameAllocator::getMaxFrameAllocation();
+}
+
+DefineEngineFunction(dumpFrameAllocatorStats, void, (),,
+   "@brief Print the size, watermark and peak usage of each thread's FrameAllocator arena.\n\n"
+   "@ingroup Debugging\n")
+{
+   FrameAllocator::dumpStats();
+}
+
+DefineEngineFunction(resetFrameAllocatorStats, void, (),,
+   "@brief Reset the peak usage of all FrameAllocator arenas.\n\n"
+   "@ingroup Debugging\n")
+{
+   FrameAllocator::resetStats();
+}
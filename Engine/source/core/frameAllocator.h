@@ -36,6 +36,12 @@
 /// memory which is allocated and expected to be contiguous.
 #define FRAMEALLOCATOR_BYTE_ALIGNMENT 4
 
+/// Default size of the frame arenas of threads other than the main thread.
+/// The main thread's arena is sized by TORQUE_FRAME_SIZE.
+#ifndef TORQUE_THREAD_FRAME_SIZE
+#define TORQUE_THREAD_FRAME_SIZE (4 << 20)
+#endif
+
 /// Temporary memory pool for per-frame allocations.
 ///
 /// In the course of rendering a frame, it is often necessary to allocate
@@ -52,19 +58,52 @@
 ///   // Free frameAllocator memory
 ///   FrameAllocator::setWaterMark(waterMark);
 /// @endcode
+///
+/// Every thread allocates from an arena of its own, so the FrameAllocator,
+/// FrameAllocatorMarker and FrameTemp can be used from worker threads as well.
+/// The main thread's arena is created by init(); other threads get one on
+/// their first allocation, which is handed on to a new thread once they exit.
+/// Job systems restore the watermark after each job.
 class FrameAllocator
 {
-   static U8*   smBuffer;
-   static U32   smHighWaterMark;
-   static U32   smWaterMark;
+  public:
+   /// Memory of a single thread.
+   struct Arena
+   {
+      U8*   buffer;
+      U32   waterMark;
+      U32   size;
 
-#ifdef TORQUE_DEBUG
-   static U32 smMaxFrameAllocation;
-#endif
+      /// Highest watermark reached since the last resetStats().
+      U32   peakWaterMark;
+
+      /// Nonzero while a thread owns the arena.
+      volatile U32 inUse;
+
+      /// Last thread to own the arena.
+      dsize_t threadId;
+
+      Arena* next;
+   };
+
+  private:
+   /// Arena of the calling thread; NULL until it first allocates.
+   static thread_local Arena* smThreadArena;
+
+   /// All arenas ever created.  Arenas are never deleted, only their buffers.
+   static Arena* volatile smArenas;
+
+   /// Size of arenas created for threads other than the main thread.
+   static U32 smThreadFrameSize;
+
+   /// Hand a free arena to the calling thread or create a new one.
+   static Arena* _acquireArena(const U32 size);
+
+   inline static Arena* _getArena();
 
   public:
-   inline static void init(const U32 frameSize);
-   inline static void destroy();
+   static void init(const U32 frameSize, const U32 threadFrameSize = TORQUE_THREAD_FRAME_SIZE);
+   static void destroy();
 
    inline static void* alloc(const U32 allocSize);
 
@@ -72,52 +111,42 @@ class FrameAllocator
    inline static U32  getWaterMark();
    inline static U32  getHighWaterMark();
 
-#ifdef TORQUE_DEBUG
-   static U32 getMaxFrameAllocation() { return smMaxFrameAllocation; }
-#endif
-};
+   /// Return the highest watermark the calling thread's arena reached since
+   /// the last resetStats().
+   static U32 getMaxFrameAllocation();
 
-void FrameAllocator::init(const U32 frameSize)
-{
-#ifdef FRAMEALLOCATOR_DEBUG_GUARD
-   AssertISV( false, "FRAMEALLOCATOR_DEBUG_GUARD has been removed because it allows non-contiguous memory allocation by the FrameAllocator, and this is *not* ok." );
-#endif
+   /// Print the size, watermark and peak watermark of each thread's arena.
+   static void dumpStats();
 
-   AssertFatal(smBuffer == NULL, "Error, already initialized");
-   smBuffer = new U8[frameSize];
-   smWaterMark = 0;
-   smHighWaterMark = frameSize;
-}
+   /// Reset the peak watermarks of all arenas.
+   static void resetStats();
+};
 
-void FrameAllocator::destroy()
+FrameAllocator::Arena* FrameAllocator::_getArena()
 {
-   AssertFatal(smBuffer != NULL, "Error, not initialized");
-
-   delete [] smBuffer;
-   smBuffer = NULL;
-   smWaterMark = 0;
-   smHighWaterMark = 0;
+   if (!smThreadArena)
+      smThreadArena = _acquireArena(smThreadFrameSize);
+   return smThreadArena;
 }
 
-
 void* FrameAllocator::alloc(const U32 allocSize)
 {
    U32 _allocSize = allocSize;
 
-   AssertFatal(smBuffer != NULL, "Error, no buffer!");
-   AssertFatal(smWaterMark + _allocSize <= smHighWaterMark, "Error alloc too large, increase frame size!");
-   smWaterMark = ( smWaterMark + ( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ) ) & (~( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ));
+   Arena* arena = _getArena();
+
+   AssertFatal(arena->buffer != NULL, "Error, no buffer!");
+   AssertFatal(arena->waterMark + _allocSize <= arena->size, "Error alloc too large, increase frame size!");
+   arena->waterMark = ( arena->waterMark + ( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ) ) & (~( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ));
 
    // Sanity check.
-   AssertFatal( !( smWaterMark & ( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ) ), "Frame allocation is not on a specified byte boundry." );
+   AssertFatal( !( arena->waterMark & ( FRAMEALLOCATOR_BYTE_ALIGNMENT - 1 ) ), "Frame allocation is not on a specified byte boundry." );
 
-   U8* p = &smBuffer[smWaterMark];
-   smWaterMark += _allocSize;
+   U8* p = &arena->buffer[arena->waterMark];
+   arena->waterMark += _allocSize;
 
-#ifdef TORQUE_DEBUG
-   if (smWaterMark > smMaxFrameAllocation)
-      smMaxFrameAllocation = smWaterMark;
-#endif
+   if (arena->waterMark > arena->peakWaterMark)
+      arena->peakWaterMark = arena->waterMark;
 
    return p;
 }
@@ -125,18 +154,28 @@ void* FrameAllocator::alloc(const U32 allocSize)
 
 void FrameAllocator::setWaterMark(const U32 waterMark)
 {
-   AssertFatal(waterMark < smHighWaterMark, "Error, invalid waterMark");
-   smWaterMark = waterMark;
+   // Threads that never allocated have nothing to restore.
+   Arena* arena = smThreadArena;
+   if (!arena)
+   {
+      AssertFatal(waterMark == 0, "Error, invalid waterMark");
+      return;
+   }
+
+   AssertFatal(waterMark < arena->size || waterMark == 0, "Error, invalid waterMark");
+   arena->waterMark = waterMark;
 }
 
 U32 FrameAllocator::getWaterMark()
 {
-   return smWaterMark;
+   // Don't create an arena just to look at it.
+   Arena* arena = smThreadArena;
+   return arena ? arena->waterMark : 0;
 }
 
 U32 FrameAllocator::getHighWaterMark()
 {
-   return smHighWaterMark;
+   return _getArena()->size;
 }
 
 /// Helper class to deal with FrameAllocator usage.
@@ -22,10 +22,16 @@
 
 #include "core/strings/stringFunctions.h"
 #include "core/stringTable.h"
+#include "platform/platformIntrinsics.h"
 #include "platform/profiler.h"
 
+#if (defined( TORQUE_CPU_X86 ) || defined( TORQUE_CPU_X64 ))
+#include <xmmintrin.h>
+#endif
+
 _StringTable *_gStringTable = NULL;
-const U32 _StringTable::csm_stInitSize = 29;
+const U32 _StringTable::csm_stInitSize = 64;
+const U32 _StringTable::csm_stShardShift = 28;
 
 //---------------------------------------------------------------
 //
@@ -34,67 +40,127 @@ const U32 _StringTable::csm_stInitSize = 29;
 //---------------------------------------------------------------
 
 namespace {
-bool sgInitTable = true;
-U8   sgHashTable[256];
 
-void initTolowerTable()
+const U64 sgOnes = 0x0101010101010101ULL;
+
+/// Lower case the ASCII letters in eight bytes at once.  This matches
+/// dStricmp(), so strings that compare equal also hash the same.
+inline U64 foldCase(U64 word)
+{
+   // The high bit of each byte is set where it is >= 'A', and where it
+   // is > 'Z'.  Bytes that already have the high bit set are left alone.
+   const U64 low = word & (0x7f * sgOnes);
+   const U64 geA = low + (0x80 - 'A') * sgOnes;
+   const U64 gtZ = low + (0x80 - 'Z' - 1) * sgOnes;
+   const U64 upper = geA & ~gtZ & ~word & (0x80 * sgOnes);
+
+   return word | (upper >> 2);
+}
+
+inline U64 mixWord(U64 hash, U64 word)
+{
+   hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+   return hash ^ (hash >> 32);
+}
+
+/// Hash len bytes of a string eight bytes at a time.
+U32 hashFolded(const char* str, U32 len)
 {
-   for (U32 i = 0; i < 256; i++) {
-      U8 c = dTolower(i);
-      sgHashTable[i] = c * c;
+   U64 hash = len * 0x9e3779b97f4a7c15ULL;
+
+   for(; len >= 8; str += 8, len -= 8)
+   {
+      U64 word;
+      dMemcpy(&word, str, 8);
+      hash = mixWord(hash, foldCase(word));
    }
 
-   sgInitTable = false;
+   if(len)
+   {
+      U64 word = 0;
+      dMemcpy(&word, str, len);
+      hash = mixWord(hash, foldCase(word));
+   }
+
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+   hash *= 0xc4ceb9fe1a85ec53ULL;
+   hash ^= hash >> 33;
+
+   return U32(hash);
+}
+
+/// Length of a string, stopping at len bytes if len isn't negative.
+inline U32 boundedLength(const char* str, S32 len)
+{
+   if(len < 0)
+      return dStrlen(str);
+
+   U32 n = 0;
+   while(n < (U32)len && str[n])
+      n++;
+   return n;
 }
 
 } // namespace {}
 
 U32 _StringTable::hashString(const char* str)
 {
-   if (sgInitTable)
-      initTolowerTable();
-
    if(!str) return -1;
 
-   U32 ret = 0;
-   char c;
-   while((c = *str++) != 0) {
-      ret <<= 1;
-      ret ^= sgHashTable[static_cast<U8>(c)];
-   }
-   return ret;
+   return hashFolded(str, dStrlen(str));
 }
 
 U32 _StringTable::hashStringn(const char* str, S32 len)
 {
-   if (sgInitTable)
-      initTolowerTable();
+   return hashFolded(str, boundedLength(str, len));
+}
 
-   U32 ret = 0;
-   char c;
-   while((c = *str++) != 0 && len--) {
-      ret <<= 1;
-      ret ^= sgHashTable[static_cast<U8>(c)];
+//--------------------------------------
+void _StringTable::Shard::lock()
+{
+   // Writers only hold the lock for an insert, so spin on reads for a
+   // bit, then give up the time slice in case the holder was preempted.
+   U32 spins = 0;
+   while(!dCompareAndSwap(writeLock, 0, 1))
+   {
+      do
+      {
+         if(++spins < 64)
+         {
+#if (defined( TORQUE_CPU_X86 ) || defined( TORQUE_CPU_X64 ))
+            _mm_pause();
+#endif
+         }
+         else
+            Platform::sleep(0);
+      } while(writeLock);
    }
-   return ret;
+}
+
+void _StringTable::Shard::unlock()
+{
+   dCompareAndSwap(writeLock, 1, 0);
 }
 
 //--------------------------------------
 _StringTable::_StringTable()
 {
-   buckets = (Node **) dMalloc(csm_stInitSize * sizeof(Node *));
-   for(U32 i = 0; i < csm_stInitSize; i++) {
-      buckets[i] = 0;
+   for(U32 i = 0; i < csm_stNumShards; i++) {
+      shards[i].table = _createTable(csm_stInitSize);
+      shards[i].writeLock = 0;
    }
-
-   numBuckets = csm_stInitSize;
-   itemCount = 0;
 }
 
 //--------------------------------------
 _StringTable::~_StringTable()
 {
-   dFree(buckets);
+   for(U32 i = 0; i < csm_stNumShards; i++) {
+      dFree(shards[i].table);
+      for(U32 j = 0; j < shards[i].retired.size(); j++)
+         dFree(shards[i].retired[j]);
+   }
 }
 
 
@@ -119,6 +185,124 @@ void _StringTable::destroy()
 }
 
 
+//--------------------------------------
+_StringTable::Table* _StringTable::_createTable(U32 size)
+{
+   AssertFatal(isPow2(size), "_StringTable::_createTable - size must be a power of two");
+
+   const dsize_t bytes = sizeof(Table) + (size - 1) * sizeof(Slot);
+   Table* table = (Table*) dMalloc(bytes);
+   dMemset(table, 0, bytes);
+   table->mask = size - 1;
+   return table;
+}
+
+//--------------------------------------
+StringTableEntry _StringTable::_find(const Table* table, U32 hash, const char* val, U32 len, bool caseSens, U32* emptySlot)
+{
+   // Strings that only differ by case have the same hash, so they follow
+   // each other in the order they were added.  A case insensitive search
+   // finds the one added first, as it always has.
+   for(U32 i = hash & table->mask; ; i = (i + 1) & table->mask)
+   {
+      const Slot& slot = table->slots[i];
+      const char* str = slot.val;
+      if(!str)
+      {
+         if(emptySlot)
+            *emptySlot = i;
+         return NULL;
+      }
+
+      if(slot.hash != hash)
+         continue;
+      if((caseSens ? !dStrncmp(str, val, len) : !dStrnicmp(str, val, len)) && str[len] == 0)
+         return str;
+   }
+}
+
+//--------------------------------------
+void _StringTable::_resizeShard(Shard& shard, U32 size)
+{
+   Table* old = shard.table;
+   Table* table = _createTable(size);
+
+   // Start copying at an empty slot so that each run of slots is copied in
+   // probe order and strings differing by case stay in the order they
+   // were added.
+   U32 start = 0;
+   while(old->slots[start].val)
+      start++;
+
+   for(U32 i = 1; i <= old->mask + 1; i++)
+   {
+      const Slot& slot = old->slots[(start + i) & old->mask];
+      if(!slot.val)
+         continue;
+
+      U32 index = slot.hash & table->mask;
+      while(table->slots[index].val)
+         index = (index + 1) & table->mask;
+      table->slots[index].hash = slot.hash;
+      table->slots[index].val = slot.val;
+   }
+   table->count = old->count;
+
+   // Lookups still on the old table see everything that was in it.
+   dCompareAndSwap(shard.table, old, table);
+   shard.retired.push_back(old);
+}
+
+//--------------------------------------
+StringTableEntry _StringTable::_insert(const char* val, U32 len, bool caseSens)
+{
+   const U32 hash = hashFolded(val, len);
+   Shard& shard = shards[hash >> csm_stShardShift];
+
+   StringTableEntry ret = _find(shard.table, hash, val, len, caseSens);
+   if(ret)
+      return ret;
+
+   shard.lock();
+
+   // Look again as another thread may have added it in the meantime.
+   U32 index;
+   ret = _find(shard.table, hash, val, len, caseSens, &index);
+   if(!ret)
+   {
+      // Keep the table at most three quarters full.
+      Table* table = shard.table;
+      if((table->count + 1) * 4 > (table->mask + 1) * 3)
+      {
+         _resizeShard(shard, (table->mask + 1) * 2);
+         table = shard.table;
+         _find(table, hash, val, len, caseSens, &index);
+      }
+
+      char* str = (char*) shard.mempool.alloc(len + 1);
+      dMemcpy(str, val, len);
+      str[len] = 0;
+
+      Slot& slot = table->slots[index];
+      slot.hash = hash;
+      dCompareAndSwap(slot.val, (char*) NULL, str);
+      table->count++;
+
+      ret = str;
+   }
+
+   shard.unlock();
+
+   return ret;
+}
+
+//--------------------------------------
+StringTableEntry _StringTable::_lookup(const char* val, U32 len, bool caseSens)
+{
+   const U32 hash = hashFolded(val, len);
+   return _find(shards[hash >> csm_stShardShift].table, hash, val, len, caseSens);
+}
+
 //--------------------------------------
 StringTableEntry _StringTable::insert(const char* _val, const bool caseSens)
 {
@@ -130,40 +314,14 @@ StringTableEntry _StringTable::insert(const char* _val, const bool caseSens)
       val = "";
    //-
 
-   Node **walk, *temp;
-   U32 key = hashString(val);
-   walk = &buckets[key % numBuckets];
-   while((temp = *walk) != NULL)   {
-      if(caseSens && !String::compare(temp->val, val))
-         return temp->val;
-      else if(!caseSens && !dStricmp(temp->val, val))
-         return temp->val;
-      walk = &(temp->next);
-   }
-   char *ret = 0;
-   if(!*walk) {
-      dsize_t valLen = dStrlen(val) + 1;
-      *walk = (Node *) mempool.alloc(sizeof(Node));
-      (*walk)->next = 0;
-      (*walk)->val = (char *) mempool.alloc(valLen);
-      dStrcpy((*walk)->val, val, valLen);
-      ret = (*walk)->val;
-      itemCount ++;
-   }
-   if(itemCount > 2 * numBuckets) {
-      resize(4 * numBuckets - 1);
-   }
-   return ret;
+   return _insert(val, dStrlen(val), caseSens);
 }
 
 //--------------------------------------
 StringTableEntry _StringTable::insertn(const char* src, S32 len, const bool  caseSens)
 {
-   char val[256];
    AssertFatal(len < 255, "Invalid string to insertn");
-   dStrncpy(val, src, len);
-   val[len] = 0;
-   return insert(val, caseSens);
+   return _insert(src, boundedLength(src, len), caseSens);
 }
 
 //--------------------------------------
@@ -171,17 +329,7 @@ StringTableEntry _StringTable::lookup(const char* val, const bool  caseSens)
 {
    PROFILE_SCOPE(StringTableLookup);
 
-   Node **walk, *temp;
-   U32 key = hashString(val);
-   walk = &buckets[key % numBuckets];
-   while((temp = *walk) != NULL)   {
-      if(caseSens && !String::compare(temp->val, val))
-            return temp->val;
-      else if(!caseSens && !dStricmp(temp->val, val))
-         return temp->val;
-      walk = &(temp->next);
-   }
-   return NULL;
+   return _lookup(val, dStrlen(val), caseSens);
 }
 
 //--------------------------------------
@@ -189,56 +337,20 @@ StringTableEntry _StringTable::lookupn(const char* val, S32 len, const bool  cas
 {
    PROFILE_SCOPE(StringTableLookupN);
 
-   Node **walk, *temp;
-   U32 key = hashStringn(val, len);
-   walk = &buckets[key % numBuckets];
-   while((temp = *walk) != NULL) {
-      if(caseSens && !dStrncmp(temp->val, val, len) && temp->val[len] == 0)
-         return temp->val;
-      else if(!caseSens && !dStrnicmp(temp->val, val, len) && temp->val[len] == 0)
-         return temp->val;
-      walk = &(temp->next);
-   }
-   return NULL;
+   return _lookup(val, boundedLength(val, len), caseSens);
 }
 
 //--------------------------------------
-void _StringTable::resize(const U32 _newSize)
+void _StringTable::resize(const U32 newSize)
 {
-   /// avoid a possible 0 division
-   const U32 newSize = _newSize ? _newSize : 1;
-
-   Node *head = NULL, *walk, *temp;
-   U32 i;
-   // reverse individual bucket lists
-   // we do this because new strings are added at the end of bucket
-   // lists so that case sens strings are always after their
-   // corresponding case insens strings
-
-   for(i = 0; i < numBuckets; i++) {
-      walk = buckets[i];
-      while(walk)
-      {
-         temp = walk->next;
-         walk->next = head;
-         head = walk;
-         walk = temp;
-      }
-   }
-   buckets = (Node **) dRealloc(buckets, newSize * sizeof(Node));
-   for(i = 0; i < newSize; i++) {
-      buckets[i] = 0;
-   }
-   numBuckets = newSize;
-   walk = head;
-   while(walk) {
-      U32 key;
-      temp = walk;
-
-      walk = walk->next;
-      key = hashString(temp->val);
-      temp->next = buckets[key % newSize];
-      buckets[key % newSize] = temp;
+   // Enough slots per shard to hold its share below the growth threshold.
+   const U32 perShard = (newSize / csm_stNumShards + 1) * 4 / 3 + 1;
+
+   for(U32 i = 0; i < csm_stNumShards; i++) {
+      Shard& shard = shards[i];
+      shard.lock();
+      if(perShard > shard.table->mask + 1)
+         _resizeShard(shard, getNextPow2(perShard));
+      shard.unlock();
    }
 }
-
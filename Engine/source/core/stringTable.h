@@ -29,6 +29,9 @@
 #ifndef _DATACHUNKER_H_
 #include "core/dataChunker.h"
 #endif
+#ifndef _TVECTOR_H_
+#include "core/util/tVector.h"
+#endif
 
 
 //--------------------------------------
@@ -73,32 +76,73 @@
 /// @note Be aware that the StringTable NEVER DEALLOCATES memory, so be careful when you
 ///       add strings to it. If you carelessly add many strings, you will end up wasting
 ///       space.
+///
+/// The StringTable may be used from any thread.  Looking up a string that is already
+/// in the table never blocks.  Strings are spread over a number of shards by their
+/// hash and adding a string only locks the shard it goes into.
 class _StringTable
 {
 private:
    /// @name Implementation details
    /// @{
 
-   /// This is internal to the _StringTable class.
-   struct Node
+   /// A slot in an open addressed table.  The string is only set once the hash is
+   /// written, so readers that see a string can trust the hash.
+   struct Slot
+   {
+      U32 hash;
+      char* volatile val;
+   };
+
+   /// Linearly probed table of strings.  Tables are never changed in place
+   /// once they are full; a bigger copy is made and swapped in instead.
+   struct Table
+   {
+      U32 mask;
+      U32 count;
+      Slot slots[1];
+   };
+
+   /// A part of the table holding the strings for a range of hashes.
+   struct Shard
    {
-      char *val;
-      Node *next;
+      Table* volatile table;
+      volatile U32 writeLock;
+      DataChunker mempool;
+
+      /// Tables replaced by bigger ones.  Lookups may still be reading them,
+      /// so they're only freed along with the string table.
+      Vector<Table*> retired;
+
+      void lock();
+      void unlock();
    };
 
-   Node**      buckets;
-   U32         numBuckets;
-   U32         itemCount;
-   DataChunker mempool;
+   static const U32 csm_stNumShards = 16;
+   Shard shards[csm_stNumShards];
 
    StringTableEntry _EmptyString;
 
   protected:
    static const U32 csm_stInitSize;
+   static const U32 csm_stShardShift;
 
    _StringTable();
    ~_StringTable();
 
+   static Table* _createTable(U32 size);
+
+   /// Replace the shard's table with one of the given size.  The shard
+   /// must be locked.
+   static void _resizeShard(Shard& shard, U32 size);
+
+   /// Find a string in a table.
+   /// @param emptySlot Set to the slot the string would go in if it isn't found.
+   static StringTableEntry _find(const Table* table, U32 hash, const char* val, U32 len, bool caseSens, U32* emptySlot = NULL);
+
+   StringTableEntry _insert(const char* val, U32 len, bool caseSens);
+   StringTableEntry _lookup(const char* val, U32 len, bool caseSens);
+
    /// @}
   public:
 
@@ -143,17 +187,17 @@ private:
    StringTableEntry lookupn(const char *string, S32 len, bool caseSens = false);
 
 
-   /// Resize the StringTable to be able to hold newSize items. This
-   /// is called automatically by the StringTable when the table is
-   /// full past a certain threshhold.
+   /// Resize the StringTable to be able to hold newSize items without growing.
+   /// The StringTable grows automatically when it is full past a certain
+   /// threshhold.
    ///
    /// @param newSize   Number of new items to allocate space for.
    void             resize(const U32 newSize);
 
-   /// Hash a string into a U32.
+   /// Hash a string into a U32, ignoring case.
    static U32 hashString(const char* in_pString);
 
-   /// Hash a string of given length into a U32.
+   /// Hash at most len bytes of a string into a U32, ignoring case.
    static U32 hashStringn(const char* in_pString, S32 len);
 
    /// Represents a zero length string.
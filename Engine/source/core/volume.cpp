@@ -1133,6 +1133,49 @@ bool ReadFile(const Path &inPath, void *&outData, U32 &outSize, bool inNullTermi
    return true;
 }
 
+MappedFile::MappedFile(const FileRef &file, void* data, U32 size, bool mapped)
+   : mFile(file),
+     mData(data),
+     mSize(size),
+     mMapped(mapped)
+{
+}
+
+MappedFile::~MappedFile()
+{
+   if (mMapped)
+      mFile->unmap(mData, mSize);
+   else
+      delete [] static_cast<char *>(mData);
+}
+
+MappedFileRef MapFile(const Path &inPath)
+{
+   FileRef fileR = OpenFile( inPath, File::Read );
+   if ( fileR == NULL )
+      return NULL;
+
+   U32 size = 0;
+   void* data = fileR->map(size);
+   if ( data )
+   {
+      fileR->close();
+      return new MappedFile( fileR, data, size, true );
+   }
+
+   // Read it the slow way.
+   size = fileR->getSize();
+   data = new char [getMax( size, (U32)1 )];
+   if ( fileR->read(data, size) != size )
+   {
+      delete [] static_cast<char *>(data);
+      return NULL;
+   }
+
+   fileR->close();
+   return new MappedFile( fileR, data, size, false );
+}
+
 DirectoryRef OpenDirectory(const Path &path)
 {
    return sgMountSystem.openDirectory(path);
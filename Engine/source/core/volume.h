@@ -182,12 +182,55 @@ public:
 
    virtual U32 read(void* dst, U32 size) = 0;
    virtual U32 write(const void* src, U32 size) = 0;
+
+   /// Maps the whole of the open file into memory.  The mapping is
+   /// copy-on-write, so writing to it never changes the file, and
+   /// it stays valid after the file is closed until unmap().
+   /// @return NULL if the file system can't map files.
+   virtual void* map(U32 &outSize) { outSize = 0; return NULL; }
+
+   /// Releases a mapping returned by map().
+   virtual void unmap(void* data, U32 size) {}
 };
 
 typedef WeakRefPtr<File> FilePtr;
 typedef StrongRefPtr<File>  FileRef;
 
 
+//-----------------------------------------------------------------------------
+
+/// The whole contents of a file in memory.
+/// The file is memory mapped if its file system supports it and read into
+/// a buffer if not, so the pages of a mapped file are shared with the OS
+/// file cache and everyone else mapping it.  Writing to the data is
+/// allowed and only changes this copy.
+/// @see MapFile
+/// @ingroup VolumeSystem
+class MappedFile : public StrongRefBase
+{
+public:
+   MappedFile(const FileRef &file, void* data, U32 size, bool mapped);
+   ~MappedFile();
+
+   U8* getData() const { return (U8*)mData; }
+   U32 getSize() const { return mSize; }
+
+   /// The name of the file the data came from.
+   Path getPath() const { return mFile->getName(); }
+
+   /// Returns false if the file was read into a buffer.
+   bool isMapped() const { return mMapped; }
+
+private:
+   FileRef mFile;
+   void* mData;
+   U32 mSize;
+   bool mMapped;
+};
+
+typedef StrongRefPtr<MappedFile> MappedFileRef;
+
+
 //-----------------------------------------------------------------------------
 
 /// Directory in a FileSystem.
@@ -537,6 +580,12 @@ FileRef OpenFile(const Path &file, File::AccessMode mode);
 ///@return successful read?  If not, outData will be NULL and outSize will be 0
 bool  ReadFile(const Path &inPath, void *&outData, U32 &outSize, bool inNullTerminate = false );
 
+/// Map an entire file into memory.
+/// Falls back to reading the file when its file system can't map it.
+///@return Null if the file could not be opened or read
+///@ingroup VolumeSystem
+MappedFileRef MapFile(const Path &inPath);
+
 /// Open a directory.
 /// If the directory exists a directory object will be returned even if the
 /// open operation fails.
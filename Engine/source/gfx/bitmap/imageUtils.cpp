@@ -23,7 +23,7 @@
 #include "platform/platform.h"
 #include "gfx/bitmap/imageUtils.h"
 #include "gfx/bitmap/ddsFile.h"
-#include "platform/threads/threadPool.h"
+#include "platform/threads/parallelFor.h"
 #include "squish/squish.h"
 
 namespace ImageUtil
@@ -64,26 +64,44 @@ namespace ImageUtil
       }
    }
 
-   //Thread work job for compression
-   struct CompressJob : public ThreadPool::WorkItem
+   // Rows per compression band.  Bands of a mip compress independently so
+   // that the large top mips spread across threads too.  Multiple of 4.
+   static const S32 sCompressBandRows = 64;
+
+   // A horizontal band of a mip to compress
+   struct CompressBand
    {
-      S32 width;
-      S32 height;
       const U8 *pSrc;
       U8 *pDst;
-      GFXFormat format;
-      CompressQuality quality;
-
-      CompressJob(const U8 *srcRGBA, U8 *dst, const S32 w, const S32 h, const GFXFormat compressFormat, const CompressQuality compressQuality)
-         : pSrc(srcRGBA),pDst(dst), width(w), height(h), format(compressFormat),quality(compressQuality) {}
+      S32 width;
+      S32 height;
+   };
 
-   protected:
-      virtual void execute()
+   // split a mip into bands
+   static void _addCompressBands(Vector<CompressBand> &bands, const U8 *srcRGBA, U8 *dst, const S32 width, const S32 height, const S32 squishFlags)
+   {
+      for (S32 y = 0; y < height; y += sCompressBandRows)
       {
-         rawCompress(pSrc,pDst, width, height, format,quality);
+         // blocks are stored row by row, so the output of a band starts
+         // right after the blocks of all rows above it
+         CompressBand band;
+         band.pSrc = srcRGBA + y * width * 4;
+         band.pDst = dst + squish::GetStorageRequirements(width, y, squishFlags);
+         band.width = width;
+         band.height = getMin(sCompressBandRows, height - y);
+         bands.push_back(band);
       }
-   };
+   }
 
+   // compress bands on the job system, serially if there is none
+   static void _compressBands(const Vector<CompressBand> &bands, const GFXFormat compressFormat, const CompressQuality compressQuality)
+   {
+      parallelFor(0, bands.size(), 1, [&](U32 start, U32 end)
+      {
+         for (U32 i = start; i < end; i++)
+            rawCompress(bands[i].pSrc, bands[i].pDst, bands[i].width, bands[i].height, compressFormat, compressQuality);
+      });
+   }
 
    // compress raw pixel data, expects rgba format
    bool rawCompress(const U8 *srcRGBA, U8 *dst, const S32 width, const S32 height, const GFXFormat compressFormat, const CompressQuality compressQuality)
@@ -123,8 +141,8 @@ namespace ImageUtil
       srcDDS->mFormat = compressFormat;
       srcDDS->mFlags.set(DDSFile::CompressedData);
 
-      //grab global thread pool
-      ThreadPool* pThreadPool = &ThreadPool::GLOBAL();
+      const S32 squishFlags = _getSquishFormat(compressFormat);
+      Vector<CompressBand> bands;
 
       if (cubemap)
       {
@@ -143,14 +161,11 @@ namespace ImageUtil
                U8 *dstBits = new U8[mipSz];
                dstDataStore[dataIndex] = dstBits;
 
-               ThreadSafeRef<CompressJob> item(new CompressJob(srcBits, dstBits, srcDDS->getWidth(currentMip), srcDDS->getHeight(currentMip), compressFormat, compressQuality));
-               pThreadPool->queueWorkItem(item);
-
+               _addCompressBands(bands, srcBits, dstBits, srcDDS->getWidth(currentMip), srcDDS->getHeight(currentMip), squishFlags);
             }
          }
 
-         //wait for work items to finish
-         pThreadPool->waitForAllItems();
+         _compressBands(bands, compressFormat, compressQuality);
 
          for (S32 cubeFace = 0; cubeFace < nCubeFaces; cubeFace++)
          {
@@ -171,8 +186,6 @@ namespace ImageUtil
          // Create a new surface, this will be the DXT compressed surface. Once we
          // are done, we can discard the old surface, and replace it with this one.
          DDSFile::SurfaceData *pNewSurface = new DDSFile::SurfaceData();
-         //no point using threading if only 1 mip
-         const bool useThreading = bool(mipCount > 1);
          for (U32 currentMip = 0; currentMip < mipCount; currentMip++)
          {
             const U8 *pSrcBits = pSrcSurface->mMips[currentMip];
@@ -181,19 +194,11 @@ namespace ImageUtil
             U8 *pDstBits = new U8[mipSz];
             pNewSurface->mMips.push_back(pDstBits);
 
-            if (useThreading)
-            {
-               // Create CompressJob item
-               ThreadSafeRef<CompressJob> item(new CompressJob(pSrcBits, pDstBits, srcDDS->getWidth(currentMip), srcDDS->getHeight(currentMip), compressFormat, compressQuality));
-               pThreadPool->queueWorkItem(item);
-            }
-            else
-               rawCompress(pSrcBits, pDstBits, srcDDS->getWidth(currentMip), srcDDS->getHeight(currentMip), compressFormat, compressQuality);
-
+            _addCompressBands(bands, pSrcBits, pDstBits, srcDDS->getWidth(currentMip), srcDDS->getHeight(currentMip), squishFlags);
          }
-         //block and wait for CompressJobs to finish
-         if(useThreading)
-            pThreadPool->waitForAllItems();
+
+         // runs serially when there is only a single band
+         _compressBands(bands, compressFormat, compressQuality);
 
          // Now delete the source surface and replace with new compressed surface
          srcDDS->mSurfaces.pop_back();
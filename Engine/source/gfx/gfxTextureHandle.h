@@ -46,6 +46,11 @@ public:
    GFXTexHandle( const String &texName, GFXTextureProfile *profile, const String &desc );
    bool set( const String &texName, GFXTextureProfile *profile, const String &desc );
 
+   /// Loads the texture on the thread pool and sets the handle to a
+   /// placeholder until it is done.
+   /// @see GFXTextureManager::createTextureAsync
+   bool setAsync( const String &texName, GFXTextureProfile *profile, const String &desc );
+
    // load composite
    GFXTexHandle(const String &texNameR, const String &texNameG, const String &texNameB, const String &texNameA, U32 inputKey[4], GFXTextureProfile *profile, const String &desc);
    bool set( const String &texNameR, const String &texNameG, const String &texNameB, const String &texNameA, U32 inputKey[4], GFXTextureProfile *profile, const String &desc );
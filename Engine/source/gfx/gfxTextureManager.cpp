@@ -35,6 +35,9 @@
 #include "console/consoleTypes.h"
 #include "console/engineAPI.h"
 #include "renderInstance/renderProbeMgr.h"
+#include "platform/threads/threadPool.h"
+#include "platform/platformIntrinsics.h"
+#include "core/stream/fileStream.h"
 
 using namespace Torque;
 
@@ -42,6 +45,7 @@ using namespace Torque;
 
 
 S32 GFXTextureManager::smTextureReductionLevel = 0;
+S32 GFXTextureManager::smAsyncUploadBudget = 4096;
 
 String GFXTextureManager::smMissingTexturePath(Con::getVariable("$Core::MissingTexturePath"));
 String GFXTextureManager::smUnavailableTexturePath(Con::getVariable("$Core::UnAvailableTexturePath"));
@@ -61,6 +65,11 @@ void GFXTextureManager::init()
       "as not allowing down scaling.\n"
       "@ingroup GFX\n" );
 
+   Con::addVariable( "$pref::Video::asyncTextureUploadBudget", TypeS32, &smAsyncUploadBudget,
+      "The KB of asynchronously loaded texture data to upload each frame.  At "
+      "least one texture is uploaded each frame if one is ready.\n"
+      "@ingroup GFX\n" );
+
    Con::addVariable( "$pref::Video::missingTexturePath", TypeRealString, &smMissingTexturePath,
       "The file path of the texture to display when the requested texture is missing.\n"
       "@ingroup GFX\n" );
@@ -128,6 +137,10 @@ void GFXTextureManager::kill()
 {
    AssertFatal( mTextureManagerState != GFXTextureManager::Dead, "Texture Manager already killed!" );
 
+   // Let go of the placeholders.  The work items still
+   // running will clean up after themselves.
+   mAsyncLoads.clear();
+
    // Release everything in the cache we can
    // so we don't leak any textures.
    cleanupCache();
@@ -652,7 +665,11 @@ GFXTextureObject *GFXTextureManager::createTexture( const Torque::Path &path, GF
 
    GFXTextureObject *retTexObj = _lookupTexture( pathNoExt, profile );
    if( retTexObj )
+   {
+      // Callers of the synchronous load expect the real thing.
+      _flushAsyncLoad( retTexObj );
       return retTexObj;
+   }
 
    const U32 scalePower = getTextureDownscalePower( profile );
 
@@ -735,6 +752,274 @@ GFXTextureObject *GFXTextureManager::createTexture( const Torque::Path &path, GF
    return retTexObj;
 }
 
+//-----------------------------------------------------------------------------
+// Async loading
+//-----------------------------------------------------------------------------
+
+class GFXTextureManager::AsyncLoadItem : public ThreadPool::WorkItem
+{
+public:
+
+   typedef ThreadPool::WorkItem Parent;
+
+   AsyncLoadItem( const Torque::Path &path, bool isDDS, U32 dropMipCount )
+      :  mPath( path ),
+         mIsDDS( isDDS ),
+         mDropMipCount( dropMipCount ),
+         mBitmap( NULL ),
+         mDDS( NULL ),
+         mDecoded( 0 )
+   {
+   }
+
+   virtual ~AsyncLoadItem()
+   {
+      SAFE_DELETE( mBitmap );
+      SAFE_DELETE( mDDS );
+   }
+
+   /// The file being loaded.
+   const Torque::Path mPath;
+
+   /// If true the file is read as a DDSFile else as a GBitmap.
+   const bool mIsDDS;
+
+   /// The mips to drop when loading a DDSFile.
+   const U32 mDropMipCount;
+
+   /// The decoded image which is only valid once isDecoded() is
+   /// true.  Both are NULL if the file failed to load.
+   GBitmap *mBitmap;
+   DDSFile *mDDS;
+
+   /// Returns true once the worker is done with the item.
+   bool isDecoded() { return dAtomicRead( mDecoded ) != 0; }
+
+   /// Returns the size of the decoded image data.
+   U32 getDecodedSize() const
+   {
+      if ( mDDS )
+         return mDDS->getSizeInBytes();
+      if ( mBitmap )
+         return mBitmap->getByteSize();
+      return 0;
+   }
+
+protected:
+
+   volatile U32 mDecoded;
+
+   virtual void execute()
+   {
+      PROFILE_SCOPE( GFXTextureManager_AsyncDecode );
+
+      // This mirrors the Resource<>::create() for the two types
+      // as the ResourceManager is only safe on the main thread.
+      FileStream stream;
+      stream.open( mPath.getFullPath(), Torque::FS::File::Read );
+      if ( stream.getStatus() == Stream::Ok )
+      {
+         if ( mIsDDS )
+         {
+            mDDS = new DDSFile;
+            if ( mDDS->read( stream, mDropMipCount ) )
+            {
+               mDDS->mSourcePath = mPath;
+               mDDS->mCacheString = Torque::Path::Join( mPath.getRoot(), ':', mPath.getPath() );
+               mDDS->mCacheString = Torque::Path::Join( mDDS->mCacheString, '/', mPath.getFileName() );
+            }
+            else
+               SAFE_DELETE( mDDS );
+         }
+         else
+         {
+            mBitmap = new GBitmap;
+            if ( !mBitmap->readBitmap( mPath.getExtension(), stream ) )
+               SAFE_DELETE( mBitmap );
+         }
+      }
+
+      dCompareAndSwap( mDecoded, 0, 1 );
+   }
+
+   virtual void onCancelled()
+   {
+      dCompareAndSwap( mDecoded, 0, 1 );
+   }
+};
+
+GFXTextureObject *GFXTextureManager::createTextureAsync( const Torque::Path &path, GFXTextureProfile *profile )
+{
+   PROFILE_SCOPE( GFXTextureManager_createTextureAsync );
+
+   Torque::Path correctPath = validatePath( path );
+
+   // Check the cache first... this may also be a
+   // placeholder for a load that is still running.
+   String pathNoExt = Torque::Path::Join( correctPath.getRoot(), ':', correctPath.getPath() );
+   pathNoExt = Torque::Path::Join( pathNoExt, '/', correctPath.getFileName() );
+
+   GFXTextureObject *retTexObj = _lookupTexture( pathNoExt, profile );
+   if ( retTexObj )
+      return retTexObj;
+
+   // Find the file the same way createTexture() does, but
+   // without loading it.
+   Torque::Path realPath;
+   bool isDDS = false;
+
+   if ( Torque::FS::IsFile( correctPath ) )
+   {
+      realPath = correctPath;
+      isDDS = sDDSExt.equal( correctPath.getExtension(), String::NoCase );
+   }
+   else
+   {
+      Torque::Path tryDDSPath = pathNoExt;
+      if ( tryDDSPath.getExtension().isNotEmpty() )
+         tryDDSPath.setFileName( tryDDSPath.getFullFileName() );
+      tryDDSPath.setExtension( sDDSExt );
+
+      if ( Torque::FS::IsFile( tryDDSPath ) )
+      {
+         realPath = tryDDSPath;
+         isDDS = true;
+      }
+      else if ( !GBitmap::sFindFile( correctPath, &realPath ) )
+         return createTexture( path, profile );
+   }
+
+   // The placeholder is a flat color, with normal
+   // maps getting a flat normal.
+   const ColorI color = profile->getType() == GFXTextureProfile::NormalMap ? 
+      ColorI( 128, 128, 255, 255 ) : ColorI( 128, 128, 128, 255 );
+
+   GBitmap *bmp = new GBitmap( 4, 4, false, GFXFormatR8G8B8A8 );
+   bmp->fill( color );
+
+   retTexObj = _createTexture( bmp, pathNoExt, profile, true, NULL );
+   if ( !retTexObj )
+      return NULL;
+
+   mAsyncLoads.increment();
+   AsyncLoad &load = mAsyncLoads.last();
+   load.item = new AsyncLoadItem( realPath, isDDS, getTextureDownscalePower( profile ) );
+   load.texture = retTexObj;
+
+   ThreadPool::GLOBAL().queueWorkItem( load.item );
+
+   return retTexObj;
+}
+
+bool GFXTextureManager::isTextureLoading( const GFXTextureObject *texture ) const
+{
+   for ( U32 i = 0; i < mAsyncLoads.size(); i++ )
+   {
+      if ( mAsyncLoads[i].texture.getPointer() == texture )
+         return true;
+   }
+
+   return false;
+}
+
+U32 GFXTextureManager::processAsyncLoads( U32 maxBytes )
+{
+   PROFILE_SCOPE( GFXTextureManager_processAsyncLoads );
+
+   U32 uploaded = 0;
+   U32 uploadedBytes = 0;
+
+   for ( U32 i = 0; i < mAsyncLoads.size(); )
+   {
+      // Stop at the first load still decoding so the
+      // textures are uploaded in the order requested.
+      AsyncLoad &load = mAsyncLoads[i];
+      if ( !load.item->isDecoded() )
+         break;
+
+      const U32 size = load.item->getDecodedSize();
+      if ( uploaded > 0 && uploadedBytes + size > maxBytes )
+         break;
+
+      _finishAsyncLoad( load );
+      mAsyncLoads.erase( i );
+
+      uploaded++;
+      uploadedBytes += size;
+   }
+
+   return uploaded;
+}
+
+void GFXTextureManager::flushAsyncLoads()
+{
+   PROFILE_SCOPE( GFXTextureManager_flushAsyncLoads );
+
+   while ( !mAsyncLoads.empty() )
+   {
+      _waitForAsyncDecode( mAsyncLoads.first() );
+      _finishAsyncLoad( mAsyncLoads.first() );
+      mAsyncLoads.pop_front();
+   }
+}
+
+void GFXTextureManager::_flushAsyncLoad( GFXTextureObject *texture )
+{
+   for ( U32 i = 0; i < mAsyncLoads.size(); i++ )
+   {
+      if ( mAsyncLoads[i].texture.getPointer() != texture )
+         continue;
+
+      _waitForAsyncDecode( mAsyncLoads[i] );
+      _finishAsyncLoad( mAsyncLoads[i] );
+      mAsyncLoads.erase( i );
+      return;
+   }
+}
+
+void GFXTextureManager::_waitForAsyncDecode( AsyncLoad &load )
+{
+   PROFILE_SCOPE( GFXTextureManager_waitForAsyncDecode );
+
+   // Only the flush paths get here, when something needs
+   // the texture right now and can't wait for a later frame.
+   while ( !load.item->isDecoded() )
+      Platform::sleep( 1 );
+}
+
+void GFXTextureManager::_finishAsyncLoad( AsyncLoad &load )
+{
+   PROFILE_SCOPE( GFXTextureManager_finishAsyncLoad );
+
+   AsyncLoadItem *item = load.item;
+   GFXTextureObject *obj = load.texture;
+
+   AssertFatal( item->isDecoded(), "GFXTextureManager::_finishAsyncLoad - The load hasn't been decoded yet!" );
+
+   GFXTextureObject *ret = NULL;
+   if ( item->mDDS )
+      ret = _createTexture( item->mDDS, obj->mProfile, false, obj );
+   else if ( item->mBitmap )
+      ret = _createTexture( item->mBitmap, obj->mTextureLookupName, obj->mProfile, false, obj );
+
+   if ( !ret )
+   {
+      Con::errorf( "GFXTextureManager::_finishAsyncLoad - Failed to load '%s'.", item->mPath.getFullPath().c_str() );
+
+      // Keep the placeholder for the holders of the handle
+      // but take it out of the cache so the next request
+      // for the texture tries again.
+      hashRemove( obj );
+      obj->mTextureLookupName = String::EmptyString;
+      return;
+   }
+
+   // Store the path and register for change
+   // notifications like createTexture() does.
+   obj->mPath = item->mPath;
+   FS::AddChangeNotification( obj->getPath(), this, &GFXTextureManager::_onFileChanged );
+}
+
 GFXTextureObject *GFXTextureManager::createTexture(  U32 width, U32 height, void *pixels, GFXFormat format, GFXTextureProfile *profile )
 {
    // For now, stuff everything into a GBitmap and pass it off... This may need to be revisited -- BJG
@@ -41,6 +41,9 @@
 #ifndef _TSIGNAL_H_
 #include "core/util/tSignal.h"
 #endif
+#ifndef _THREADSAFEREFCOUNT_H_
+#include "platform/threads/threadSafeRefCount.h"
+#endif
 #include "gfxTextureHandle.h"
 
 
@@ -109,6 +112,39 @@ public:
    virtual GFXTextureObject *createTexture(  const Torque::Path &path,
       GFXTextureProfile *profile );
 
+   /// Starts loading a texture file on the thread pool and returns
+   /// right away with a small placeholder texture.
+   ///
+   /// The file is read and decoded on a worker thread.  The decoded
+   /// image is then uploaded into the same texture object on the main
+   /// thread by processAsyncLoads(), so handles to the placeholder see
+   /// the real texture once it is done.
+   ///
+   /// If the file can't be found up front this falls back to the
+   /// synchronous createTexture() which does the full search.
+   ///
+   /// @see isTextureLoading
+   GFXTextureObject *createTextureAsync( const Torque::Path &path,
+      GFXTextureProfile *profile );
+
+   /// Returns true if the texture is still a placeholder waiting
+   /// for an async load to finish.
+   bool isTextureLoading( const GFXTextureObject *texture ) const;
+
+   /// Uploads decoded async loads in the order they were requested
+   /// until maxBytes of image data have been uploaded or it reaches
+   /// one which is still decoding.  At least one is always uploaded
+   /// if the oldest is ready so that loads make progress.
+   ///
+   /// This is called every frame with the budget set by
+   /// $pref::Video::asyncTextureUploadBudget.
+   ///
+   /// @return The number of textures uploaded.
+   U32 processAsyncLoads( U32 maxBytes );
+
+   /// Blocks until all pending async loads are decoded and uploaded.
+   void flushAsyncLoads();
+
    virtual GFXTextureObject *createTexture(  U32 width,
       U32 height,
       void *pixels,
@@ -203,6 +239,13 @@ public:
    /// 
    static S32 smTextureReductionLevel;
 
+   /// The KB of async loaded texture data to upload each frame.
+   ///
+   /// Exposed to script via $pref::Video::asyncTextureUploadBudget.
+   ///
+   /// @see processAsyncLoads
+   static S32 smAsyncUploadBudget;
+
 protected:
 
    /// File path to the missing texture
@@ -249,6 +292,32 @@ protected:
    /// All the allocated texture pool textures.
    TexturePoolMap mTexturePool;
 
+   /// The work item which reads and decodes an async load.
+   class AsyncLoadItem;
+
+   /// A texture waiting on an async load.
+   struct AsyncLoad
+   {
+      ThreadSafeRef<AsyncLoadItem> item;
+
+      /// The placeholder, which is held until the
+      /// load is finished so that it can't go away.
+      GFXTexHandle texture;
+   };
+
+   /// The async loads in the order they were requested.
+   Vector<AsyncLoad> mAsyncLoads;
+
+   /// Blocks until the async load has been decoded.  Only used
+   /// when flushing as it stalls the calling thread.
+   void _waitForAsyncDecode( AsyncLoad &load );
+
+   /// Uploads a decoded async load into its placeholder.
+   void _finishAsyncLoad( AsyncLoad &load );
+
+   /// Finishes the async load for the texture if it has one.
+   void _flushAsyncLoad( GFXTextureObject *texture );
+
    //-----------------------------------------------------------------------
    // Protected methods
    //-----------------------------------------------------------------------
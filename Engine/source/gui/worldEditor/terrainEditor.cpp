@@ -2452,6 +2452,15 @@ DefineEngineMethod( TerrainEditor, attachTerrain, void, (const char * terrain),
 
             Con::errorf(ConsoleLogEntry::Script, "TerrainEditor::attach: cannot attach to client TerrainBlock");
          }
+         else if (terrains[i]->getFile() && terrains[i]->getFile()->isStreamed())
+         {
+            // Streamed terrain files only keep some of their pages
+            // in memory and cannot be saved, so they are read only.
+            Con::errorf(ConsoleLogEntry::Script, "TerrainEditor::attach: cannot edit the streamed terrain '%s', load it with $pref::Terrain::streamPages off to edit it.",
+               terrains[i]->getName() ? terrains[i]->getName() : terrains[i]->getIdString());
+
+            terrains[i] = NULL;
+         }
       }
    }
 
@@ -40,12 +40,14 @@
 #include "math/mathIO.h"
 
 #include "core/stream/fileStream.h"
+#include "platform/threads/parallelFor.h"
 
 extern bool gEditingMission;
 
 IMPLEMENT_CO_NETOBJECT_V1(NavMesh);
 
 const U32 NavMesh::mMaxVertsPerPoly = 3;
+S32 NavMesh::smTileBuildBatch = 0;
 
 SimObjectPtr<SimSet> NavMesh::smServerSet = NULL;
 
@@ -213,6 +215,7 @@ NavMesh::NavMesh()
    mAlwaysRender = false;
 
    mBuilding = false;
+   mGeneration = 0;
    mCurLinkID = 0;
 }
 
@@ -344,6 +347,14 @@ void NavMesh::initPersistFields()
    Parent::initPersistFields();
 }
 
+void NavMesh::consoleInit()
+{
+   Con::addVariable("$Nav::tileBuildBatch", TypeS32, &smTileBuildBatch,
+      "Number of tiles a NavMesh builds per tick in a background build. The tiles "
+      "are built in parallel. If 0, builds one tile per worker thread.\n\n"
+      "@ingroup Navigation");
+}
+
 bool NavMesh::onAdd()
 {
    if(!Parent::onAdd())
@@ -598,6 +609,16 @@ DefineEngineMethod(NavMesh, deleteLinks, void, (),,
    //object->eraseLinks();
 }
 
+/// Returns the number of tiles to build at once.
+static U32 getTileBuildBatch()
+{
+   if(NavMesh::smTileBuildBatch > 0)
+      return NavMesh::smTileBuildBatch;
+   if(!JobSystem::isGlobalRunning())
+      return 1;
+   return JobSystem::GLOBAL().getNumThreads() + 1;
+}
+
 bool NavMesh::build(bool background, bool saveIntermediates)
 {
    if(mBuilding)
@@ -615,6 +636,7 @@ bool NavMesh::build(bool background, bool saveIntermediates)
    dtFreeNavMesh(nm);
    // Allocate a new navmesh.
    nm = dtAllocNavMesh();
+   mGeneration++;
    if(!nm)
    {
       Con::errorf("Could not allocate dtNavMesh for NavMesh %s", getIdString());
@@ -655,8 +677,9 @@ bool NavMesh::build(bool background, bool saveIntermediates)
 
    if(!background)
    {
+      // Build in batches so we don't hold the geometry of every tile at once.
       while(!mDirtyTiles.empty())
-         buildNextTile();
+         buildNextTiles(getTileBuildBatch());
    }
 
    return true;
@@ -785,66 +808,150 @@ void NavMesh::updateTiles(bool dirty)
 
 void NavMesh::processTick(const Move *move)
 {
-   buildNextTile();
+   buildNextTiles(getTileBuildBatch());
 }
 
 void NavMesh::buildNextTile()
 {
    PROFILE_SCOPE(NavMesh_buildNextTile);
-   if(!mDirtyTiles.empty())
+   if(mDirtyTiles.empty())
+      return;
+
+   // Pop a single dirty tile and process it.
+   U32 i = mDirtyTiles.front();
+   mDirtyTiles.pop_front();
+   const Tile &tile = mTiles[i];
+   // Intermediate data for tile build.
+   TileData tempdata;
+   TileData &tdata = mSaveIntermediates ? mTileData[i] : tempdata;
+
+   // Generate navmesh for this tile.
+   gatherTileGeometry(tile, tdata);
+   U32 dataSize = 0;
+   const char *error = NULL;
+   unsigned char *data = buildTileData(tile, tdata, ctx, dataSize, error);
+   addTileData(i, data, dataSize, error);
+
+   checkBuildComplete();
+}
+
+void NavMesh::buildNextTiles(U32 count)
+{
+   PROFILE_SCOPE(NavMesh_buildNextTiles);
+   count = getMin(count, (U32)mDirtyTiles.size());
+   if(!count)
+      return;
+
+   // Nothing to spread out, or nowhere to spread it to.
+   if(count == 1 || !JobSystem::isGlobalRunning())
    {
-      // Pop a single dirty tile and process it.
-      U32 i = mDirtyTiles.front();
+      for(U32 i = 0; i < count; i++)
+         buildNextTile();
+      return;
+   }
+
+   struct TileBuild
+   {
+      U32 index;
+      TileData *data;
+      unsigned char *navData;
+      U32 dataSize;
+      const char *error;
+   };
+
+   // Intermediate data for tile build.
+   TileData *tempData = mSaveIntermediates ? NULL : new TileData[count];
+
+   // Pop the dirty tiles and collect their geometry, which has to happen
+   // on this thread.
+   Vector<TileBuild> builds;
+   builds.setSize(count);
+   for(U32 i = 0; i < count; i++)
+   {
+      TileBuild &build = builds[i];
+      build.index = mDirtyTiles.front();
       mDirtyTiles.pop_front();
-      const Tile &tile = mTiles[i];
-      // Intermediate data for tile build.
-      TileData tempdata;
-      TileData &tdata = mSaveIntermediates ? mTileData[i] : tempdata;
-      
-      // Remove any previous data.
-      nm->removeTile(nm->getTileRefAt(tile.x, tile.y, 0), 0, 0);
+      build.data = mSaveIntermediates ? &mTileData[build.index] : &tempData[i];
+      build.navData = NULL;
+      build.dataSize = 0;
+      build.error = NULL;
+      gatherTileGeometry(mTiles[build.index], *build.data);
+   }
 
-      // Generate navmesh for this tile.
-      U32 dataSize = 0;
-      unsigned char* data = buildTileData(tile, tdata, dataSize);
-      if(data)
+   // Tiles don't depend on each other, so run the Recast stages in
+   // parallel.  Our NavContext logs to the console, so the workers get
+   // their own quiet context.
+   parallelFor(JobSystem::GLOBAL(), 0, count, 1, [&](U32 start, U32 end)
+   {
+      rcContext context(false);
+      for(U32 i = start; i < end; i++)
       {
-         // Add new data (navmesh owns and deletes the data).
-         dtStatus status = nm->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, 0);
-         int success = 1;
-         if(dtStatusFailed(status))
-         {
-            success = 0;
-            dtFree(data);
-         }
-         if(getEventManager())
-         {
-            String str = String::ToString("%d %d %d (%d, %d) %d %.3f %s",
-               getId(),
-               i, mTiles.size(),
-               tile.x, tile.y,
-               success,
-               ctx->getAccumulatedTime(RC_TIMER_TOTAL) / 1000.0f,
-               castConsoleTypeToString(tile.box));
-            getEventManager()->postEvent("NavMeshTileUpdate", str.c_str());
-            setMaskBits(LoadFlag);
-         }
+         TileBuild &build = builds[i];
+         build.navData = buildTileData(mTiles[build.index], *build.data, &context, build.dataSize, build.error);
       }
-      // Did we just build the last tile?
-      if(mDirtyTiles.empty())
+   });
+
+   for(U32 i = 0; i < count; i++)
+      addTileData(builds[i].index, builds[i].navData, builds[i].dataSize, builds[i].error);
+
+   delete [] tempData;
+
+   checkBuildComplete();
+}
+
+void NavMesh::addTileData(U32 index, unsigned char *data, U32 dataSize, const char *error)
+{
+   const Tile &tile = mTiles[index];
+
+   if(error)
+      Con::errorf("%s for tile (%d, %d) of NavMesh %s", error, tile.x, tile.y, getIdString());
+
+   // Remove any previous data.
+   nm->removeTile(nm->getTileRefAt(tile.x, tile.y, 0), 0, 0);
+
+   if(data)
+   {
+      // Add new data (navmesh owns and deletes the data).
+      dtStatus status = nm->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, 0);
+      int success = 1;
+      if(dtStatusFailed(status))
       {
-         ctx->stopTimer(RC_TIMER_TOTAL);
-         if(getEventManager())
-         {
-            String str = String::ToString("%d", getId());
-            getEventManager()->postEvent("NavMeshUpdate", str.c_str());
-            setMaskBits(LoadFlag);
-         }
-         mBuilding = false;
+         success = 0;
+         dtFree(data);
+      }
+      if(getEventManager())
+      {
+         String str = String::ToString("%d %d %d (%d, %d) %d %.3f %s",
+            getId(),
+            index, mTiles.size(),
+            tile.x, tile.y,
+            success,
+            ctx->getAccumulatedTime(RC_TIMER_TOTAL) / 1000.0f,
+            castConsoleTypeToString(tile.box));
+         getEventManager()->postEvent("NavMeshTileUpdate", str.c_str());
+         setMaskBits(LoadFlag);
       }
    }
 }
 
+void NavMesh::checkBuildComplete()
+{
+   // Did we just build the last tile?
+   if(!mDirtyTiles.empty())
+      return;
+
+   ctx->stopTimer(RC_TIMER_TOTAL);
+   Con::printf("NavMesh %s built in %.3f seconds", getIdString(),
+      ctx->getAccumulatedTime(RC_TIMER_TOTAL) / 1000.0f);
+   if(getEventManager())
+   {
+      String str = String::ToString("%d", getId());
+      getEventManager()->postEvent("NavMeshUpdate", str.c_str());
+      setMaskBits(LoadFlag);
+   }
+   mBuilding = false;
+}
+
 static void buildCallback(SceneObject* object,void *key)
 {
    SceneContainer::CallbackInfo* info = reinterpret_cast<SceneContainer::CallbackInfo*>(key);
@@ -852,16 +959,23 @@ static void buildCallback(SceneObject* object,void *key)
    object->buildPolyList(info->context,info->polyList,info->boundingBox,info->boundingSphere);
 }
 
-unsigned char *NavMesh::buildTileData(const Tile &tile, TileData &data, U32 &dataSize)
+void NavMesh::getTileBounds(const Tile &tile, F32 *bmin, F32 *bmax) const
 {
    // Push out tile boundaries a bit.
+   rcVcopy(bmin, tile.bmin);
+   rcVcopy(bmax, tile.bmax);
+   bmin[0] -= cfg.borderSize * cfg.cs;
+   bmin[2] -= cfg.borderSize * cfg.cs;
+   bmax[0] += cfg.borderSize * cfg.cs;
+   bmax[2] += cfg.borderSize * cfg.cs;
+}
+
+void NavMesh::gatherTileGeometry(const Tile &tile, TileData &data)
+{
+   PROFILE_SCOPE(NavMesh_gatherTileGeometry);
+
    F32 tileBmin[3], tileBmax[3];
-   rcVcopy(tileBmin, tile.bmin);
-   rcVcopy(tileBmax, tile.bmax);
-   tileBmin[0] -= cfg.borderSize * cfg.cs;
-   tileBmin[2] -= cfg.borderSize * cfg.cs;
-   tileBmax[0] += cfg.borderSize * cfg.cs;
-   tileBmax[2] += cfg.borderSize * cfg.cs;
+   getTileBounds(tile, tileBmin, tileBmax);
 
    // Parse objects from level into RC-compatible format.
    Box3F box = RCtoDTS(tileBmin, tileBmax);
@@ -874,12 +988,20 @@ unsigned char *NavMesh::buildTileData(const Tile &tile, TileData &data, U32 &dat
    getContainer()->findObjects(box, StaticObjectType | DynamicShapeObjectType, buildCallback, &info);
 
    // Parse water objects into the same list, but remember how much geometry was /not/ water.
-   U32 nonWaterVertCount = data.geom.getVertCount();
-   U32 nonWaterTriCount = data.geom.getTriCount();
+   data.nonWaterVertCount = data.geom.getVertCount();
+   data.nonWaterTriCount = data.geom.getTriCount();
    if(mWaterMethod != Ignore)
    {
       getContainer()->findObjects(box, WaterObjectType, buildCallback, &info);
    }
+}
+
+unsigned char *NavMesh::buildTileData(const Tile &tile, TileData &data, rcContext *context, U32 &dataSize, const char *&error)
+{
+   PROFILE_SCOPE(NavMesh_buildTileData);
+
+   F32 tileBmin[3], tileBmax[3];
+   getTileBounds(tile, tileBmin, tileBmax);
 
    // Check for no geometry.
    if (!data.geom.getVertCount())
@@ -897,12 +1019,12 @@ unsigned char *NavMesh::buildTileData(const Tile &tile, TileData &data, U32 &dat
    data.hf = rcAllocHeightfield();
    if(!data.hf)
    {
-      Con::errorf("Out of memory (rcHeightField) for NavMesh %s", getIdString());
+      error = "Out of memory (rcHeightField)";
       return NULL;
    }
-   if(!rcCreateHeightfield(ctx, *data.hf, width, height, tileBmin, tileBmax, cfg.cs, cfg.ch))
+   if(!rcCreateHeightfield(context, *data.hf, width, height, tileBmin, tileBmax, cfg.cs, cfg.ch))
    {
-      Con::errorf("Could not generate rcHeightField for NavMesh %s", getIdString());
+      error = "Could not generate rcHeightField";
       return NULL;
    }
 
@@ -914,18 +1036,18 @@ unsigned char *NavMesh::buildTileData(const Tile &tile, TileData &data, U32 &dat
    if(mWaterMethod == Solid)
    {
       // Treat water as solid: i.e. mark areas as walkable based on angle.
-      rcMarkWalkableTriangles(ctx, cfg.walkableSlopeAngle,
+      rcMarkWalkableTriangles(context, cfg.walkableSlopeAngle,
          data.geom.getVerts(), data.geom.getVertCount(),
          data.geom.getTris(), data.geom.getTriCount(), areas);
    }
    else
    {
       // Treat water as impassable: leave all area flags 0.
-      rcMarkWalkableTriangles(ctx, cfg.walkableSlopeAngle,
-         data.geom.getVerts(), nonWaterVertCount,
-         data.geom.getTris(), nonWaterTriCount, areas);
+      rcMarkWalkableTriangles(context, cfg.walkableSlopeAngle,
+         data.geom.getVerts(), data.nonWaterVertCount,
+         data.geom.getTris(), data.nonWaterTriCount, areas);
    }
-   rcRasterizeTriangles(ctx,
+   rcRasterizeTriangles(context,
       data.geom.getVerts(), data.geom.getVertCount(),
       data.geom.getTris(), areas, data.geom.getTriCount(),
       *data.hf, cfg.walkableClimb);
@@ -933,24 +1055,24 @@ unsigned char *NavMesh::buildTileData(const Tile &tile, TileData &data, U32 &dat
    delete[] areas;
 
    // Filter out areas with low ceilings and other stuff.
-   rcFilterLowHangingWalkableObstacles(ctx, cfg.walkableClimb, *data.hf);
-   rcFilterLedgeSpans(ctx, cfg.walkableHeight, cfg.walkableClimb, *data.hf);
-   rcFilterWalkableLowHeightSpans(ctx, cfg.walkableHeight, *data.hf);
+   rcFilterLowHangingWalkableObstacles(context, cfg.walkableClimb, *data.hf);
+   rcFilterLedgeSpans(context, cfg.walkableHeight, cfg.walkableClimb, *data.hf);
+   rcFilterWalkableLowHeightSpans(context, cfg.walkableHeight, *data.hf);
 
    data.chf = rcAllocCompactHeightfield();
    if(!data.chf)
    {
-      Con::errorf("Out of memory (rcCompactHeightField) for NavMesh %s", getIdString());
+      error = "Out of memory (rcCompactHeightField)";
       return NULL;
    }
-   if(!rcBuildCompactHeightfield(ctx, cfg.walkableHeight, cfg.walkableClimb, *data.hf, *data.chf))
+   if(!rcBuildCompactHeightfield(context, cfg.walkableHeight, cfg.walkableClimb, *data.hf, *data.chf))
    {
-      Con::errorf("Could not generate rcCompactHeightField for NavMesh %s", getIdString());
+      error = "Could not generate rcCompactHeightField";
       return NULL;
    }
-   if(!rcErodeWalkableArea(ctx, cfg.walkableRadius, *data.chf))
+   if(!rcErodeWalkableArea(context, cfg.walkableRadius, *data.chf))
    {
-      Con::errorf("Could not erode walkable area for NavMesh %s", getIdString());
+      error = "Could not erode walkable area";
       return NULL;
    }
 
@@ -963,22 +1085,22 @@ unsigned char *NavMesh::buildTileData(const Tile &tile, TileData &data, U32 &dat
 
    if(false)
    {
-      if(!rcBuildRegionsMonotone(ctx, *data.chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
+      if(!rcBuildRegionsMonotone(context, *data.chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
       {
-         Con::errorf("Could not build regions for NavMesh %s", getIdString());
+         error = "Could not build regions";
          return NULL;
       }
    }
    else
    {
-      if(!rcBuildDistanceField(ctx, *data.chf))
+      if(!rcBuildDistanceField(context, *data.chf))
       {
-         Con::errorf("Could not build distance field for NavMesh %s", getIdString());
+         error = "Could not build distance field";
          return NULL;
       }
-      if(!rcBuildRegions(ctx, *data.chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
+      if(!rcBuildRegions(context, *data.chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
       {
-         Con::errorf("Could not build regions for NavMesh %s", getIdString());
+         error = "Could not build regions";
          return NULL;
       }
    }
@@ -986,47 +1108,47 @@ unsigned char *NavMesh::buildTileData(const Tile &tile, TileData &data, U32 &dat
    data.cs = rcAllocContourSet();
    if(!data.cs)
    {
-      Con::errorf("Out of memory (rcContourSet) for NavMesh %s", getIdString());
+      error = "Out of memory (rcContourSet)";
       return NULL;
    }
-   if(!rcBuildContours(ctx, *data.chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *data.cs))
+   if(!rcBuildContours(context, *data.chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *data.cs))
    {
-      Con::errorf("Could not construct rcContourSet for NavMesh %s", getIdString());
+      error = "Could not construct rcContourSet";
       return NULL;
    }
    if(data.cs->nconts <= 0)
    {
-      Con::errorf("No contours in rcContourSet for NavMesh %s", getIdString());
+      error = "No contours in rcContourSet";
       return NULL;
    }
 
    data.pm = rcAllocPolyMesh();
    if(!data.pm)
    {
-      Con::errorf("Out of memory (rcPolyMesh) for NavMesh %s", getIdString());
+      error = "Out of memory (rcPolyMesh)";
       return NULL;
    }
-   if(!rcBuildPolyMesh(ctx, *data.cs, cfg.maxVertsPerPoly, *data.pm))
+   if(!rcBuildPolyMesh(context, *data.cs, cfg.maxVertsPerPoly, *data.pm))
    {
-      Con::errorf("Could not construct rcPolyMesh for NavMesh %s", getIdString());
+      error = "Could not construct rcPolyMesh";
       return NULL;
    }
 
    data.pmd = rcAllocPolyMeshDetail();
    if(!data.pmd)
    {
-      Con::errorf("Out of memory (rcPolyMeshDetail) for NavMesh %s", getIdString());
+      error = "Out of memory (rcPolyMeshDetail)";
       return NULL;
    }
-   if(!rcBuildPolyMeshDetail(ctx, *data.pm, *data.chf, cfg.detailSampleDist, cfg.detailSampleMaxError, *data.pmd))
+   if(!rcBuildPolyMeshDetail(context, *data.pm, *data.chf, cfg.detailSampleDist, cfg.detailSampleMaxError, *data.pmd))
    {
-      Con::errorf("Could not construct rcPolyMeshDetail for NavMesh %s", getIdString());
+      error = "Could not construct rcPolyMeshDetail";
       return NULL;
    }
 
    if(data.pm->nverts >= 0xffff)
    {
-      Con::errorf("Too many vertices in rcPolyMesh for NavMesh %s", getIdString());
+      error = "Too many vertices in rcPolyMesh";
       return NULL;
    }
    for(U32 i = 0; i < data.pm->npolys; i++)
@@ -1082,8 +1204,7 @@ unsigned char *NavMesh::buildTileData(const Tile &tile, TileData &data, U32 &dat
 
    if(!dtCreateNavMeshData(&params, &navData, &navDataSize))
    {
-      Con::errorf("Could not create dtNavMeshData for tile (%d, %d) of NavMesh %s",
-         tile.x, tile.y, getIdString());
+      error = "Could not create dtNavMeshData";
       return NULL;
    }
 
@@ -1558,6 +1679,7 @@ bool NavMesh::load()
    if(nm)
       dtFreeNavMesh(nm);
    nm = dtAllocNavMesh();
+   mGeneration++;
    if(!nm)
    {
       stream.close();
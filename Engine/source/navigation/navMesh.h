@@ -47,6 +47,7 @@
 class NavMesh : public SceneObject {
    typedef SceneObject Parent;
    friend class NavPath;
+   friend class NavPathScheduler;
 
 public:
    /// @name NavMesh build
@@ -199,6 +200,11 @@ public:
    /// @{
 
    static void initPersistFields();
+   static void consoleInit();
+
+   /// Number of dirty tiles built per tick in a background build.  If 0,
+   /// builds one per job system thread.
+   static S32 smTileBuildBatch;
 
    bool onAdd();
    void onRemove();
@@ -261,6 +267,17 @@ private:
    /// Builds the next tile in the dirty list.
    void buildNextTile();
 
+   /// Builds up to count tiles from the front of the dirty list.  The
+   /// Recast stages of the tiles run in parallel on the job system, if
+   /// there is one and more than one tile to build.
+   void buildNextTiles(U32 count);
+
+   /// Replaces the tile at mTiles[index] with the data built for it.
+   void addTileData(U32 index, unsigned char *data, U32 dataSize, const char *error);
+
+   /// Finishes the build once the last dirty tile has been built.
+   void checkBuildComplete();
+
    /// Save imtermediate navmesh creation data?
    bool mSaveIntermediates;
 
@@ -291,6 +308,8 @@ private:
    /// Intermediate data for tile creation.
    struct TileData {
       RecastPolyList          geom;
+      /// Amount of geom that isn't water.
+      U32 nonWaterVertCount, nonWaterTriCount;
       rcHeightfield        *hf;
       rcCompactHeightfield *chf;
       rcContourSet         *cs;
@@ -298,6 +317,7 @@ private:
       rcPolyMeshDetail     *pmd;
       TileData()
       {
+         nonWaterVertCount = nonWaterTriCount = 0;
          hf = NULL;
          chf = NULL;
          cs = NULL;
@@ -331,8 +351,17 @@ private:
    /// Update tile dimensions.
    void updateTiles(bool dirty = false);
 
-   /// Generates navmesh data for a single tile.
-   unsigned char *buildTileData(const Tile &tile, TileData &data, U32 &dataSize);
+   /// Gets the bounds of a tile including its border.
+   void getTileBounds(const Tile &tile, F32 *bmin, F32 *bmax) const;
+
+   /// Collects the geometry in a tile from the scene.
+   void gatherTileGeometry(const Tile &tile, TileData &data);
+
+   /// Generates navmesh data for a single tile from its gathered geometry.
+   /// This doesn't touch the scene or the console, so it's safe to call
+   /// from any thread.  On failure, returns NULL and sets error unless
+   /// the tile simply has no geometry.
+   unsigned char *buildTileData(const Tile &tile, TileData &data, rcContext *context, U32 &dataSize, const char *&error);
 
    /// @}
 
@@ -403,6 +432,11 @@ private:
    /// A simple flag to say we are building.
    bool mBuilding;
 
+   /// Bumped whenever nm is replaced by a new dtNavMesh.  Poly refs of
+   /// the new mesh can match ones of the old, so anything holding on to
+   /// refs has to check this too.
+   U32 mGeneration;
+
    /// @}
 
    /// @name Rendering
@@ -65,6 +65,10 @@ NavPath::NavPath() :
 
    mMaxIterations = 1;
 
+   mScheduled = false;
+   mPriority = 0;
+   mLegsLeft = 0;
+
    mAlwaysRender = false;
    mXray = false;
    mRenderSearch = false;
@@ -211,6 +215,12 @@ void NavPath::initPersistFields()
       "Plan this path over multiple updates instead of all at once.");
    addFieldV("maxIterations", TypeS32, Offset(mMaxIterations, NavPath), &ValidIterations,
       "Maximum iterations of path planning this path does per tick.");
+   addField("scheduled", TypeBool, Offset(mScheduled, NavPath),
+      "Plan this path with the shared path scheduler, which spends at most $Nav::pathBudget "
+      "milliseconds a tick on all scheduled paths. onPlanned(%success) is called on this "
+      "object once the path is ready.");
+   addField("priority", TypeS32, Offset(mPriority, NavPath),
+      "Scheduled paths with a higher priority are planned first.");
    addProtectedField("autoUpdate", TypeBool, Offset(mAutoUpdate, NavPath),
       &setProtectedAutoUpdate, &defaultProtectedGetFn,
       "If set, this path will automatically replan when its navigation mesh changes.");
@@ -277,6 +287,8 @@ bool NavPath::onAdd()
 
 void NavPath::onRemove()
 {
+   cancelScheduled();
+
    Parent::onRemove();
 
    removeFromScene();
@@ -372,6 +384,8 @@ void NavPath::resize()
 bool NavPath::plan()
 {
    PROFILE_SCOPE(NavPath_plan);
+   cancelScheduled();
+
    // Initialise filter.
    mFilter.setIncludeFlags(mLinkTypes.getFlags());
 
@@ -379,12 +393,95 @@ bool NavPath::plan()
    if(!init())
       return false;
 
-   if(mIsSliced)
+   if(mScheduled)
+      return planScheduled();
+   else if(mIsSliced)
       return planSliced();
    else
       return planInstant();
 }
 
+bool NavPath::planScheduled()
+{
+   setProcessTick(false);
+
+   S32 s = mVisitPoints.size();
+   if(s < 2)
+      return false;
+
+   mLegsLeft = s - 1;
+   mLegRequests.setSize(mLegsLeft);
+   mLegResults.clear();
+   mLegResults.setSize(mLegsLeft);
+   mStatus = DT_IN_PROGRESS;
+
+   NavPathScheduler *scheduler = NavPathScheduler::get();
+   for(U32 i = 0; i < mLegsLeft; i++)
+   {
+      mLegRequests[i] = scheduler->request(mMesh, mVisitPoints[s-1-i], mVisitPoints[s-2-i],
+         mFilter, mPriority, NavPathScheduler::Callback(this, &NavPath::onLegPlanned));
+   }
+
+   return true;
+}
+
+void NavPath::onLegPlanned(NavPathScheduler::RequestId id, const NavPathScheduler::Result &result)
+{
+   S32 leg = mLegRequests.find_next(id);
+   if(leg < 0)
+      return;
+
+   mLegRequests[leg] = 0;
+   mLegResults[leg] = result;
+   if(--mLegsLeft)
+      return;
+
+   // Every leg is planned, so join them up in order.  As with the other
+   // planners, a failed leg ends the path.
+   mStatus = DT_SUCCESS;
+   for(U32 i = 0; i < mLegResults.size(); i++)
+   {
+      const NavPathScheduler::Result &legResult = mLegResults[i];
+      if(!legResult.success)
+      {
+         mStatus = DT_FAILURE;
+         break;
+      }
+
+      U32 s = mPoints.size();
+      mPoints.merge(legResult.points);
+      mFlags.merge(legResult.flags);
+      if(s > 0 && legResult.points.size())
+         mLength += (mPoints[s] - mPoints[s-1]).len();
+      mLength += legResult.length;
+   }
+
+   mLegRequests.clear();
+   mLegResults.clear();
+
+   if(isServerObject())
+      setMaskBits(PathMask);
+
+   Con::executef(this, "onPlanned", Con::getBoolArg(finalise()));
+}
+
+void NavPath::cancelScheduled()
+{
+   if(!mLegsLeft)
+      return;
+
+   NavPathScheduler *scheduler = NavPathScheduler::get();
+   for(U32 i = 0; i < mLegRequests.size(); i++)
+   {
+      if(mLegRequests[i])
+         scheduler->cancel(mLegRequests[i]);
+   }
+
+   mLegRequests.clear();
+   mLegResults.clear();
+   mLegsLeft = 0;
+}
+
 bool NavPath::planSliced()
 {
    bool visited = visitNext();
@@ -535,7 +632,7 @@ void NavPath::processTick(const Move *move)
    if(!mMesh)
       if(Sim::findObject(mMeshName.c_str(), mMesh))
          plan();
-   if(dtStatusInProgress(mStatus))
+   if(dtStatusInProgress(mStatus) && !mLegsLeft)
       update();
 }
 
@@ -26,6 +26,7 @@
 #include "scene/sceneObject.h"
 #include "scene/simPath.h"
 #include "navMesh.h"
+#include "navPathScheduler.h"
 #include <DetourNavMeshQuery.h>
 
 class NavPath: public SceneObject {
@@ -51,6 +52,9 @@ public:
 
    S32 mMaxIterations;
 
+   bool mScheduled;
+   S32 mPriority;
+
    bool mAlwaysRender;
    bool mXray;
    bool mRenderSearch;
@@ -150,6 +154,21 @@ private:
    /// 'Visit' the last two points on our visit list.
    bool visitNext();
 
+   /// Queue every leg of the path with the path scheduler.
+   /// @return True if the legs were queued.
+   bool planScheduled();
+
+   /// Called by the path scheduler when a leg has been planned.
+   void onLegPlanned(NavPathScheduler::RequestId id, const NavPathScheduler::Result &result);
+
+   /// Remove legs that haven't been planned yet from the scheduler.
+   void cancelScheduled();
+
+   /// Scheduler requests for each leg, 0 once a leg is planned.
+   Vector<NavPathScheduler::RequestId> mLegRequests;
+   Vector<NavPathScheduler::Result> mLegResults;
+   U32 mLegsLeft;
+
    dtNavMeshQuery *mQuery;
    dtStatus mStatus;
    dtQueryFilter mFilter;
@@ -0,0 +1,443 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 Daniel Buckmaster
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "torqueRecast.h"
+#include "navPathScheduler.h"
+
+#include "console/engineAPI.h"
+#include "console/consoleTypes.h"
+#include "core/module.h"
+#include "core/util/hashFunction.h"
+#include "platform/threads/parallelFor.h"
+#include "T3D/gameBase/gameProcess.h"
+#include "scene/sceneContainer.h"
+
+#include <chrono>
+
+NavPathScheduler* NavPathScheduler::smScheduler = NULL;
+F32 NavPathScheduler::smBudgetMs = 2.0f;
+S32 NavPathScheduler::smCacheSize = 1024;
+
+MODULE_BEGIN( NavPathScheduler )
+
+   MODULE_SHUTDOWN
+   {
+      NavPathScheduler::destroy();
+   }
+
+MODULE_END;
+
+AFTER_MODULE_INIT( Sim )
+{
+   Con::addVariable( "$Nav::pathBudget", TypeF32, &NavPathScheduler::smBudgetMs,
+      "Milliseconds spent planning scheduled paths each tick.\n\n"
+      "@ingroup Navigation" );
+   Con::addVariable( "$Nav::pathCacheSize", TypeS32, &NavPathScheduler::smCacheSize,
+      "Maximum number of path corridors cached by the path scheduler.\n\n"
+      "@ingroup Navigation" );
+}
+
+/// Monotonic clock in milliseconds.
+static F64 getTimeMs()
+{
+   return std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Atomically increment the given counter and return the old value.
+static U32 atomicIncrement( volatile U32 &counter )
+{
+   U32 value;
+   do
+   {
+      value = counter;
+   }
+   while( !dCompareAndSwap( counter, value, value + 1 ) );
+
+   return value;
+}
+
+U64 NavPathScheduler::CacheKey::getHash() const
+{
+   U64 values[] = { (U64(generation) << 32) | meshId, (U64)startRef, (U64)endRef, (U64(includeFlags) << 16) | excludeFlags };
+   return Torque::hash64((const U8*)values, sizeof(values), 0);
+}
+
+bool NavPathScheduler::CacheKey::operator==(const CacheKey &other) const
+{
+   return meshId == other.meshId &&
+      generation == other.generation &&
+      startRef == other.startRef &&
+      endRef == other.endRef &&
+      includeFlags == other.includeFlags &&
+      excludeFlags == other.excludeFlags;
+}
+
+NavPathScheduler* NavPathScheduler::get()
+{
+   if(!smScheduler)
+      smScheduler = new NavPathScheduler();
+   return smScheduler;
+}
+
+void NavPathScheduler::destroy()
+{
+   delete smScheduler;
+   smScheduler = NULL;
+}
+
+NavPathScheduler::NavPathScheduler()
+{
+   mNextId = 1;
+   mProcessCount = 0;
+   resetStats();
+
+   if(ServerProcessList::get())
+      ServerProcessList::get()->preTickSignal().notify(this, &NavPathScheduler::_onPreTick);
+}
+
+NavPathScheduler::~NavPathScheduler()
+{
+   if(ServerProcessList::get())
+      ServerProcessList::get()->preTickSignal().remove(this, &NavPathScheduler::_onPreTick);
+
+   for(U32 i = 0; i < mQueue.size(); i++)
+      delete mQueue[i];
+   for(U32 i = 0; i < mQueries.size(); i++)
+      dtFreeNavMeshQuery(mQueries[i]);
+}
+
+void NavPathScheduler::_onPreTick()
+{
+   if(mQueue.size())
+      process(smBudgetMs);
+}
+
+NavPathScheduler::RequestId NavPathScheduler::request(NavMesh *mesh, const Point3F &from, const Point3F &to,
+   const dtQueryFilter &filter, S32 priority, const Callback &callback)
+{
+   Request *req = new Request;
+   req->id = mNextId++;
+   if(!mNextId)
+      mNextId = 1;
+   req->priority = priority;
+   req->mesh = mesh;
+   req->from = from;
+   req->to = to;
+   req->filter = filter;
+   req->callback = callback;
+   req->time = getTimeMs();
+   req->cancelled = false;
+
+   // Drop to height of statics.  The container can't be used from the
+   // planning threads, so do it now.
+   if(mesh && mesh->getContainer())
+   {
+      RayInfo info;
+      if(mesh->getContainer()->castRay(req->from, req->from - Point3F(0, 0, mesh->mWalkableHeight * 2.0f), StaticObjectType, &info))
+         req->from = info.point;
+      if(mesh->getContainer()->castRay(req->to + Point3F(0, 0, 0.1f), req->to - Point3F(0, 0, mesh->mWalkableHeight * 2.0f), StaticObjectType, &info))
+         req->to = info.point;
+   }
+
+   // Insert after everything with the same or a higher priority.
+   U32 index = mQueue.size();
+   while(index > 0 && mQueue[index - 1]->priority < priority)
+      index--;
+   mQueue.insert(index, req);
+
+   return req->id;
+}
+
+void NavPathScheduler::cancel(RequestId id)
+{
+   for(U32 i = 0; i < mQueue.size(); i++)
+   {
+      if(mQueue[i]->id == id)
+      {
+         delete mQueue[i];
+         mQueue.erase(i);
+         return;
+      }
+   }
+
+   for(U32 i = 0; i < mFinished.size(); i++)
+   {
+      if(mFinished[i]->id == id)
+      {
+         mFinished[i]->cancelled = true;
+         return;
+      }
+   }
+}
+
+U32 NavPathScheduler::process(F32 budgetMs)
+{
+   PROFILE_SCOPE(NavPathScheduler_process);
+
+   const U32 count = mQueue.size();
+   if(!count)
+      return 0;
+
+   const F64 start = getTimeMs();
+   mProcessCount++;
+
+   const U32 numSlots = JobSystem::isGlobalRunning() ? JobSystem::GLOBAL().getNumThreads() + 1 : 1;
+   while((U32)mQueries.size() < numSlots)
+   {
+      mQueries.push_back(dtAllocNavMeshQuery());
+      mQueryMeshes.push_back(NULL);
+   }
+
+   Vector<Work> work;
+   work.setSize(count);
+   for(U32 i = 0; i < count; i++)
+   {
+      work[i].request = mQueue[i];
+      work[i].done = false;
+      work[i].cacheHit = false;
+   }
+
+   // Each slot owns a query and takes requests in queue order until
+   // they run out or the budget is used up.  The first request is
+   // always planned so the queue can't stall.
+   volatile U32 next = 0;
+   auto planSlots = [&](U32 slotBegin, U32 slotEnd)
+   {
+      for(U32 slot = slotBegin; slot < slotEnd; slot++)
+      {
+         for(;;)
+         {
+            const U32 i = atomicIncrement(next);
+            if(i >= count || (i > 0 && getTimeMs() - start >= budgetMs))
+               break;
+
+            _plan(slot, work[i]);
+            work[i].done = true;
+         }
+      }
+   };
+
+   if(numSlots > 1)
+      parallelFor(JobSystem::GLOBAL(), 0, numSlots, 1, planSlots);
+   else
+      planSlots(0, 1);
+
+   // Take the planned requests off the queue before calling anyone back,
+   // since the callbacks may queue new ones.
+   const U32 firstFinished = mFinished.size();
+   for(U32 i = 0, j = 0; i < count; i++)
+   {
+      if(work[i].done)
+         mFinished.push_back(mQueue[i]);
+      else
+         mQueue[j++] = mQueue[i];
+   }
+   const U32 numDone = mFinished.size() - firstFinished;
+   mQueue.setSize(count - numDone);
+
+   const F64 end = getTimeMs();
+   for(U32 i = 0; i < count; i++)
+   {
+      Work &w = work[i];
+      if(!w.done)
+         continue;
+
+      mStats.numPlanned++;
+      mStats.totalLatencyMs += end - w.request->time;
+      if(w.cacheHit)
+      {
+         mStats.numCacheHits++;
+         Cache::Iterator iter = mCache.find(w.key.getHash());
+         if(iter != mCache.end())
+            iter->value.lastUsed = mProcessCount;
+      }
+      else if(w.corridor.size())
+         _addToCache(w.key, w.corridor);
+
+      if(!w.request->cancelled && !w.request->callback.empty())
+         w.request->callback(w.request->id, w.result);
+   }
+
+   for(U32 i = firstFinished; i < mFinished.size(); i++)
+      delete mFinished[i];
+   mFinished.setSize(firstFinished);
+
+   return numDone;
+}
+
+void NavPathScheduler::_plan(U32 slot, Work &work)
+{
+   PROFILE_SCOPE(NavPathScheduler_plan);
+
+   const Request &req = *work.request;
+   Result &result = work.result;
+
+   NavMesh *mesh = req.mesh;
+   if(!mesh || !mesh->getNavMesh())
+      return;
+
+   const dtNavMesh *nm = mesh->getNavMesh();
+   dtNavMeshQuery *query = mQueries[slot];
+   if(mQueryMeshes[slot] != nm)
+   {
+      if(dtStatusFailed(query->init(nm, MaxNodes)))
+         return;
+      mQueryMeshes[slot] = nm;
+   }
+
+   // Convert to Detour-friendly coordinates and data structures.
+   F32 from[] = {req.from.x, req.from.z, -req.from.y};
+   F32 to[] =   {req.to.x,   req.to.z,   -req.to.y};
+   F32 extx = mesh->mWalkableRadius * 4.0f;
+   F32 extz = mesh->mWalkableHeight;
+   F32 extents[] = {extx, extz, extx};
+   dtPolyRef startRef, endRef;
+
+   if(dtStatusFailed(query->findNearestPoly(from, extents, &req.filter, &startRef, NULL)) || !startRef)
+      return;
+   if(dtStatusFailed(query->findNearestPoly(to, extents, &req.filter, &endRef, NULL)) || !endRef)
+      return;
+
+   work.key.meshId = mesh->getId();
+   work.key.generation = mesh->mGeneration;
+   work.key.startRef = startRef;
+   work.key.endRef = endRef;
+   work.key.includeFlags = req.filter.getIncludeFlags();
+   work.key.excludeFlags = req.filter.getExcludeFlags();
+
+   dtPolyRef path[MaxPathLen];
+   S32 pathLen = 0;
+
+   // Use the cached corridor if its tiles haven't been rebuilt since.  A
+   // whole new mesh reuses the old refs, which the generation catches.
+   Cache::Iterator iter = mCache.find(work.key.getHash());
+   if(iter != mCache.end() && iter->value.key == work.key)
+   {
+      const Vector<dtPolyRef> &corridor = iter->value.corridor;
+      bool valid = true;
+      for(U32 i = 0; i < corridor.size() && valid; i++)
+         valid = nm->isValidPolyRef(corridor[i]);
+
+      if(valid)
+      {
+         pathLen = corridor.size();
+         dMemcpy(path, corridor.address(), pathLen * sizeof(dtPolyRef));
+         work.cacheHit = true;
+      }
+   }
+
+   if(!work.cacheHit)
+   {
+      const dtStatus status = query->findPath(startRef, endRef, from, to, &req.filter, path, &pathLen, MaxPathLen);
+      if(dtStatusFailed(status) || !pathLen)
+         return;
+
+      // Partial paths depend on where the search gave up, so
+      // only cache complete ones.
+      if(!dtStatusDetail(status, DT_PARTIAL_RESULT))
+      {
+         work.corridor.setSize(pathLen);
+         dMemcpy(work.corridor.address(), path, pathLen * sizeof(dtPolyRef));
+      }
+   }
+
+   F32 straightPath[MaxPathLen * 3];
+   S32 straightPathLen;
+   dtPolyRef straightPathPolys[MaxPathLen];
+   U8 straightPathFlags[MaxPathLen];
+
+   if(dtStatusFailed(query->findStraightPath(from, to, path, pathLen,
+      straightPath, straightPathFlags,
+      straightPathPolys, &straightPathLen, MaxPathLen)))
+      return;
+
+   result.points.setSize(straightPathLen);
+   result.flags.setSize(straightPathLen);
+   for(S32 i = 0; i < straightPathLen; i++)
+   {
+      result.points[i] = RCtoDTS(straightPath + i * 3);
+      nm->getPolyFlags(straightPathPolys[i], &result.flags[i]);
+      if(i > 0)
+         result.length += (result.points[i] - result.points[i - 1]).len();
+   }
+
+   result.success = true;
+}
+
+void NavPathScheduler::_addToCache(const CacheKey &key, const Vector<dtPolyRef> &corridor)
+{
+   if(smCacheSize <= 0)
+      return;
+
+   // Make room by evicting the least recently used corridor.
+   const U64 hash = key.getHash();
+   if(!mCache.contains(hash) && (S32)mCache.size() >= smCacheSize)
+   {
+      Cache::Iterator oldest = mCache.begin();
+      for(Cache::Iterator iter = mCache.begin(); iter != mCache.end(); ++iter)
+      {
+         if(iter->value.lastUsed < oldest->value.lastUsed)
+            oldest = iter;
+      }
+      mCache.erase(oldest);
+   }
+
+   CacheEntry &entry = mCache[hash];
+   entry.key = key;
+   entry.corridor = corridor;
+   entry.lastUsed = mProcessCount;
+}
+
+void NavPathScheduler::flushCache()
+{
+   mCache.clear();
+}
+
+NavPathScheduler::Stats NavPathScheduler::getStats() const
+{
+   Stats stats = mStats;
+   stats.queueDepth = mQueue.size();
+   return stats;
+}
+
+void NavPathScheduler::resetStats()
+{
+   dMemset(&mStats, 0, sizeof(mStats));
+}
+
+DefineEngineFunction(getNavPathSchedulerStats, String, (),,
+   "@brief Get statistics of the path scheduler.\n\n"
+   "@return \"queueDepth planned averageLatencyMs cacheHitRate\", where planned is the "
+   "number of paths planned since the stats were last reset.\n\n"
+   "@ingroup Navigation")
+{
+   const NavPathScheduler::Stats stats = NavPathScheduler::get()->getStats();
+   return String::ToString("%d %d %g %g", stats.queueDepth, stats.numPlanned,
+      stats.getAverageLatency(), stats.getCacheHitRate());
+}
+
+DefineEngineFunction(resetNavPathSchedulerStats, void, (),,
+   "@brief Reset the statistics of the path scheduler.\n\n"
+   "@ingroup Navigation")
+{
+   NavPathScheduler::get()->resetStats();
+}
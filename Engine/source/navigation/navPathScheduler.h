@@ -0,0 +1,188 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 Daniel Buckmaster
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _NAVPATHSCHEDULER_H_
+#define _NAVPATHSCHEDULER_H_
+
+#include "navMesh.h"
+#include "core/util/tDictionary.h"
+#include "core/util/delegate.h"
+#include <DetourNavMeshQuery.h>
+
+/// Plans paths for many clients on a shared per-tick time budget.
+///
+/// Requests are queued with a priority and planned by process() in order
+/// of priority, oldest first among equal priorities.  process() plans them
+/// in parallel on the job system, each thread with its own dtNavMeshQuery,
+/// and leaves whatever doesn't fit in the budget for the next call.  It runs
+/// every server tick with a budget of $Nav::pathBudget milliseconds.
+///
+/// The polygon corridors of finished paths are cached by their start and
+/// goal polygons, so repeated requests between the same places skip the
+/// search and only straighten the cached corridor.
+class NavPathScheduler
+{
+public:
+   /// Identifies a request.  0 is never a valid request.
+   typedef U32 RequestId;
+
+   /// The path planned for a request.
+   struct Result
+   {
+      bool success;
+      Vector<Point3F> points;
+      Vector<U16> flags;
+      F32 length;
+
+      Result() : success(false), length(0.0f) {}
+   };
+
+   /// Called on the main thread once a request has been planned.
+   typedef Delegate<void(RequestId, const Result&)> Callback;
+
+   struct Stats
+   {
+      /// Number of requests waiting to be planned.
+      U32 queueDepth;
+      /// Number of requests planned since the last reset.
+      U32 numPlanned;
+      /// Number of planned requests that used a cached corridor.
+      U32 numCacheHits;
+      /// Total time from request to result of the planned requests.
+      F64 totalLatencyMs;
+
+      F32 getAverageLatency() const { return numPlanned ? totalLatencyMs / numPlanned : 0.0f; }
+      F32 getCacheHitRate() const { return numPlanned ? F32(numCacheHits) / numPlanned : 0.0f; }
+   };
+
+   /// Milliseconds spent planning paths each tick.
+   static F32 smBudgetMs;
+
+   /// Maximum number of corridors kept in the cache.
+   static S32 smCacheSize;
+
+   static NavPathScheduler* get();
+
+   /// Deletes the scheduler, if it was ever created.
+   static void destroy();
+
+   ~NavPathScheduler();
+
+   /// Queues a path from one point to another.
+   RequestId request(NavMesh *mesh, const Point3F &from, const Point3F &to,
+                     const dtQueryFilter &filter, S32 priority, const Callback &callback);
+
+   /// Removes a request from the queue without calling its callback.
+   void cancel(RequestId id);
+
+   /// Plans queued requests until budgetMs have passed.  At least one
+   /// request is always planned.
+   /// @return The number of requests planned.
+   U32 process(F32 budgetMs);
+
+   /// Empties the corridor cache.
+   void flushCache();
+
+   Stats getStats() const;
+   void resetStats();
+
+protected:
+   NavPathScheduler();
+
+   static const U32 MaxPathLen = 2048;
+   static const U32 MaxNodes = 2048;
+
+   struct Request
+   {
+      RequestId id;
+      S32 priority;
+      SimObjectPtr<NavMesh> mesh;
+      Point3F from, to;
+      dtQueryFilter filter;
+      Callback callback;
+      F64 time;
+      bool cancelled;
+   };
+
+   /// Identifies a cached corridor.
+   struct CacheKey
+   {
+      SimObjectId meshId;
+      /// NavMesh::mGeneration when the corridor was found.
+      U32 generation;
+      dtPolyRef startRef, endRef;
+      U16 includeFlags, excludeFlags;
+
+      U64 getHash() const;
+      bool operator==(const CacheKey &other) const;
+   };
+
+   struct CacheEntry
+   {
+      CacheKey key;
+      Vector<dtPolyRef> corridor;
+      U32 lastUsed;
+   };
+
+   /// A request being planned by process().
+   struct Work
+   {
+      Request *request;
+      bool done;
+      bool cacheHit;
+      CacheKey key;
+      Vector<dtPolyRef> corridor;
+      Result result;
+   };
+
+   /// Queued requests, highest priority first.
+   Vector<Request*> mQueue;
+
+   /// Planned requests whose callbacks are being called.  Kept so that
+   /// a callback can still cancel the others.
+   Vector<Request*> mFinished;
+
+   /// One query per job system thread.
+   Vector<dtNavMeshQuery*> mQueries;
+   Vector<const dtNavMesh*> mQueryMeshes;
+
+   typedef Map<U64, CacheEntry> Cache;
+   Cache mCache;
+
+   RequestId mNextId;
+   U32 mProcessCount;
+   Stats mStats;
+
+   /// Plans one request with the given query.  Runs on any thread, so
+   /// it only reads the cache.
+   void _plan(U32 slot, Work &work);
+
+   /// Adds a corridor to the cache, evicting the least recently used
+   /// one if it is full.
+   void _addToCache(const CacheKey &key, const Vector<dtPolyRef> &corridor);
+
+   void _onPreTick();
+
+   static NavPathScheduler* smScheduler;
+};
+
+#endif
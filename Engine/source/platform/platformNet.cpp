@@ -99,11 +99,20 @@ typedef int SOCKET;
 
 #endif
 
+// The network thread uses recvmmsg/sendmmsg, which are Linux only.
+#if defined( TORQUE_OS_LINUX )
+#define TORQUE_NET_IO_THREAD
+#include <fcntl.h>
+#endif
+
 #include "core/util/tVector.h"
 #include "platform/platformNetAsync.h"
 #include "console/console.h"
 #include "core/util/journal/process.h"
 #include "core/util/journal/journal.h"
+#include "core/util/safeDelete.h"
+#include "platform/threads/thread.h"
+#include "platform/platformIntrinsics.h"
 
 
 NetSocket NetSocket::INVALID = NetSocket::fromHandle(-1);
@@ -477,6 +486,9 @@ bool Net::smMulticastEnabled = true;
 bool Net::smIpv4Enabled = true;
 bool Net::smIpv6Enabled = false;
 //
+// Threading
+bool Net::smUseIOThread = false;
+//
 
 // the Socket structure helps us keep track of the
 // above states
@@ -664,6 +676,385 @@ static void IPSocket6ToNetAddress(const struct sockaddr_in6 *sockAddr, NetAddres
    address->address.ipv6.netScope = sockAddr->sin6_scope_id;
 }
 
+/// Returns true if the packet was sent by us, e.g. a broadcast.
+static bool isOwnPacket(const NetAddress &srcAddress)
+{
+   return srcAddress.type == NetAddress::IPAddress &&
+      srcAddress.address.ipv4.netNum[0] == 127 &&
+      srcAddress.address.ipv4.netNum[1] == 0 &&
+      srcAddress.address.ipv4.netNum[2] == 0 &&
+      srcAddress.address.ipv4.netNum[3] == 1 &&
+      srcAddress.port == PlatformNetState::netPort;
+}
+
+#ifdef TORQUE_NET_IO_THREAD
+
+/// A preallocated packet passed between the main thread and the network thread.
+struct NetPacketBuffer
+{
+   sockaddr_storage address;
+   socklen_t addressLen;
+   U32 socketIndex;
+   U32 size;
+   U8 data[Net::MaxPacketDataSize];
+};
+
+/// Lock free ring of preallocated packets for a single producer and a
+/// single consumer thread.
+///
+/// The producer fills the slots returned by getWrite() and publishes them
+/// with commitWrite().  The consumer reads the slots returned by getRead()
+/// and hands them back with commitRead().
+class NetPacketRing
+{
+   NetPacketBuffer *mPackets;
+   U32 mMask;
+
+   /// Index of the next packet to read.  Only written by the consumer.
+   volatile U32 mHead;
+
+   /// Index of the next packet to write.  Only written by the producer.
+   volatile U32 mTail;
+
+   static void advance( volatile U32 &index, U32 count )
+   {
+      // There's only one writer, so this always succeeds.  It's used
+      // for the memory barrier.
+      const U32 value = index;
+      dCompareAndSwap( index, value, value + count );
+   }
+
+public:
+
+   /// @param capacity Number of packets in the ring, must be a power of two.
+   NetPacketRing( U32 capacity )
+      : mMask( capacity - 1 ), mHead( 0 ), mTail( 0 )
+   {
+      AssertFatal( isPow2( capacity ), "NetPacketRing - capacity must be a power of two" );
+      mPackets = new NetPacketBuffer[ capacity ];
+   }
+
+   ~NetPacketRing()
+   {
+      delete [] mPackets;
+   }
+
+   U32 getUsed() { return dAtomicRead( mTail ) - dAtomicRead( mHead ); }
+   U32 getFree() { return mMask + 1 - getUsed(); }
+
+   NetPacketBuffer& getWrite( U32 i ) { return mPackets[ ( mTail + i ) & mMask ]; }
+   void commitWrite( U32 count ) { advance( mTail, count ); }
+
+   NetPacketBuffer& getRead( U32 i ) { return mPackets[ ( mHead + i ) & mMask ]; }
+   void commitRead( U32 count ) { advance( mHead, count ); }
+};
+
+/// Bumped whenever the network thread is stopped.
+static U32 gNetIOThreadGeneration = 0;
+
+/// Thread that owns the I/O on the unreliable port while it is enabled.
+///
+/// Incoming packets are drained from the sockets with recvmmsg into
+/// mReceived, which Net::process() empties on the main thread.  Packets
+/// sent from the main thread are queued in mToSend and written out with
+/// sendmmsg, a batch at a time.
+class NetIOThread : public Thread
+{
+public:
+
+   enum
+   {
+      RingSize = 1024,
+      BatchSize = 64,
+   };
+
+   NetPacketRing mReceived;
+   NetPacketRing mToSend;
+
+   /// The ipv4 and ipv6 sockets, either of which may be invalid.
+   SOCKET mSockets[2];
+
+   /// Pipe used to wake the thread up when there is something to send.
+   int mWakePipe[2];
+   volatile U32 mWakePending;
+
+   NetIOThread( SOCKET udpFd, SOCKET udp6Fd )
+      : mReceived( RingSize ), mToSend( RingSize ), mWakePending( 0 )
+   {
+      mSockets[0] = udpFd;
+      mSockets[1] = udp6Fd;
+
+      if ( pipe( mWakePipe ) == 0 )
+      {
+         fcntl( mWakePipe[0], F_SETFL, O_NONBLOCK );
+         fcntl( mWakePipe[1], F_SETFL, O_NONBLOCK );
+      }
+      else
+         mWakePipe[0] = mWakePipe[1] = -1;
+   }
+
+   ~NetIOThread()
+   {
+      if ( mWakePipe[0] != -1 )
+      {
+         close( mWakePipe[0] );
+         close( mWakePipe[1] );
+      }
+   }
+
+   bool isValid() const { return mWakePipe[0] != -1; }
+
+   void wake()
+   {
+      if ( dCompareAndSwap( mWakePending, 0, 1 ) )
+      {
+         const U8 byte = 0;
+         if ( write( mWakePipe[1], &byte, 1 ) < 0 )
+            mWakePending = 0;
+      }
+   }
+
+   /// Stops the thread and waits for it to exit.
+   void shutdown()
+   {
+      stop();
+      mWakePending = 0;
+      wake();
+      join();
+   }
+
+   /// Queues a packet to be sent by the thread.  Returns false if it has to
+   /// be sent directly instead.
+   bool queueSend( const NetAddress *address, const U8 *buffer, S32 bufferSize )
+   {
+      // Only the main thread may produce into the ring.
+      if ( !ThreadManager::isMainThread() || bufferSize > Net::MaxPacketDataSize )
+         return false;
+
+      U32 socketIndex;
+      if ( address->type == NetAddress::IPAddress || address->type == NetAddress::IPBroadcastAddress )
+         socketIndex = 0;
+      else if ( address->type == NetAddress::IPV6Address )
+         socketIndex = 1;
+      else
+         return false;
+
+      if ( mSockets[ socketIndex ] == InvalidSocketHandle || !mToSend.getFree() )
+         return false;
+
+      NetPacketBuffer &packet = mToSend.getWrite( 0 );
+      if ( socketIndex == 0 )
+      {
+         NetAddressToIPSocket( address, (sockaddr_in*)&packet.address );
+         packet.addressLen = sizeof( sockaddr_in );
+      }
+      else
+      {
+         NetAddressToIPSocket6( address, (sockaddr_in6*)&packet.address );
+         packet.addressLen = sizeof( sockaddr_in6 );
+      }
+      packet.socketIndex = socketIndex;
+      packet.size = bufferSize;
+      dMemcpy( packet.data, buffer, bufferSize );
+
+      mToSend.commitWrite( 1 );
+      wake();
+      return true;
+   }
+
+   /// Triggers the packet receive event for everything received so far.
+   void processReceived()
+   {
+      const U32 generation = gNetIOThreadGeneration;
+      U8 data[ Net::MaxPacketDataSize ];
+
+      const U32 count = mReceived.getUsed();
+      for ( U32 i = 0; i < count; i++ )
+      {
+         NetPacketBuffer &packet = mReceived.getRead( i );
+
+         NetAddress srcAddress;
+         if ( packet.address.ss_family == AF_INET )
+            IPSocketToNetAddress( (sockaddr_in*)&packet.address, &srcAddress );
+         else if ( packet.address.ss_family == AF_INET6 )
+            IPSocket6ToNetAddress( (sockaddr_in6*)&packet.address, &srcAddress );
+         else
+            continue;
+
+         if ( packet.size == 0 || isOwnPacket( srcAddress ) )
+            continue;
+
+         // Handlers may close the port, which deletes the ring, so
+         // hand them a copy and stop if that happened.
+         const U32 size = packet.size;
+         dMemcpy( data, packet.data, size );
+         Net::smPacketReceive->trigger( srcAddress, RawData( (S8*)data, size ) );
+
+         if ( generation != gNetIOThreadGeneration )
+            return;
+      }
+
+      mReceived.commitRead( count );
+   }
+
+   virtual void run( void *arg = 0 )
+   {
+      while ( !checkForStop() )
+      {
+         _send();
+
+         pollfd fds[3];
+         U32 numFds = 0;
+
+         fds[ numFds ].fd = mWakePipe[0];
+         fds[ numFds ].events = POLLIN;
+         numFds++;
+
+         // If the main thread has fallen behind leave the packets
+         // with the socket and check back shortly.
+         const bool canReceive = mReceived.getFree() > 0;
+         for ( U32 i = 0; i < 2; i++ )
+         {
+            fds[ numFds ].fd = mSockets[i] != InvalidSocketHandle ? mSockets[i] : -1;
+            fds[ numFds ].events = canReceive ? POLLIN : 0;
+            numFds++;
+         }
+
+         if ( poll( fds, numFds, canReceive ? 100 : 1 ) <= 0 )
+            continue;
+
+         if ( fds[0].revents & POLLIN )
+         {
+            U8 bytes[64];
+            while ( read( mWakePipe[0], bytes, sizeof( bytes ) ) > 0 ) {}
+            mWakePending = 0;
+         }
+
+         for ( U32 i = 0; i < 2; i++ )
+         {
+            if ( fds[ i + 1 ].revents & POLLIN )
+               _receive( mSockets[i] );
+         }
+      }
+   }
+
+protected:
+
+   void _receive( SOCKET socketFd )
+   {
+      mmsghdr msgs[ BatchSize ];
+      iovec iovs[ BatchSize ];
+
+      for ( ;; )
+      {
+         const U32 count = getMin( mReceived.getFree(), (U32)BatchSize );
+         if ( !count )
+            return;
+
+         for ( U32 i = 0; i < count; i++ )
+         {
+            NetPacketBuffer &packet = mReceived.getWrite( i );
+            iovs[i].iov_base = packet.data;
+            iovs[i].iov_len = Net::MaxPacketDataSize;
+
+            dMemset( &msgs[i], 0, sizeof( mmsghdr ) );
+            msgs[i].msg_hdr.msg_name = &packet.address;
+            msgs[i].msg_hdr.msg_namelen = sizeof( sockaddr_storage );
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+         }
+
+         const S32 received = recvmmsg( socketFd, msgs, count, MSG_DONTWAIT, NULL );
+         if ( received <= 0 )
+            return;
+
+         for ( S32 i = 0; i < received; i++ )
+         {
+            NetPacketBuffer &packet = mReceived.getWrite( i );
+            packet.addressLen = msgs[i].msg_hdr.msg_namelen;
+            packet.size = msgs[i].msg_len;
+         }
+
+         mReceived.commitWrite( received );
+
+         if ( (U32)received < count )
+            return;
+      }
+   }
+
+   void _send()
+   {
+      mmsghdr msgs[ BatchSize ];
+      iovec iovs[ BatchSize ];
+
+      for ( ;; )
+      {
+         const U32 used = getMin( mToSend.getUsed(), (U32)BatchSize );
+         if ( !used )
+            return;
+
+         // A batch can only go to one socket, so stop at
+         // the first packet for the other one.
+         const U32 socketIndex = mToSend.getRead( 0 ).socketIndex;
+         U32 count = 0;
+         for ( ; count < used; count++ )
+         {
+            NetPacketBuffer &packet = mToSend.getRead( count );
+            if ( packet.socketIndex != socketIndex )
+               break;
+
+            iovs[ count ].iov_base = packet.data;
+            iovs[ count ].iov_len = packet.size;
+
+            dMemset( &msgs[ count ], 0, sizeof( mmsghdr ) );
+            msgs[ count ].msg_hdr.msg_name = &packet.address;
+            msgs[ count ].msg_hdr.msg_namelen = packet.addressLen;
+            msgs[ count ].msg_hdr.msg_iov = &iovs[ count ];
+            msgs[ count ].msg_hdr.msg_iovlen = 1;
+         }
+
+         // Like a failed sendto, a packet that can't be sent is dropped.
+         const S32 sent = sendmmsg( mSockets[ socketIndex ], msgs, count, 0 );
+         mToSend.commitRead( sent > 0 ? sent : 1 );
+      }
+   }
+};
+
+static NetIOThread* gNetIOThread = NULL;
+
+static void startNetIOThread()
+{
+   if ( !Net::smUseIOThread || Journal::IsPlaying() )
+      return;
+
+   SOCKET udpFd = PlatformNetState::smReservedSocketList.resolve( PlatformNetState::udpSocket );
+   SOCKET udp6Fd = PlatformNetState::smReservedSocketList.resolve( PlatformNetState::udp6Socket );
+   if ( udpFd == InvalidSocketHandle && udp6Fd == InvalidSocketHandle )
+      return;
+
+   gNetIOThread = new NetIOThread( udpFd, udp6Fd );
+   if ( !gNetIOThread->isValid() )
+   {
+      Con::errorf( "Unable to start the network thread." );
+      SAFE_DELETE( gNetIOThread );
+      return;
+   }
+
+   gNetIOThread->start();
+}
+
+static void stopNetIOThread()
+{
+   if ( !gNetIOThread )
+      return;
+
+   gNetIOThread->shutdown();
+   SAFE_DELETE( gNetIOThread );
+   gNetIOThreadGeneration++;
+}
+
+#endif // TORQUE_NET_IO_THREAD
+
 //
 
 NetSocket Net::openListenPort(U16 port, NetAddress::Type addressType)
@@ -902,6 +1293,10 @@ Net::Error Net::sendtoSocket(NetSocket handleFd, const U8 *buffer, S32  bufferSi
 
 bool Net::openPort(S32 port, bool doBind)
 {
+#ifdef TORQUE_NET_IO_THREAD
+   stopNetIOThread();
+#endif
+
    if (PlatformNetState::udpSocket != NetSocket::INVALID)
    {
       closeSocket(PlatformNetState::udpSocket);
@@ -917,6 +1312,7 @@ bool Net::openPort(S32 port, bool doBind)
    Net::smMulticastEnabled = Con::getBoolVariable("pref::Net::Multicast6Enabled", true);
    Net::smIpv4Enabled = Con::getBoolVariable("pref::Net::IPV4Enabled", true);
    Net::smIpv6Enabled = Con::getBoolVariable("pref::Net::IPV6Enabled", false);
+   Net::smUseIOThread = Con::getBoolVariable("pref::Net::IOThread", false);
 
    // we turn off VDP in non-release builds because VDP does not support broadcast packets
    // which are required for LAN queries (PC->Xbox connectivity).  The wire protocol still
@@ -1039,6 +1435,10 @@ bool Net::openPort(S32 port, bool doBind)
 
    PlatformNetState::netPort = port;
 
+#ifdef TORQUE_NET_IO_THREAD
+   startNetIOThread();
+#endif
+
    return PlatformNetState::udpSocket != NetSocket::INVALID || PlatformNetState::udp6Socket != NetSocket::INVALID;
 }
 
@@ -1047,8 +1447,22 @@ NetSocket Net::getPort()
    return PlatformNetState::udpSocket;
 }
 
+Net::Error Net::getPortAddress(NetAddress::Type type, NetAddress *address)
+{
+   if (type == NetAddress::IPAddress)
+      return PlatformNetState::getSocketAddress(PlatformNetState::smReservedSocketList.resolve(PlatformNetState::udpSocket), AF_INET, address);
+   else if (type == NetAddress::IPV6Address)
+      return PlatformNetState::getSocketAddress(PlatformNetState::smReservedSocketList.resolve(PlatformNetState::udp6Socket), AF_INET6, address);
+
+   return WrongProtocolType;
+}
+
 void Net::closePort()
 {
+#ifdef TORQUE_NET_IO_THREAD
+   stopNetIOThread();
+#endif
+
    if (PlatformNetState::udpSocket != NetSocket::INVALID)
       closeSocket(PlatformNetState::udpSocket);
    if (PlatformNetState::udp6Socket != NetSocket::INVALID)
@@ -1060,6 +1474,11 @@ Net::Error Net::sendto(const NetAddress *address, const U8 *buffer, S32  bufferS
    if(Journal::IsPlaying())
       return NoError;
 
+#ifdef TORQUE_NET_IO_THREAD
+   if (gNetIOThread && gNetIOThread->queueSend(address, buffer, bufferSize))
+      return NoError;
+#endif
+
    SOCKET socketFd;
 
    if(address->type == NetAddress::IPAddress || address->type == NetAddress::IPBroadcastAddress)
@@ -1107,8 +1526,15 @@ Net::Error Net::sendto(const NetAddress *address, const U8 *buffer, S32  bufferS
 void Net::process()
 {
    // Process listening sockets
-   processListenSocket(PlatformNetState::udpSocket);
-   processListenSocket(PlatformNetState::udp6Socket);
+#ifdef TORQUE_NET_IO_THREAD
+   if (gNetIOThread)
+      gNetIOThread->processReceived();
+   else
+#endif
+   {
+      processListenSocket(PlatformNetState::udpSocket);
+      processListenSocket(PlatformNetState::udp6Socket);
+   }
 
 #ifdef TORQUE_NET_CURL
    // process HTTPObject
@@ -1384,12 +1810,7 @@ void Net::processListenSocket(NetSocket socketHandle)
       if (bytesRead <= 0)
          continue;
 
-      if (srcAddress.type == NetAddress::IPAddress &&
-         srcAddress.address.ipv4.netNum[0] == 127 &&
-         srcAddress.address.ipv4.netNum[1] == 0 &&
-         srcAddress.address.ipv4.netNum[2] == 0 &&
-         srcAddress.address.ipv4.netNum[3] == 1 &&
-         srcAddress.port == PlatformNetState::netPort)
+      if (isOwnPacket(srcAddress))
          continue;
 
       tmpBuffer.size = bytesRead;
@@ -214,6 +214,10 @@ struct Net
    static bool smMulticastEnabled;
    static bool smIpv4Enabled;
    static bool smIpv6Enabled;
+
+   /// If true, openPort() starts a thread that does the I/O on the
+   /// unreliable port in batches.  Only supported on Linux.
+   static bool smUseIOThread;
    
    static ConnectionNotifyEvent*   smConnectionNotify;
    static ConnectionAcceptedEvent* smConnectionAccept;
@@ -232,6 +236,9 @@ struct Net
    static bool openPort(S32 connectPort, bool doBind = true);
    static NetSocket getPort();
 
+   /// Gets the address the unreliable port is bound to.
+   static Error getPortAddress(NetAddress::Type type, NetAddress *address);
+
    static void closePort();
    static Error sendto(const NetAddress *address, const U8 *buffer, S32 bufferSize);
 
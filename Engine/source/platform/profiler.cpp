@@ -35,13 +35,123 @@
 
 #include "platform/profiler.h"
 #include "platform/threads/thread.h"
+#include "platform/platformIntrinsics.h"
 
 #include "console/engineAPI.h"
 
+#include <chrono>
+
 #ifdef TORQUE_ENABLE_PROFILER
 ProfilerRootData *ProfilerRootData::sRootList = NULL;
 Profiler *gProfiler = NULL;
 
+/// Trace events recorded by a single thread.
+///
+/// Only the owning thread writes to its buffer.  Events are written
+/// before the count is bumped, so the trace writer can read everything
+/// below the count while the thread keeps going.  Buffers are linked
+/// into a list on first use and live as long as the profiler.
+struct ProfilerThreadTrace
+{
+   enum { MaxStackDepth = 256 };
+
+   struct Event
+   {
+      ProfilerRootData *root;
+      U64 time;
+      bool begin;
+   };
+
+   /// Small sequential id used as the trace tid.
+   U32 index;
+   dsize_t threadId;
+   bool isMainThread;
+
+   /// Capture this buffer was last reset for.  Only published once the
+   /// rest of the buffer has been reset, see getThreadTrace().
+   volatile U32 epoch;
+
+   volatile U32 numEvents;
+   U32 numDropped;
+
+   /// Open blocks so we can name the end events.
+   U32 stackDepth;
+   ProfilerRootData *stack[MaxStackDepth];
+
+   Event *events;
+   ProfilerThreadTrace *next;
+};
+
+static ProfilerThreadTrace* volatile sThreadTraces = NULL;
+static thread_local ProfilerThreadTrace *tThreadTrace = NULL;
+
+/// Monotonic trace clock in nanoseconds.
+static U64 getTraceTime()
+{
+   return (U64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Returns the calling thread's trace buffer for the given capture,
+/// creating or resetting it as needed.
+static ProfilerThreadTrace* getThreadTrace(U32 epoch, U32 capacity)
+{
+   ProfilerThreadTrace *trace = tThreadTrace;
+   if (!trace)
+   {
+      trace = (ProfilerThreadTrace *) malloc(sizeof(ProfilerThreadTrace));
+      trace->threadId = ThreadManager::getCurrentThreadId();
+      trace->isMainThread = ThreadManager::isMainThread();
+      trace->epoch = epoch - 1;
+      trace->numEvents = 0;
+      trace->events = (ProfilerThreadTrace::Event *) malloc(sizeof(ProfilerThreadTrace::Event) * capacity);
+
+      // Lock free push onto the buffer list.
+      ProfilerThreadTrace *head;
+      do
+      {
+         head = sThreadTraces;
+         trace->next = head;
+         trace->index = head ? head->index + 1 : 0;
+      }
+      while (!dCompareAndSwap(sThreadTraces, head, trace));
+
+      tThreadTrace = trace;
+   }
+
+   const U32 oldEpoch = trace->epoch;
+   if (oldEpoch != epoch)
+   {
+      // Reset the buffer before publishing the new epoch.  The trace
+      // writer only reads buffers of the current epoch, so it must not
+      // see the new one together with the old count.  The swap is a full
+      // barrier so the reset can't be reordered past it.
+      trace->numEvents = 0;
+      trace->numDropped = 0;
+      trace->stackDepth = 0;
+      dCompareAndSwap(trace->epoch, oldEpoch, epoch);
+   }
+
+   return trace;
+}
+
+static void recordTraceEvent(ProfilerThreadTrace *trace, U32 capacity, ProfilerRootData *root, bool begin)
+{
+   const U32 index = trace->numEvents;
+   if (index >= capacity)
+   {
+      trace->numDropped++;
+      return;
+   }
+
+   ProfilerThreadTrace::Event &event = trace->events[index];
+   event.root = root;
+   event.time = getTraceTime();
+   event.begin = begin;
+
+   // Publish the event.
+   dFetchAndAdd(trace->numEvents, 1);
+}
+
 // Uncomment the following line to enable a debugging aid for mismatched profiler blocks.
 //#define TORQUE_PROFILER_DEBUG
 
@@ -156,6 +266,12 @@ Profiler::Profiler()
    mDumpToConsole   = false;
    mDumpToFile      = false;
    mDumpFileName[0] = '\0';
+
+   mTracing = 0;
+   mTraceEpoch = 0;
+   mTraceStartTime = 0;
+   mTraceDumpToFile = false;
+   mTraceFileName[0] = '\0';
 }
 
 Profiler::~Profiler()
@@ -163,6 +279,15 @@ Profiler::~Profiler()
    reset();
    free(mRootProfilerData);
    gProfiler = NULL;
+
+   mTracing = 0;
+   while (sThreadTraces)
+   {
+      ProfilerThreadTrace *trace = sThreadTraces;
+      sThreadTraces = trace->next;
+      free(trace->events);
+      free(trace);
+   }
 }
 
 void Profiler::reset()
@@ -289,8 +414,37 @@ const char * Profiler::constructProfilePath(ProfilerData * pd)
    return "root";
 }
 #endif
+void Profiler::tracePush(ProfilerRootData *root)
+{
+   ProfilerThreadTrace *trace = getThreadTrace(mTraceEpoch, TraceEventsPerThread);
+
+   if (trace->stackDepth >= ProfilerThreadTrace::MaxStackDepth)
+      return;
+
+   trace->stack[trace->stackDepth++] = root;
+
+   if (root->mEnabled)
+      recordTraceEvent(trace, TraceEventsPerThread, root, true);
+}
+
+void Profiler::tracePop()
+{
+   // Ignore blocks that were opened before this capture started.
+   ProfilerThreadTrace *trace = tThreadTrace;
+   if (!trace || trace->epoch != mTraceEpoch || trace->stackDepth == 0)
+      return;
+
+   ProfilerRootData *root = trace->stack[--trace->stackDepth];
+
+   if (root->mEnabled)
+      recordTraceEvent(trace, TraceEventsPerThread, root, false);
+}
+
 void Profiler::hashPush(ProfilerRootData *root)
 {
+   if(mTracing)
+      tracePush(root);
+
 #ifdef TORQUE_MULTITHREAD
    // Ignore non-main-thread profiler activity.
    if( !ThreadManager::isMainThread() )
@@ -386,6 +540,9 @@ void Profiler::dumpToFile(const char* fileName)
 
 void Profiler::hashPop(ProfilerRootData *expected)
 {
+   if(mTracing)
+      tracePop();
+
 #ifdef TORQUE_MULTITHREAD
    // Ignore non-main-thread profiler activity.
    if( !ThreadManager::isMainThread() )
@@ -429,6 +586,12 @@ void Profiler::hashPop(ProfilerRootData *expected)
       if(!mEnabled && mNextEnable)
          startHighResolutionTimer(mCurrentProfilerData->mStartTime);
 
+      if(mTraceDumpToFile)
+      {
+         mTraceDumpToFile = false;
+         stopTrace(mTraceFileName);
+      }
+
 #if defined(TORQUE_OS_WIN)
       // The high performance counters under win32 are unreliable when running on multiple
       // processors. When the profiler is enabled, we restrict Torque to a single processor.
@@ -634,6 +797,95 @@ void Profiler::dump()
    mDumpFileName[0] = '\0';
 }
 
+void Profiler::startTrace()
+{
+   mTraceDumpToFile = false;
+   mTraceStartTime = getTraceTime();
+
+   // Threads reset their buffers when they see the new epoch.
+   dFetchAndAdd(mTraceEpoch, 1);
+   mTracing = 1;
+}
+
+void Profiler::dumpTraceToFile(const char *fileName)
+{
+   AssertFatal(dStrlen(fileName) < DumpFileNameLength, "Error, trace filename too long");
+   dStrcpy(mTraceFileName, fileName, DumpFileNameLength);
+   mTraceDumpToFile = true;
+}
+
+bool Profiler::stopTrace(const char *fileName)
+{
+   mTracing = 0;
+   return writeTrace(fileName);
+}
+
+bool Profiler::writeTrace(const char *fileName)
+{
+   FileStream fws;
+   if (!fws.open(fileName, Torque::FS::File::Write))
+   {
+      Con::errorf("Profiler::writeTrace - Cannot write trace to '%s'!", fileName);
+      return false;
+   }
+
+   // Keep our own file writes out of the trace.
+   const bool enableSave = mEnabled;
+   mEnabled = false;
+
+   char buffer[512];
+   const char *separator = "";
+   U32 numEvents = 0;
+   U32 numDropped = 0;
+
+   dStrcpy(buffer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", sizeof(buffer));
+   fws.write(dStrlen(buffer), buffer);
+
+   for (ProfilerThreadTrace *trace = sThreadTraces; trace; trace = trace->next)
+   {
+      if (dAtomicRead(trace->epoch) != mTraceEpoch)
+         continue;
+
+      const U32 count = dAtomicRead(trace->numEvents);
+      if (!count)
+         continue;
+
+      if (trace->isMainThread)
+         dSprintf(buffer, sizeof(buffer), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Main Thread\"}}", separator, trace->index);
+      else
+         dSprintf(buffer, sizeof(buffer), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}", separator, trace->index, trace->index);
+      fws.write(dStrlen(buffer), buffer);
+      separator = ",\n";
+
+      for (U32 i = 0; i < count; i++)
+      {
+         const ProfilerThreadTrace::Event &event = trace->events[i];
+
+         // Trace timestamps are in microseconds.
+         const F64 time = F64(S64(event.time - mTraceStartTime)) / 1000.0;
+
+         dSprintf(buffer, sizeof(buffer), "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+            separator, event.root->mName, event.begin ? 'B' : 'E', time, trace->index);
+         fws.write(dStrlen(buffer), buffer);
+      }
+
+      numEvents += count;
+      numDropped += trace->numDropped;
+   }
+
+   dStrcpy(buffer, "\n]}\n", sizeof(buffer));
+   fws.write(dStrlen(buffer), buffer);
+   fws.close();
+
+   mEnabled = enableSave;
+
+   Con::printf("Profiler: wrote %u trace events to '%s'.", numEvents, fileName);
+   if (numDropped)
+      Con::warnf("Profiler: %u trace events were dropped, the per thread buffers were full.", numDropped);
+
+   return true;
+}
+
 void Profiler::enableMarker(const char *marker, bool enable)
 {
    reset();
@@ -714,6 +966,35 @@ DefineEngineFunction( profilerDumpToFile, void, ( const char* fileName ),,
       gProfiler->dumpToFile(fileName);
 }
 
+DefineEngineFunction( profilerTraceStart, void, (),,
+            "@brief Starts capturing a timeline of the profile markers on all threads.\n\n"
+            "Unlike the percentage dumps this also records markers hit on worker threads, "
+            "such as the thread pool and async I/O.  Use profilerTraceDumpToFile() to end the "
+            "capture.  It does not require the profiler to be enabled.\n\n"
+            "@see profilerTraceDumpToFile\n"
+            "@ingroup Debugging" )
+{
+   if(gProfiler)
+      gProfiler->startTrace();
+}
+
+DefineEngineFunction( profilerTraceDumpToFile, void, ( const char* fileName ),,
+            "@brief Ends a trace capture and writes it to a file as Chrome trace event JSON.\n\n"
+            "The file is written once the main thread has finished its current frame.  It can "
+            "be viewed in chrome://tracing or the Perfetto UI.\n"
+            "@param fileName Name and path of file to write the trace to. Must use forward slashes (/).\n"
+            "@tsexample\n"
+            "profilerTraceStart();\n"
+            "// ... play for a few frames ...\n"
+            "profilerTraceDumpToFile( \"C:/Torque/trace.json\" );\n"
+            "@endtsexample\n\n"
+            "@see profilerTraceStart\n"
+            "@ingroup Debugging" )
+{
+   if(gProfiler)
+      gProfiler->dumpTraceToFile(fileName);
+}
+
 DefineEngineFunction( profilerReset, void, (),,
             "@brief Resets the profiler, clearing it of all its data.\n\n"
             "If the profiler is currently running, it will first be disabled. "
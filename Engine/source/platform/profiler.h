@@ -44,8 +44,15 @@ struct ProfilerRootData;
 /// profilerDump();                                         //dumps all profiler data to the console
 /// profilerDumpToFile(string filename);                    //dumps all profiler data to a given file
 /// profilerMarkerEnable((string markerName, bool enable);  //enables or disables a given profile tag
+/// profilerTraceStart();                                   //starts capturing a timeline on all threads
+/// profilerTraceDumpToFile(string filename);               //stops the capture and writes it as a Chrome trace
 /// @endcode
 ///
+/// The percentage dumps only cover the main thread.  The trace capture
+/// records begin and end events of every profile block on every thread
+/// into per thread buffers, and writes them as Chrome trace event JSON
+/// which can be loaded in chrome://tracing or Perfetto.
+///
 /// The C++ code side of the profiler uses pairs of PROFILE_START() and PROFILE_END().
 ///
 /// When using these macros, make sure there is a PROFILE_END() for every PROFILE_START
@@ -72,7 +79,8 @@ class Profiler
 {
    enum {
       MaxStackDepth = 256,
-      DumpFileNameLength = 256
+      DumpFileNameLength = 256,
+      TraceEventsPerThread = 1 << 18
    };
    U32 mCurrentHash;
 
@@ -87,6 +95,27 @@ class Profiler
    bool mDumpToConsole;
    bool mDumpToFile;
    char mDumpFileName[DumpFileNameLength];
+
+   /// @name Trace Capture
+   /// @{
+
+   /// Set while trace events are being recorded.
+   volatile U32 mTracing;
+
+   /// Bumped on every capture so threads know to reset their buffers.
+   volatile U32 mTraceEpoch;
+
+   /// Trace time at which the current capture started.
+   U64 mTraceStartTime;
+
+   bool mTraceDumpToFile;
+   char mTraceFileName[DumpFileNameLength];
+
+   void tracePush(ProfilerRootData *root);
+   void tracePop();
+   bool writeTrace(const char *fileName);
+   /// @}
+
    void dump();
    void validate();
 public:
@@ -109,6 +138,18 @@ public:
    void hashPop(ProfilerRootData *expected=NULL);
    /// Enable a profiler marker
    void enableMarker(const char *marker, bool enabled);
+   /// Start capturing a trace of the profile blocks on all threads
+   void startTrace();
+   /// Stop capturing and write the trace as Chrome trace event JSON
+   /// once the main thread has left all profile blocks.
+   /// @param fileName filename to write the trace to
+   void dumpTraceToFile(const char *fileName);
+   /// Stop capturing and write the trace immediately.  Blocks still
+   /// open on any thread are left unterminated in the output.
+   /// @param fileName filename to write the trace to
+   /// @return false if the file could not be written
+   bool stopTrace(const char *fileName);
+   bool isTracing() const { return mTracing != 0; }
 #ifdef TORQUE_ENABLE_PROFILE_PATH
    /// Get current profile path
    const char * getProfilePath();
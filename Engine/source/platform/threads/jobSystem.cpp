@@ -0,0 +1,532 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "platform/threads/jobSystem.h"
+#include "platform/threads/thread.h"
+#include "platform/platformCPUCount.h"
+#include "platform/platformIntrinsics.h"
+#include "platform/profiler.h"
+#include "core/frameAllocator.h"
+#include "core/strings/stringFunctions.h"
+
+
+/// System and deque index of the calling thread.  Only set on worker threads.
+static thread_local JobSystem* tCurrentSystem;
+static thread_local U32 tCurrentIndex;
+
+/// Atomically decrement the given counter and return the new value.
+static U32 atomicDecrement( volatile U32& counter )
+{
+   U32 value;
+   do
+   {
+      value = counter;
+      AssertFatal( value > 0, "JobSystem - counter underflow" );
+   }
+   while( !dCompareAndSwap( counter, value, value - 1 ) );
+
+   return value - 1;
+}
+
+
+//=============================================================================
+//    JobSystem::JobDeque.
+//=============================================================================
+
+/// Spinlock-protected ring buffer of jobs.
+///
+/// The owning thread pushes and pops at the back while thieves take from the
+/// front.  Jobs are only held for a very short time, so a spinlock is cheaper
+/// here than a mutex.
+struct JobSystem::JobDeque
+{
+   volatile U32 mLock;
+   Job** mItems;
+   U32 mCapacity;
+   volatile U32 mHead;
+   volatile U32 mTail;
+
+   JobDeque()
+      : mLock( 0 ),
+        mItems( NULL ),
+        mCapacity( 0 ),
+        mHead( 0 ),
+        mTail( 0 ) {}
+
+   ~JobDeque()
+   {
+      dFree( mItems );
+   }
+
+   /// Quick unlocked check; may be stale by the time it returns.
+   bool isEmpty() const { return ( mHead == mTail ); }
+
+   void lock()
+   {
+      while( !dCompareAndSwap( mLock, 0, 1 ) )
+         ;
+   }
+
+   void unlock()
+   {
+      dCompareAndSwap( mLock, 1, 0 );
+   }
+
+   void pushBack( Job* job )
+   {
+      lock();
+
+      const U32 count = mTail - mHead;
+      if( count == mCapacity )
+      {
+         // Grow and unwrap the ring.
+
+         const U32 newCapacity = getMax( mCapacity * 2, U32( 64 ) );
+         Job** newItems = ( Job** ) dMalloc( newCapacity * sizeof( Job* ) );
+         for( U32 i = 0; i < count; ++ i )
+            newItems[ i ] = mItems[ ( mHead + i ) & ( mCapacity - 1 ) ];
+
+         dFree( mItems );
+         mItems = newItems;
+         mCapacity = newCapacity;
+         mHead = 0;
+         mTail = count;
+      }
+
+      mItems[ mTail & ( mCapacity - 1 ) ] = job;
+      mTail ++;
+
+      unlock();
+   }
+
+   /// Take the newest job.
+   Job* popBack()
+   {
+      Job* job = NULL;
+
+      lock();
+      if( mHead != mTail )
+      {
+         mTail --;
+         job = mItems[ mTail & ( mCapacity - 1 ) ];
+      }
+      unlock();
+
+      return job;
+   }
+
+   /// Take the oldest job.
+   Job* popFront()
+   {
+      Job* job = NULL;
+
+      lock();
+      if( mHead != mTail )
+      {
+         job = mItems[ mHead & ( mCapacity - 1 ) ];
+         mHead ++;
+      }
+      unlock();
+
+      return job;
+   }
+};
+
+
+//=============================================================================
+//    JobSystem::WorkerThread.
+//=============================================================================
+
+struct JobSystem::WorkerThread : public Thread
+{
+   WorkerThread( JobSystem* system, U32 index );
+
+   WorkerThread*     getNext() { return mNext; }
+   virtual void      run( void* arg = 0 );
+
+private:
+   U32               mIndex;
+   JobSystem*        mSystem;
+   WorkerThread*     mNext;
+};
+
+JobSystem::WorkerThread::WorkerThread( JobSystem* system, U32 index )
+   : mIndex( index ),
+     mSystem( system )
+{
+   // Link us to the system's thread list.
+
+   mNext = system->mThreads;
+   system->mThreads = this;
+}
+
+void JobSystem::WorkerThread::run( void* arg )
+{
+   #ifdef TORQUE_DEBUG
+   {
+      // Set the thread's name for debugging.
+      char buffer[ 2048 ];
+      dSprintf( buffer, sizeof( buffer ), "JobSystem(%s) WorkerThread %i", mSystem->mName.c_str(), mIndex );
+      _setName( buffer );
+   }
+   #endif
+
+   tCurrentSystem = mSystem;
+   tCurrentIndex = mIndex;
+
+   while( !checkForStop() )
+   {
+      Job* job = mSystem->_findJob( mIndex );
+      if( !job )
+      {
+         // Announce that we are about to sleep and then look again so that
+         // we can't miss a job queued in between.
+
+         dFetchAndAdd( mSystem->mNumSleeping, 1 );
+
+         job = mSystem->_findJob( mIndex );
+         if( !job )
+            mSystem->mSemaphore.acquire();
+
+         dFetchAndAdd( mSystem->mNumSleeping, ( U32 ) -1 );
+      }
+
+      if( job )
+         mSystem->_execute( job );
+   }
+
+   tCurrentSystem = NULL;
+}
+
+
+//=============================================================================
+//    JobSystem::Job.
+//=============================================================================
+
+JobSystem::Job::Job( JobFunction function, void* data )
+   : mFunction( function ),
+     mData( data ),
+     mNumUnfinished( 1 ),
+     mNumPendingDependencies( 1 ),
+     mSubmitted( false )
+{
+}
+
+
+//=============================================================================
+//    JobSystem.
+//=============================================================================
+
+JobSystem::JobSystem( const char* name, U32 numThreads )
+   : mName( name ),
+     mNumThreads( numThreads ),
+     mDeques( NULL ),
+     mThreads( NULL ),
+     mNumSleeping( 0 ),
+     mSemaphore( 0 ),
+     mNumWaiting( 0 ),
+     mWaitSemaphore( 0 )
+{
+   if( !mNumThreads )
+   {
+      // Use platformCPUInfo directly as in the case of the global system,
+      // Platform::SystemInfo will not yet have been initialized.
+      //
+      // Only go by physical cores.  The global ThreadPool already runs a
+      // worker per logical CPU, so sizing by those as well would leave
+      // twice as many threads as the CPU can run whenever both are busy.
+
+      U32 numLogical = 0;
+      U32 numCores = 0;
+
+      CPUInfo::CPUCount( numLogical, numCores );
+
+      const U32 baseCount = numCores ? numCores : numLogical;
+      mNumThreads = ( baseCount > 1 ) ? baseCount - 1 : 1;
+   }
+
+   // Deque zero belongs to the non-worker threads.
+
+   mDeques = new JobDeque[ mNumThreads + 1 ];
+
+   for( U32 i = 0; i < mNumThreads; ++ i )
+   {
+      WorkerThread* thread = new WorkerThread( this, i + 1 );
+      thread->start();
+   }
+}
+
+//--------------------------------------------------------------------------
+
+JobSystem::~JobSystem()
+{
+   shutdown();
+
+   // Drop jobs that were never executed.
+
+   Job* job;
+   while( ( job = mDeques[ 0 ].popBack() ) != NULL )
+      job->release();
+
+   delete [] mDeques;
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::shutdown()
+{
+   if( !mThreads )
+      return;
+
+   // Tell our worker threads to stop.
+
+   for( WorkerThread* thread = mThreads; thread != 0; thread = thread->getNext() )
+      thread->stop();
+
+   // Release the semaphore as many times as there are threads.
+
+   for( U32 n = 0; n < mNumThreads; ++ n )
+      mSemaphore.release();
+
+   for( WorkerThread* thread = mThreads; thread != 0; )
+   {
+      WorkerThread* next = thread->getNext();
+      thread->join();
+      delete thread;
+      thread = next;
+   }
+
+   mThreads = NULL;
+
+   // Move what's left on the workers' deques over to deque zero so that
+   // waitForJob() can still finish them on the calling thread.
+
+   for( U32 i = 1; i <= mNumThreads; ++ i )
+   {
+      Job* job;
+      while( ( job = mDeques[ i ].popFront() ) != NULL )
+         mDeques[ 0 ].pushBack( job );
+   }
+
+   mNumThreads = 0;
+}
+
+//--------------------------------------------------------------------------
+
+U32 JobSystem::_getCurrentIndex() const
+{
+   if( tCurrentSystem == this )
+      return tCurrentIndex;
+
+   return 0;
+}
+
+//--------------------------------------------------------------------------
+
+JobSystem::Job* JobSystem::_findJob( U32 index )
+{
+   Job* job = mDeques[ index ].popBack();
+   if( job )
+      return job;
+
+   // Steal from the others, starting with our neighbor.
+
+   const U32 numDeques = mNumThreads + 1;
+   for( U32 i = 1; i < numDeques; ++ i )
+   {
+      JobDeque& victim = mDeques[ ( index + i ) % numDeques ];
+      if( victim.isEmpty() )
+         continue;
+
+      job = victim.popFront();
+      if( job )
+         return job;
+   }
+
+   return NULL;
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::_enqueue( Job* job )
+{
+   // The queue holds a reference until the job has been executed.
+   job->addRef();
+   mDeques[ _getCurrentIndex() ].pushBack( job );
+
+   if( dAtomicRead( mNumSleeping ) )
+      mSemaphore.release();
+
+   // Threads blocked in waitForJob() can help out with it.
+   _wakeWaiters();
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::_execute( Job* job )
+{
+   if( job->mFunction )
+   {
+      // Jobs may allocate scratch from the FrameAllocator of whatever thread
+      // they run on; drop what they leave behind.
+
+      const U32 waterMark = FrameAllocator::getWaterMark();
+      job->mFunction( job->mData );
+      FrameAllocator::setWaterMark( waterMark );
+   }
+
+   _finish( job );
+   job->release();
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::_finish( Job* job )
+{
+   if( atomicDecrement( job->mNumUnfinished ) != 0 )
+      return;
+
+   // Let anyone waiting on this job, or on a job this finishes
+   // in turn, check again.
+   _wakeWaiters();
+
+   // Nothing touches the dependents or the parent anymore except us.
+
+   for( U32 i = 0; i < job->mDependents.size(); ++ i )
+      _releaseDependency( job->mDependents[ i ] );
+   job->mDependents.clear();
+
+   JobRef parent = job->mParent;
+   job->mParent = NULL;
+   if( parent != NULL )
+      _finish( parent );
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::_wakeWaiters()
+{
+   // Claim the waiters one at a time and release one token for each so
+   // that the semaphore's count never drifts from the number of waiters
+   // that will acquire it.
+
+   U32 numWaiting;
+   while( ( numWaiting = dAtomicRead( mNumWaiting ) ) != 0 )
+   {
+      if( dCompareAndSwap( mNumWaiting, numWaiting, numWaiting - 1 ) )
+         mWaitSemaphore.release();
+   }
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::_releaseDependency( Job* job )
+{
+   if( atomicDecrement( job->mNumPendingDependencies ) == 0 )
+      _enqueue( job );
+}
+
+//--------------------------------------------------------------------------
+
+JobSystem::JobRef JobSystem::createJob( JobFunction function, void* data, Job* parent )
+{
+   JobRef job = new Job( function, data );
+
+   if( parent )
+   {
+      AssertFatal( !parent->isFinished(), "JobSystem::createJob - parent has already finished" );
+
+      dFetchAndAdd( parent->mNumUnfinished, 1 );
+      job->mParent = parent;
+   }
+
+   return job;
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::addDependency( Job* job, Job* dependency )
+{
+   AssertFatal( !job->mSubmitted && !dependency->mSubmitted,
+      "JobSystem::addDependency - dependencies must be set up before the jobs are run" );
+
+   dFetchAndAdd( job->mNumPendingDependencies, 1 );
+   dependency->mDependents.push_back( job );
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::run( Job* job )
+{
+   AssertFatal( !job->mSubmitted, "JobSystem::run - job has already been run" );
+
+   job->mSubmitted = true;
+   _releaseDependency( job );
+}
+
+//--------------------------------------------------------------------------
+
+void JobSystem::waitForJob( Job* job )
+{
+   PROFILE_SCOPE( JobSystem_waitForJob );
+
+   const U32 index = _getCurrentIndex();
+   while( !job->isFinished() )
+   {
+      // Help out while we wait.
+
+      Job* next = _findJob( index );
+      if( next )
+      {
+         _execute( next );
+         continue;
+      }
+
+      // Nothing left to take so the remaining jobs are in flight on other
+      // threads.  Announce that we are about to block and then look again
+      // so that we can't miss a job finishing or being queued in between.
+
+      dFetchAndAdd( mNumWaiting, 1 );
+
+      next = _findJob( index );
+      if( !next && !job->isFinished() )
+         mWaitSemaphore.acquire();
+      else
+      {
+         // Take ourselves off the count again.  If _wakeWaiters() got to
+         // it first, there is a token waiting for us that we have to take.
+
+         U32 numWaiting;
+         do
+         {
+            numWaiting = dAtomicRead( mNumWaiting );
+         }
+         while( numWaiting && !dCompareAndSwap( mNumWaiting, numWaiting, numWaiting - 1 ) );
+
+         if( !numWaiting )
+            mWaitSemaphore.acquire();
+      }
+
+      if( next )
+         _execute( next );
+   }
+}
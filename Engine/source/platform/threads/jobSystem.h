@@ -0,0 +1,277 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JOBSYSTEM_H_
+#define _JOBSYSTEM_H_
+
+#ifndef _THREADSAFEREFCOUNT_H_
+   #include "platform/threads/threadSafeRefCount.h"
+#endif
+#ifndef _PLATFORM_THREAD_SEMAPHORE_H_
+   #include "platform/threads/semaphore.h"
+#endif
+#ifndef _TVECTOR_H_
+   #include "core/util/tVector.h"
+#endif
+#ifndef _TORQUE_STRING_H_
+   #include "core/util/str.h"
+#endif
+#ifndef _TSINGLETON_H_
+   #include "core/util/tSingleton.h"
+#endif
+#ifndef _PLATFORMINTRINSICS_H_
+   #include "platform/platformIntrinsics.h"
+#endif
+
+
+/// @file
+/// Interface for the work-stealing job scheduler.
+
+
+/// Work-stealing job scheduler for short lived, fine grained work.
+///
+/// ThreadPool is built for background work that trickles through a single
+/// shared priority queue and offers no way to wait on anything short of all
+/// pending items.  The job system is meant for splitting up a phase of a frame
+/// into many small jobs and waiting on exactly those.
+///
+/// Each worker thread owns a deque.  Jobs started from a worker go onto its own
+/// deque, jobs started from any other thread go onto the deque of the main
+/// thread.  Threads take their newest job first and, once they run dry, steal
+/// the oldest job from another deque.
+///
+/// Jobs can be structured in two ways:
+///
+/// - A job created with a parent keeps the parent from finishing until the
+///   child has finished.  Waiting on the parent waits on the whole tree.
+/// - A job can depend on other jobs with addDependency().  It will only be
+///   started once run() has been called on it and all the jobs it depends on
+///   have finished.
+///
+/// waitForJob() executes other jobs while it waits, so it can be called from
+/// inside a job without tying up the worker.  Once there is nothing left to
+/// take it blocks until a job finishes or new work is queued.
+///
+/// The global system is created and destroyed by the main loop.  Code that
+/// may run without it, e.g. tools or startup code, should check
+/// isGlobalRunning() and fall back to doing its work serially.
+///
+/// @code
+/// JobSystem& jobs = JobSystem::GLOBAL();
+///
+/// JobSystem::JobRef group = jobs.createJob();
+/// for( U32 i = 0; i < numItems; ++ i )
+///    jobs.run( jobs.createJob( &updateItem, &items[ i ], group ) );
+///
+/// JobSystem::JobRef resolve = jobs.createJob( &resolveItems, &items );
+/// jobs.addDependency( resolve, group );
+///
+/// jobs.run( resolve );
+/// jobs.run( group );
+/// jobs.waitForJob( resolve );
+/// @endcode
+///
+class JobSystem
+{
+   public:
+
+      class Job;
+      typedef ThreadSafeRef< Job > JobRef;
+
+      /// Function executed by a job.
+      typedef void ( *JobFunction )( void* data );
+
+      /// A unit of work scheduled on the job system.
+      ///
+      /// Jobs are concurrently reference-counted and are released once the
+      /// last reference, including the system's own while the job is queued,
+      /// disappears.
+      class Job : public ThreadSafeRefCount< Job >
+      {
+         public:
+
+            typedef ThreadSafeRefCount< Job > Parent;
+
+         protected:
+
+            friend class JobSystem;
+
+            /// Function to execute; may be NULL for jobs that only group children.
+            JobFunction mFunction;
+
+            /// Argument passed to mFunction.
+            void* mData;
+
+            /// Parent job; kept alive until this job has finished.
+            JobRef mParent;
+
+            /// One for the job itself plus one for each unfinished child.
+            volatile U32 mNumUnfinished;
+
+            /// One until run() is called plus one for each unfinished job
+            /// this job depends on.
+            volatile U32 mNumPendingDependencies;
+
+            /// Jobs that depend on this one.
+            Vector< JobRef > mDependents;
+
+            /// Whether run() has been called on this job.
+            bool mSubmitted;
+
+         public:
+
+            Job( JobFunction function, void* data );
+
+            /// Return true if this job and all its children have finished.
+            bool isFinished()
+            {
+               return ( dAtomicRead( mNumUnfinished ) == 0 );
+            }
+      };
+
+      struct GlobalJobSystem;
+
+   protected:
+
+      struct WorkerThread;
+      struct JobDeque;
+
+      friend struct WorkerThread;
+
+      /// Name of this system.  Used to name worker threads.
+      String mName;
+
+      /// Number of worker threads.
+      U32 mNumThreads;
+
+      /// Deques; index zero is shared by all non-worker threads.
+      JobDeque* mDeques;
+
+      /// List of worker threads.
+      WorkerThread* mThreads;
+
+      /// Number of workers waiting on the semaphore.
+      volatile U32 mNumSleeping;
+
+      /// Semaphore used to wake up sleeping workers.
+      Semaphore mSemaphore;
+
+      /// Number of threads blocked in waitForJob() that have not been
+      /// woken up yet.
+      volatile U32 mNumWaiting;
+
+      /// Semaphore used to wake up threads blocked in waitForJob().
+      Semaphore mWaitSemaphore;
+
+      /// Return the deque index of the calling thread.
+      U32 _getCurrentIndex() const;
+
+      /// Take a job from the given deque or, failing that, steal one.
+      Job* _findJob( U32 index );
+
+      /// Queue a job whose dependencies are satisfied.
+      void _enqueue( Job* job );
+
+      /// Execute a job taken from a deque and drop the queue's reference.
+      void _execute( Job* job );
+
+      /// Count down a job's unfinished count and finish it at zero.
+      void _finish( Job* job );
+
+      /// Count down a job's pending dependencies and queue it at zero.
+      void _releaseDependency( Job* job );
+
+      /// Wake up all threads blocked in waitForJob().
+      void _wakeWaiters();
+
+   public:
+
+      /// Create a new job system with the given number of worker threads.
+      ///
+      /// If numThreads is zero (the default), one worker less than the number
+      /// of physical CPU cores is created as the waiting thread helps out.
+      /// The global ThreadPool already keeps a thread per logical CPU for
+      /// background work, so the job system doesn't claim those as well.
+      ///
+      /// @param numThreads Number of threads to create or zero for default.
+      JobSystem( const char* name, U32 numThreads = 0 );
+
+      ~JobSystem();
+
+      /// Manually shutdown threads outside of static destructors.
+      void shutdown();
+
+      /// Return the number of worker threads.
+      U32 getNumThreads() const { return mNumThreads; }
+
+      /// Create a job.  It will not be started before run() is called on it.
+      ///
+      /// @param function Function to execute; may be NULL to create a job that
+      ///   only groups children.
+      /// @param data Argument passed to function.
+      /// @param parent If not NULL, the parent won't finish before this job has.
+      ///   The parent must not have finished yet.
+      JobRef createJob( JobFunction function = NULL, void* data = NULL, Job* parent = NULL );
+
+      /// Make a job wait for another job to finish before it starts.
+      ///
+      /// Must be called before run() is called on either job.
+      void addDependency( Job* job, Job* dependency );
+
+      /// Start a job once all the jobs it depends on have finished.
+      void run( Job* job );
+
+      /// Block until the given job and all its children have finished,
+      /// executing other jobs in the meantime.
+      void waitForJob( Job* job );
+
+      /// Return the global job system singleton.
+      /// @note Asserts when called before the main loop has created it.
+      static JobSystem& GLOBAL();
+
+      /// Return true if the global job system has been created.
+      static bool isGlobalRunning();
+};
+
+
+struct JobSystem::GlobalJobSystem : public JobSystem, public ManagedSingleton< GlobalJobSystem >
+{
+   typedef JobSystem Parent;
+
+   GlobalJobSystem()
+      : Parent( "GLOBAL" ) {}
+
+   // For ManagedSingleton.
+   static const char* getSingletonName() { return "GlobalJobSystem"; }
+};
+
+inline JobSystem& JobSystem::GLOBAL()
+{
+   return *( GlobalJobSystem::instance() );
+}
+
+inline bool JobSystem::isGlobalRunning()
+{
+   return ( GlobalJobSystem::instanceOrNull() != NULL );
+}
+
+#endif // !_JOBSYSTEM_H_
@@ -0,0 +1,226 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _PARALLELFOR_H_
+#define _PARALLELFOR_H_
+
+#ifndef _JOBSYSTEM_H_
+   #include "platform/threads/jobSystem.h"
+#endif
+#ifndef _TVECTOR_H_
+   #include "core/util/tVector.h"
+#endif
+
+
+/// @file
+/// Data parallel loops on top of the JobSystem.
+///
+/// Both functions split [begin,end) into contiguous chunks of at least
+/// grain indices and hand each chunk to fn( chunkBegin, chunkEnd ).  The
+/// calling thread runs the last chunk itself and helps out with the others
+/// until all of them are done.
+///
+/// Ranges of no more than grain indices, and job systems without workers,
+/// run serially on the calling thread without touching the job system at
+/// all, so grain should be roughly the amount of work that's worth the
+/// hand off.  The versions without a job system argument use the global
+/// one and also run serially when it hasn't been created, e.g. in tools
+/// that don't go through the main loop.
+///
+/// @code
+/// parallelFor( 0, numVerts, 1024, [&]( U32 start, U32 end )
+/// {
+///    for( U32 i = start; i < end; ++ i )
+///       verts[ i ] += offset;
+/// });
+///
+/// const F32 total = parallelReduce( 0, numVerts, 1024, 0.0f,
+///    [&]( U32 start, U32 end )
+///    {
+///       F32 sum = 0.0f;
+///       for( U32 i = start; i < end; ++ i )
+///          sum += weights[ i ];
+///       return sum;
+///    },
+///    []( F32 a, F32 b ) { return a + b; } );
+/// @endcode
+
+
+namespace ParallelForDetail
+{
+   template< typename Fn >
+   struct Chunk
+   {
+      const Fn* fn;
+      U32 begin;
+      U32 end;
+
+      static void execute( void* data )
+      {
+         Chunk* chunk = ( Chunk* ) data;
+         ( *chunk->fn )( chunk->begin, chunk->end );
+      }
+   };
+
+   template< typename T, typename Fn >
+   struct ReduceChunk
+   {
+      const Fn* fn;
+      U32 begin;
+      U32 end;
+      T result;
+
+      static void execute( void* data )
+      {
+         ReduceChunk* chunk = ( ReduceChunk* ) data;
+         chunk->result = ( *chunk->fn )( chunk->begin, chunk->end );
+      }
+   };
+
+   /// Return the number of indices per chunk.  Aims for a few chunks per
+   /// thread so that uneven chunks still balance out.
+   inline U32 getChunkSize( const JobSystem& jobs, U32 count, U32 grain )
+   {
+      const U32 numChunks = ( jobs.getNumThreads() + 1 ) * 4;
+      return getMax( grain, ( count + numChunks - 1 ) / numChunks );
+   }
+
+   /// Return true if [begin,end) should just run on the calling thread.
+   inline bool isSerial( const JobSystem& jobs, U32 count, U32 grain )
+   {
+      return ( count <= grain || !jobs.getNumThreads() );
+   }
+}
+
+/// Call fn( chunkBegin, chunkEnd ) for chunks covering [begin,end) on the
+/// given job system.
+template< typename Fn >
+void parallelFor( JobSystem& jobs, U32 begin, U32 end, U32 grain, const Fn& fn )
+{
+   if( end <= begin )
+      return;
+
+   const U32 count = end - begin;
+   grain = getMax( grain, U32( 1 ) );
+
+   if( ParallelForDetail::isSerial( jobs, count, grain ) )
+   {
+      fn( begin, end );
+      return;
+   }
+
+   typedef ParallelForDetail::Chunk< Fn > ChunkType;
+
+   const U32 chunkSize = ParallelForDetail::getChunkSize( jobs, count, grain );
+   const U32 numChunks = ( count + chunkSize - 1 ) / chunkSize;
+
+   Vector< ChunkType > chunks( numChunks, __FILE__, __LINE__ );
+   chunks.setSize( numChunks - 1 );
+
+   JobSystem::JobRef group = jobs.createJob();
+   for( U32 i = 0; i < numChunks - 1; ++ i )
+   {
+      ChunkType& chunk = chunks[ i ];
+      chunk.fn = &fn;
+      chunk.begin = begin + i * chunkSize;
+      chunk.end = chunk.begin + chunkSize;
+
+      jobs.run( jobs.createJob( &ChunkType::execute, &chunk, group ) );
+   }
+   jobs.run( group );
+
+   fn( begin + ( numChunks - 1 ) * chunkSize, end );
+   jobs.waitForJob( group );
+}
+
+/// Call fn( chunkBegin, chunkEnd ) for chunks covering [begin,end) on the
+/// global job system.
+template< typename Fn >
+inline void parallelFor( U32 begin, U32 end, U32 grain, const Fn& fn )
+{
+   if( JobSystem::isGlobalRunning() )
+      parallelFor( JobSystem::GLOBAL(), begin, end, grain, fn );
+   else if( begin < end )
+      fn( begin, end );
+}
+
+/// Reduce [begin,end) on the given job system.
+///
+/// fn( chunkBegin, chunkEnd ) returns the partial result of a chunk and
+/// combine( a, b ) merges two partial results.  Partial results are combined
+/// in index order, starting from identity, so combine need not be
+/// commutative.
+template< typename T, typename Fn, typename Combine >
+T parallelReduce( JobSystem& jobs, U32 begin, U32 end, U32 grain, const T& identity, const Fn& fn, const Combine& combine )
+{
+   if( end <= begin )
+      return identity;
+
+   const U32 count = end - begin;
+   grain = getMax( grain, U32( 1 ) );
+
+   if( ParallelForDetail::isSerial( jobs, count, grain ) )
+      return combine( identity, fn( begin, end ) );
+
+   typedef ParallelForDetail::ReduceChunk< T, Fn > ChunkType;
+
+   const U32 chunkSize = ParallelForDetail::getChunkSize( jobs, count, grain );
+   const U32 numChunks = ( count + chunkSize - 1 ) / chunkSize;
+
+   Vector< ChunkType > chunks( numChunks, __FILE__, __LINE__ );
+   chunks.setSize( numChunks - 1 );
+
+   JobSystem::JobRef group = jobs.createJob();
+   for( U32 i = 0; i < numChunks - 1; ++ i )
+   {
+      ChunkType& chunk = chunks[ i ];
+      chunk.fn = &fn;
+      chunk.begin = begin + i * chunkSize;
+      chunk.end = chunk.begin + chunkSize;
+
+      jobs.run( jobs.createJob( &ChunkType::execute, &chunk, group ) );
+   }
+   jobs.run( group );
+
+   const T last = fn( begin + ( numChunks - 1 ) * chunkSize, end );
+   jobs.waitForJob( group );
+
+   T result = identity;
+   for( U32 i = 0; i < numChunks - 1; ++ i )
+      result = combine( result, chunks[ i ].result );
+
+   return combine( result, last );
+}
+
+/// Reduce [begin,end) on the global job system.
+template< typename T, typename Fn, typename Combine >
+inline T parallelReduce( U32 begin, U32 end, U32 grain, const T& identity, const Fn& fn, const Combine& combine )
+{
+   if( JobSystem::isGlobalRunning() )
+      return parallelReduce( JobSystem::GLOBAL(), begin, end, grain, identity, fn, combine );
+   else if( begin < end )
+      return combine( identity, fn( begin, end ) );
+
+   return identity;
+}
+
+#endif // !_PARALLELFOR_H_
@@ -25,6 +25,7 @@
 #include "platform/platformCPUCount.h"
 #include "core/strings/stringFunctions.h"
 #include "core/util/tSingleton.h"
+#include "core/frameAllocator.h"
 
 
 //#define DEBUG_SPEW
@@ -119,7 +120,11 @@ void ThreadPool::Context::updateAccumulatedPriorityBiases()
 
 void ThreadPool::WorkItem::process()
 {
+   // Drop FrameAllocator memory the item didn't free.
+   const U32 waterMark = FrameAllocator::getWaterMark();
    execute();
+   FrameAllocator::setWaterMark( waterMark );
+
    mExecuted = true;
 }
 
@@ -22,6 +22,8 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "core/crc.h"
 #include "core/frameAllocator.h"
@@ -441,6 +443,29 @@ U32 PosixFile::write(const void* src, U32 size)
    return bytesWritten;
 }
 
+void* PosixFile::map(U32 &outSize)
+{
+   outSize = 0;
+   if (_status != Open && _status != EndOfFile)
+      return NULL;
+
+   struct stat info;
+   if (fstat(fileno(_handle), &info) != 0 || info.st_size <= 0)
+      return NULL;
+
+   void* data = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(_handle), 0);
+   if (data == MAP_FAILED)
+      return NULL;
+
+   outSize = info.st_size;
+   return data;
+}
+
+void PosixFile::unmap(void* data, U32 size)
+{
+   munmap(data, size);
+}
+
 void PosixFile::_updateStatus()
 {
    switch (errno)
@@ -533,6 +533,35 @@ U32 Win32File::write(const void* src, U32 size)
    return bytesWritten;
 }
 
+void* Win32File::map(U32 &outSize)
+{
+   outSize = 0;
+   if (mStatus != Open && mStatus != EndOfFile)
+      return NULL;
+
+   DWORD size = ::GetFileSize((HANDLE)mHandle, NULL);
+   if (size == INVALID_FILE_SIZE || size == 0)
+      return NULL;
+
+   HANDLE mapping = ::CreateFileMappingW((HANDLE)mHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+   if (!mapping)
+      return NULL;
+
+   // The view keeps the mapping object alive.
+   void* data = ::MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+   ::CloseHandle(mapping);
+   if (!data)
+      return NULL;
+
+   outSize = size;
+   return data;
+}
+
+void Win32File::unmap(void* data, U32 size)
+{
+   ::UnmapViewOfFile(data);
+}
+
 void Win32File::_updateStatus()
 {
    switch (::GetLastError())
@@ -78,6 +78,8 @@ public:
 
    U32 read(void* dst, U32 size);
    U32 write(const void* src, U32 size);
+   void* map(U32 &outSize);
+   void unmap(void* data, U32 size);
 
 private:
    friend class Win32FileSystem;
@@ -27,6 +27,7 @@
 #include "materials/matInstance.h"
 #include "scene/sceneManager.h"
 #include "console/engineAPI.h"
+#include "core/frameAllocator.h"
 
 
 IMPLEMENT_CONOBJECT(RenderBinManager);
@@ -139,7 +140,94 @@ void RenderBinManager::clear()
 
 void RenderBinManager::sort()
 {
-   dQsort( mElementList.address(), mElementList.size(), sizeof(MainSortElem), cmpKeyFunc);
+   sortElements( mElementList.address(), mElementList.size() );
+}
+
+/// Returns the composite key which sorts ascending in the same
+/// order cmpKeyFunc does: key descending then key2 ascending.
+static inline U64 _getSortKey( const RenderBinManager::MainSortElem &elem )
+{
+   return ( U64( ~elem.key ) << 32 ) | U64( elem.key2 );
+}
+
+void RenderBinManager::sortElements( MainSortElem *elems, U32 count )
+{
+   PROFILE_SCOPE( RenderBinManager_sortElements );
+
+   if ( count < 2 )
+      return;
+
+   // Small bins aren't worth the histogram passes.
+   if ( count <= 32 )
+   {
+      for ( U32 i = 1; i < count; i++ )
+      {
+         const MainSortElem elem = elems[i];
+         const U64 key = _getSortKey( elem );
+
+         U32 j = i;
+         for ( ; j > 0 && _getSortKey( elems[j-1] ) > key; j-- )
+            elems[j] = elems[j-1];
+         elems[j] = elem;
+      }
+      return;
+   }
+
+   FrameTemp<U64> keys( count );
+   FrameTemp<U64> scratchKeys( count );
+   FrameTemp<MainSortElem> scratchElems( count );
+
+   // Build all the byte histograms in one pass.
+   U32 hist[8][256];
+   dMemset( hist, 0, sizeof( hist ) );
+
+   for ( U32 i = 0; i < count; i++ )
+   {
+      const U64 key = _getSortKey( elems[i] );
+      keys[i] = key;
+
+      for ( U32 b = 0; b < 8; b++ )
+         hist[b][ ( key >> ( b * 8 ) ) & 0xFF ]++;
+   }
+
+   U64 *srcKeys = ~keys;
+   U64 *dstKeys = ~scratchKeys;
+   MainSortElem *src = elems;
+   MainSortElem *dst = ~scratchElems;
+
+   for ( U32 b = 0; b < 8; b++ )
+   {
+      const U32 shift = b * 8;
+      U32 *offsets = hist[b];
+
+      // Most of the key bytes are the same for the whole
+      // bin, like the high bytes of small state hints, so
+      // skip any pass that wouldn't move anything.
+      if ( offsets[ ( srcKeys[0] >> shift ) & 0xFF ] == count )
+         continue;
+
+      U32 sum = 0;
+      for ( U32 i = 0; i < 256; i++ )
+      {
+         const U32 n = offsets[i];
+         offsets[i] = sum;
+         sum += n;
+      }
+
+      for ( U32 i = 0; i < count; i++ )
+      {
+         const U32 dest = offsets[ ( srcKeys[i] >> shift ) & 0xFF ]++;
+         dst[ dest ] = src[i];
+         dstKeys[ dest ] = srcKeys[i];
+      }
+
+      std::swap( src, dst );
+      std::swap( srcKeys, dstKeys );
+   }
+
+   // An odd number of passes leaves the result in the scratch.
+   if ( src != elems )
+      dMemcpy( elems, src, sizeof( MainSortElem ) * count );
 }
 
 S32 FN_CDECL RenderBinManager::cmpKeyFunc(const void* p1, const void* p2)
@@ -93,6 +93,14 @@ public:
       U32 key2;
    };
 
+   /// Sorts elements by key descending and then key2 ascending, the
+   /// same order as cmpKeyFunc, comparing the keys as unsigned values.
+   ///
+   /// The two keys are combined into a 64 bit key and sorted with a
+   /// stable LSD radix sort.  The scratch comes from the calling
+   /// thread's FrameAllocator.
+   static void sortElements( MainSortElem *elems, U32 count );
+
 protected:
    void setRenderPass( RenderPassManager *rpm );
 
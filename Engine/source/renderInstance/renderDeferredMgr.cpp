@@ -289,8 +289,8 @@ void RenderDeferredMgr::sort()
 {
    PROFILE_SCOPE( RenderDeferredMgr_sort );
    Parent::sort();
-   dQsort( mTerrainElementList.address(), mTerrainElementList.size(), sizeof(MainSortElem), cmpKeyFunc);
-   dQsort( mObjectElementList.address(), mObjectElementList.size(), sizeof(MainSortElem), cmpKeyFunc);
+   sortElements( mTerrainElementList.address(), mTerrainElementList.size() );
+   sortElements( mObjectElementList.address(), mObjectElementList.size() );
 }
 
 void RenderDeferredMgr::clear()
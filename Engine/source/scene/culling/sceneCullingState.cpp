@@ -31,6 +31,16 @@
 #include "terrain/terrData.h"
 #include "util/tempAlloc.h"
 #include "gfx/sim/debugDraw.h"
+#include "platform/threads/parallelFor.h"
+
+#if (defined( TORQUE_CPU_X86 ) || defined( TORQUE_CPU_X64 ))
+#define SCENE_CULLING_SSE
+#include <xmmintrin.h>
+#ifdef __AVX__
+#define SCENE_CULLING_AVX
+#include <immintrin.h>
+#endif
+#endif
 
 
 extern bool gEditingMission;
@@ -38,6 +48,7 @@ extern bool gEditingMission;
 
 bool SceneCullingState::smDisableTerrainOcclusion = true;
 bool SceneCullingState::smDisableZoneCulling = false;
+S32 SceneCullingState::smBatchCullThreshold = 64;
 U32 SceneCullingState::smMaxOccludersPerZone = 4;
 F32 SceneCullingState::smOccluderMinWidthPercentage = 0.1f;
 F32 SceneCullingState::smOccluderMinHeightPercentage = 0.1f;
@@ -728,12 +739,175 @@ bool SceneCullingState::isOccluded( const SphereF& sphere, const U32* zones, U32
 
 //-----------------------------------------------------------------------------
 
+namespace {
+
+   /// Results of the bulk plane tests in SceneCullingState::_cullBounds().
+   enum BatchCullFlags
+   {
+      BatchCullFrustum  = BIT( 0 ),    ///< Behind one of the frustum planes.
+      BatchCullNearFar  = BIT( 1 ),    ///< Behind the near or the far plane.
+      BatchCullExtra    = BIT( 2 )     ///< Behind one of the extra culling planes.
+   };
+
+   /// Number of boxes tested at a time; the arrays are padded to this.
+   const U32 BatchCullWidth = 8;
+
+   /// Snapshot of the object bounds for the bulk plane tests, one
+   /// array per component.
+   struct BatchCullBounds
+   {
+      Vector< F32 > minX, minY, minZ;
+      Vector< F32 > maxX, maxY, maxZ;
+      Vector< U8 > flags;
+
+      void setSize( U32 size )
+      {
+         minX.setSize( size );
+         minY.setSize( size );
+         minZ.setSize( size );
+         maxX.setSize( size );
+         maxY.setSize( size );
+         maxZ.setSize( size );
+         flags.setSize( size );
+      }
+
+      /// Set flag on the boxes in [start,end) that are behind any of the
+      /// planes.  This is PlaneF::whichSide() returning Back for the box,
+      /// which only needs the corner furthest along the plane normal.
+      void test( U32 start, U32 end, const PlaneF* planes, U32 numPlanes, U8 flag )
+      {
+         for( U32 n = 0; n < numPlanes; ++ n )
+         {
+            const PlaneF& plane = planes[ n ];
+            const F32* px = ( plane.x > 0.0f ) ? maxX.address() : minX.address();
+            const F32* py = ( plane.y > 0.0f ) ? maxY.address() : minY.address();
+            const F32* pz = ( plane.z > 0.0f ) ? maxZ.address() : minZ.address();
+
+         #if defined( SCENE_CULLING_AVX )
+
+            const __m256 nx = _mm256_set1_ps( plane.x );
+            const __m256 ny = _mm256_set1_ps( plane.y );
+            const __m256 nz = _mm256_set1_ps( plane.z );
+            const __m256 d = _mm256_set1_ps( plane.d );
+            const __m256 back = _mm256_set1_ps( -0.005f );
+
+            for( U32 i = start; i < end; i += 8 )
+            {
+               __m256 dist = _mm256_add_ps( _mm256_mul_ps( _mm256_loadu_ps( px + i ), nx ), _mm256_mul_ps( _mm256_loadu_ps( py + i ), ny ) );
+               dist = _mm256_add_ps( _mm256_add_ps( dist, _mm256_mul_ps( _mm256_loadu_ps( pz + i ), nz ) ), d );
+
+               const S32 culled = _mm256_movemask_ps( _mm256_cmp_ps( dist, back, _CMP_LE_OQ ) );
+               if( !culled )
+                  continue;
+
+               for( U32 j = 0; j < 8; ++ j )
+                  if( culled & ( 1 << j ) )
+                     flags[ i + j ] |= flag;
+            }
+
+         #elif defined( SCENE_CULLING_SSE )
+
+            const __m128 nx = _mm_set1_ps( plane.x );
+            const __m128 ny = _mm_set1_ps( plane.y );
+            const __m128 nz = _mm_set1_ps( plane.z );
+            const __m128 d = _mm_set1_ps( plane.d );
+            const __m128 back = _mm_set1_ps( -0.005f );
+
+            for( U32 i = start; i < end; i += 4 )
+            {
+               __m128 dist = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( px + i ), nx ), _mm_mul_ps( _mm_loadu_ps( py + i ), ny ) );
+               dist = _mm_add_ps( _mm_add_ps( dist, _mm_mul_ps( _mm_loadu_ps( pz + i ), nz ) ), d );
+
+               const S32 culled = _mm_movemask_ps( _mm_cmple_ps( dist, back ) );
+               if( !culled )
+                  continue;
+
+               for( U32 j = 0; j < 4; ++ j )
+                  if( culled & ( 1 << j ) )
+                     flags[ i + j ] |= flag;
+            }
+
+         #else
+
+            for( U32 i = start; i < end; ++ i )
+            {
+               const F32 dist = px[ i ] * plane.x + py[ i ] * plane.y + pz[ i ] * plane.z + plane.d;
+               if( dist <= -0.005f )
+                  flags[ i ] |= flag;
+            }
+
+         #endif
+         }
+      }
+   };
+
+   /// Only used by cullObjects() on the main thread so the
+   /// arrays are kept around between calls.
+   BatchCullBounds sBatchCullBounds;
+}
+
+const U8* SceneCullingState::_cullBounds( SceneObject** objects, U32 numObjects ) const
+{
+   PROFILE_SCOPE( SceneCullingState_cullBounds );
+
+   BatchCullBounds& bounds = sBatchCullBounds;
+
+   const U32 numBlocks = ( numObjects + BatchCullWidth - 1 ) / BatchCullWidth;
+   bounds.setSize( numBlocks * BatchCullWidth );
+
+   // Fetch the planes here as the frustum updates them lazily.
+   const PlaneF* frustumPlanes = getCullingFrustum().getPlanes();
+   const U32 numFrustumPlanes = getCullingFrustum().getNumPlanes();
+   const PlaneF nearFarPlanes[ 2 ] = { frustumPlanes[ Frustum::PlaneNear ], frustumPlanes[ Frustum::PlaneFar ] };
+
+   auto cullBlocks = [&]( U32 startBlock, U32 endBlock )
+   {
+      const U32 start = startBlock * BatchCullWidth;
+      const U32 end = endBlock * BatchCullWidth;
+
+      for( U32 i = start; i < end; ++ i )
+      {
+         // The padding past the last object is tested but never looked at.
+         const Box3F& box = ( i < numObjects ) ? objects[ i ]->getWorldBox() : Box3F::Zero;
+
+         bounds.minX[ i ] = box.minExtents.x;
+         bounds.minY[ i ] = box.minExtents.y;
+         bounds.minZ[ i ] = box.minExtents.z;
+         bounds.maxX[ i ] = box.maxExtents.x;
+         bounds.maxY[ i ] = box.maxExtents.y;
+         bounds.maxZ[ i ] = box.maxExtents.z;
+         bounds.flags[ i ] = 0;
+      }
+
+      bounds.test( start, end, frustumPlanes, numFrustumPlanes, BatchCullFrustum );
+      bounds.test( start, end, nearFarPlanes, 2, BatchCullNearFar );
+
+      if( mExtraPlanesCull.getNumPlanes() )
+         bounds.test( start, end, mExtraPlanesCull.getPlanes(), mExtraPlanesCull.getNumPlanes(), BatchCullExtra );
+   };
+
+   if( JobSystem::isGlobalRunning() )
+      parallelFor( JobSystem::GLOBAL(), 0, numBlocks, 128, cullBlocks );
+   else
+      cullBlocks( 0, numBlocks );
+
+   return bounds.flags.address();
+}
+
+//-----------------------------------------------------------------------------
+
 U32 SceneCullingState::cullObjects( SceneObject** objects, U32 numObjects, U32 cullOptions ) const
 {
    PROFILE_SCOPE( SceneCullingState_cullObjects );
 
    U32 numRemainingObjects = 0;
 
+   // For long lists, test all the bounds against the frustum planes
+   // up front.  The tests below then just look up the results.
+   const U8* batchFlags = NULL;
+   if( smBatchCullThreshold > 0 && S32( numObjects ) >= smBatchCullThreshold )
+      batchFlags = _cullBounds( objects, numObjects );
+
    // We test near and far planes separately in order to not do the tests
    // repeatedly, so fetch the planes now.
    const PlaneF& nearPlane = getCullingFrustum().getPlanes()[ Frustum::PlaneNear ];
@@ -789,9 +963,18 @@ U32 SceneCullingState::cullObjects( SceneObject** objects, U32 numObjects, U32 c
                ( object->getTypeMask() & CULLING_EXCLUDE_TYPEMASK ) ||
                disableZoneCulling() )
       {
-         isCulled = getCullingFrustum().isCulled( object->getWorldBox() );
+         if( batchFlags )
+            isCulled = ( batchFlags[ i ] & BatchCullFrustum ) != 0;
+         else
+            isCulled = getCullingFrustum().isCulled( object->getWorldBox() );
       }
 
+      // Objects behind the near or far plane fail the zone tests
+      // below whichever zones they're in.
+
+      else if( batchFlags && ( batchFlags[ i ] & BatchCullNearFar ) )
+         isCulled = true;
+
       // Go through the zones that the object is assigned to and
       // test the object against the frustums of each of the zones.
 
@@ -809,7 +992,12 @@ U32 SceneCullingState::cullObjects( SceneObject** objects, U32 numObjects, U32 c
       }
 
       if( !isCulled )
-         isCulled = isOccludedWithExtraPlanesCull( object->getWorldBox() );
+      {
+         if( batchFlags )
+            isCulled = ( batchFlags[ i ] & BatchCullExtra ) != 0;
+         else
+            isCulled = isOccludedWithExtraPlanesCull( object->getWorldBox() );
+      }
 
       if( !isCulled )
          objects[ numRemainingObjects ++ ] = object;
@@ -64,6 +64,12 @@ class SceneCullingState
       /// Whether to force zone culling to off by default.
       static bool smDisableZoneCulling;
 
+      /// Object lists of at least this size passed to cullObjects() have their
+      /// bounds tested against the frustum planes in bulk, several boxes at a
+      /// time and spread across the job system if it is running.  Zero
+      /// disables the bulk tests.
+      static S32 smBatchCullThreshold;
+
       /// @name Occluder Restrictions
       /// Size restrictions on occlusion culling volumes.  Any occlusion volume
       /// that does not meet these minimum requirements is not accepted into the
@@ -329,6 +335,10 @@ class SceneCullingState
       template< typename T, typename Iter > CullingTestResult _test
          ( const T& bounds, Iter iter, const PlaneF& nearPlane, const PlaneF& farPlane ) const;
       template< typename T, typename Iter > CullingTestResult _testOccludersOnly( const T& bounds, Iter iter ) const;
+
+      /// Test the world bounds of the objects against the frustum, near/far and
+      /// extra culling planes in bulk and return a BatchCullFlags per object.
+      const U8* _cullBounds( SceneObject** objects, U32 numObjects ) const;
 };
 
 #endif // !_SCENECULLINGSTATE_H_
@@ -29,6 +29,12 @@
 #include "platform/profiler.h"
 #include "console/engineAPI.h"
 #include "math/util/frustum.h"
+#include "platform/threads/parallelFor.h"
+
+#if (defined( TORQUE_CPU_X86 ) || defined( TORQUE_CPU_X64 ))
+#define SCENE_CONTAINER_SSE
+#include <xmmintrin.h>
+#endif
 
 
 // [rene, 02-Mar-11]
@@ -46,6 +52,10 @@ const F32 SceneContainer::csmBinSize = 64;
 const F32 SceneContainer::csmTotalAxisBinSize = SceneContainer::csmBinSize * SceneContainer::csmNumAxisBins;
 const U32 SceneContainer::csmOverflowBinIdx = (SceneContainer::csmNumAxisBins * SceneContainer::csmNumAxisBins);
 const U32 SceneContainer::csmTotalNumBins = SceneContainer::csmOverflowBinIdx + 1;
+S32 SceneContainer::smBatchParallelThreshold = 32;
+
+const F32 SceneContainerQuadtree::csmDefaultHalfSize = 8192; // 16km square
+const U32 SceneContainerQuadtree::csmMaxDepth = 9; // 32 unit nodes at the default size
 
 
 // Statics used by buildPolyList methods
@@ -291,6 +301,45 @@ struct SceneRayHelper
       return foundCandidate;
    }
 
+   /// Performs raycast against the quadtree nodes crossed by the line,
+   /// nearest first, stopping once the nodes are further than the closest hit.
+   /// Invokes Delegate::checkFunc to locate candidates.
+   template<typename DEL> static bool castInQuadtree(
+      const QueryParams params,
+      State& state,
+      const SceneContainerQuadtree& tree,
+      RayInfo* info,
+      DEL del)
+   {
+      F32 currentT = state.mCurrentT;
+      bool foundCandidate = false;
+
+      tree.castRay(*params.start, *params.end, currentT, [&](SceneObject* ptr)
+      {
+         if (del.checkFunc(params, ptr, info, currentT) && !foundCandidate)
+            foundCandidate = true;
+
+         ptr->setContainerSeqKey(params.seqKey);
+      });
+
+      state.mCurrentT = currentT;
+      return foundCandidate;
+   }
+
+   /// Moves the normal of a hit from object space into world space.
+   static void normalToWorld(RayInfo* info)
+   {
+      PlaneF fakePlane;
+      fakePlane.x = info->normal.x;
+      fakePlane.y = info->normal.y;
+      fakePlane.z = info->normal.z;
+      fakePlane.d = 0;
+
+      PlaneF result;
+      mTransformPlane(info->object->getTransform(), info->object->getScale(), fakePlane, &result);
+      info->normal = result;
+   }
+
    /// Tests an object against a ray
    template<typename CBFunc> struct CheckObjectRayDelegate
    {
@@ -350,6 +399,214 @@ struct SceneRayHelper
 };
 
 
+//=============================================================================
+//    SceneContainerQuadtree.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+
+SceneContainerQuadtree::SceneContainerQuadtree(const Point2F& center, F32 halfSize)
+   : mCenter(center),
+     mHalfSize(halfSize)
+{
+   VECTOR_SET_ASSOCIATION( mNodes );
+   clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerQuadtree::clear()
+{
+   mNodes.clear();
+
+   mNodes.increment();
+   Node& root = mNodes.last();
+   root.center = mCenter;
+   root.halfSize = mHalfSize;
+   root.children[0] = root.children[1] = root.children[2] = root.children[3] = -1;
+   root.parent = -1;
+   root.numObjects = 0;
+   root.depth = 0;
+   root.cellX = 0;
+   root.cellY = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerQuadtree::_getCell(const Box3F& box, bool global, U32& outDepth, U32& outX, U32& outY) const
+{
+   outDepth = 0;
+   outX = 0;
+   outY = 0;
+
+   if (global)
+      return;
+
+   const F32 extent = getMax(box.len_x(), box.len_y()) * 0.5f;
+   const F32 relX = (box.minExtents.x + box.maxExtents.x) * 0.5f - (mCenter.x - mHalfSize);
+   const F32 relY = (box.minExtents.y + box.maxExtents.y) * 0.5f - (mCenter.y - mHalfSize);
+
+   // Anything too big or outside of the tree stays in the root. Written
+   // so that NaN coordinates also end up here.
+   const F32 treeSize = mHalfSize * 2.0f;
+   if (!(extent <= mHalfSize && relX >= 0.0f && relX < treeSize && relY >= 0.0f && relY < treeSize))
+      return;
+
+   // Go down while the children are still at least as big as the object
+   F32 halfSize = mHalfSize;
+   while (outDepth < csmMaxDepth && halfSize * 0.5f >= extent)
+   {
+      halfSize *= 0.5f;
+      outDepth++;
+   }
+
+   const U32 maxCell = (1 << outDepth) - 1;
+   outX = getMin(U32(relX / (halfSize * 2.0f)), maxCell);
+   outY = getMin(U32(relY / (halfSize * 2.0f)), maxCell);
+}
+
+//-----------------------------------------------------------------------------
+
+U32 SceneContainerQuadtree::_getNode(U32 depth, U32 x, U32 y)
+{
+   U32 nodeIdx = 0;
+
+   for (U32 level = 1; level <= depth; level++)
+   {
+      const U32 childX = x >> (depth - level);
+      const U32 childY = y >> (depth - level);
+      const U32 quadrant = (childX & 1) | ((childY & 1) << 1);
+
+      S32 childIdx = mNodes[nodeIdx].children[quadrant];
+      if (childIdx < 0)
+      {
+         const F32 halfSize = mNodes[nodeIdx].halfSize * 0.5f;
+
+         childIdx = mNodes.size();
+         mNodes[nodeIdx].children[quadrant] = childIdx;
+
+         mNodes.increment();
+         Node& child = mNodes.last();
+         child.center.x = mCenter.x - mHalfSize + (childX * 2 + 1) * halfSize;
+         child.center.y = mCenter.y - mHalfSize + (childY * 2 + 1) * halfSize;
+         child.halfSize = halfSize;
+         child.children[0] = child.children[1] = child.children[2] = child.children[3] = -1;
+         child.parent = nodeIdx;
+         child.numObjects = 0;
+         child.depth = level;
+         child.cellX = childX;
+         child.cellY = childY;
+      }
+
+      nodeIdx = childIdx;
+   }
+
+   return nodeIdx;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerQuadtree::insert(SceneObject* object)
+{
+   PROFILE_SCOPE(SceneContainerQuadtree_Insert);
+   AssertFatal(object->mContainerLookup.mListHandle == 0, "SceneContainerQuadtree::insert - object already in tree");
+
+   U32 depth, x, y;
+   _getCell(object->getWorldBox(), object->isGlobalBounds(), depth, x, y);
+
+   const U32 nodeIdx = _getNode(depth, x, y);
+   mNodes[nodeIdx].objects.push_back(object);
+
+   for (S32 i = nodeIdx; i >= 0; i = mNodes[i].parent)
+      mNodes[i].numObjects++;
+
+   object->mContainerLookup.mRange = SceneBinRange::makeFromBin(x, x, y, y);
+   object->mContainerLookup.mListHandle = nodeIdx + 1;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerQuadtree::remove(SceneObject* object)
+{
+   PROFILE_SCOPE(SceneContainerQuadtree_Remove);
+   AssertFatal(object->mContainerLookup.mListHandle != 0, "SceneContainerQuadtree::remove - object not in tree");
+
+   const U32 nodeIdx = object->mContainerLookup.mListHandle - 1;
+   Vector<SceneObject*>& list = mNodes[nodeIdx].objects;
+
+   Vector<SceneObject*>::iterator itr = std::find(list.begin(), list.end(), object);
+   if (itr != list.end())
+   {
+      list.erase_fast(itr);
+
+      for (S32 i = nodeIdx; i >= 0; i = mNodes[i].parent)
+         mNodes[i].numObjects--;
+   }
+
+   object->mContainerLookup.mListHandle = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainerQuadtree::update(SceneObject* object)
+{
+   if (object->mContainerLookup.mListHandle == 0)
+   {
+      // Failsafe case
+      insert(object);
+      return;
+   }
+
+   U32 depth, x, y;
+   _getCell(object->getWorldBox(), object->isGlobalBounds(), depth, x, y);
+
+   const Node& node = mNodes[object->mContainerLookup.mListHandle - 1];
+   if (node.depth == depth && node.cellX == x && node.cellY == y)
+      return;
+
+   remove(object);
+   insert(object);
+}
+
+//-----------------------------------------------------------------------------
+
+bool SceneContainerQuadtree::_clipLoose(const Node& node, const Point3F& start, const Point3F& dir, F32& outT)
+{
+   const F32 size = node.halfSize * 2.0f;
+   const F32 center[2] = { node.center.x, node.center.y };
+
+   F32 tMin = 0.0f;
+   F32 tMax = 1.0f;
+
+   for (U32 axis = 0; axis < 2; axis++)
+   {
+      const F32 lo = center[axis] - size;
+      const F32 hi = center[axis] + size;
+
+      if (mFabs(dir[axis]) < 1e-6f)
+      {
+         if (start[axis] < lo || start[axis] > hi)
+            return false;
+         continue;
+      }
+
+      const F32 invDir = 1.0f / dir[axis];
+      F32 t0 = (lo - start[axis]) * invDir;
+      F32 t1 = (hi - start[axis]) * invDir;
+      if (t0 > t1)
+         std::swap(t0, t1);
+
+      tMin = getMax(tMin, t0);
+      tMax = getMin(tMax, t1);
+      if (tMin > tMax)
+         return false;
+   }
+
+   outT = tMin;
+   return true;
+}
+
+
 //=============================================================================
 //    SceneContainer.
 //=============================================================================
@@ -360,6 +617,7 @@ SceneContainer::SceneContainer()
 {
    mSearchInProgress = false;
    mCurrSeqKey = 0;
+   mQuadtree = NULL;
 
    mBinArray = new ObjectList[csmTotalNumBins];
    for (U32 i=0; i<csmTotalNumBins; i++)
@@ -395,12 +653,34 @@ SceneContainer::~SceneContainer()
    }
 
    delete[] mBinArray;
+   SAFE_DELETE( mQuadtree );
 
    cleanupSearchVectors();
 }
 
 //-----------------------------------------------------------------------------
 
+void SceneContainer::setSpatialIndex( SpatialIndexType type )
+{
+   if ( type == getSpatialIndex() )
+      return;
+
+   AssertFatal( !mSearchInProgress, "SceneContainer::setSpatialIndex - Can't switch during a query" );
+
+   for ( SceneObject* obj : mGlobalList )
+      removeFromBins( obj );
+
+   if ( type == LooseQuadtree )
+      mQuadtree = new SceneContainerQuadtree;
+   else
+      SAFE_DELETE( mQuadtree );
+
+   for ( SceneObject* obj : mGlobalList )
+      insertIntoBins( obj );
+}
+
+//-----------------------------------------------------------------------------
+
 bool SceneContainer::addObject(SceneObject* obj)
 {
    AssertFatal(obj->mContainer == NULL, "Adding already added object.");
@@ -464,6 +744,12 @@ void SceneContainer::insertIntoBins(SceneObject* obj)
 {
    AssertFatal(obj != NULL, "No object?");
 
+   if (mQuadtree)
+   {
+      mQuadtree->insert(obj);
+      return;
+   }
+
    if (obj->isGlobalBounds())
    {
       // This goes straight into the overflow bin
@@ -489,6 +775,13 @@ void SceneContainer::insertIntoBins(SceneObject* obj,
    PROFILE_START(SceneContainer_InsertIntoBins);
    AssertFatal(obj != NULL, "No object?");
 
+   if (mQuadtree)
+   {
+      mQuadtree->insert(obj);
+      PROFILE_END();
+      return;
+   }
+
    mBinValueList.clear();
    SceneBinListLookup binLookup;
    binLookup.mRange = range;
@@ -538,7 +831,14 @@ void SceneContainer::removeFromBins(SceneObject* object)
    PROFILE_START(RemoveFromBins);
    AssertFatal(object != NULL, "No object?");
    AssertFatal(object->mContainerLookup.mListHandle != 0, "SceneContainer::removeFromBins - object not in bins");
-   
+
+   if (mQuadtree)
+   {
+      mQuadtree->remove(object);
+      PROFILE_END();
+      return;
+   }
+
    BinValueList::ListHandle listHandle = (BinValueList::ListHandle)object->mContainerLookup.mListHandle;
    U32 numValues = 0;
 
@@ -571,6 +871,12 @@ void SceneContainer::checkBins(SceneObject* object)
 {
    AssertFatal(object != NULL, "Invalid object");
 
+   if (mQuadtree)
+   {
+      mQuadtree->update(object);
+      return;
+   }
+
    if ((BinValueList::ListHandle)object->mContainerLookup.mListHandle == 0)
    {
       // Failsafe case
@@ -604,32 +910,29 @@ void SceneContainer::checkBins(SceneObject* object)
 
 //-----------------------------------------------------------------------------
 
-void SceneContainer::findObjects(const Box3F& box, U32 mask, FindCallback callback, void *key)
+template<typename FUNC> void SceneContainer::_findInIndex( const Box3F& box, FUNC func, bool newKey )
 {
-   PROFILE_SCOPE(ContainerFindObjects_Box);
+   if (newKey)
+      mCurrSeqKey++;
 
-   // If we're searching for just water, just physical zones, or
-   // just water and physical zones then use the optimized path.
-   if ( mask == WaterObjectType || 
-        mask == PhysicalZoneObjectType ||
-        mask == (WaterObjectType|PhysicalZoneObjectType) )
-   {
-      _findSpecialObjects( mWaterAndZones, box, mask, callback, key );
-      return;
-   }
-   else if( mask == TerrainObjectType )
+   if (mQuadtree)
    {
-      _findSpecialObjects( mTerrains, box, mask, callback, key );
+      // Objects are only ever in one node so the key only matters
+      // when several boxes of a batch share it
+      mQuadtree->findObjects(box, [&](SceneObject* object)
+      {
+         if (object->getContainerSeqKey() != mCurrSeqKey)
+         {
+            object->setContainerSeqKey(mCurrSeqKey);
+            func(object);
+         }
+      });
       return;
    }
 
-   AssertFatal( !mSearchInProgress, "SceneContainer::findObjects - Container queries are not re-entrant" );
-   mSearchInProgress = true;
-
    U32 minX, maxX, minY, maxY;
    getBinRange(box.minExtents.x, box.maxExtents.x, minX, maxX);
    getBinRange(box.minExtents.y, box.maxExtents.y, minY, maxY);
-   mCurrSeqKey++;
 
    for (U32 i = minY; i <= maxY; i++)
    {
@@ -645,15 +948,7 @@ void SceneContainer::findObjects(const Box3F& box, U32 mask, FindCallback callba
             if (object->getContainerSeqKey() != mCurrSeqKey)
             {
                object->setContainerSeqKey(mCurrSeqKey);
-
-               if ((object->getTypeMask() & mask) != 0 &&
-                   object->isCollisionEnabled())
-               {
-                  if (object->getWorldBox().isOverlapped(box) || object->isGlobalBounds())
-                  {
-                     (*callback)(object,key);
-                  }
-               }
+               func(object);
             }
          }
       }
@@ -665,17 +960,46 @@ void SceneContainer::findObjects(const Box3F& box, U32 mask, FindCallback callba
       if (object->getContainerSeqKey() != mCurrSeqKey)
       {
          object->setContainerSeqKey(mCurrSeqKey);
+         func(object);
+      }
+   }
+}
 
-         if ((object->getTypeMask() & mask) != 0 &&
-             object->isCollisionEnabled())
+//-----------------------------------------------------------------------------
+
+void SceneContainer::findObjects(const Box3F& box, U32 mask, FindCallback callback, void *key)
+{
+   PROFILE_SCOPE(ContainerFindObjects_Box);
+
+   // If we're searching for just water, just physical zones, or
+   // just water and physical zones then use the optimized path.
+   if ( mask == WaterObjectType || 
+        mask == PhysicalZoneObjectType ||
+        mask == (WaterObjectType|PhysicalZoneObjectType) )
+   {
+      _findSpecialObjects( mWaterAndZones, box, mask, callback, key );
+      return;
+   }
+   else if( mask == TerrainObjectType )
+   {
+      _findSpecialObjects( mTerrains, box, mask, callback, key );
+      return;
+   }
+
+   AssertFatal( !mSearchInProgress, "SceneContainer::findObjects - Container queries are not re-entrant" );
+   mSearchInProgress = true;
+
+   _findInIndex( box, [&]( SceneObject* object )
+   {
+      if ((object->getTypeMask() & mask) != 0 &&
+          object->isCollisionEnabled())
+      {
+         if (object->getWorldBox().isOverlapped(box) || object->isGlobalBounds())
          {
-            if (object->getWorldBox().isOverlapped(box) || object->isGlobalBounds())
-            {
-               (*callback)(object,key);
-            }
+            (*callback)(object,key);
          }
       }
-   }
+   });
 
    mSearchInProgress = false;
 }
@@ -704,61 +1028,19 @@ void SceneContainer::findObjects( const Frustum &frustum, U32 mask, FindCallback
    AssertFatal( !mSearchInProgress, "SceneContainer::findObjects - Container queries are not re-entrant" );
    mSearchInProgress = true;
 
-   U32 minX, maxX, minY, maxY;
-   getBinRange(searchBox.minExtents.x, searchBox.maxExtents.x, minX, maxX);
-   getBinRange(searchBox.minExtents.y, searchBox.maxExtents.y, minY, maxY);
-   mCurrSeqKey++;
-
-   for (U32 i = minY; i <= maxY; i++)
-   {
-      U32 insertY = i % csmNumAxisBins;
-      U32 base    = insertY * csmNumAxisBins;
-      for (U32 j = minX; j <= maxX; j++)
-      {
-         U32 insertX = j % csmNumAxisBins;
-
-         ObjectList& chainList = mBinArray[base + insertX];
-         for(SceneObject* object : chainList)
-         {
-            if (object->getContainerSeqKey() != mCurrSeqKey)
-            {
-               object->setContainerSeqKey(mCurrSeqKey);
-
-               if ((object->getTypeMask() & mask) != 0 &&
-                  object->isCollisionEnabled())
-               {
-                  const Box3F &worldBox = object->getWorldBox();
-                  if ( object->isGlobalBounds() || worldBox.isOverlapped(searchBox) )
-                  {
-                     if ( !frustum.isCulled( worldBox ) )
-                        (*callback)(object,key);
-                  }
-               }
-            }
-         }
-      }
-   }
-
-   ObjectList& overflowList = mBinArray[csmOverflowBinIdx];
-   for(SceneObject* object : overflowList)
+   _findInIndex( searchBox, [&]( SceneObject* object )
    {
-      if (object->getContainerSeqKey() != mCurrSeqKey)
+      if ((object->getTypeMask() & mask) != 0 &&
+         object->isCollisionEnabled())
       {
-         object->setContainerSeqKey(mCurrSeqKey);
-
-         if ((object->getTypeMask() & mask) != 0 &&
-            object->isCollisionEnabled())
+         const Box3F &worldBox = object->getWorldBox();
+         if ( object->isGlobalBounds() || worldBox.isOverlapped(searchBox) )
          {
-            const Box3F &worldBox = object->getWorldBox();
-
-            if ( object->isGlobalBounds() || worldBox.isOverlapped(searchBox) )
-            {
-               if ( !frustum.isCulled( worldBox ) )
-                  (*callback)(object,key);
-            }
+            if ( !frustum.isCulled( worldBox ) )
+               (*callback)(object,key);
          }
       }
-   }
+   });
 
    mSearchInProgress = false;
 }
@@ -796,56 +1078,17 @@ void SceneContainer::polyhedronFindObjects(const Polyhedron& polyhedron, U32 mas
    AssertFatal( !mSearchInProgress, "SceneContainer::polyhedronFindObjects - Container queries are not re-entrant" );
    mSearchInProgress = true;
 
-   U32 minX, maxX, minY, maxY;
-   getBinRange(box.minExtents.x, box.maxExtents.x, minX, maxX);
-   getBinRange(box.minExtents.y, box.maxExtents.y, minY, maxY);
-   mCurrSeqKey++;
-
-   for (i = minY; i <= maxY; i++)
+   _findInIndex( box, [&]( SceneObject* object )
    {
-      U32 insertY = i % csmNumAxisBins;
-      U32 base    = insertY * csmNumAxisBins;
-      for (U32 j = minX; j <= maxX; j++)
+      if ((object->getTypeMask() & mask) != 0 &&
+          object->isCollisionEnabled())
       {
-         U32 insertX = j % csmNumAxisBins;
-
-         ObjectList& chainList = mBinArray[base + insertX];
-         for(SceneObject* object : chainList)
+         if (object->getWorldBox().isOverlapped(box) || object->isGlobalBounds())
          {
-            if (object->getContainerSeqKey() != mCurrSeqKey)
-            {
-               object->setContainerSeqKey(mCurrSeqKey);
-
-               if ((object->getTypeMask() & mask) != 0 &&
-                   object->isCollisionEnabled())
-               {
-                  if (object->getWorldBox().isOverlapped(box) || object->isGlobalBounds())
-                  {
-                     (*callback)(object,key);
-                  }
-               }
-            }
+            (*callback)(object,key);
          }
       }
-   }
-
-   ObjectList& overflowList = mBinArray[csmOverflowBinIdx];
-   for(SceneObject* object : overflowList)
-   {
-      if (object->getContainerSeqKey() != mCurrSeqKey)
-      {
-         object->setContainerSeqKey(mCurrSeqKey);
-
-         if ((object->getTypeMask() & mask) != 0 &&
-             object->isCollisionEnabled())
-         {
-            if (object->getWorldBox().isOverlapped(box) || object->isGlobalBounds())
-            {
-               (*callback)(object,key);
-            }
-         }
-      }
-   }
+   });
 
    mSearchInProgress = false;
 }
@@ -859,59 +1102,18 @@ void SceneContainer::findObjectList( const Box3F& searchBox, U32 mask, Vector<Sc
    AssertFatal( !mSearchInProgress, "SceneContainer::findObjectList - Container queries are not re-entrant" );
    mSearchInProgress = true;
 
-   U32 minX, maxX, minY, maxY;
-   getBinRange(searchBox.minExtents.x, searchBox.maxExtents.x, minX, maxX);
-   getBinRange(searchBox.minExtents.y, searchBox.maxExtents.y, minY, maxY);
-   mCurrSeqKey++;
-
-   for (U32 i = minY; i <= maxY; i++)
+   _findInIndex( searchBox, [&]( SceneObject* object )
    {
-      U32 insertY = i % csmNumAxisBins;
-      U32 base    = insertY * csmNumAxisBins;
-      for (U32 j = minX; j <= maxX; j++)
-      {
-         U32 insertX = j % csmNumAxisBins;
-
-         ObjectList& chainList = mBinArray[base + insertX];
-         for(SceneObject* object : chainList)
-         {
-            if (object->getContainerSeqKey() != mCurrSeqKey)
-            {
-               object->setContainerSeqKey(mCurrSeqKey);
-
-               if ((object->getTypeMask() & mask) != 0 &&
-                  object->isCollisionEnabled())
-               {
-                  const Box3F &worldBox = object->getWorldBox();
-                  if ( object->isGlobalBounds() || worldBox.isOverlapped( searchBox ) )
-                  {
-                     outFound->push_back( object );
-                  }
-               }
-            }
-         }
-      }
-   }
-
-   ObjectList& overflowList = mBinArray[csmOverflowBinIdx];
-   for(SceneObject* object : overflowList)
-   {
-      if (object->getContainerSeqKey() != mCurrSeqKey)
+      if ((object->getTypeMask() & mask) != 0 &&
+         object->isCollisionEnabled())
       {
-         object->setContainerSeqKey(mCurrSeqKey);
-
-         if ((object->getTypeMask() & mask) != 0 &&
-            object->isCollisionEnabled())
+         const Box3F &worldBox = object->getWorldBox();
+         if ( object->isGlobalBounds() || worldBox.isOverlapped( searchBox ) )
          {
-            const Box3F &worldBox = object->getWorldBox();
-
-            if ( object->isGlobalBounds() || worldBox.isOverlapped( searchBox ) )
-            {
-               outFound->push_back( object );
-            }
+            outFound->push_back( object );
          }
       }
-   }
+   });
 
    mSearchInProgress = false;
 }
@@ -1049,18 +1251,25 @@ bool SceneContainer::_castRay( U32 type, const Point3F& start, const Point3F& en
    rayParams.seqKey = mCurrSeqKey;
    rayParams.type = (SceneContainer::CastRayType)type;
 
-   // First check overflow
-   foundCandidate = SceneRayHelper::castInBinIdx(rayParams, rayQuery, mBinArray, SceneContainer::csmOverflowBinIdx, info, del);
-
-   if (simpleCase)
+   if (mQuadtree)
    {
-      if (SceneRayHelper::castInBinSimple(rayParams, rayQuery, mBinArray, info, del))
-         foundCandidate = true;
+      foundCandidate = SceneRayHelper::castInQuadtree(rayParams, rayQuery, *mQuadtree, info, del);
    }
    else
    {
-      if (SceneRayHelper::castInBins(rayParams, rayQuery, mBinArray, info, del))
-         foundCandidate = true;
+      // First check overflow
+      foundCandidate = SceneRayHelper::castInBinIdx(rayParams, rayQuery, mBinArray, SceneContainer::csmOverflowBinIdx, info, del);
+
+      if (simpleCase)
+      {
+         if (SceneRayHelper::castInBinSimple(rayParams, rayQuery, mBinArray, info, del))
+            foundCandidate = true;
+      }
+      else
+      {
+         if (SceneRayHelper::castInBins(rayParams, rayQuery, mBinArray, info, del))
+            foundCandidate = true;
+      }
    }
 
    mSearchInProgress = false;
@@ -1068,16 +1277,7 @@ bool SceneContainer::_castRay( U32 type, const Point3F& start, const Point3F& en
    // Bump the normal into worldspace if appropriate.
    if(foundCandidate)
    {
-      PlaneF fakePlane;
-      fakePlane.x = info->normal.x;
-      fakePlane.y = info->normal.y;
-      fakePlane.z = info->normal.z;
-      fakePlane.d = 0;
-
-      PlaneF result;
-      mTransformPlane(info->object->getTransform(), info->object->getScale(), fakePlane, &result);
-      info->normal = result;
-
+      SceneRayHelper::normalToWorld(info);
       return true;
    }
    else
@@ -1175,24 +1375,418 @@ bool SceneContainer::collideBox(const Point3F &start, const Point3F &end, U32 ma
    rayParams.seqKey = mCurrSeqKey;
    rayParams.type = CollisionGeometry;
 
-   // First check overflow
-   foundCandidate = SceneRayHelper::castInBinIdx(rayParams, rayQuery, mBinArray, SceneContainer::csmOverflowBinIdx, info, BoxRayOverflowCallbackDelegate());
-
-   if (simpleCase)
+   if (mQuadtree)
    {
-      if (SceneRayHelper::castInBinSimple(rayParams, rayQuery, mBinArray, info, BoxRayCallbackDelegate()))
-         foundCandidate = true;
+      // Global bounds objects are skipped as they are in the overflow bin
+      struct BoxRayQuadtreeCallbackDelegate
+      {
+         inline bool checkFunc(SceneRayHelper::QueryParams delParams, SceneObject* ptr, RayInfo* delInfo, F32& currentT) const
+         {
+            if (ptr->isGlobalBounds())
+               return false;
+
+            return BoxRayCallbackDelegate().checkFunc(delParams, ptr, delInfo, currentT);
+         }
+      };
+
+      foundCandidate = SceneRayHelper::castInQuadtree(rayParams, rayQuery, *mQuadtree, info, BoxRayQuadtreeCallbackDelegate());
    }
    else
    {
-      if (SceneRayHelper::castInBins(rayParams, rayQuery, mBinArray, info, BoxRayCallbackDelegate()))
-         foundCandidate = true;
+      // First check overflow
+      foundCandidate = SceneRayHelper::castInBinIdx(rayParams, rayQuery, mBinArray, SceneContainer::csmOverflowBinIdx, info, BoxRayOverflowCallbackDelegate());
+
+      if (simpleCase)
+      {
+         if (SceneRayHelper::castInBinSimple(rayParams, rayQuery, mBinArray, info, BoxRayCallbackDelegate()))
+            foundCandidate = true;
+      }
+      else
+      {
+         if (SceneRayHelper::castInBins(rayParams, rayQuery, mBinArray, info, BoxRayCallbackDelegate()))
+            foundCandidate = true;
+      }
    }
 
    mSearchInProgress = false;
    return foundCandidate;
 }
 
+//=============================================================================
+//    Batched queries.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::BatchCandidates::clear()
+{
+   minX.clear();
+   minY.clear();
+   minZ.clear();
+   maxX.clear();
+   maxY.clear();
+   maxZ.clear();
+   typeMask.clear();
+   objects.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::BatchCandidates::push_back( SceneObject* object )
+{
+   if ( object->isGlobalBounds() )
+   {
+      // Everything hits these
+      minX.push_back( -F32_MAX );
+      minY.push_back( -F32_MAX );
+      minZ.push_back( -F32_MAX );
+      maxX.push_back( F32_MAX );
+      maxY.push_back( F32_MAX );
+      maxZ.push_back( F32_MAX );
+   }
+   else
+   {
+      const Box3F& box = object->getWorldBox();
+      minX.push_back( box.minExtents.x );
+      minY.push_back( box.minExtents.y );
+      minZ.push_back( box.minExtents.z );
+      maxX.push_back( box.maxExtents.x );
+      maxY.push_back( box.maxExtents.y );
+      maxZ.push_back( box.maxExtents.z );
+   }
+
+   typeMask.push_back( object->getTypeMask() );
+   objects.push_back( object );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::BatchCandidates::pad()
+{
+   // The padding is never reported as objects only holds the real candidates
+   while ( minX.size() & 3 )
+   {
+      minX.push_back( 0.0f );
+      minY.push_back( 0.0f );
+      minZ.push_back( 0.0f );
+      maxX.push_back( 0.0f );
+      maxY.push_back( 0.0f );
+      maxZ.push_back( 0.0f );
+      typeMask.push_back( 0 );
+   }
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::_testBatchRay( const BatchCandidates& batch, const Point3F& start, const Point3F& end, U32 mask, Vector< BatchHit >& outHits )
+{
+   const U32 numObjects = batch.objects.size();
+   const U32 padded = batch.minX.size();
+
+   // An axis the ray doesn't move along gets a huge inverse so its slab
+   // either takes in the whole ray or none of it.
+   const Point3F dir = end - start;
+   const F32 invX = mFabs( dir.x ) > 1e-20f ? 1.0f / dir.x : F32_MAX;
+   const F32 invY = mFabs( dir.y ) > 1e-20f ? 1.0f / dir.y : F32_MAX;
+   const F32 invZ = mFabs( dir.z ) > 1e-20f ? 1.0f / dir.z : F32_MAX;
+
+   auto addHit = [&]( U32 candidate, F32 t )
+   {
+      if ( candidate >= numObjects || !( batch.typeMask[ candidate ] & mask ) )
+         return;
+
+      outHits.increment();
+      outHits.last().candidate = candidate;
+      outHits.last().t = t;
+   };
+
+#ifdef SCENE_CONTAINER_SSE
+
+   const __m128 startX = _mm_set1_ps( start.x );
+   const __m128 startY = _mm_set1_ps( start.y );
+   const __m128 startZ = _mm_set1_ps( start.z );
+   const __m128 invDirX = _mm_set1_ps( invX );
+   const __m128 invDirY = _mm_set1_ps( invY );
+   const __m128 invDirZ = _mm_set1_ps( invZ );
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps( 1.0f );
+
+   for ( U32 i = 0; i < padded; i += 4 )
+   {
+      __m128 t0 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &batch.minX[i] ), startX ), invDirX );
+      __m128 t1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &batch.maxX[i] ), startX ), invDirX );
+      __m128 tEnter = _mm_max_ps( zero, _mm_min_ps( t0, t1 ) );
+      __m128 tExit = _mm_min_ps( one, _mm_max_ps( t0, t1 ) );
+
+      t0 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &batch.minY[i] ), startY ), invDirY );
+      t1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &batch.maxY[i] ), startY ), invDirY );
+      tEnter = _mm_max_ps( tEnter, _mm_min_ps( t0, t1 ) );
+      tExit = _mm_min_ps( tExit, _mm_max_ps( t0, t1 ) );
+
+      t0 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &batch.minZ[i] ), startZ ), invDirZ );
+      t1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &batch.maxZ[i] ), startZ ), invDirZ );
+      tEnter = _mm_max_ps( tEnter, _mm_min_ps( t0, t1 ) );
+      tExit = _mm_min_ps( tExit, _mm_max_ps( t0, t1 ) );
+
+      const S32 hits = _mm_movemask_ps( _mm_cmple_ps( tEnter, tExit ) );
+      if ( !hits )
+         continue;
+
+      F32 enter[ 4 ];
+      _mm_storeu_ps( enter, tEnter );
+      for ( U32 j = 0; j < 4; j++ )
+      {
+         if ( hits & ( 1 << j ) )
+            addHit( i + j, enter[ j ] );
+      }
+   }
+
+#else
+
+   for ( U32 i = 0; i < padded; i++ )
+   {
+      F32 t0 = ( batch.minX[i] - start.x ) * invX;
+      F32 t1 = ( batch.maxX[i] - start.x ) * invX;
+      F32 tEnter = getMax( 0.0f, getMin( t0, t1 ) );
+      F32 tExit = getMin( 1.0f, getMax( t0, t1 ) );
+
+      t0 = ( batch.minY[i] - start.y ) * invY;
+      t1 = ( batch.maxY[i] - start.y ) * invY;
+      tEnter = getMax( tEnter, getMin( t0, t1 ) );
+      tExit = getMin( tExit, getMax( t0, t1 ) );
+
+      t0 = ( batch.minZ[i] - start.z ) * invZ;
+      t1 = ( batch.maxZ[i] - start.z ) * invZ;
+      tEnter = getMax( tEnter, getMin( t0, t1 ) );
+      tExit = getMin( tExit, getMax( t0, t1 ) );
+
+      if ( tEnter <= tExit )
+         addHit( i, tEnter );
+   }
+
+#endif // SCENE_CONTAINER_SSE
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::_testBatchBox( const BatchCandidates& batch, const Box3F& box, Vector< SceneObject* >& outFound )
+{
+   const U32 numObjects = batch.objects.size();
+   const U32 padded = batch.minX.size();
+
+#ifdef SCENE_CONTAINER_SSE
+
+   const __m128 boxMinX = _mm_set1_ps( box.minExtents.x );
+   const __m128 boxMinY = _mm_set1_ps( box.minExtents.y );
+   const __m128 boxMinZ = _mm_set1_ps( box.minExtents.z );
+   const __m128 boxMaxX = _mm_set1_ps( box.maxExtents.x );
+   const __m128 boxMaxY = _mm_set1_ps( box.maxExtents.y );
+   const __m128 boxMaxZ = _mm_set1_ps( box.maxExtents.z );
+
+   for ( U32 i = 0; i < padded; i += 4 )
+   {
+      __m128 overlap = _mm_and_ps( _mm_cmple_ps( _mm_loadu_ps( &batch.minX[i] ), boxMaxX ),
+                                   _mm_cmpge_ps( _mm_loadu_ps( &batch.maxX[i] ), boxMinX ) );
+      overlap = _mm_and_ps( overlap, _mm_and_ps( _mm_cmple_ps( _mm_loadu_ps( &batch.minY[i] ), boxMaxY ),
+                                                 _mm_cmpge_ps( _mm_loadu_ps( &batch.maxY[i] ), boxMinY ) ) );
+      overlap = _mm_and_ps( overlap, _mm_and_ps( _mm_cmple_ps( _mm_loadu_ps( &batch.minZ[i] ), boxMaxZ ),
+                                                 _mm_cmpge_ps( _mm_loadu_ps( &batch.maxZ[i] ), boxMinZ ) ) );
+
+      const S32 hits = _mm_movemask_ps( overlap );
+      if ( !hits )
+         continue;
+
+      for ( U32 j = 0; j < 4; j++ )
+      {
+         if ( ( hits & ( 1 << j ) ) && i + j < numObjects )
+            outFound.push_back( batch.objects[ i + j ] );
+      }
+   }
+
+#else
+
+   for ( U32 i = 0; i < numObjects; i++ )
+   {
+      if ( batch.minX[i] <= box.maxExtents.x && batch.maxX[i] >= box.minExtents.x &&
+           batch.minY[i] <= box.maxExtents.y && batch.maxY[i] >= box.minExtents.y &&
+           batch.minZ[i] <= box.maxExtents.z && batch.maxZ[i] >= box.minExtents.z )
+         outFound.push_back( batch.objects[ i ] );
+   }
+
+#endif // SCENE_CONTAINER_SSE
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename FUNC>
+void SceneContainer::_forEachQuery( U32 count, const FUNC& fn )
+{
+   if ( S32( count ) < smBatchParallelThreshold || !JobSystem::isGlobalRunning() )
+      fn( 0, count );
+   else
+      parallelFor( JobSystem::GLOBAL(), 0, count, 16, fn );
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::findObjectLists( const Box3F* boxes, U32 count, U32 mask, Vector< SceneObject* >* outFound )
+{
+   PROFILE_SCOPE( Container_FindObjectLists );
+
+   if ( !count )
+      return;
+
+   AssertFatal( !mSearchInProgress, "SceneContainer::findObjectLists - Container queries are not re-entrant" );
+   mSearchInProgress = true;
+
+   // Gather everything near any of the boxes, using one key for the
+   // whole batch so each object is only added once.
+   mBatch.clear();
+   mCurrSeqKey++;
+
+   for ( U32 i = 0; i < count; i++ )
+   {
+      _findInIndex( boxes[ i ], [&]( SceneObject* object )
+      {
+         if ((object->getTypeMask() & mask) != 0 &&
+             object->isCollisionEnabled())
+            mBatch.push_back( object );
+      }, false );
+   }
+
+   mBatch.pad();
+
+   _forEachQuery( count, [&]( U32 start, U32 end )
+   {
+      for ( U32 i = start; i < end; i++ )
+         _testBatchBox( mBatch, boxes[ i ], outFound[ i ] );
+   });
+
+   mSearchInProgress = false;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneContainer::castRays( RayQuery* queries, U32 count, CastRayCallback callback )
+{
+   PROFILE_SCOPE( SceneContainer_CastRays );
+
+   if ( !count )
+      return;
+
+   AssertFatal( !mSearchInProgress, "SceneContainer::castRays - Container queries are not re-entrant" );
+   mSearchInProgress = true;
+
+   // Gathers the objects near a ray, skipping the ones an earlier
+   // ray of the batch already added.
+   struct GatherDelegate
+   {
+      BatchCandidates* batch;
+
+      inline bool checkFunc(SceneRayHelper::QueryParams params, SceneObject* ptr, RayInfo* info, F32& currentT) const
+      {
+         if (ptr->getContainerSeqKey() != params.seqKey &&
+             ptr->isCollisionEnabled() &&
+             (ptr->getTypeMask() & params.mask) != 0)
+            batch->push_back(ptr);
+
+         return false;
+      }
+   };
+
+   mBatch.clear();
+   mCurrSeqKey++;
+
+   GatherDelegate gather;
+   gather.batch = &mBatch;
+
+   SceneRayHelper::QueryParams rayParams;
+   rayParams.mask = 0;
+   rayParams.seqKey = mCurrSeqKey;
+   rayParams.type = CollisionGeometry;
+
+   for ( U32 i = 0; i < count; i++ )
+      rayParams.mask |= queries[ i ].mask;
+
+   RayInfo gatherInfo;
+   for ( U32 i = 0; i < count; i++ )
+   {
+      rayParams.start = &queries[ i ].start;
+      rayParams.end = &queries[ i ].end;
+
+      SceneRayHelper::State rayQuery;
+      const bool simpleCase = rayQuery.setup( queries[ i ].start, queries[ i ].end );
+
+      if ( mQuadtree )
+      {
+         SceneRayHelper::castInQuadtree( rayParams, rayQuery, *mQuadtree, &gatherInfo, gather );
+      }
+      else
+      {
+         SceneRayHelper::castInBinIdx( rayParams, rayQuery, mBinArray, csmOverflowBinIdx, &gatherInfo, gather );
+
+         if ( simpleCase )
+            SceneRayHelper::castInBinSimple( rayParams, rayQuery, mBinArray, &gatherInfo, gather );
+         else
+            SceneRayHelper::castInBins( rayParams, rayQuery, mBinArray, &gatherInfo, gather );
+      }
+   }
+
+   mBatch.pad();
+
+   // Find the boxes each ray crosses, nearest first.
+   while ( mBatchHits.size() < count )
+      mBatchHits.increment();
+
+   _forEachQuery( count, [&]( U32 start, U32 end )
+   {
+      for ( U32 i = start; i < end; i++ )
+      {
+         Vector< BatchHit >& hits = mBatchHits[ i ];
+         hits.clear();
+
+         _testBatchRay( mBatch, queries[ i ].start, queries[ i ].end, queries[ i ].mask, hits );
+
+         std::sort( hits.begin(), hits.end(), []( const BatchHit& a, const BatchHit& b )
+         {
+            return a.t < b.t;
+         });
+      }
+   });
+
+   // Then ask the objects.  Once a box starts further along the
+   // ray than the closest hit nothing past it can be closer.
+   SceneRayHelper::CheckObjectRayDelegate<CastRayCallback> del( callback );
+
+   for ( U32 i = 0; i < count; i++ )
+   {
+      RayQuery& query = queries[ i ];
+      AssertFatal( query.info.userData == NULL, "SceneContainer::castRays - RayInfo->userData cannot be used here!" );
+
+      rayParams.start = &query.start;
+      rayParams.end = &query.end;
+      rayParams.mask = query.mask;
+
+      query.hit = false;
+      F32 currentT = F32_MAX;
+
+      const Vector< BatchHit >& hits = mBatchHits[ i ];
+      for ( U32 j = 0; j < hits.size(); j++ )
+      {
+         if ( hits[ j ].t > currentT )
+            break;
+
+         if ( del.checkFunc( rayParams, mBatch.objects[ hits[ j ].candidate ], &query.info, currentT ) )
+            query.hit = true;
+      }
+
+      if ( query.hit )
+         SceneRayHelper::normalToWorld( &query.info );
+   }
+
+   mSearchInProgress = false;
+}
+
 //-----------------------------------------------------------------------------
 
 static void buildCallback(SceneObject* object,void *key)
@@ -1480,10 +2074,31 @@ void SceneContainer::getBinRange( const F32 min, const F32 max, U32& minBin, U32
 //=============================================================================
 // MARK: ---- Console API ----
 
+ImplementEnumType( SceneContainerSpatialIndex,
+   "The spatial index a SceneContainer uses to look up objects.\n"
+   "@ingroup Game\n\n")
+   { SceneContainer::BinGrid,       "BinGrid", "Fixed wrap-around grid of bins plus an overflow bin for large objects.\n" },
+   { SceneContainer::LooseQuadtree, "LooseQuadtree", "Loose quadtree; better suited to large worlds and large objects.\n" },
+EndImplementEnumType;
+
 ConsoleFunctionGroupBegin( Containers,  "Functions for ray casting and spatial queries.\n\n");
 
 //-----------------------------------------------------------------------------
 
+DefineEngineFunction( setContainerSpatialIndex, void, ( SceneContainerSpatialIndex type, bool useClientContainer ), ( false ),
+   "@brief Change the spatial index used to look up objects in a container.\n\n"
+   "Objects already in the container are moved over to the new index.\n"
+   "@param type The index to use.\n"
+   "@param useClientContainer Optionally indicates the client container should be changed.\n"
+   "@ingroup Game")
+{
+   SceneContainer* pContainer = useClientContainer ? &gClientContainer : &gServerContainer;
+
+   pContainer->setSpatialIndex( type );
+}
+
+//-----------------------------------------------------------------------------
+
 DefineEngineFunction( containerBoxEmpty, bool,
    ( U32 mask, Point3F center, F32 xRadius, F32 yRadius, F32 zRadius, bool useClientContainer ), ( -1, -1, false ),
    "@brief See if any objects of the given types are present in box of given extent.\n\n"
@@ -545,6 +545,178 @@ public:
 
 //----------------------------------------------------------------------------
 
+/// Loose quadtree over the XY plane used by SceneContainer in place of the
+/// bin grid.
+///
+/// Every object is stored in exactly one node: the deepest node at least as
+/// big as the object that contains the object's center. Nodes are looked up
+/// using their loose bounds, which are twice the node size, so an object never
+/// sticks out of the node it is stored in. Objects with global bounds, objects
+/// bigger than the whole tree and objects outside of it are kept in the root,
+/// which every query visits.
+///
+/// The node an object is stored in is kept in SceneObject::mContainerLookup.
+class SceneContainerQuadtree
+{
+public:
+
+   /// Default half size of the root node
+   static const F32 csmDefaultHalfSize;
+
+   /// Depth of the smallest nodes
+   static const U32 csmMaxDepth;
+
+   struct Node
+   {
+      /// Center of the node
+      Point2F center;
+
+      /// Half the node size; the loose bounds extend twice this from center
+      F32 halfSize;
+
+      /// Child node indices, -1 if not allocated
+      S32 children[4];
+
+      /// Parent node index, -1 for the root
+      S32 parent;
+
+      /// Objects in this node and all of its children
+      U32 numObjects;
+
+      /// Depth and cell of this node
+      U32 depth;
+      U32 cellX;
+      U32 cellY;
+
+      /// Objects stored in this node
+      Vector<SceneObject*> objects;
+   };
+
+protected:
+
+   /// All nodes, the root is node 0. Nodes are never freed until clear();
+   /// empty ones are skipped by numObjects.
+   Vector<Node> mNodes;
+
+   Point2F mCenter;
+   F32 mHalfSize;
+
+   /// Find the depth and cell an object with the given bounds belongs in
+   void _getCell(const Box3F& box, bool global, U32& outDepth, U32& outX, U32& outY) const;
+
+   /// Find or allocate the node for a depth and cell
+   U32 _getNode(U32 depth, U32 x, U32 y);
+
+   static inline bool _overlapsLoose(const Node& node, const Box3F& box)
+   {
+      const F32 size = node.halfSize * 2.0f;
+      return box.minExtents.x <= node.center.x + size && box.maxExtents.x >= node.center.x - size &&
+             box.minExtents.y <= node.center.y + size && box.maxExtents.y >= node.center.y - size;
+   }
+
+   /// Clips the XY part of a line to the loose bounds of a node.
+   /// @return false if the line misses the node, otherwise the entry time in outT
+   static bool _clipLoose(const Node& node, const Point3F& start, const Point3F& dir, F32& outT);
+
+public:
+
+   SceneContainerQuadtree(const Point2F& center = Point2F(0, 0), F32 halfSize = csmDefaultHalfSize);
+
+   /// Removes all nodes. Objects should have been removed first.
+   void clear();
+
+   /// Adds an object to the node that fits it
+   void insert(SceneObject* object);
+
+   /// Removes an object from the tree
+   void remove(SceneObject* object);
+
+   /// Moves an object to another node if its bounds have changed enough
+   void update(SceneObject* object);
+
+   const Vector<Node>& getNodes() const { return mNodes; }
+
+   /// Invokes func for every object in nodes overlapping box.
+   template<typename FUNC> void findObjects(const Box3F& box, FUNC func) const
+   {
+      U32 stack[4 * 32];
+      U32 stackSize = 0;
+      stack[stackSize++] = 0;
+
+      while (stackSize > 0)
+      {
+         const Node& node = mNodes[stack[--stackSize]];
+         if (node.numObjects == 0)
+            continue;
+
+         for (SceneObject* object : node.objects)
+            func(object);
+
+         for (U32 i = 0; i < 4; i++)
+         {
+            if (node.children[i] >= 0 && _overlapsLoose(mNodes[node.children[i]], box))
+               stack[stackSize++] = node.children[i];
+         }
+      }
+   }
+
+   /// Invokes func for every object in nodes crossed by the line from start to end,
+   /// nearest nodes first. Nodes entered after currentT are skipped, so func should
+   /// lower currentT as it finds hits.
+   template<typename FUNC> void castRay(const Point3F& start, const Point3F& end, const F32& currentT, FUNC func) const
+   {
+      const Point3F dir = end - start;
+
+      U32 stack[4 * 32];
+      F32 stackT[4 * 32];
+      U32 stackSize = 0;
+      stack[stackSize] = 0;
+      stackT[stackSize++] = 0.0f;
+
+      while (stackSize > 0)
+      {
+         stackSize--;
+         if (stackT[stackSize] > currentT)
+            continue;
+
+         const Node& node = mNodes[stack[stackSize]];
+         if (node.numObjects == 0)
+            continue;
+
+         for (SceneObject* object : node.objects)
+            func(object);
+
+         // Push the children far to near so the nearest is visited next
+         U32 childIdx[4];
+         F32 childT[4];
+         U32 numChildren = 0;
+         for (U32 i = 0; i < 4; i++)
+         {
+            F32 t;
+            if (node.children[i] < 0 || !_clipLoose(mNodes[node.children[i]], start, dir, t))
+               continue;
+
+            U32 j = numChildren++;
+            for (; j > 0 && childT[j - 1] < t; j--)
+            {
+               childIdx[j] = childIdx[j - 1];
+               childT[j] = childT[j - 1];
+            }
+            childIdx[j] = node.children[i];
+            childT[j] = t;
+         }
+
+         for (U32 i = 0; i < numChildren; i++)
+         {
+            stack[stackSize] = childIdx[i];
+            stackT[stackSize++] = childT[i];
+         }
+      }
+   }
+};
+
+//----------------------------------------------------------------------------
+
 /// Database for SceneObjects.
 ///
 /// ScenceContainer implements a grid-based spatial subdivision for the contents of a scene.
@@ -557,6 +729,13 @@ class SceneContainer
          RenderedGeometry,
       };
 
+      /// Spatial index used to look up objects by position
+      enum SpatialIndexType
+      {
+         BinGrid,       ///< Wrap-around grid of csmNumAxisBins x csmNumAxisBins bins plus an overflow bin
+         LooseQuadtree, ///< SceneContainerQuadtree; better for large worlds and large objects
+      };
+
    public:
 
       typedef SceneContainerBinRefList<U16> BinValueList;
@@ -610,6 +789,36 @@ class SceneContainer
       /// Maintains a list of bin references
       BinValueList mBinRefLists;
 
+      /// Used instead of the bins if set
+      SceneContainerQuadtree* mQuadtree;
+
+      /// Bounds of the objects gathered by a batched query, one array per
+      /// component so they can be tested four at a time.  The arrays are
+      /// padded to a multiple of four.
+      struct BatchCandidates
+      {
+         Vector<F32> minX, minY, minZ;
+         Vector<F32> maxX, maxY, maxZ;
+         Vector<U32> typeMask;
+         Vector<SceneObject*> objects;
+
+         void clear();
+         void push_back( SceneObject* object );
+         void pad();
+      };
+
+      /// A candidate box crossed by a ray of a batch and where the ray enters it.
+      struct BatchHit
+      {
+         U32 candidate;
+         F32 t;
+      };
+
+      BatchCandidates mBatch;
+
+      /// Boxes crossed by each ray of the last castRays() batch.
+      Vector< Vector< BatchHit > > mBatchHits;
+
    public:
       /// World units of side of bin
       static const F32 csmBinSize;
@@ -623,6 +832,10 @@ class SceneContainer
       /// Total number of bin lists to allocate
       static const U32 csmTotalNumBins;
 
+      /// Batched queries with fewer boxes or rays than this are tested on
+      /// the calling thread instead of the job system.
+      static S32 smBatchParallelThreshold;
+
    public:
 
       SceneContainer();
@@ -634,6 +847,14 @@ class SceneContainer
       /// Return a vector containing all terrain objects in this container.
       const Vector< SceneObject* >& getTerrains() const { return mTerrains; }
 
+      /// Switches the spatial index, moving all objects over to it.
+      void setSpatialIndex( SpatialIndexType type );
+
+      SpatialIndexType getSpatialIndex() const { return mQuadtree ? LooseQuadtree : BinGrid; }
+
+      /// Returns the quadtree, or NULL if the bin grid is used.
+      const SceneContainerQuadtree* getQuadtree() const { return mQuadtree; }
+
       /// @name Basic database operations
       /// @{
 
@@ -663,6 +884,14 @@ class SceneContainer
       ///
       void findObjectList( const Frustum& frustum, U32 mask, Vector< SceneObject* >* outFound );
 
+      /// Find the objects overlapping each of count boxes, adding the ones
+      /// for boxes[ i ] to outFound[ i ].
+      ///
+      /// Gives the same results as calling findObjectList() for each box but
+      /// walks the index once for the whole batch and tests the boxes against
+      /// the candidates four at a time, on the job system for large batches.
+      void findObjectLists( const Box3F* boxes, U32 count, U32 mask, Vector< SceneObject* >* outFound );
+
       /// @}
 
       /// @name Line intersection
@@ -679,6 +908,28 @@ class SceneContainer
 
       bool collideBox(const Point3F &start, const Point3F &end, U32 mask, RayInfo* info);
 
+      /// One ray of a castRays() batch.
+      struct RayQuery
+      {
+         Point3F start;
+         Point3F end;
+         U32 mask;
+
+         /// Set by castRays(), info is only valid if hit is true.
+         bool hit;
+         RayInfo info;
+      };
+
+      /// Test a batch of rays against collision geometry.
+      ///
+      /// Gives the same results as calling castRay() for each query but walks
+      /// the index once for the whole batch.  The rays are tested against the
+      /// candidate boxes four at a time, on the job system for large batches
+      /// (see smBatchParallelThreshold), then the objects
+      /// are asked for their castRay() on the calling thread, nearest box
+      /// first, until a box is further away than the closest hit.
+      void castRays( RayQuery* queries, U32 count, CastRayCallback callback = NULL );
+
       /// @}
 
       /// @name Poly list
@@ -726,6 +977,23 @@ class SceneContainer
 
       void cleanupSearchVectors();
 
+      /// Invokes func once for each object in the bins or quadtree nodes
+      /// touched by box, and in the overflow bin.  Batched queries pass
+      /// newKey false so that objects already visited by an earlier box of
+      /// the batch are skipped.
+      template<typename FUNC> void _findInIndex( const Box3F& box, FUNC func, bool newKey = true );
+
+      /// Appends to outHits the candidates in batch whose box is crossed by
+      /// the ray and whose type matches mask, with the ray t where it enters the box.
+      static void _testBatchRay( const BatchCandidates& batch, const Point3F& start, const Point3F& end, U32 mask, Vector< BatchHit >& outHits );
+
+      /// Appends to outFound the candidates in batch overlapping box.
+      static void _testBatchBox( const BatchCandidates& batch, const Box3F& box, Vector< SceneObject* >& outFound );
+
+      /// Calls fn( start, end ) over the count queries of a batch, split up
+      /// on the job system if there is one and the batch is big enough.
+      template<typename FUNC> static void _forEachQuery( U32 count, const FUNC& fn );
+
       /// Base cast ray code
       bool _castRay( U32 type, const Point3F &start, const Point3F &end, U32 mask, RayInfo* info, CastRayCallback callback );
 
@@ -782,4 +1050,7 @@ inline bool SceneBinRange::shouldOverflow() const
 extern SceneContainer gServerContainer;
 extern SceneContainer gClientContainer;
 
+typedef SceneContainer::SpatialIndexType SceneContainerSpatialIndex;
+DefineEnumType( SceneContainerSpatialIndex );
+
 #endif // !_SCENECONTAINER_H_
@@ -72,10 +72,33 @@ MODULE_BEGIN( Scene )
          "If true, zone culling will be disabled and the scene contents will only be culled against the root frustum.\n\n"
          "@ingroup Rendering\n" );
 
+      Con::addVariable( "$Scene::batchCullThreshold", TypeS32, &SceneCullingState::smBatchCullThreshold,
+         "Object lists of at least this size have their bounds tested against the frustum planes in bulk "
+         "on the job system before the per object culling tests.  0 disables the bulk tests.\n\n"
+         "@ingroup Rendering\n" );
+
+      Con::addVariable( "$Scene::batchQueryParallelThreshold", TypeS32, &SceneContainer::smBatchParallelThreshold,
+         "Batched container queries with at least this many boxes or rays are tested on the job system, "
+         "smaller batches run on the calling thread.\n\n"
+         "@ingroup Rendering\n" );
+
       Con::addVariable( "$Scene::renderBoundingBoxes", TypeBool, &SceneManager::smRenderBoundingBoxes,
          "If true, the bounding boxes of objects will be displayed.\n\n"
          "@ingroup Rendering" );
 
+      Con::addVariable( "$Scene::useScopingCache", TypeBool, &SceneManager::smUseScopingCache,
+         "If true, connections whose cameras are in the same cell and have the same visible distance "
+         "share a single container query per tick when scoping ghosts.\n\n"
+         "@ingroup Networking" );
+
+      Con::addVariable( "$Scene::scopingCellSize", TypeF32, &SceneManager::smScopingCellSize,
+         "Side length in world units of the camera cells used to group scoping queries.\n\n"
+         "@ingroup Networking" );
+
+      Con::addVariable( "$Scene::scopingQueriesSaved", TypeS32, &SceneManager::smScopingQueriesSaved,
+         "Number of scoping container queries that were answered from the scoping cache in the current tick.\n\n"
+         "@ingroup Networking" );
+
       Con::addVariable( "$Scene::maxOccludersPerZone", TypeS32, &SceneCullingState::smMaxOccludersPerZone,
          "Maximum number of occluders that will be concurrently allowed into the scene culling state of any given zone.\n\n"
          "@ingroup Rendering" );
@@ -100,6 +123,9 @@ MODULE_END;
 
 bool SceneManager::smRenderBoundingBoxes;
 bool SceneManager::smLockDiffuseFrustum = false;
+bool SceneManager::smUseScopingCache = true;
+F32 SceneManager::smScopingCellSize = 32.0f;
+S32 SceneManager::smScopingQueriesSaved = 0;
 SceneCameraState SceneManager::smLockedDiffuseCamera = SceneCameraState( RectI(), Frustum(), MatrixF(), MatrixF() );
 
 SceneManager* gClientSceneGraph = NULL;
@@ -119,9 +145,12 @@ SceneManager::SceneManager( bool isClient )
      mNearClip( 0.1f ),
      mLightManager( NULL ),
      mAmbientLightColor( LinearColorF( 0.1f, 0.1f, 0.1f, 1.0f ) ),
-     mDefaultRenderPass( NULL )
+     mDefaultRenderPass( NULL ),
+     mNumScopingGroups( 0 ),
+     mScopingTime( 0 )
 {
    VECTOR_SET_ASSOCIATION( mBatchQueryList );
+   VECTOR_SET_ASSOCIATION( mScopingGroups );
 
    // For the client, create a zone manager.
 
@@ -141,6 +170,9 @@ SceneManager::~SceneManager()
 {   
    SAFE_DELETE( mZoneManager );
 
+   for( U32 i = 0; i < mScopingGroups.size(); ++ i )
+      delete mScopingGroups[ i ];
+
    if( mLightManager )
       mLightManager->deactivate();   
 }
@@ -519,6 +551,7 @@ struct ScopingInfo
    Point3F        scopePoint;
    F32            scopeDist;
    F32            scopeDistSquared;
+   Box3F          scopeArea;
    NetConnection* connection;
 };
 
@@ -545,6 +578,59 @@ static void _scopeCallback( SceneObject* object, void* data )
    }
 }
 
+void SceneManager::_scopingGroupCallback( SceneObject* object, void* key )
+{
+   if( object->isScopeable() )
+      reinterpret_cast< ScopingGroup* >( key )->objects.push_back( object );
+}
+
+SceneManager::ScopingGroup* SceneManager::_getScopingGroup( const CameraScopeQuery* query )
+{
+   // Scoping results are only valid for the tick they were built in.
+
+   const SimTime now = Sim::getCurrentTime();
+   if( now != mScopingTime )
+   {
+      mScopingTime = now;
+      smScopingQueriesSaved = 0;
+      _invalidateScopingCache();
+   }
+
+   const F32 cellSize = getMax( smScopingCellSize, 1.0f );
+   const Point3I cell( ( S32 ) mFloor( query->pos.x / cellSize ),
+                       ( S32 ) mFloor( query->pos.y / cellSize ),
+                       ( S32 ) mFloor( query->pos.z / cellSize ) );
+
+   for( U32 i = 0; i < mNumScopingGroups; ++ i )
+   {
+      ScopingGroup* group = mScopingGroups[ i ];
+      if( group->cell == cell && group->visibleDistance == query->visibleDistance )
+      {
+         smScopingQueriesSaved ++;
+         return group;
+      }
+   }
+
+   if( mNumScopingGroups == (U32)mScopingGroups.size() )
+      mScopingGroups.push_back( new ScopingGroup );
+
+   ScopingGroup* group = mScopingGroups[ mNumScopingGroups ++ ];
+   group->cell = cell;
+   group->visibleDistance = query->visibleDistance;
+   group->objects.clear();
+
+   // Query the area that any camera in the cell could scope.
+
+   Box3F area( Point3F( cell.x, cell.y, cell.z ) * cellSize,
+               Point3F( cell.x + 1, cell.y + 1, cell.z + 1 ) * cellSize );
+   area.minExtents -= Point3F( query->visibleDistance, query->visibleDistance, query->visibleDistance );
+   area.maxExtents += Point3F( query->visibleDistance, query->visibleDistance, query->visibleDistance );
+
+   getContainer()->findObjects( area, 0xFFFFFFFF, _scopingGroupCallback, group );
+
+   return group;
+}
+
 void SceneManager::scopeScene( CameraScopeQuery* query, NetConnection* netConnection )
 {
    PROFILE_SCOPE( SceneGraph_scopeScene );
@@ -566,14 +652,29 @@ void SceneManager::scopeScene( CameraScopeQuery* query, NetConnection* netConnec
    info.scopePoint       = query->pos;
    info.scopeDist        = query->visibleDistance;
    info.scopeDistSquared = info.scopeDist * info.scopeDist;
+   info.scopeArea        = Box3F( query->visibleDistance );
+   info.scopeArea.setCenter( query->pos );
    info.connection       = netConnection;
 
-   // Scope all objects in the query area.
+   if( !smUseScopingCache )
+   {
+      // Scope all objects in the query area.
+
+      getContainer()->findObjects( info.scopeArea, 0xFFFFFFFF, _scopeCallback, &info );
+      return;
+   }
 
-   Box3F area( query->visibleDistance );
-   area.setCenter( query->pos );
+   // Scope from the container query shared by all cameras in the cell.  The group
+   // covers a larger area so filter by our own query area first; this gives the
+   // same set of objects as a direct container query.
 
-   getContainer()->findObjects( area, 0xFFFFFFFF, _scopeCallback, &info );
+   ScopingGroup* group = _getScopingGroup( query );
+   for( S32 i = 0; i < group->objects.size(); ++ i )
+   {
+      SceneObject* object = group->objects[ i ];
+      if( object->getWorldBox().isOverlapped( info.scopeArea ) || object->isGlobalBounds() )
+         _scopeCallback( object, &info );
+   }
 }
 
 //-----------------------------------------------------------------------------
@@ -585,6 +686,7 @@ bool SceneManager::addObjectToScene( SceneObject* object )
    // Mark the object as belonging to us.
 
    object->mSceneManager = this;
+   _invalidateScopingCache();
 
    // Register with managers except its the root zone.
 
@@ -612,6 +714,8 @@ void SceneManager::removeObjectFromScene( SceneObject* obj )
    AssertFatal( obj, "SceneManager::removeObjectFromScene - Object is not declared" );
    AssertFatal( obj->getSceneManager() == this, "SceneManager::removeObjectFromScene - Object not part of SceneManager" );
 
+   _invalidateScopingCache();
+
    // Notify the object.
 
    obj->onSceneRemove();
@@ -635,6 +739,8 @@ void SceneManager::removeObjectFromScene( SceneObject* obj )
 
 void SceneManager::notifyObjectDirty( SceneObject* object )
 {
+   _invalidateScopingCache();
+
    // Update container state.
 
    if( object->mContainer )
@@ -121,6 +121,16 @@ class SceneManager
       /// If true, render the AABBs of objects for debugging.
       static bool smRenderBoundingBoxes;
 
+      /// If true, connections with cameras in the same cell share a single
+      /// container query per tick when scoping.
+      static bool smUseScopingCache;
+
+      /// Side length of the camera cells used to group scoping queries.
+      static F32 smScopingCellSize;
+
+      /// Number of container queries the scoping cache saved during the current tick.
+      static S32 smScopingQueriesSaved;
+
       //A cache list of objects that made it through culling, so we don't have to attempt to re-test
       //visibility of objects later.
       Vector< SceneObject* > mRenderedObjectsList;
@@ -203,6 +213,45 @@ class SceneManager
 
       /// @}
 
+      /// @name Networking
+      /// @{
+
+      /// Result of a scoping container query that is shared by all connections
+      /// whose cameras are in the same cell and have the same visible distance.
+      struct ScopingGroup
+      {
+         /// Camera cell the group was built for.
+         Point3I cell;
+
+         /// Visible distance the group was built for.
+         F32 visibleDistance;
+
+         /// Everything the container query returned for the cell's scoping area.
+         Vector< SceneObject* > objects;
+      };
+
+      /// Scoping groups of the current tick.  Entries past #mNumScopingGroups
+      /// are kept around for reuse.
+      Vector< ScopingGroup* > mScopingGroups;
+
+      /// Number of valid entries in #mScopingGroups.
+      U32 mNumScopingGroups;
+
+      /// Sim time at which the current scoping groups were built.
+      SimTime mScopingTime;
+
+      /// Drop all cached scoping results.
+      void _invalidateScopingCache() { mNumScopingGroups = 0; }
+
+      /// Return the scoping group for the given camera query, running the container
+      /// query for it if no other connection has done so yet this tick.
+      ScopingGroup* _getScopingGroup( const CameraScopeQuery* query );
+
+      /// Callback for the scoping group container query.
+      static void _scopingGroupCallback( SceneObject* object, void* key );
+
+      /// @}
+
    public:
 
       SceneManager( bool isClient );
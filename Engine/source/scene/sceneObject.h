@@ -122,6 +122,7 @@ class SceneObject : public NetObject, public ProcessObject
 
       friend class SceneManager;
       friend class SceneContainer;
+      friend class SceneContainerQuadtree;
       friend class SceneZoneSpaceManager;
       friend class SceneCullingState; // _getZoneRefHead
       friend class SceneObjectLink; // mSceneObjectLinks
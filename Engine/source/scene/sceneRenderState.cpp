@@ -25,6 +25,7 @@
 
 #include "renderInstance/renderPassManager.h"
 #include "math/util/matrixSet.h"
+#include "ts/tsShapeInstance.h"
 
 //-----------------------------------------------------------------------------
 
@@ -101,6 +102,11 @@ void SceneRenderState::renderObjects( SceneObject** objects, U32 numObjects )
 {
    // Let the objects batch their stuff.
 
+   // Software skinned shapes are queued up during the batching
+   // and skinned together before the pass renders.
+
+   TSShapeInstance::beginSkinningBatch();
+
    PROFILE_START( SceneRenderState_prepRenderImages );
    for( U32 i = 0; i < numObjects; ++ i )
    {
@@ -110,6 +116,8 @@ void SceneRenderState::renderObjects( SceneObject** objects, U32 numObjects )
 
    PROFILE_END();
 
+   TSShapeInstance::endSkinningBatch();
+
    // Render what the objects have batched.
 
    getRenderPass()->renderPass( this );
@@ -30,6 +30,8 @@
 #include "gfx/gfxDevice.h"
 #include "core/memVolume.h"
 #include "core/module.h"
+#include "console/engineAPI.h"
+#include "app/version.h"
 
 #ifdef TORQUE_D3D11
 #include "shaderGen/HLSL/customFeatureHLSL.h"
@@ -56,10 +58,17 @@ MODULE_BEGIN( ShaderGen )
 MODULE_END;
 
 String ShaderGen::smCommonShaderPath("shaders/common");
+const String ShaderGen::smIndexFileName("shaderIndex.bin");
+
+/// Bump when the layout of the index file changes.
+static const U32 sIndexFileVersion = 1;
 
 ShaderGen::ShaderGen()
 {
    mInit = false;
+   mUseIndex = false;
+   mIndexPath = "shadergen:/" + smIndexFileName;
+   mFeatureSignature = 0;
    GFXDevice::getDeviceEventSignal().notify(this, &ShaderGen::_handleGFXEvent);
    mOutput = NULL;
 }
@@ -133,6 +142,212 @@ void ShaderGen::initShaderGen()
 
    // Delete the auto-generated conditioner include file.
    Torque::FS::Remove( "shadergen:/" + ConditionerFeature::ConditionerIncludeFileName );
+
+   // The index is only worth keeping when the generated
+   // files are still around next run.
+   mUseIndex = mMemFS.isNull() && Con::getBoolVariable( "$ShaderGen::useIndex", true );
+   if ( mUseIndex )
+      _loadIndex();
+}
+
+U64 ShaderGen::_getFeatureSignature()
+{
+   if ( mFeatureSignature )
+      return mFeatureSignature;
+
+   String features;
+   for ( U32 i = 0; i < FEATUREMGR->getFeatureCount(); i++ )
+   {
+      const FeatureInfo &info = FEATUREMGR->getAt( i );
+      features += info.type->getName() + ":" + info.feature->getName() + ";";
+   }
+
+   mFeatureSignature = Torque::hash64( (const U8*)features.c_str(), features.length(), 0 );
+   return mFeatureSignature;
+}
+
+void ShaderGen::_loadIndex()
+{
+   PROFILE_SCOPE( ShaderGen_LoadIndex );
+
+   mIndex.clear();
+
+   FileStream stream;
+   if ( Torque::FS::IsFile( mIndexPath ) && stream.open( mIndexPath, Torque::FS::File::Read ) )
+   {
+      U32 version = 0, adapterType = 0, engineVersion = 0;
+      String compileTime, fileEnding;
+      stream.read( &version );
+      stream.read( &adapterType );
+      stream.read( &engineVersion );
+      stream.read( &compileTime );
+      stream.read( &fileEnding );
+
+      // The generated files may be stale if the engine has changed.
+      if (  stream.getStatus() == Stream::Ok &&
+            version == sIndexFileVersion &&
+            adapterType == GFX->getAdapterType() &&
+            engineVersion == getVersionNumber() &&
+            compileTime.equal( getCompileTimeString() ) &&
+            fileEnding.equal( mFileEnding ) )
+      {
+         U32 numRecords = 0;
+
+         while ( stream.getPosition() < stream.getStreamSize() )
+         {
+            String cacheKey;
+            IndexEntry entry;
+            U32 count;
+
+            stream.read( &cacheKey );
+            stream.read( &entry.featureSignature );
+            stream.read( &entry.pixVersion );
+
+            stream.read( &count );
+            for ( U32 i = 0; i < count && stream.getStatus() == Stream::Ok; i++ )
+            {
+               entry.macros.increment();
+               stream.read( &entry.macros.last().name );
+               stream.read( &entry.macros.last().value );
+            }
+
+            stream.read( &count );
+            for ( U32 i = 0; i < count && stream.getStatus() == Stream::Ok; i++ )
+            {
+               entry.samplers.increment();
+               stream.read( &entry.samplers.last() );
+            }
+
+            stream.read( &count );
+            for ( U32 i = 0; i < count && stream.getStatus() == Stream::Ok; i++ )
+            {
+               entry.instancing.increment();
+               IndexElement &element = entry.instancing.last();
+               stream.read( &element.semantic );
+               stream.read( &element.type );
+               stream.read( &element.index );
+               stream.read( &element.stream );
+            }
+
+            // A partly written entry at the end is dropped.
+            if ( stream.getStatus() != Stream::Ok )
+               break;
+
+            mIndex[cacheKey] = entry;
+            numRecords++;
+         }
+
+         stream.close();
+
+         Con::printf( "ShaderGen: Loaded %d entries from the shader index", mIndex.size() );
+
+         // Shaders regenerated after their files were lost are appended
+         // again, so drop the old records once they outnumber the live ones.
+         if ( numRecords - mIndex.size() > mIndex.size() && !_saveIndex() )
+            mUseIndex = false;
+
+         return;
+      }
+
+      stream.close();
+   }
+
+   // Otherwise start a new one.
+   if ( !_saveIndex() )
+      mUseIndex = false;
+}
+
+bool ShaderGen::_saveIndex()
+{
+   FileStream stream;
+   if ( !stream.open( mIndexPath, Torque::FS::File::Write ) )
+   {
+      Con::warnf( "ShaderGen: Unable to write the shader index %s", mIndexPath.c_str() );
+      return false;
+   }
+
+   _writeIndexHeader( stream );
+
+   for ( ShaderIndex::Iterator iter = mIndex.begin(); iter != mIndex.end(); ++iter )
+      _writeIndexEntry( stream, iter->key, iter->value );
+
+   return true;
+}
+
+void ShaderGen::_appendToIndex( const String &cacheKey, const IndexEntry &entry )
+{
+   FileStream stream;
+   if ( !stream.open( mIndexPath, Torque::FS::File::WriteAppend ) )
+      return;
+
+   _writeIndexEntry( stream, cacheKey, entry );
+}
+
+void ShaderGen::_writeIndexHeader( Stream &stream )
+{
+   stream.write( sIndexFileVersion );
+   stream.write( (U32)GFX->getAdapterType() );
+   stream.write( getVersionNumber() );
+   stream.write( String( getCompileTimeString() ) );
+   stream.write( mFileEnding );
+}
+
+void ShaderGen::_writeIndexEntry( Stream &stream, const String &cacheKey, const IndexEntry &entry )
+{
+   stream.write( cacheKey );
+   stream.write( entry.featureSignature );
+   stream.write( entry.pixVersion );
+
+   stream.write( (U32)entry.macros.size() );
+   for ( U32 i = 0; i < entry.macros.size(); i++ )
+   {
+      stream.write( entry.macros[i].name );
+      stream.write( entry.macros[i].value );
+   }
+
+   stream.write( (U32)entry.samplers.size() );
+   for ( U32 i = 0; i < entry.samplers.size(); i++ )
+      stream.write( entry.samplers[i] );
+
+   stream.write( (U32)entry.instancing.size() );
+   for ( U32 i = 0; i < entry.instancing.size(); i++ )
+   {
+      const IndexElement &element = entry.instancing[i];
+      stream.write( element.semantic );
+      stream.write( element.type );
+      stream.write( element.index );
+      stream.write( element.stream );
+   }
+}
+
+GFXShader* ShaderGen::_createFromIndex( const String &cacheKey, const IndexEntry &entry, const Vector<String> &samplers )
+{
+   if ( entry.pixVersion != GFX->getPixelShaderVersion() )
+      return NULL;
+
+   const String vertFile = String::ToString( "shadergen:/%s_V.%s", cacheKey.c_str(), mFileEnding.c_str() );
+   const String pixFile = String::ToString( "shadergen:/%s_P.%s", cacheKey.c_str(), mFileEnding.c_str() );
+   if ( !Torque::FS::IsFile( vertFile ) || !Torque::FS::IsFile( pixFile ) )
+      return NULL;
+
+   GFXVertexFormat instancingFormat;
+   for ( U32 i = 0; i < entry.instancing.size(); i++ )
+   {
+      const IndexElement &element = entry.instancing[i];
+      instancingFormat.addElement( element.semantic, (GFXDeclType)element.type, element.index, element.stream );
+   }
+
+   GFXShader *shader = GFX->createShader();
+   if ( !shader )
+      return NULL;
+
+   if ( !shader->init( vertFile, pixFile, entry.pixVersion, entry.macros, samplers, &instancingFormat ) )
+   {
+      delete shader;
+      return NULL;
+   }
+
+   return shader;
 }
 
 void ShaderGen::generateShader( const MaterialFeatureData &featureData,
@@ -471,7 +686,7 @@ GFXShader* ShaderGen::getShader( const MaterialFeatureData &featureData, const G
    // Don't get paranoid!  This has 1 in 18446744073709551616
    // chance for collision... it won't happen in this lifetime.
    //
-   U64 hash = Torque::hash64( (const U8*)shaderDescription.c_str(), shaderDescription.length(), 0 );
+   U64 hash = Torque::hash64( (const U8*)shaderDescription.c_str(), shaderDescription.length(), _getFeatureSignature() );
    hash = convertHostToLEndian(hash);
    U32 high = (U32)( hash >> 32 );
    U32 low = (U32)( hash & 0x00000000FFFFFFFF );
@@ -481,6 +696,20 @@ GFXShader* ShaderGen::getShader( const MaterialFeatureData &featureData, const G
    if ( match )
       return match;
 
+   // If an earlier run generated it, skip straight to creating it.
+   ShaderIndex::Iterator indexIter = mIndex.find( cacheKey );
+   if ( indexIter != mIndex.end() )
+   {
+      GFXShader *shader = _createFromIndex( cacheKey, indexIter->value, samplers );
+      if ( shader )
+      {
+         mProcShaders[cacheKey] = shader;
+         return shader;
+      }
+
+      mIndex.erase( indexIter );
+   }
+
    // if not, then create it
    char vertFile[256];
    char pixFile[256];
@@ -501,6 +730,29 @@ GFXShader* ShaderGen::getShader( const MaterialFeatureData &featureData, const G
 
    mProcShaders[cacheKey] = shader;
 
+   if ( mUseIndex && Con::getBoolVariable( "ShaderGen::GenNewShaders", true ) )
+   {
+      IndexEntry &entry = mIndex[cacheKey];
+      entry.featureSignature = _getFeatureSignature();
+      entry.pixVersion = pixVersion;
+      entry.macros = shaderMacros;
+      entry.samplers = samplers;
+      entry.instancing.clear();
+
+      for ( U32 i = 0; i < mInstancingFormat.getElementCount(); i++ )
+      {
+         const GFXVertexElement &element = mInstancingFormat.getElement( i );
+         entry.instancing.increment();
+         IndexElement &indexElement = entry.instancing.last();
+         indexElement.semantic = element.getSemantic();
+         indexElement.type = element.getType();
+         indexElement.index = element.getSemanticIndex();
+         indexElement.stream = element.getStreamIndex();
+      }
+
+      _appendToIndex( cacheKey, entry );
+   }
+
    return shader;
 }
 
@@ -509,4 +761,43 @@ void ShaderGen::flushProceduralShaders()
    // The shaders are reference counted, so we
    // just need to clear the map.
    mProcShaders.clear();  
+
+   // This is also called when the registered features change.
+   mFeatureSignature = 0;
+}
+
+U32 ShaderGen::prewarmShaders()
+{
+   PROFILE_SCOPE( ShaderGen_PrewarmShaders );
+
+   const U64 featureSignature = _getFeatureSignature();
+   U32 numCreated = 0;
+
+   for ( ShaderIndex::Iterator iter = mIndex.begin(); iter != mIndex.end(); ++iter )
+   {
+      // Skip the ones generated with other features, like
+      // those of a different lighting system.
+      const IndexEntry &entry = iter->value;
+      if ( entry.featureSignature != featureSignature || mProcShaders.contains( iter->key ) )
+         continue;
+
+      GFXShader *shader = _createFromIndex( iter->key, entry, entry.samplers );
+      if ( shader )
+      {
+         mProcShaders[iter->key] = shader;
+         numCreated++;
+      }
+   }
+
+   return numCreated;
+}
+
+DefineEngineFunction( prewarmProceduralShaders, S32, (),,
+   "@brief Creates the procedural shaders listed in the shader index that haven't been used yet.\n\n"
+   "The shader index lists the shaders generated into the shader cache in earlier runs, so calling "
+   "this while loading avoids creating them when they are first rendered.\n\n"
+   "@return The number of shaders created.\n\n"
+   "@ingroup Materials")
+{
+   return SHADERGEN->prewarmShaders();
 }
@@ -160,12 +160,20 @@ public:
    // the ShaderFeatures have changed (due to lighting system change, or new plugin)
    virtual void flushProceduralShaders();
 
+   /// Creates the shaders listed in the shader index that haven't been asked
+   /// for yet, so that they don't have to be created when first rendered.
+   /// Returns the number of shaders created.
+   U32 prewarmShaders();
+
    void setPrinter(ShaderGenPrinter* printer) { mPrinter = printer; }
    void setComponentFactory(ShaderGenComponentFactory* factory) { mComponentFactory = factory; }
    void setFileEnding(String ending) { mFileEnding = ending; }
 
    static String smCommonShaderPath;
 
+   /// Name of the shader index file in the shader cache.
+   static const String smIndexFileName;
+
 protected:   
 
    friend class ManagedSingleton<ShaderGen>;
@@ -196,6 +204,42 @@ protected:
    typedef Map<String, GFXShaderRef> ShaderMap;
    ShaderMap mProcShaders;
 
+   /// An instancing format element as stored in the shader index.
+   struct IndexElement
+   {
+      String semantic;
+      U32 type;
+      U32 index;
+      U32 stream;
+   };
+
+   /// What is needed to create a shader again from the files generated
+   /// for it in an earlier run, without processing its features.
+   struct IndexEntry
+   {
+      U64 featureSignature;
+      F32 pixVersion;
+      Vector<GFXShaderMacro> macros;
+      Vector<String> samplers;
+      Vector<IndexElement> instancing;
+   };
+
+   /// Map of cache string -> index entry.  When the shader cache is on
+   /// disk this is loaded at init and new entries are appended to the
+   /// index file as shaders get generated.
+   typedef Map<String, IndexEntry> ShaderIndex;
+   ShaderIndex mIndex;
+
+   /// Set from $ShaderGen::useIndex at init.
+   bool mUseIndex;
+
+   /// Where the index file lives, in the shader cache.
+   String mIndexPath;
+
+   /// Hash of the registered features, used to seed the cache keys so
+   /// that shaders generated with different features never share files.
+   U64 mFeatureSignature;
+
    ShaderGen();
 
    bool _handleGFXEvent(GFXDevice::GFXDeviceEventType event);
@@ -206,6 +250,27 @@ protected:
    void _init();
    void _uninit();
 
+   /// Returns the hash of the registered features.
+   U64 _getFeatureSignature();
+
+   /// Reads the index file, or starts a new one if it's missing or
+   /// was written by a different device or engine version.  The file is
+   /// rewritten if most of it is entries replaced by later ones.
+   void _loadIndex();
+
+   /// Rewrites the index file with just the entries in mIndex.
+   bool _saveIndex();
+
+   /// Adds the entry to the index file.
+   void _appendToIndex( const String &cacheKey, const IndexEntry &entry );
+
+   void _writeIndexHeader( Stream &stream );
+   void _writeIndexEntry( Stream &stream, const String &cacheKey, const IndexEntry &entry );
+
+   /// Creates a shader from its generated files.  Returns NULL if the
+   /// files are gone or the shader doesn't compile.
+   virtual GFXShader* _createFromIndex( const String &cacheKey, const IndexEntry &entry, const Vector<String> &samplers );
+
    /// Creates all the various shader components that will be filled in when 
    /// the shader features are processed.
    void _createComponents();
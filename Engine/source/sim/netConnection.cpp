@@ -298,6 +298,21 @@ void NetConnection::consoleInit()
       "@brief The total number of ghosts added, removed, and/or updated on the client "
       "during the last packet process operation.\n\n"
 
+      "@ingroup Networking");
+
+   Con::addVariable("$pref::Net::ParallelGhostUpdates", TypeBool, &smParallelGhostUpdates,
+      "@brief If true, the server prioritizes and sorts ghost updates for all clients in parallel.\n\n"
+
+      "Scope queries and packet writing still happen on the main thread; only the per-client "
+      "priority and sort pass is handed to the global job system.  The default value is false.\n\n"
+
+      "@ingroup Networking");
+
+   Con::addVariable("$pref::Net::ParallelGhostMinClients", TypeS32, &smParallelGhostMinConnections,
+      "@brief Minimum number of clients due for a packet before ghost updates are prepared in parallel.\n\n"
+
+      "Below this count the job system overhead outweighs the gain.  The default value is 8.\n\n"
+
       "@ingroup Networking");
 }
 
@@ -418,6 +433,8 @@ NetConnection::NetConnection()
    mGhostRefs = NULL;
    mGhostLookupTable = NULL;
    mLocalGhosts = NULL;
+   mGhostMaxUpdateIndex = 0;
+   mGhostUpdatesPrepared = false;
 
    mGhostsActive = 0;
 
@@ -796,6 +813,17 @@ public:
    }
 };
 
+bool NetConnection::isPacketSendDue()
+{
+   U32 curTime = Platform::getVirtualMilliseconds();
+   U32 delay = isConnectionToServer() ? gPacketUpdateDelayToServer : mCurRate.updateDelay;
+
+   if(curTime < mLastUpdateTime + delay - mSendDelayCredit)
+      return false;
+
+   return !windowFull();
+}
+
 void NetConnection::checkPacketSend(bool force)
 {
    U32 curTime = Platform::getVirtualMilliseconds();
@@ -822,6 +822,35 @@ protected:
    void ghostReadPacket(BitStream *bstream);
    void freeGhostInfo(GhostInfo *);
 
+   /// Camera information gathered by the last scope query.
+   CameraScopeQuery mGhostCamInfo;
+
+   /// Highest ghost index with a pending update; computed by ghostPrioritizeUpdates().
+   S32 mGhostMaxUpdateIndex;
+
+   /// Set when the scope, priority and sort phases of the next ghostWritePacket()
+   /// have already been run by prepareGhostUpdates().
+   bool mGhostUpdatesPrepared;
+
+   /// Scope query phase of ghostWritePacket().
+   ///
+   /// Runs the scope object's camera query, detaches ghosts that left scope and
+   /// frees killed ghosts that were never sent.  This touches the scene container
+   /// and the per-object ghost reference lists, so it must run on the main thread.
+   void ghostScopeQuery();
+
+   /// Priority and sort phase of ghostWritePacket().
+   ///
+   /// Only reads shared object state and only writes to this connection's ghost
+   /// array, so it may run on a worker thread concurrently with other connections.
+   void ghostPrioritizeUpdates();
+
+   /// Returns true if checkPacketSend(false) would build a packet right now.
+   bool isPacketSendDue();
+
+   /// JobSystem entry point for ghostPrioritizeUpdates(); data is the connection.
+   static void ghostPrioritizeJob(void *data);
+
    void ghostWriteStartBlock(ResizeBitStream *stream);
    void ghostReadStartBlock(BitStream *stream);
 
@@ -946,6 +975,21 @@ public:
    /// before performing an operation.
    static Signal<void()> smGhostAlwaysDone;
 
+   /// If true, the server runs the ghost priority and sort phase of all connections
+   /// that are about to send a packet as jobs on the global job system.
+   static bool smParallelGhostUpdates;
+
+   /// Minimum number of sending connections before ghost updates are prepared in parallel.
+   static S32 smParallelGhostMinConnections;
+
+   /// Run the scope, priority and sort phases of ghostWritePacket() for every
+   /// server-side connection that is due to send a packet this tick.
+   ///
+   /// Scoping is done on the main thread; prioritizing and sorting is spread
+   /// across the global job system, if there is one.  Called by
+   /// NetInterface::processServer().
+   static void prepareGhostUpdates();
+
    /// @}
 public:
 //----------------------------------------------------------------
@@ -30,10 +30,14 @@
 #include "console/console.h"
 #include "console/consoleTypes.h"
 #include "console/engineAPI.h"
+#include "platform/threads/jobSystem.h"
+#include "platform/profiler.h"
 
 #define DebugChecksum 0xF00DBAAD
 
 Signal<void()>    NetConnection::smGhostAlwaysDone;
+bool              NetConnection::smParallelGhostUpdates = false;
+S32               NetConnection::smParallelGhostMinConnections = 8;
 
 extern U32 gGhostUpdates;
 
@@ -319,45 +323,26 @@ static S32 QSORT_CALLBACK UQECompare(const void *a,const void *b)
    return (ret < 0) ? -1 : ((ret > 0) ? 1 : 0);
 }
 
-void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
+void NetConnection::ghostPrioritizeJob(void *data)
 {
-#ifdef    TORQUE_DEBUG_NET
-   bstream->writeInt(DebugChecksum, 32);
-#endif
-
-   notify->ghostList = NULL;
-
-   if(!isGhostingFrom())
-      return;
-
-   if(!bstream->writeFlag(mGhosting))
-      return;
-
-   // fill a packet (or two) with ghosting data
-
-   // first step is to check all our polled ghosts:
-
-   // 1. Scope query - find if any new objects have come into
-   //    scope and if any have gone out.
-   // 2. call scoped objects' priority functions if the flag set is nonzero
-   //    A removed ghost is assumed to have a high priority
-   // 3. call updates based on sorted priority until the packet is
-   //    full.  set flags to zero for all updated objects
+   ((NetConnection *) data)->ghostPrioritizeUpdates();
+}
 
-   CameraScopeQuery camInfo;
+void NetConnection::ghostScopeQuery()
+{
+   PROFILE_SCOPE(NetConnection_ghostScopeQuery);
 
-   camInfo.camera = NULL;
-   camInfo.pos.set(0,0,0);
-   camInfo.orientation.set(0,1,0);
-   camInfo.visibleDistance = 1;
-   camInfo.fov = (F32)(3.1415f / 4.0f);
-   camInfo.sinFov = 0.7071f;
-   camInfo.cosFov = 0.7071f;
+   mGhostCamInfo.camera = NULL;
+   mGhostCamInfo.pos.set(0,0,0);
+   mGhostCamInfo.orientation.set(0,1,0);
+   mGhostCamInfo.visibleDistance = 1;
+   mGhostCamInfo.fov = (F32)(3.1415f / 4.0f);
+   mGhostCamInfo.sinFov = 0.7071f;
+   mGhostCamInfo.cosFov = 0.7071f;
 
    GhostInfo *walk;
 
    // only need to worry about the ghosts that have update masks set...
-   S32 maxIndex = 0;
    S32 i;
    for(i = 0; i < mGhostZeroUpdateIndex; i++)
    {
@@ -369,7 +354,7 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
    }
 
    if( mScopeObject )
-      mScopeObject->onCameraScopeQuery( this, &camInfo );
+      mScopeObject->onCameraScopeQuery( this, &mGhostCamInfo );
    doneScopingScene();
 
    for(i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
@@ -384,37 +369,131 @@ void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
          detachObject(mGhostArray[i]);
    }
 
+   // clear out any kill objects that haven't been ghosted yet
+   for(i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
+   {
+      walk = mGhostArray[i];
+      if((walk->flags & GhostInfo::KillGhost) && (walk->flags & GhostInfo::NotYetGhosted))
+         freeGhostInfo(walk);
+   }
+}
+
+void NetConnection::ghostPrioritizeUpdates()
+{
+   PROFILE_SCOPE(NetConnection_ghostPrioritizeUpdates);
+
+   GhostInfo *walk;
+   S32 maxIndex = 0;
+   S32 i;
    for(i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
    {
       walk = mGhostArray[i];
       if(walk->index > maxIndex)
          maxIndex = walk->index;
 
-      // clear out any kill objects that haven't been ghosted yet
-      if((walk->flags & GhostInfo::KillGhost) && (walk->flags & GhostInfo::NotYetGhosted))
-      {
-         freeGhostInfo(walk);
-         continue;
-      }
       // don't do any ghost processing on objects that are being killed
       // or in the process of ghosting
-      else if(!(walk->flags & (GhostInfo::KillingGhost | GhostInfo::Ghosting)))
+      if(!(walk->flags & (GhostInfo::KillingGhost | GhostInfo::Ghosting)))
       {
          if(walk->flags & GhostInfo::KillGhost)
             walk->priority = 10000;
          else
-            walk->priority = walk->obj->getUpdatePriority(&camInfo, walk->updateMask, walk->updateSkipCount);
+            walk->priority = walk->obj->getUpdatePriority(&mGhostCamInfo, walk->updateMask, walk->updateSkipCount);
       }
       else
          walk->priority = 0;
    }
-   GhostRef *updateList = NULL;
    dQsort(mGhostArray, mGhostZeroUpdateIndex, sizeof(GhostInfo *), UQECompare);
 
    // reset the array indices...
    for(i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
       mGhostArray[i]->arrayIndex = i;
 
+   mGhostMaxUpdateIndex = maxIndex;
+}
+
+void NetConnection::prepareGhostUpdates()
+{
+   // Drop anything prepared for a packet that was never written so that
+   // it can't be picked up later, e.g. after the pref was turned off.
+   for(NetConnection *walk = getConnectionList(); walk; walk = walk->getNext())
+      walk->mGhostUpdatesPrepared = false;
+
+   if(!smParallelGhostUpdates || !JobSystem::isGlobalRunning())
+      return;
+
+   Vector<NetConnection *> sending(__FILE__, __LINE__);
+   for(NetConnection *walk = getConnectionList(); walk; walk = walk->getNext())
+   {
+      if(walk->isConnectionToServer() || !(walk->isLocalConnection() || walk->isNetworkConnection()))
+         continue;
+      if(!walk->isGhostingFrom() || !walk->mGhosting)
+         continue;
+      if(walk->isPacketSendDue())
+         sending.push_back(walk);
+   }
+
+   if(S32(sending.size()) < smParallelGhostMinConnections)
+      return;
+
+   PROFILE_SCOPE(NetConnection_prepareGhostUpdates);
+
+   // Scoping links ghosts into the objects' reference lists and searches the
+   // scene container, so it stays on the main thread.
+   for(U32 i = 0; i < sending.size(); i++)
+      sending[i]->ghostScopeQuery();
+
+   JobSystem& jobs = JobSystem::GLOBAL();
+   JobSystem::JobRef group = jobs.createJob();
+   for(U32 i = 0; i < sending.size(); i++)
+      jobs.run(jobs.createJob(&ghostPrioritizeJob, sending[i], group));
+   jobs.run(group);
+   jobs.waitForJob(group);
+
+   for(U32 i = 0; i < sending.size(); i++)
+      sending[i]->mGhostUpdatesPrepared = true;
+}
+
+void NetConnection::ghostWritePacket(BitStream *bstream, PacketNotify *notify)
+{
+#ifdef    TORQUE_DEBUG_NET
+   bstream->writeInt(DebugChecksum, 32);
+#endif
+
+   notify->ghostList = NULL;
+
+   if(!isGhostingFrom())
+      return;
+
+   if(!bstream->writeFlag(mGhosting))
+      return;
+
+   // fill a packet (or two) with ghosting data
+
+   // first step is to check all our polled ghosts:
+
+   // 1. Scope query - find if any new objects have come into
+   //    scope and if any have gone out.
+   // 2. call scoped objects' priority functions if the flag set is nonzero
+   //    A removed ghost is assumed to have a high priority
+   // 3. call updates based on sorted priority until the packet is
+   //    full.  set flags to zero for all updated objects
+   //
+   // Steps 1 and 2 may already have been run for this packet by
+   // prepareGhostUpdates().
+
+   if(!mGhostUpdatesPrepared)
+   {
+      ghostScopeQuery();
+      ghostPrioritizeUpdates();
+   }
+   mGhostUpdatesPrepared = false;
+
+   GhostInfo *walk;
+   S32 maxIndex = mGhostMaxUpdateIndex;
+   S32 i;
+   GhostRef *updateList = NULL;
+
    S32 sendSize = 1;
    while(maxIndex >>= 1)
       sendSize++;
@@ -435,6 +435,7 @@ void NetInterface::processClient()
 void NetInterface::processServer()
 {
    NetObject::collapseDirtyList(); // collapse all the mask bits...
+   NetConnection::prepareGhostUpdates();
    for(NetConnection *walk = NetConnection::getConnectionList();
       walk; walk = walk->getNext())
    {
@@ -524,8 +524,11 @@ void TerrainDetailMapFeatGLSL::processPix(   Vector<ShaderComponent*> &component
       layerTex->constNum = Var::getTexUnitNum();
 
       // Read the layer texture to get the samples.
-      meta->addStatement( new GenOp( "   @ = round( tex2D( @, @.xy ) * 255.0f );\r\n", 
-                                       new DecOp( layerSample ), layerTex, inTexCoord ) );
+      // The layers of streamed terrains are kept in a window which
+      // wraps over the terrain, so the coords are rescaled to it.
+      Var *layerTexScale = _getUniformVar( "layerTexScale", "float", cspPass );
+      meta->addStatement( new GenOp( "   @ = round( tex2D( @, @.xy * @ ) * 255.0f );\r\n", 
+                                       new DecOp( layerSample ), layerTex, inTexCoord, layerTexScale ) );
    }
 
    Var *layerSize = (Var*)LangElement::find( "layerSize" );
@@ -777,8 +780,11 @@ void TerrainMacroMapFeatGLSL::processPix(   Vector<ShaderComponent*> &componentL
       layerTex->constNum = Var::getTexUnitNum();
 
       // Read the layer texture to get the samples.
-      meta->addStatement( new GenOp( "   @ = round( tex2D( @, @.xy ) * 255.0f );\r\n", 
-                                       new DecOp( layerSample ), layerTex, inTex ) );
+      // The layers of streamed terrains are kept in a window which
+      // wraps over the terrain, so the coords are rescaled to it.
+      Var *layerTexScale = _getUniformVar( "layerTexScale", "float", cspPass );
+      meta->addStatement( new GenOp( "   @ = round( tex2D( @, @.xy * @ ) * 255.0f );\r\n", 
+                                       new DecOp( layerSample ), layerTex, inTex, layerTexScale ) );
    }
 
    Var *layerSize = (Var*)LangElement::find( "layerSize" );
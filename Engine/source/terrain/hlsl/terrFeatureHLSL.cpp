@@ -603,8 +603,11 @@ void TerrainDetailMapFeatHLSL::processPix(   Vector<ShaderComponent*> &component
       layerTexObj->texture = true;
       layerTexObj->constNum = layerTex->constNum;
       // Read the layer texture to get the samples.
-      meta->addStatement(new GenOp("   @ = round( @.Sample( @, @.xy ) * 255.0f );\r\n",
-         new DecOp(layerSample), layerTexObj, layerTex, inTexCoord));
+      // The layers of streamed terrains are kept in a window which
+      // wraps over the terrain, so the coords are rescaled to it.
+      Var *layerTexScale = _getUniformVar( "layerTexScale", "float", cspPass );
+      meta->addStatement(new GenOp("   @ = round( @.Sample( @, @.xy * @ ) * 255.0f );\r\n",
+         new DecOp(layerSample), layerTexObj, layerTex, inTexCoord, layerTexScale));
    }
 
    Var *layerSize = (Var*)LangElement::find( "layerSize" );
@@ -864,8 +867,11 @@ void TerrainMacroMapFeatHLSL::processPix(   Vector<ShaderComponent*> &componentL
       layerTexObj->uniform = true;
       layerTexObj->texture = true;
       layerTexObj->constNum = layerTex->constNum;
-      meta->addStatement(new GenOp("   @ = round( @.Sample( @, @.xy ) * 255.0f );\r\n",
-         new DecOp(layerSample), layerTexObj, layerTex, inTex));
+      // The layers of streamed terrains are kept in a window which
+      // wraps over the terrain, so the coords are rescaled to it.
+      Var *layerTexScale = _getUniformVar( "layerTexScale", "float", cspPass );
+      meta->addStatement(new GenOp("   @ = round( @.Sample( @, @.xy * @ ) * 255.0f );\r\n",
+         new DecOp(layerSample), layerTexObj, layerTex, inTex, layerTexScale));
    }
 
    Var *layerSize = (Var*)LangElement::find( "layerSize" );
@@ -305,8 +305,20 @@ void TerrCell::_init( TerrainBlock *terrain,
    mSize = size;
    mLevel = level;
 
-   // Generate a VB (and maybe a PB) for this cell, unless we are the Root cell.
-   if ( level > 0 )
+   const TerrainFile *file = mTerrain->getFile();
+
+   // Cells of streamed terrains without any loaded
+   // pages are filled in later by updatePages().
+   if ( !file->isAnyResident( RectI( mPoint, Point2I( mSize, mSize ) ) ) )
+   {
+      _updatePagedBounds();
+      return;
+   }
+
+   // Generate a VB (and maybe a PB) for this cell, unless we are the Root cell
+   // or some of the samples or layers it needs are not loaded.
+   const RectI vertRect = _getVertexRect();
+   if ( level > 0 && file->isResident( vertRect ) && mTerrain->isLayerResident( vertRect ) )
    {
       _updateVertexBuffer();
       _updatePrimitiveBuffer();
@@ -428,6 +440,91 @@ void TerrCell::updateGrid( const RectI &gridRect, bool opacityOnly )
       mMaterial->init( mTerrain, mMaterials );
 }
 
+void TerrCell::updatePages( const RectI &gridRect )
+{
+   PROFILE_SCOPE( TerrCell_UpdatePages );
+
+   const TerrainFile *file = mTerrain->getFile();
+
+   if ( !file->isAnyResident( RectI( mPoint, Point2I( mSize, mSize ) ) ) )
+   {
+      _releaseGeometry();
+      _updatePagedBounds();
+      return;
+   }
+
+   // Create or drop the VB as the samples it needs come and go.
+   const RectI vertRect = _getVertexRect();
+   const bool needsVB = mLevel > 0 && file->isResident( vertRect ) && mTerrain->isLayerResident( vertRect );
+   if ( needsVB && !mVertexBuffer.isValid() )
+   {
+      _updateVertexBuffer();
+      _updatePrimitiveBuffer();
+   }
+   else if ( !needsVB && mVertexBuffer.isValid() )
+   {
+      mVertexBuffer = NULL;
+      mPrimBuffer = NULL;
+      mHasEmpty = false;
+      mEmptyVertexList.clear();
+      deleteZodiacVertexBuffer();
+   }
+
+   if ( mSize <= smMinCellSize )
+   {
+      _updateBounds();
+      _updateMaterials();
+      return;
+   }
+
+   const U32 childSize = mSize / 2;
+   mMaterials = 0;
+
+   for ( U32 i = 0; i < 4; i++ )
+   {
+      if ( !mChildren[i] )
+      {
+         mChildren[i] = new TerrCell;
+         mChildren[i]->_init( mTerrain,
+                              Point2I( mPoint.x + ( i & 1 ) * childSize, mPoint.y + ( i >> 1 ) * childSize ),
+                              childSize,
+                              mLevel + 1 );
+      }
+      else
+      {
+         const RectI cellRect = mChildren[i]->_getVertexRect();
+         if (  cellRect.contains( gridRect ) ||
+               cellRect.overlaps( gridRect ) )
+            mChildren[i]->updatePages( gridRect );
+      }
+
+      if ( i == 0 )
+         mBounds = mChildren[i]->getBounds();
+      else
+         mBounds.intersect( mChildren[i]->getBounds() );
+
+      mMaterials |= mChildren[i]->getMaterials();
+   }
+
+   mRadius = mBounds.len() * 0.5f;
+   _updateOBB();
+
+   if ( mMaterial )
+      mMaterial->init( mTerrain, mMaterials );
+}
+
+void TerrCell::_releaseGeometry()
+{
+   for ( U32 i = 0; i < 4; i++ )
+      SAFE_DELETE( mChildren[i] );
+
+   mVertexBuffer = NULL;
+   mPrimBuffer = NULL;
+   mHasEmpty = false;
+   mEmptyVertexList.clear();
+   deleteZodiacVertexBuffer();
+}
+
 void TerrCell::_updateVertexBuffer()
 {
    PROFILE_SCOPE( TerrCell_UpdateVertexBuffer );
@@ -910,6 +1007,28 @@ void TerrCell::_updateBounds()
    _updateOBB();
 }
 
+void TerrCell::_updatePagedBounds()
+{
+   const F32 squareSize = mTerrain->getSquareSize();
+   const TerrainFile *file = mTerrain->getFile();
+
+   // Cells without loaded pages are never smaller than a page
+   // so the grid map always has a square covering the cell.
+   const TerrainSquare *sq = file->findSquare( getBinLog2( mSize ), mPoint.x, mPoint.y );
+
+   mBounds.minExtents.set( (F32)mPoint.x * squareSize, 
+                           (F32)mPoint.y * squareSize, 
+                           fixedToFloat( sq->minHeight ) );
+   mBounds.maxExtents.set( (F32)( mPoint.x + mSize ) * squareSize, 
+                           (F32)( mPoint.y + mSize ) * squareSize, 
+                           fixedToFloat( sq->maxHeight ) );
+
+   mRadius = mBounds.len() * 0.5f;
+   mMaterials = 0;
+
+   _updateOBB();
+}
+
 void TerrCell::_updateOBB()
 {
    mOBB.set( mTerrain->getTransform(), mBounds );
@@ -967,11 +1086,13 @@ void TerrCell::cullCells(  const SceneRenderState *state,
                            const Point3F &objLodPos,
                            Vector<TerrCell*> *outCells  )
 {
-   // If we have a VB and no children then just add 
-   // ourselves to the results and return.
-   if ( mVertexBuffer.isValid() && !mChildren[0]  )               
+   // If we have no children then just add ourselves to the 
+   // results and return.  Cells of streamed terrains may not 
+   // have a VB when their pages are not loaded.
+   if ( !mChildren[0] )
    {
-      outCells->push_back( this );
+      if ( mVertexBuffer.isValid() )
+         outCells->push_back( this );
       return;
    }
 
@@ -1007,11 +1128,10 @@ void TerrCell::cullCells(  const SceneRenderState *state,
       F32 errorMeters = ( cell->mSize / smMinCellSize ) * mTerrain->getSquareSize();
       U32 errorPixels = mCeil( state->projectRadius( dist, errorMeters ) );
 
-      if ( errorPixels < screenError )
-      {
-         if ( cell->mVertexBuffer.isValid() )
-            outCells->push_back( cell );       
-      }
+      // Cells which are only partly loaded have no VB so
+      // we use their children instead.
+      if ( errorPixels < screenError && cell->mVertexBuffer.isValid() )
+         outCells->push_back( cell );       
       else      
          cell->cullCells( state, objLodPos, outCells );
    }
@@ -145,6 +145,20 @@ protected:
    ///
    void _updateBounds();
 
+   /// Sets the bounds from the terrain grid map for a
+   /// cell whose pages are not loaded.
+   void _updatePagedBounds();
+
+   /// Returns the sample rect read by the vertices
+   /// and normals of this cell.
+   RectI _getVertexRect() const
+   {
+      return RectI( mPoint.x - 1, mPoint.y - 1, mSize + 3, mSize + 3 );
+   }
+
+   /// Drops the geometry and children of the cell.
+   void _releaseGeometry();
+
    /// Update #mOBB from the current terrain transform state.
    void _updateOBB();
 
@@ -179,6 +193,12 @@ public:
 
    void updateGrid( const RectI &gridRect, bool opacityOnly = false );
 
+   /// Updates the cells of a streamed terrain after pages
+   /// under the grid rect were loaded or evicted.  Children are
+   /// only created where pages are loaded and vertex buffers
+   /// only where all the samples they read are loaded.
+   void updatePages( const RectI &gridRect );
+
    /// Update the world-space OBBs used for culling.
    void updateOBBs();
 
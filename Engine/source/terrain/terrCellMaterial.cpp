@@ -508,6 +508,7 @@ bool TerrainCellMaterial::_initShader(bool deferredMat,
    mEyePosConst = mShader->getShaderConstHandle("$eyePos");
    mVEyeConst = mShader->getShaderConstHandle("$vEye");
    mLayerSizeConst = mShader->getShaderConstHandle("$layerSize");
+   mLayerTexScaleConst = mShader->getShaderConstHandle("$layerTexScale");
    mObjTransConst = mShader->getShaderConstHandle("$objTrans");
    mWorldToObjConst = mShader->getShaderConstHandle("$worldToObj");
    mLightInfoBufferConst = mShader->getShaderConstHandle("$lightInfoBuffer");
@@ -535,8 +536,10 @@ bool TerrainCellMaterial::_initShader(bool deferredMat,
    if (mBaseTexMapConst->isValid())
       desc.samplers[mBaseTexMapConst->getSamplerRegister()] = GFXSamplerStateDesc::getWrapLinear();
 
+   // The layer texture window of a streamed terrain wraps.
    if (mLayerTexConst->isValid())
-      desc.samplers[mLayerTexConst->getSamplerRegister()] = GFXSamplerStateDesc::getClampPoint();
+      desc.samplers[mLayerTexConst->getSamplerRegister()] = mTerrain->getFile()->isStreamed() ?
+         GFXSamplerStateDesc::getWrapPoint() : GFXSamplerStateDesc::getClampPoint();
 
    if (mLightInfoBufferConst->isValid())
       desc.samplers[mLightInfoBufferConst->getSamplerRegister()] = GFXSamplerStateDesc::getClampPoint();
@@ -841,7 +844,9 @@ bool TerrainCellMaterial::setupPass(   const SceneRenderState *state,
    if (mOrmTexArrayConst->isValid() && mTerrain->getOrmTextureArray().isValid())
       GFX->setTextureArray(mOrmTexArrayConst->getSamplerRegister(), mTerrain->getOrmTextureArray());
 
-   mConsts->setSafe( mLayerSizeConst, (F32)mTerrain->mLayerTex.getWidth() );
+   const F32 layerSize = mTerrain->getBlockSize();
+   mConsts->setSafe( mLayerSizeConst, layerSize );
+   mConsts->setSafe( mLayerTexScaleConst, layerSize / (F32)mTerrain->mLayerTex.getWidth() );
 
    if ( mOneOverTerrainSizeConst->isValid() )
    {
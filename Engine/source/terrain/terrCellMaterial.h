@@ -95,6 +95,7 @@ protected:
    GFXShaderConstHandle *mVEyeConst;
 
    GFXShaderConstHandle *mLayerSizeConst;
+   GFXShaderConstHandle *mLayerTexScaleConst;
    GFXShaderConstHandle *mLightParamsConst;
    GFXShaderConstHandle *mLightInfoBufferConst;
 
@@ -808,6 +808,11 @@ bool TerrainBlock::castRayBlock( const Point3F &pStart,
       F32 endT   = sn->endT;
       Point2I blockPos = sn->blockPos;
 
+      // The squares of pages which are not loaded can't be hit.
+      if (  mFile->isStreamed() && level <= mFile->mPageShift &&
+            !mFile->isResident( blockPos.x, blockPos.y ) )
+         continue;
+
       const TerrainSquare *sq = mFile->findSquare( level, blockPos.x, blockPos.y );
 
       F32 startZ = startT * (pEnd.z - pStart.z) + pStart.z;
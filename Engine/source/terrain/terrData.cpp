@@ -54,6 +54,8 @@
 #include "T3D/physics/physicsCollision.h"
 #include "console/engineAPI.h"
 #include "core/util/safeRelease.h"
+#include "T3D/gameBase/gameConnection.h"
+#include "T3D/gameBase/gameProcess.h"
 
 #include "T3D/assets/TerrainMaterialAsset.h"
 using namespace Torque;
@@ -89,6 +91,7 @@ Signal<void(U32,TerrainBlock*,const Point2I& ,const Point2I&)> TerrainBlock::smU
 
 F32 TerrainBlock::smLODScale = 1.0f;
 F32 TerrainBlock::smDetailScale = 1.0f;
+F32 TerrainBlock::smPageStreamRadius = 1024.0f;
 
 
 //RBP - Global function declared in Terrdata.h
@@ -190,6 +193,7 @@ TerrainBlock::TerrainBlock()
    mLightMapSize( 256 ),
    mCRC( 0 ),
    mMaxDetailDistance( 0.0f ),
+   mLayerTexPages( 0 ),
    mBaseTexScaleConst( NULL ),
    mBaseTexIdConst( NULL ),
    mBaseLayerSizeConst(NULL),
@@ -250,6 +254,7 @@ void TerrainBlock::_onTextureEvent( GFXTexCallbackCode code )
          mBaseTex = NULL;
 
       mLayerTex = NULL;
+      mLayerTexSlots.clear();
       mLightMapTex = NULL;
    }
 }
@@ -313,7 +318,7 @@ bool TerrainBlock::_setBaseTexFormat(void *obj, const char *index, const char *d
          // If the cached base texture is older that the terrain file or
          // it doesn't exist then generate and cache it.
          String baseCachePath = terrain->_getBaseTexCacheFileName();
-         if (Platform::compareModifiedTimes(baseCachePath, terrain->mTerrainAsset->getTerrainFilePath()) < 0 && terrain->mUpdateBasetex)
+         if (Platform::compareModifiedTimes(baseCachePath, terrain->mTerrainAsset->getTerrainFilePath()) < 0 && terrain->mUpdateBasetex && !terrain->mFile->isStreamed())
             terrain->_updateBaseTexture(true);
          break;
       }
@@ -365,6 +370,7 @@ void TerrainBlock::setFile(const Resource<TerrainFile>& terr)
    {
       GFXTextureManager::removeEventDelegate(this, &TerrainBlock::_onTextureEvent);
       MATMGR->getFlushSignal().remove(this, &TerrainBlock::_onFlushMaterials);
+      mFile->getPageSignal().remove(this, &TerrainBlock::_onPagesChanged);
    }
 
    mFile = terr;
@@ -384,7 +390,8 @@ void TerrainBlock::setFile(const Resource<TerrainFile>& terr)
       }
    }
 
-   if (terr->mFileVersion != TerrainFile::FILE_VERSION || terr->mNeedsResaving)
+   // Version 7 files only lack the pages used for streaming.
+   if (terr->mFileVersion < 7 || terr->mNeedsResaving)
    {
       Con::errorf(" *********************************************************");
       Con::errorf(" *********************************************************");
@@ -416,9 +423,10 @@ void TerrainBlock::setFile(const Resource<TerrainFile>& terr)
       _updateLayerTexture();
 
       // If the cached base texture is older that the terrain file or
-      // it doesn't exist then generate and cache it.
+      // it doesn't exist then generate and cache it.  Streamed files
+      // don't have the layers to do that until their pages are loaded.
       String baseCachePath = _getBaseTexCacheFileName();
-      if (Platform::compareModifiedTimes(baseCachePath, mTerrainAsset->getTerrainFilePath()) < 0 && mUpdateBasetex)
+      if (Platform::compareModifiedTimes(baseCachePath, mTerrainAsset->getTerrainFilePath()) < 0 && mUpdateBasetex && !mFile->isStreamed())
          _updateBaseTexture(true);
 
       // The base texture should have been cached by now... so load it.
@@ -426,6 +434,7 @@ void TerrainBlock::setFile(const Resource<TerrainFile>& terr)
 
       GFXTextureManager::addEventDelegate(this, &TerrainBlock::_onTextureEvent);
       MATMGR->getFlushSignal().notify(this, &TerrainBlock::_onFlushMaterials);
+      mFile->getPageSignal().notify(this, &TerrainBlock::_onPagesChanged);
 
       // Build the terrain quadtree.
       _rebuildQuadtree();
@@ -1142,6 +1151,9 @@ bool TerrainBlock::onAdd()
 
    _updatePhysics();
 
+   if ( isServerObject() )
+      ServerProcessList::get()->preTickSignal().notify( this, &TerrainBlock::_onServerTick );
+
    return true;
 }
 
@@ -1170,6 +1182,14 @@ void TerrainBlock::_updatePhysics()
    if ( !PHYSICSMGR )
       return;
 
+   // There is no full height map to build a heightfield from.
+   if ( mFile && mFile->isStreamed() )
+   {
+      SAFE_DELETE( mPhysicsRep );
+      Con::warnf( "TerrainBlock::_updatePhysics - '%s' is streamed and has no physics representation.", mFile->mFilePath.getFullPath().c_str() );
+      return;
+   }
+
    SAFE_DELETE( mPhysicsRep );
 
    PhysicsCollision *colShape = NULL;
@@ -1221,10 +1241,17 @@ void TerrainBlock::onRemove()
 
    SAFE_DELETE( mPhysicsRep );
 
+   if ( isServerObject() )
+      ServerProcessList::get()->preTickSignal().remove( this, &TerrainBlock::_onServerTick );
+
    if ( isClientObject() )
    {
+      if ( mFile )
+         mFile->getPageSignal().remove( this, &TerrainBlock::_onPagesChanged );
+
       mBaseTex = NULL;
       mLayerTex = NULL;
+      mLayerTexSlots.clear();
       SAFE_DELETE( mBaseMaterial );
       SAFE_DELETE( mDefaultMatInst );
       SAFE_DELETE( mCell );
@@ -1240,6 +1267,30 @@ void TerrainBlock::onRemove()
 void TerrainBlock::prepRenderImage( SceneRenderState* state )
 {
    PROFILE_SCOPE(TerrainBlock_prepRenderImage);
+
+   // Keep the pages around the camera loaded.
+   if ( mFile && mFile->isStreamed() && state->isDiffusePass() )
+   {
+      Point3F objCamPos = state->getDiffuseCameraPosition();
+      getRenderWorldTransform().mulP( objCamPos );
+
+      _requestPages( objCamPos );
+      mFile->updatePages();
+
+      // Rebuild the layer texture window if the stream radius
+      // changed, else take back any slots the pages around
+      // the camera lost to pages elsewhere.
+      if ( mLayerTex.isValid() && mLayerTexPages != _getLayerTexPages() )
+         mLayerTex = NULL;
+      else if ( mLayerTex.isValid() )
+      {
+         const S32 radius = mCeil( smPageStreamRadius / mSquareSize );
+         _claimLayerTexSlots( RectI(   (S32)mFloor( objCamPos.x / mSquareSize ) - radius,
+                                       (S32)mFloor( objCamPos.y / mSquareSize ) - radius,
+                                       radius * 2,
+                                       radius * 2 ) );
+      }
+   }
    
    // If we need to update our cached 
    // zone state then do it now.
@@ -1252,6 +1303,110 @@ void TerrainBlock::prepRenderImage( SceneRenderState* state )
    _renderBlock( state );
 }
 
+void TerrainBlock::_requestPages( const Point3F &objPos )
+{
+   const S32 radius = mCeil( smPageStreamRadius / mSquareSize );
+   const RectI rect( (S32)mFloor( objPos.x / mSquareSize ) - radius,
+                     (S32)mFloor( objPos.y / mSquareSize ) - radius,
+                     radius * 2,
+                     radius * 2 );
+
+   // Don't load the edge of the terrain for
+   // positions that are nowhere near it.
+   if ( rect.overlaps( RectI( 0, 0, getBlockSize(), getBlockSize() ) ) )
+      mFile->requestPages( rect );
+}
+
+void TerrainBlock::_onPagesChanged( const RectI &rect )
+{
+   if ( !mCell )
+      return;
+
+   PROFILE_SCOPE( TerrainBlock_onPagesChanged );
+
+   // Copy in the layers of a loaded page.  The row and column
+   // before it are updated too as they blend with the page.
+   if ( mLayerTex.isValid() && mFile->isResident( rect ) )
+   {
+      // A page of a streamed file takes over its slot in the layer
+      // texture window, so the page it displaced stops rendering.
+      if ( mLayerTexPages )
+      {
+         const U32 page =  ( rect.point.x >> mFile->mPageShift ) + 
+                           ( rect.point.y >> mFile->mPageShift ) * mFile->mPagesPerSide;
+         const S32 displaced = _claimLayerTexSlot( page );
+         if ( displaced != -1 )
+            _updateCellPages( mFile->_getPageRect( displaced ) );
+      }
+
+      _updateLayerTexture( RectI( rect.point.x - 1, rect.point.y - 1, rect.extent.x + 1, rect.extent.y + 1 ) );
+   }
+
+   _updateCellPages( rect );
+}
+
+void TerrainBlock::_updateCellPages( const RectI &rect )
+{
+   // The cells may have been deleted.
+   mDebugCells.clear();
+
+   mCell->updatePages( rect );
+   mZoningDirty = true;
+}
+
+bool TerrainBlock::isLayerResident( const RectI &gridRect ) const
+{
+   if ( !mLayerTexPages )
+      return true;
+
+   // Until the window is built again after a reset.
+   if ( mLayerTexSlots.empty() )
+      return false;
+
+   const S32 maxPt = mFile->mSize - 1;
+   const S32 x0 = mClamp( gridRect.point.x, 0, maxPt ) >> mFile->mPageShift;
+   const S32 y0 = mClamp( gridRect.point.y, 0, maxPt ) >> mFile->mPageShift;
+   const S32 x1 = mClamp( gridRect.point.x + gridRect.extent.x - 1, 0, maxPt ) >> mFile->mPageShift;
+   const S32 y1 = mClamp( gridRect.point.y + gridRect.extent.y - 1, 0, maxPt ) >> mFile->mPageShift;
+
+   for ( S32 py = y0; py <= y1; py++ )
+   {
+      for ( S32 px = x0; px <= x1; px++ )
+      {
+         const U32 page = px + py * mFile->mPagesPerSide;
+         if ( mLayerTexSlots[ _getLayerTexSlot( page ) ] != (S32)page )
+            return false;
+      }
+   }
+
+   return true;
+}
+
+void TerrainBlock::_onServerTick()
+{
+   if ( !mFile || !mFile->isStreamed() )
+      return;
+
+   PROFILE_SCOPE( TerrainBlock_onServerTick );
+
+   // Keep the pages around each client's control
+   // object loaded so that it has something to collide with.
+   SimGroup *clientGroup = Sim::getClientGroup();
+   for ( SimGroup::iterator itr = clientGroup->begin(); itr != clientGroup->end(); itr++ )
+   {
+      GameConnection *con = dynamic_cast<GameConnection*>( *itr );
+      if ( !con || !con->getControlObject() )
+         continue;
+
+      Point3F objPos = con->getControlObject()->getPosition();
+      getWorldTransform().mulP( objPos );
+
+      _requestPages( objPos );
+   }
+
+   mFile->updatePages();
+}
+
 void TerrainBlock::setTransform(const MatrixF & mat)
 {
    Parent::setTransform( mat );
@@ -1336,6 +1491,18 @@ void TerrainBlock::initPersistFields()
 
    Con::addVariable( "$pref::Terrain::detailScale", TypeF32, &smDetailScale, "A global detail scale used to tweak the material detail distances.\n\n" 
 	   "@ingroup Terrain");
+
+   Con::addVariable( "$pref::Terrain::streamPages", TypeBool, &TerrainFile::smStreamPages, "If true terrain files are loaded with only their header and "
+      "their pages are streamed in around the camera and each client's control object.  Streamed terrains can't be edited.\n\n"
+	   "@ingroup Terrain");
+
+   Con::addVariable( "$pref::Terrain::pageStreamRadius", TypeF32, &smPageStreamRadius, "The distance in meters around the camera and each client's "
+      "control object in which streamed terrain pages are kept loaded.\n\n"
+	   "@ingroup Terrain");
+
+   Con::addVariable( "$pref::Terrain::pageEvictTime", TypeS32, &TerrainFile::smPageEvictTime, "The time in milliseconds a streamed terrain page "
+      "stays loaded after it was last needed.\n\n"
+	   "@ingroup Terrain");
 }
 
 void TerrainBlock::inspectPostApply()
@@ -146,6 +146,14 @@ protected:
    /// 
    GFXTexHandle mLayerTex;
 
+   /// The pages along each side of the layer texture window
+   /// of a streamed file or zero if it holds the whole file.
+   U32 mLayerTexPages;
+
+   /// The page which owns each slot of the layer texture
+   /// window or -1 if the slot is empty.
+   Vector<S32> mLayerTexSlots;
+
    /// The shader used to generate the base texture map.
    GFXShaderRef mBaseShader;
 
@@ -217,6 +225,12 @@ protected:
    /// material detail distances.
    static F32 smDetailScale;
 
+   /// The distance in meters around the camera and each
+   /// client's control object in which the pages of streamed
+   /// terrain files are kept loaded.  It is exposed to the
+   /// console via $pref::Terrain::pageStreamRadius.
+   static F32 smPageStreamRadius;
+
    /// True if the zoning needs to be recalculated for the terrain.
    bool mZoningDirty;
 
@@ -252,12 +266,51 @@ protected:
 
    void _updateLayerTexture();
 
+   /// Updates the layer texture within the grid rect.
+   void _updateLayerTexture( const RectI &rect );
+
+   /// Copies the layers within the grid rect to the texel
+   /// position in the layer texture.
+   void _writeLayerTexture( const RectI &gridRect, const Point2I &texPos );
+
+   /// Returns the pages along each side of the layer texture
+   /// window needed to hold the pages _requestPages() loads.
+   U32 _getLayerTexPages() const;
+
+   /// Returns the slot of the page in the layer texture window.
+   U32 _getLayerTexSlot( U32 page ) const;
+
+   /// Gives the page its slot in the layer texture window and
+   /// copies in its layers.  Returns the page it displaced or -1.
+   S32 _claimLayerTexSlot( U32 page );
+
+   /// Claims the slots of the resident pages within the grid
+   /// rect which have lost them to other pages.
+   void _claimLayerTexSlots( const RectI &gridRect );
+
+   /// Rebuilds the cells within the grid rect after pages were
+   /// loaded, evicted or lost their layer texture slot.
+   void _updateCellPages( const RectI &rect );
+
    void _updateBounds();
 
    void _onZoningChanged( SceneZoneSpaceManager *zoneManager );
 
    void _updateZoning();
 
+   /// Requests the file pages within smPageStreamRadius
+   /// of the object space position.
+   void _requestPages( const Point3F &objPos );
+
+   /// Updates the cells and layer texture when pages
+   /// of a streamed file are loaded or evicted.
+   /// @see TerrainFile::getPageSignal
+   void _onPagesChanged( const RectI &rect );
+
+   /// Keeps the pages around the control objects of the
+   /// clients loaded for a streamed file on the server.
+   void _onServerTick();
+
    // Protected fields
    static bool _setTerrainFile( void *obj, const char *index, const char *data );
    static bool _setTerrainAsset(void* obj, const char* index, const char* data);
@@ -460,6 +513,10 @@ public:
 
    U32 getScreenError() const { return smLODScale * mScreenError; }
 
+   /// Returns true if the layers within the grid rect are in
+   /// the layer texture window of a streamed file.
+   bool isLayerResident( const RectI &gridRect ) const;
+
    // SceneObject
    void setTransform( const MatrixF &mat );
    void setScale( const VectorF &scale );
@@ -31,6 +31,11 @@
 
 bool TerrainBlock::exportHeightMap( const UTF8 *filePath, const String &format ) const
 {
+   if ( mFile->isStreamed() )
+   {
+      Con::errorf( "TerrainBlock::exportHeightMap - Can't export a streamed terrain file!" );
+      return false;
+   }
 
    GBitmap output(   mFile->mSize,
                      mFile->mSize,
@@ -92,6 +97,12 @@ bool TerrainBlock::exportHeightMap( const UTF8 *filePath, const String &format )
 
 bool TerrainBlock::exportLayerMaps( const UTF8 *filePrefix, const String &format ) const
 {
+   if ( mFile->isStreamed() )
+   {
+      Con::errorf( "TerrainBlock::exportLayerMaps - Can't export a streamed terrain file!" );
+      return false;
+   }
+
    for(S32 i = 0; i < mFile->mMaterials.size(); i++)
    {
       Vector<const U8>::iterator iBits = mFile->mLayerMap.begin();
@@ -29,6 +29,8 @@
 #include "gfx/gfxTextureHandle.h"
 #include "gfx/bitmap/gBitmap.h"
 #include "platform/profiler.h"
+#include "platform/platformIntrinsics.h"
+#include "platform/threads/threadPool.h"
 #include "math/mPlane.h"
 
 
@@ -44,11 +46,18 @@ template<> ResourceBase::Signature Resource<TerrainFile>::signature()
 }
 
 
+bool TerrainFile::smStreamPages = false;
+S32 TerrainFile::smPageEvictTime = 5000;
+
+
 TerrainFile::TerrainFile()
    : mSize( 256 ),
      mGridLevels(0),
      mFileVersion( FILE_VERSION ),
-     mNeedsResaving( false )
+     mNeedsResaving( false ),
+     mPageShift( 0 ),
+     mPagesPerSide( 0 ),
+     mPageDataOffset( 0 )
 {
    mLayerMap.setSize( mSize * mSize );
    dMemset( mLayerMap.address(), 0, mLayerMap.memSize() );
@@ -59,6 +68,7 @@ TerrainFile::TerrainFile()
 
 TerrainFile::~TerrainFile()
 {
+   _releasePages();
 }
 
 static U16 calcDev( const PlaneF &pl, const Point3F &pt )
@@ -90,6 +100,120 @@ inline U32 getMostSignificantBit( U32 v )
    return bit;
 }
 
+/// Calculates the height range, empty state and split of the grid
+/// square from the samples of the source.  This is shared by the
+/// full grid map and the grid maps of streamed pages.
+template<class T>
+static void calcGridSquare(   const T &src,
+                              S32 level,
+                              S32 squareX,
+                              S32 squareY,
+                              TerrainSquare *parent,
+                              TerrainSquare *sq )
+{
+   const S32 squareSize = 1 << level;
+
+   U16 min = 0xFFFF;
+   U16 max = 0;
+   U16 mindev45 = 0;
+   U16 mindev135 = 0;
+
+   // determine max error for both possible splits.
+
+   const Point3F p1(0, 0, src.getHeight(squareX * squareSize, squareY * squareSize));
+   const Point3F p2(0, (F32)squareSize, src.getHeight(squareX * squareSize, squareY * squareSize + squareSize));
+   const Point3F p3((F32)squareSize, (F32)squareSize, src.getHeight(squareX * squareSize + squareSize, squareY * squareSize + squareSize));
+   const Point3F p4((F32)squareSize, 0, src.getHeight(squareX * squareSize + squareSize, squareY * squareSize));
+
+   // pl1, pl2 = split45, pl3, pl4 = split135
+   const PlaneF pl1(p1, p2, p3);
+   const PlaneF pl2(p1, p3, p4);
+   const PlaneF pl3(p1, p2, p4);
+   const PlaneF pl4(p2, p3, p4);
+
+   const bool parentSplit45 = parent && ( parent->flags & TerrainSquare::Split45 );
+
+   bool empty = true;
+   bool hasEmpty = false;
+
+   for ( S32 sizeX = 0; sizeX <= squareSize; sizeX++ )
+   {
+      for ( S32 sizeY = 0; sizeY <= squareSize; sizeY++ )
+      {
+         S32 x = squareX * squareSize + sizeX;
+         S32 y = squareY * squareSize + sizeY;
+
+         if(sizeX != squareSize && sizeY != squareSize)
+         {
+            if ( !src.isEmptyAt( x, y ) )
+               empty = false;
+            else
+               hasEmpty = true;
+         }
+
+         U16 ht = src.getHeight( x, y );
+         if ( ht < min )
+            min = ht;
+         if( ht > max )
+            max = ht;
+
+         Point3F pt( (F32)sizeX, (F32)sizeY, (F32)ht );
+         U16 dev;
+
+         if(sizeX < sizeY)
+            dev = calcDev(pl1, pt);
+         else if(sizeX > sizeY)
+            dev = calcDev(pl2, pt);
+         else
+            dev = Umax(calcDev(pl1, pt), calcDev(pl2, pt));
+
+         if(dev > mindev45)
+            mindev45 = dev;
+
+         if(sizeX + sizeY < squareSize)
+            dev = calcDev(pl3, pt);
+         else if(sizeX + sizeY > squareSize)
+            dev = calcDev(pl4, pt);
+         else
+            dev = Umax(calcDev(pl3, pt), calcDev(pl4, pt));
+
+         if(dev > mindev135)
+            mindev135 = dev;
+      }
+   }
+
+   sq->minHeight = min;
+   sq->maxHeight = max;
+
+   sq->flags = empty ? TerrainSquare::Empty : 0;
+   if ( hasEmpty )
+      sq->flags |= TerrainSquare::HasEmpty;
+
+   bool shouldSplit45 = ((squareX ^ squareY) & 1) == 0;
+   bool split45;
+
+   //split45 = shouldSplit45;
+   if ( level == 0 )
+      split45 = shouldSplit45;
+   else if( level < 4 && shouldSplit45 == parentSplit45 )
+      split45 = shouldSplit45;
+   else
+      split45 = mindev45 < mindev135;
+
+   //split45 = shouldSplit45;
+   if(split45)
+   {
+      sq->flags |= TerrainSquare::Split45;
+      sq->heightDeviance = mindev45;
+   }
+   else
+      sq->heightDeviance = mindev135;
+
+   if( parent )
+      if (  parent->heightDeviance < sq->heightDeviance )
+            parent->heightDeviance = sq->heightDeviance;
+}
+
 void TerrainFile::_buildGridMap()
 {
    // The grid level count is the same as the
@@ -127,112 +251,12 @@ void TerrainFile::_buildGridMap()
       {
          for ( S32 squareY = 0; squareY < squareCount; squareY++ )
          {
-            U16 min = 0xFFFF;
-            U16 max = 0;
-            U16 mindev45 = 0;
-            U16 mindev135 = 0;
-
-            // determine max error for both possible splits.
-
-            const Point3F p1(0, 0, getHeight(squareX * squareSize, squareY * squareSize));
-            const Point3F p2(0, (F32)squareSize, getHeight(squareX * squareSize, squareY * squareSize + squareSize));
-            const Point3F p3((F32)squareSize, (F32)squareSize, getHeight(squareX * squareSize + squareSize, squareY * squareSize + squareSize));
-            const Point3F p4((F32)squareSize, 0, getHeight(squareX * squareSize + squareSize, squareY * squareSize));
-
-            // pl1, pl2 = split45, pl3, pl4 = split135
-            const PlaneF pl1(p1, p2, p3);
-            const PlaneF pl2(p1, p3, p4);
-            const PlaneF pl3(p1, p2, p4);
-            const PlaneF pl4(p2, p3, p4);
-
-            bool parentSplit45 = false;
             TerrainSquare *parent = NULL;
             if ( i < mGridLevels )
-            {
                parent = findSquare( i+1, squareX * squareSize, squareY * squareSize );
-               parentSplit45 = parent->flags & TerrainSquare::Split45;
-            }
-
-            bool empty = true;
-            bool hasEmpty = false;
-
-            for ( S32 sizeX = 0; sizeX <= squareSize; sizeX++ )
-            {
-               for ( S32 sizeY = 0; sizeY <= squareSize; sizeY++ )
-               {
-                  S32 x = squareX * squareSize + sizeX;
-                  S32 y = squareY * squareSize + sizeY;
-
-                  if(sizeX != squareSize && sizeY != squareSize)
-                  {
-                     if ( !isEmptyAt( x, y ) )
-                        empty = false;
-                     else
-                        hasEmpty = true;
-                  }
-
-                  U16 ht = getHeight( x, y );
-                  if ( ht < min )
-                     min = ht;
-                  if( ht > max )
-                     max = ht;
-
-                  Point3F pt( (F32)sizeX, (F32)sizeY, (F32)ht );
-                  U16 dev;
-
-                  if(sizeX < sizeY)
-                     dev = calcDev(pl1, pt);
-                  else if(sizeX > sizeY)
-                     dev = calcDev(pl2, pt);
-                  else
-                     dev = Umax(calcDev(pl1, pt), calcDev(pl2, pt));
-
-                  if(dev > mindev45)
-                     mindev45 = dev;
-
-                  if(sizeX + sizeY < squareSize)
-                     dev = calcDev(pl3, pt);
-                  else if(sizeX + sizeY > squareSize)
-                     dev = calcDev(pl4, pt);
-                  else
-                     dev = Umax(calcDev(pl3, pt), calcDev(pl4, pt));
-
-                  if(dev > mindev135)
-                     mindev135 = dev;
-               }
-            }
 
             TerrainSquare *sq = findSquare( i, squareX * squareSize, squareY * squareSize );
-            sq->minHeight = min;
-            sq->maxHeight = max;
-
-            sq->flags = empty ? TerrainSquare::Empty : 0;
-            if ( hasEmpty )
-               sq->flags |= TerrainSquare::HasEmpty;
-
-            bool shouldSplit45 = ((squareX ^ squareY) & 1) == 0;
-            bool split45;
-
-            //split45 = shouldSplit45;
-            if ( i == 0 )
-               split45 = shouldSplit45;
-            else if( i < 4 && shouldSplit45 == parentSplit45 )
-               split45 = shouldSplit45;
-            else
-               split45 = mindev45 < mindev135;
-
-            //split45 = shouldSplit45;
-            if(split45)
-            {
-               sq->flags |= TerrainSquare::Split45;
-               sq->heightDeviance = mindev45;
-            }
-            else
-               sq->heightDeviance = mindev135;
-
-            if( parent )
-               if (  parent->heightDeviance < sq->heightDeviance )
-                     parent->heightDeviance = sq->heightDeviance;
+            calcGridSquare( *this, i, squareX, squareY, parent, sq );
          }
       }
    }
@@ -267,28 +291,69 @@ void TerrainFile::_initMaterialInstMapping()
 
 bool TerrainFile::save( const char *filename )
 {
+   if ( isStreamed() )
+   {
+      Con::errorf( "TerrainFile::save - Can't save a streamed terrain file, load it with $pref::Terrain::streamPages off to edit it." );
+      return false;
+   }
+
    FileStream stream;
    stream.open( filename, Torque::FS::File::Write );
    if ( stream.getStatus() != Stream::Ok )
       return false;
 
-   stream.write( (U8)FILE_VERSION );
+   if ( mGridMap.empty() )
+      _buildGridMap();
 
-   stream.write( mSize );
+   const U32 pageSize = getMin( mSize, (U32)PAGE_SIZE );
+   const U32 pageShift = getBinLog2( pageSize );
+   const U32 pagesPerSide = mSize / pageSize;
 
-   // Write out the height map.
-   for ( U32 i=0; i < mHeightMap.size(); i++)
-      stream.write( mHeightMap[i] );
+   stream.write( (U8)FILE_VERSION );
 
-   // Write out the layer map.
-   for ( U32 i=0; i < mLayerMap.size(); i++)
-      stream.write( mLayerMap[i] );
+   stream.write( mSize );
+   stream.write( pageSize );
 
    // Write out the material names.
    stream.write( (U32)mMaterials.size() );
    for ( U32 i=0; i < mMaterials.size(); i++ )
       stream.write( String( mMaterials[i]->getInternalName() ) );
 
+   // Write out the grid map levels above the pages so that 
+   // streamed loads don't need every page to build them.
+   for ( S32 i = mGridLevels; i >= (S32)pageShift; i-- )
+   {
+      const U32 count = 1 << ( 2 * ( mGridLevels - i ) );
+      const TerrainSquare *sq = mGridMap[i];
+      for ( U32 j=0; j < count; j++, sq++ )
+      {
+         stream.write( sq->minHeight );
+         stream.write( sq->maxHeight );
+         stream.write( sq->heightDeviance );
+         stream.write( sq->flags );
+      }
+   }
+
+   // Write out the pages.  The heights of each page include the
+   // first row and column of its neighbors so that a page alone
+   // has all the samples its squares need.
+   for ( U32 py=0; py < pagesPerSide; py++ )
+   {
+      for ( U32 px=0; px < pagesPerSide; px++ )
+      {
+         const U32 x0 = px * pageSize;
+         const U32 y0 = py * pageSize;
+
+         for ( U32 y=0; y <= pageSize; y++ )
+            for ( U32 x=0; x <= pageSize; x++ )
+               stream.write( getHeight( x0 + x, y0 + y ) );
+
+         for ( U32 y=0; y < pageSize; y++ )
+            for ( U32 x=0; x < pageSize; x++ )
+               stream.write( getLayerIndex( x0 + x, y0 + y ) );
+      }
+   }
+
    return stream.getStatus() == FileStream::Ok;
 }
 
@@ -311,17 +376,25 @@ TerrainFile* TerrainFile::load( const Torque::Path &path )
       return NULL;
    }
 
+   if ( smStreamPages && version < 8 )
+      Con::warnf( "Resource<TerrainFile>::create - '%s' can't be streamed until it is resaved", path.getFullPath().c_str() );
+
    TerrainFile *ret = new TerrainFile;
    ret->mFileVersion = version;
    ret->mFilePath = path;
 
-   if ( version >= 7 )
+   if ( version >= 8 )
+      ret->_loadTiled( stream, smStreamPages );
+   else if ( version >= 7 )
       ret->_load( stream );
    else
       ret->_loadLegacy( stream );
 
-   // Update the collision structures.
-   ret->_buildGridMap();
+   // Update the collision structures.  Streamed files read
+   // the upper levels with the header and build the rest
+   // as each page is loaded.
+   if ( !ret->isStreamed() )
+      ret->_buildGridMap();
    
    // Do the material mapping.
    ret->_initMaterialInstMapping();
@@ -361,6 +434,106 @@ void TerrainFile::_load( FileStream &stream )
    _resolveMaterials( materials );
 }
 
+void TerrainFile::_loadTiled( FileStream &stream, bool streamPages )
+{
+   U32 pageSize;
+   stream.read( &mSize );
+   stream.read( &pageSize );
+
+   mPageShift = getBinLog2( pageSize );
+   mPagesPerSide = mSize >> mPageShift;
+   mGridLevels = getBinLog2( mSize );
+
+   // Get the material name count.
+   U32 materialCount;
+   stream.read( &materialCount );
+   Vector<String> materials;
+   materials.setSize( materialCount );
+
+   // Load the material names.
+   for ( U32 i=0; i < materialCount; i++ )
+      stream.read( &materials[i] );
+
+   // Resolve the TerrainMaterial objects from the names.
+   _resolveMaterials( materials );
+
+   // Load the grid map levels above the pages.  These are laid out
+   // in the pool as _buildGridMap() does with the levels below the
+   // pages left out.
+   U32 poolSize = 0;
+   for ( U32 i = mPageShift; i <= mGridLevels; i++ )
+      poolSize += 1 << ( 2 * ( mGridLevels - i ) );
+
+   mGridMapPool.setSize( poolSize );
+   mGridMapPool.compact();
+   mGridMap.setSize( mGridLevels + 1 );
+   mGridMap.compact();
+
+   TerrainSquare *grid = mGridMapPool.address();
+   for ( S32 i = mGridLevels; i >= 0; i-- )
+   {
+      if ( i < (S32)mPageShift )
+      {
+         mGridMap[i] = NULL;
+         continue;
+      }
+
+      mGridMap[i] = grid;
+      grid += 1 << ( 2 * ( mGridLevels - i ) );
+   }
+
+   for ( U32 i=0; i < mGridMapPool.size(); i++ )
+   {
+      TerrainSquare &sq = mGridMapPool[i];
+      stream.read( &sq.minHeight );
+      stream.read( &sq.maxHeight );
+      stream.read( &sq.heightDeviance );
+      stream.read( &sq.flags );
+   }
+
+   if ( streamPages )
+   {
+      // The pages are all the same size so we only need
+      // to know where the first one is to find the others.
+      mPageDataOffset = stream.getPosition();
+      mPages.setSize( mPagesPerSide * mPagesPerSide );
+      return;
+   }
+
+   // Load all the pages into the flat maps.
+   mHeightMap.setSize( mSize * mSize );
+   mLayerMap.setSize( mSize * mSize );
+
+   for ( U32 py=0; py < mPagesPerSide; py++ )
+   {
+      for ( U32 px=0; px < mPagesPerSide; px++ )
+      {
+         const U32 x0 = px * pageSize;
+         const U32 y0 = py * pageSize;
+
+         // Skip over the border heights.
+         for ( U32 y=0; y <= pageSize; y++ )
+         {
+            for ( U32 x=0; x <= pageSize; x++ )
+            {
+               U16 height;
+               stream.read( &height );
+               if ( x < pageSize && y < pageSize )
+                  mHeightMap[ ( x0 + x ) + ( ( y0 + y ) * mSize ) ] = height;
+            }
+         }
+
+         for ( U32 y=0; y < pageSize; y++ )
+            for ( U32 x=0; x < pageSize; x++ )
+               stream.read( &mLayerMap[ ( x0 + x ) + ( ( y0 + y ) * mSize ) ] );
+      }
+   }
+
+   // The flat maps don't use the pages.
+   mPageShift = 0;
+   mPagesPerSide = 0;
+}
+
 void TerrainFile::_loadLegacy(  FileStream &stream )
 {
    // Some legacy constants.
@@ -574,6 +747,18 @@ void TerrainFile::_resolveMaterials( const Vector<String> &materials )
 
 void TerrainFile::setSize( U32 newSize, bool clear )
 {
+   if ( isStreamed() )
+   {
+      if ( !clear )
+      {
+         Con::errorf( "TerrainFile::setSize - Can't resize a streamed terrain file!" );
+         return;
+      }
+
+      // We're replacing everything so the pages can go.
+      _releasePages();
+   }
+
    // Make sure the resolution is a power of two.
    newSize = getNextPow2( newSize );
 
@@ -608,6 +793,12 @@ void TerrainFile::setSize( U32 newSize, bool clear )
 
 void TerrainFile::smooth( F32 factor, U32 steps, bool updateCollision )
 {
+   if ( isStreamed() )
+   {
+      Con::errorf( "TerrainFile::smooth - Streamed terrain files are read only!" );
+      return;
+   }
+
    const U32 blockSize = mSize * mSize;
 
    // Grab some temp buffers for our smoothing results.
@@ -673,6 +864,12 @@ void TerrainFile::smooth( F32 factor, U32 steps, bool updateCollision )
 
 void TerrainFile::setHeightMap( const Vector<U16> &heightmap, bool updateCollision )
 {
+   if ( isStreamed() )
+   {
+      Con::errorf( "TerrainFile::setHeightMap - Streamed terrain files are read only!" );
+      return;
+   }
+
    AssertFatal( mHeightMap.size() == heightmap.size(), "TerrainFile::setHeightMap - Incorrect heightmap size!" );
    dMemcpy( mHeightMap.address(), heightmap.address(), mHeightMap.size() ); 
 
@@ -689,6 +886,9 @@ void TerrainFile::import(  const GBitmap &heightMap,
    AssertFatal( heightMap.getWidth() == heightMap.getHeight(), "TerrainFile::import - Height map is not square!" );
    AssertFatal( isPow2( heightMap.getWidth() ), "TerrainFile::import - Height map is not power of two!" );
 
+   // The import replaces everything so the pages can go.
+   _releasePages();
+
    const U32 newSize = heightMap.getWidth();
    if ( newSize != mSize )
    {
@@ -826,6 +1026,10 @@ void TerrainFile::updateGrid( const Point2I &minPt, const Point2I &maxPt )
 
    PROFILE_SCOPE( TerrainFile_UpdateGrid );
 
+   // Streamed files are read only.
+   if ( isStreamed() )
+      return;
+
    for ( S32 y = minPt.y - 1; y < maxPt.y + 1; y++ )
    {
       for ( S32 x = minPt.x - 1; x < maxPt.x + 1; x++ )
@@ -881,3 +1085,417 @@ void TerrainFile::updateGrid( const Point2I &minPt, const Point2I &maxPt )
       }
    }
 }
+
+//-----------------------------------------------------------------------------
+// Page streaming
+//-----------------------------------------------------------------------------
+
+/// The sample source used to build the grid map of a page.
+struct PageSampleSource
+{
+   const TerrainPageData *data;
+   U32 pageShift;
+   S32 originX;
+   S32 originY;
+
+   U16 getHeight( S32 x, S32 y ) const
+   {
+      return data->heights[ ( x - originX ) + ( y - originY ) * ( ( 1 << pageShift ) + 1 ) ];
+   }
+
+   bool isEmptyAt( S32 x, S32 y ) const
+   {
+      return data->layers[ ( x - originX ) + ( ( y - originY ) << pageShift ) ] == U8_MAX;
+   }
+};
+
+/// Builds the grid map levels below the page level, which match
+/// what _buildGridMap() makes for the same squares.
+static void buildPageGridMap( TerrainPageData *data, U32 pageShift, const Point2I &origin, TerrainSquare pageSquare )
+{
+   U32 poolSize = 0;
+   for ( U32 i=0; i < pageShift; i++ )
+      poolSize += 1 << ( 2 * ( pageShift - i ) );
+
+   data->gridMapPool.setSize( poolSize );
+   data->gridMap.setSize( pageShift );
+
+   TerrainSquare *grid = data->gridMapPool.address();
+   for ( S32 i = pageShift - 1; i >= 0; i-- )
+   {
+      data->gridMap[i] = grid;
+      grid += 1 << ( 2 * ( pageShift - i ) );
+   }
+
+   PageSampleSource src;
+   src.data = data;
+   src.pageShift = pageShift;
+   src.originX = origin.x;
+   src.originY = origin.y;
+
+   for ( S32 i = pageShift - 1; i >= 0; i-- )
+   {
+      const S32 squareCount = 1 << ( pageShift - i );
+      
+      for ( S32 squareY = 0; squareY < squareCount; squareY++ )
+      {
+         for ( S32 squareX = 0; squareX < squareCount; squareX++ )
+         {
+            // The top level is parented by a copy of the page
+            // square as the shared one must not be touched here.
+            TerrainSquare *parent = &pageSquare;
+            if ( i + 1 < (S32)pageShift )
+               parent = data->gridMap[i+1] + ( squareX >> 1 ) + ( ( squareY >> 1 ) << ( pageShift - i - 1 ) );
+
+            TerrainSquare *sq = data->gridMap[i] + squareX + ( squareY << ( pageShift - i ) );
+            calcGridSquare( src, i, ( origin.x >> i ) + squareX, ( origin.y >> i ) + squareY, parent, sq );
+         }
+      }
+   }
+}
+
+class TerrainFile::PageLoadItem : public ThreadPool::WorkItem
+{
+public:
+
+   typedef ThreadPool::WorkItem Parent;
+
+   PageLoadItem(  const Torque::Path &path, 
+                  U32 offset, 
+                  U32 pageShift, 
+                  const Point2I &origin, 
+                  const TerrainSquare &pageSquare )
+      :  mPath( path ),
+         mOffset( offset ),
+         mPageShift( pageShift ),
+         mOrigin( origin ),
+         mPageSquare( pageSquare ),
+         mData( NULL ),
+         mLoaded( 0 )
+   {
+   }
+
+   virtual ~PageLoadItem()
+   {
+      SAFE_DELETE( mData );
+   }
+
+   /// The terrain file being read.
+   const Torque::Path mPath;
+
+   /// The file position of the page.
+   const U32 mOffset;
+
+   /// The log2 of the page size.
+   const U32 mPageShift;
+
+   /// The first sample of the page.
+   const Point2I mOrigin;
+
+   /// The grid square of the whole page.
+   const TerrainSquare mPageSquare;
+
+   /// The page data which is only valid once isLoaded() is
+   /// true.  It is NULL if the page failed to load.
+   TerrainPageData *mData;
+
+   /// Returns true once the worker is done with the item.
+   bool isLoaded() { return dAtomicRead( mLoaded ) != 0; }
+
+protected:
+
+   volatile U32 mLoaded;
+
+   virtual void execute()
+   {
+      PROFILE_SCOPE( TerrainFile_PageLoad );
+
+      // The ResourceManager is only safe on the main
+      // thread so we open our own stream.
+      FileStream stream;
+      stream.open( mPath.getFullPath(), Torque::FS::File::Read );
+      if ( stream.getStatus() == Stream::Ok && stream.setPosition( mOffset ) )
+      {
+         const U32 pageSize = 1 << mPageShift;
+
+         mData = new TerrainPageData;
+         mData->heights.setSize( ( pageSize + 1 ) * ( pageSize + 1 ) );
+         for ( U32 i=0; i < mData->heights.size(); i++ )
+            stream.read( &mData->heights[i] );
+
+         mData->layers.setSize( pageSize * pageSize );
+         for ( U32 i=0; i < mData->layers.size(); i++ )
+            stream.read( &mData->layers[i] );
+
+         if ( stream.getStatus() == Stream::Ok )
+            buildPageGridMap( mData, mPageShift, mOrigin, mPageSquare );
+         else
+            SAFE_DELETE( mData );
+      }
+
+      dCompareAndSwap( mLoaded, 0, 1 );
+   }
+
+   virtual void onCancelled()
+   {
+      dCompareAndSwap( mLoaded, 0, 1 );
+   }
+};
+
+RectI TerrainFile::_getPageRect( U32 page ) const
+{
+   const S32 pageSize = getPageSize();
+   return RectI(  ( page % mPagesPerSide ) * pageSize, 
+                  ( page / mPagesPerSide ) * pageSize, 
+                  pageSize, 
+                  pageSize );
+}
+
+TerrainSquare* TerrainFile::_findPagedSquare( U32 level, U32 x, U32 y ) const
+{
+   // Evicted pages have no grid map so they 
+   // look like one big hole.
+   static TerrainSquare sEmptySquare = { 0, 0, 0, TerrainSquare::Empty };
+
+   const Page &page = _getPage( x, y );
+   if ( page.state != Page::Resident )
+      return &sEmptySquare;
+
+   const U32 mask = getPageSize() - 1;
+   x = ( x & mask ) >> level;
+   y = ( y & mask ) >> level;
+
+   return page.data->gridMap[level] + x + ( y << ( mPageShift - level ) );
+}
+
+U16 TerrainFile::_getPagedHeight( U32 x, U32 y ) const
+{
+   const U32 pageSize = getPageSize();
+   const U32 stride = pageSize + 1;
+   const U32 px = x >> mPageShift;
+   const U32 py = y >> mPageShift;
+   const U32 lx = x & ( pageSize - 1 );
+   const U32 ly = y & ( pageSize - 1 );
+
+   const Page *page = &mPages[ px + py * mPagesPerSide ];
+   if ( page->state == Page::Resident )
+      return page->data->heights[ lx + ly * stride ];
+
+   // The first row and column of a page are also the 
+   // border of the pages before it, so look there too.
+   const U32 prevX = ( px + mPagesPerSide - 1 ) % mPagesPerSide;
+   const U32 prevY = ( py + mPagesPerSide - 1 ) % mPagesPerSide;
+
+   if ( lx == 0 )
+   {
+      page = &mPages[ prevX + py * mPagesPerSide ];
+      if ( page->state == Page::Resident )
+         return page->data->heights[ pageSize + ly * stride ];
+   }
+
+   if ( ly == 0 )
+   {
+      page = &mPages[ px + prevY * mPagesPerSide ];
+      if ( page->state == Page::Resident )
+         return page->data->heights[ lx + pageSize * stride ];
+   }
+
+   if ( lx == 0 && ly == 0 )
+   {
+      page = &mPages[ prevX + prevY * mPagesPerSide ];
+      if ( page->state == Page::Resident )
+         return page->data->heights[ pageSize + pageSize * stride ];
+   }
+
+   return 0;
+}
+
+bool TerrainFile::isResident( const RectI &rect ) const
+{
+   if ( !isStreamed() )
+      return true;
+
+   const S32 maxPt = mSize - 1;
+   const S32 x0 = mClamp( rect.point.x, 0, maxPt ) >> mPageShift;
+   const S32 y0 = mClamp( rect.point.y, 0, maxPt ) >> mPageShift;
+   const S32 x1 = mClamp( rect.point.x + rect.extent.x - 1, 0, maxPt ) >> mPageShift;
+   const S32 y1 = mClamp( rect.point.y + rect.extent.y - 1, 0, maxPt ) >> mPageShift;
+
+   for ( S32 py = y0; py <= y1; py++ )
+   {
+      for ( S32 px = x0; px <= x1; px++ )
+      {
+         if ( mPages[ px + py * mPagesPerSide ].state != Page::Resident )
+            return false;
+      }
+   }
+
+   return true;
+}
+
+bool TerrainFile::isAnyResident( const RectI &rect ) const
+{
+   if ( !isStreamed() )
+      return true;
+
+   const S32 maxPt = mSize - 1;
+   const S32 x0 = mClamp( rect.point.x, 0, maxPt ) >> mPageShift;
+   const S32 y0 = mClamp( rect.point.y, 0, maxPt ) >> mPageShift;
+   const S32 x1 = mClamp( rect.point.x + rect.extent.x - 1, 0, maxPt ) >> mPageShift;
+   const S32 y1 = mClamp( rect.point.y + rect.extent.y - 1, 0, maxPt ) >> mPageShift;
+
+   for ( S32 py = y0; py <= y1; py++ )
+   {
+      for ( S32 px = x0; px <= x1; px++ )
+      {
+         if ( mPages[ px + py * mPagesPerSide ].state == Page::Resident )
+            return true;
+      }
+   }
+
+   return false;
+}
+
+bool TerrainFile::isResident( U32 x, U32 y ) const
+{
+   return !isStreamed() || _getPage( x % mSize, y % mSize ).state == Page::Resident;
+}
+
+void TerrainFile::requestPages( const RectI &rect )
+{
+   if ( !isStreamed() )
+      return;
+
+   PROFILE_SCOPE( TerrainFile_requestPages );
+
+   const U32 now = Platform::getRealMilliseconds();
+   const U32 pageSize = getPageSize();
+   const U32 pageBytes = ( pageSize + 1 ) * ( pageSize + 1 ) * sizeof( U16 ) + pageSize * pageSize;
+
+   const S32 maxPt = mSize - 1;
+   const S32 x0 = mClamp( rect.point.x, 0, maxPt ) >> mPageShift;
+   const S32 y0 = mClamp( rect.point.y, 0, maxPt ) >> mPageShift;
+   const S32 x1 = mClamp( rect.point.x + rect.extent.x - 1, 0, maxPt ) >> mPageShift;
+   const S32 y1 = mClamp( rect.point.y + rect.extent.y - 1, 0, maxPt ) >> mPageShift;
+
+   for ( S32 py = y0; py <= y1; py++ )
+   {
+      for ( S32 px = x0; px <= x1; px++ )
+      {
+         const U32 index = px + py * mPagesPerSide;
+         Page &page = mPages[index];
+         page.lastRequest = now;
+
+         if ( page.state != Page::Evicted )
+            continue;
+
+         const Point2I origin( px * pageSize, py * pageSize );
+
+         page.state = Page::Loading;
+
+         mPageLoads.increment();
+         PageLoad &load = mPageLoads.last();
+         load.page = index;
+         load.item = new PageLoadItem( mFilePath, 
+                                       mPageDataOffset + index * pageBytes, 
+                                       mPageShift, 
+                                       origin, 
+                                       *findSquare( mPageShift, origin.x, origin.y ) );
+
+         ThreadPool::GLOBAL().queueWorkItem( load.item );
+      }
+   }
+}
+
+void TerrainFile::updatePages()
+{
+   if ( !isStreamed() )
+      return;
+
+   PROFILE_SCOPE( TerrainFile_updatePages );
+
+   for ( U32 i=0; i < mPageLoads.size(); )
+   {
+      if ( !mPageLoads[i].item->isLoaded() )
+      {
+         i++;
+         continue;
+      }
+
+      // Take it off the list first as the page
+      // signal may request more pages.
+      PageLoad load = mPageLoads[i];
+      mPageLoads.erase( i );
+      _finishPageLoad( load );
+   }
+
+   const U32 now = Platform::getRealMilliseconds();
+
+   for ( U32 i=0; i < mPages.size(); i++ )
+   {
+      Page &page = mPages[i];
+      if (  page.state != Page::Resident || 
+            now - page.lastRequest < (U32)getMax( smPageEvictTime, 0 ) )
+         continue;
+
+      SAFE_DELETE( page.data );
+      page.state = Page::Evicted;
+
+      mPageSignal.trigger( _getPageRect( i ) );
+   }
+}
+
+void TerrainFile::flushPageLoads()
+{
+   PROFILE_SCOPE( TerrainFile_flushPageLoads );
+
+   while ( !mPageLoads.empty() )
+   {
+      PageLoad load = mPageLoads.first();
+      mPageLoads.pop_front();
+      _finishPageLoad( load );
+   }
+}
+
+void TerrainFile::_finishPageLoad( PageLoad &load )
+{
+   PROFILE_SCOPE( TerrainFile_finishPageLoad );
+
+   PageLoadItem *item = load.item;
+
+   // The load is normally done by now, but
+   // flushing can get here before it is.
+   while ( !item->isLoaded() )
+      Platform::sleep( 1 );
+
+   Page &page = mPages[ load.page ];
+
+   if ( !item->mData )
+   {
+      Con::errorf( "TerrainFile::_finishPageLoad - Failed to load page %d of '%s'.", load.page, mFilePath.getFullPath().c_str() );
+
+      // Don't keep trying to load it.
+      page.state = Page::Failed;
+      return;
+   }
+
+   page.data = item->mData;
+   item->mData = NULL;
+   page.state = Page::Resident;
+
+   mPageSignal.trigger( _getPageRect( load.page ) );
+}
+
+void TerrainFile::_releasePages()
+{
+   for ( U32 i=0; i < mPages.size(); i++ )
+      SAFE_DELETE( mPages[i].data );
+
+   // Any loads still running will finish into
+   // their items which are then thrown away.
+   mPages.clear();
+   mPageLoads.clear();
+
+   mPageShift = 0;
+   mPagesPerSide = 0;
+}
@@ -35,6 +35,15 @@
 #ifndef _TERRMATERIAL_H_
 #include "terrain/terrMaterial.h"
 #endif
+#ifndef _TSIGNAL_H_
+#include "core/util/tSignal.h"
+#endif
+#ifndef _THREADSAFEREFCOUNT_H_
+#include "platform/threads/threadSafeRefCount.h"
+#endif
+#ifndef _MRECT_H_
+#include "math/mRect.h"
+#endif
 
 class TerrainMaterial;
 class FileStream;
@@ -63,6 +72,26 @@ struct TerrainSquare
 };
 
 
+/// The height, layer and collision data of one page of a
+/// streamed terrain file.
+struct TerrainPageData
+{
+   /// The ( pageSize + 1 ) squared heights of the page where the
+   /// last row and column duplicate the first samples of the
+   /// neighboring pages.
+   Vector<U16> heights;
+
+   /// The pageSize squared layer indices of the page.
+   Vector<U8> layers;
+
+   /// The memory pool used by the grid map layers.
+   Vector<TerrainSquare> gridMapPool;
+
+   /// The grid map layers below the page level.
+   Vector<TerrainSquare*> gridMap;
+};
+
+
 /// NOTE:  The terrain uses 11.5 fixed point which gives
 /// us a height range from 0->2048 in 1/32 increments.
 typedef U16 TerrainHeight;
@@ -111,6 +140,91 @@ protected:
    /// The full path and name of the TerrainFile
    Torque::Path mFilePath;
 
+   /// A page of a streamed terrain file.
+   struct Page
+   {
+      enum State
+      {
+         Evicted,
+         Loading,
+         Resident,
+
+         /// The page couldn't be read and won't be requested again.
+         Failed
+      };
+
+      State state;
+
+      /// The real time in milliseconds of the last request.
+      U32 lastRequest;
+
+      /// The page data which is only valid when resident.
+      TerrainPageData *data;
+
+      Page()
+         :  state( Evicted ),
+            lastRequest( 0 ),
+            data( NULL )
+      {
+      }
+   };
+
+   /// The pages of a streamed terrain file.  This is empty if
+   /// the whole terrain was loaded into the flat maps.
+   Vector<Page> mPages;
+
+   /// The log2 of the page size in samples.
+   U32 mPageShift;
+
+   /// The number of pages along each side of the terrain.
+   U32 mPagesPerSide;
+
+   /// The file position of the first page.
+   U32 mPageDataOffset;
+
+   /// The work item which reads a page and builds its grid map.
+   class PageLoadItem;
+
+   /// A page waiting on its load.
+   struct PageLoad
+   {
+      ThreadSafeRef<PageLoadItem> item;
+      U32 page;
+   };
+
+   /// The page loads in the order they were requested.
+   Vector<PageLoad> mPageLoads;
+
+   /// @see getPageSignal
+   Signal<void( const RectI& )> mPageSignal;
+
+   /// Returns the page holding the sample.
+   const Page& _getPage( U32 x, U32 y ) const
+   {
+      return mPages[ ( x >> mPageShift ) + ( y >> mPageShift ) * mPagesPerSide ];
+   }
+
+   /// Returns the page rect in samples.
+   RectI _getPageRect( U32 page ) const;
+
+   /// The slow path of findSquare() for streamed levels.
+   TerrainSquare* _findPagedSquare( U32 level, U32 x, U32 y ) const;
+
+   /// The slow path of getHeight() which also finds samples of
+   /// evicted pages in the borders of resident neighbors.
+   U16 _getPagedHeight( U32 x, U32 y ) const;
+
+   /// Installs a finished page load.
+   void _finishPageLoad( PageLoad &load );
+
+   /// Drops all the pages and pending loads, leaving the
+   /// file with only its flat maps.
+   void _releasePages();
+
+   /// Reads the tiled file header and the pages into the flat maps
+   /// or, when streaming, only the header.
+   void _loadTiled( FileStream &stream, bool streamPages );
+
    /// The internal loading function.
    void _load( FileStream &stream );
 
@@ -131,9 +245,22 @@ public:
 
    enum Constants
    {
-      FILE_VERSION = 7
+      FILE_VERSION = 8,
+
+      /// The page size of tiled files.
+      PAGE_SIZE = 256
    };
 
+   /// If true tiled terrain files are loaded with only their
+   /// header and pages are streamed in on request.  It is
+   /// exposed to the console via $pref::Terrain::streamPages.
+   static bool smStreamPages;
+
+   /// The time in milliseconds a page stays resident after its
+   /// last request.  It is exposed to the console via
+   /// $pref::Terrain::pageEvictTime.
+   static S32 smPageEvictTime;
+
    TerrainFile();
 
    virtual ~TerrainFile();
@@ -183,6 +310,38 @@ public:
 
    U16 getMaxHeight() const { return mGridMap[mGridLevels]->maxHeight; }
 
+   /// Returns true if the pages are streamed in on request.
+   bool isStreamed() const { return !mPages.empty(); }
+
+   /// Returns the page size in samples.
+   U32 getPageSize() const { return 1 << mPageShift; }
+
+   /// Returns true if all the samples in the rect are loaded.  The
+   /// rect is clamped to the terrain and this is always true if the
+   /// file is not streamed.
+   bool isResident( const RectI &rect ) const;
+
+   /// Returns true if any page under the rect is loaded.
+   bool isAnyResident( const RectI &rect ) const;
+
+   /// Returns true if the sample is loaded.
+   bool isResident( U32 x, U32 y ) const;
+
+   /// Keeps the pages under the rect resident, queuing
+   /// loads for any which are not.
+   void requestPages( const RectI &rect );
+
+   /// Installs the finished page loads and evicts the pages
+   /// which have not been requested within smPageEvictTime.
+   void updatePages();
+
+   /// Waits for and installs all the pending page loads.
+   void flushPageLoads();
+
+   /// Triggered with the sample rect of a page when it is
+   /// loaded or evicted.
+   Signal<void( const RectI& )>& getPageSignal() { return mPageSignal; }
+
    /// Returns the constant heightmap vector.
    const Vector<U16>& getHeightMap() const { return mHeightMap; }
 
@@ -198,6 +357,10 @@ inline TerrainSquare* TerrainFile::findSquare( U32 level, U32 x, U32 y ) const
 {
    x %= mSize;
    y %= mSize;
+
+   if ( isStreamed() && level < mPageShift )
+      return _findPagedSquare( level, x, y );
+
    x >>= level;
    y >>= level;
 
@@ -206,6 +369,10 @@ inline TerrainSquare* TerrainFile::findSquare( U32 level, U32 x, U32 y ) const
 
 inline void TerrainFile::setHeight( U32 x, U32 y, U16 height )
 {
+   AssertFatal( !isStreamed(), "TerrainFile::setHeight - Streamed terrain files are read only!" );
+   if ( isStreamed() )
+      return;
+
    x %= mSize;
    y %= mSize;
    mHeightMap[ x + ( y * mSize ) ] = height;
@@ -213,6 +380,8 @@ inline void TerrainFile::setHeight( U32 x, U32 y, U16 height )
 
 inline const U16* TerrainFile::getHeightAddress( U32 x, U32 y ) const
 {
+   AssertFatal( !isStreamed(), "TerrainFile::getHeightAddress - Streamed terrain files have no flat height map!" );
+
    x %= mSize;
    y %= mSize;
    return &mHeightMap[ x + ( y * mSize ) ];
@@ -222,6 +391,10 @@ inline U16 TerrainFile::getHeight( U32 x, U32 y ) const
 {
    x %= mSize;
    y %= mSize;
+
+   if ( isStreamed() )
+      return _getPagedHeight( x, y );
+
    return mHeightMap[ x + ( y * mSize ) ];
 }
 
@@ -229,11 +402,27 @@ inline U8 TerrainFile::getLayerIndex( U32 x, U32 y ) const
 {
    x %= mSize;
    y %= mSize;
+
+   if ( isStreamed() )
+   {
+      // Evicted pages read as empty.
+      const Page &page = _getPage( x, y );
+      if ( page.state != Page::Resident )
+         return U8_MAX;
+
+      const U32 mask = getPageSize() - 1;
+      return page.data->layers[ ( x & mask ) + ( ( y & mask ) << mPageShift ) ];
+   }
+
    return mLayerMap[ x + ( y * mSize ) ];
 }
 
 inline void TerrainFile::setLayerIndex( U32 x, U32 y, U8 index )
 {
+   AssertFatal( !isStreamed(), "TerrainFile::setLayerIndex - Streamed terrain files are read only!" );
+   if ( isStreamed() )
+      return;
+
    x %= mSize;
    y %= mSize;
    mLayerMap[ x + ( y * mSize ) ] = index;
@@ -249,9 +438,7 @@ inline BaseMatInstance* TerrainFile::getMaterialMapping( U32 index ) const
 
 inline StringTableEntry TerrainFile::getMaterialName( U32 x, U32 y) const
 {
-   x %= mSize;
-   y %= mSize;
-   const U8 &index = mLayerMap[ x + ( y * mSize ) ];
+   const U8 index = getLayerIndex( x, y );
 
    if ( index < mMaterials.size() )
       return mMaterials[ index ]->getInternalName();
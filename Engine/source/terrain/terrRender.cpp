@@ -248,7 +248,13 @@ void TerrainBlock::_updateMaterials()
 
 void TerrainBlock::_updateLayerTexture()
 {
-   const U32 layerSize = mFile->mSize;
+   // Streamed files are too big to keep all their layers on the
+   // GPU, so they get a window of pages around the camera which
+   // wraps over the terrain.  The pages claim their slots in it
+   // as they are loaded.
+   mLayerTexPages = mFile->isStreamed() ? _getLayerTexPages() : 0;
+
+   const U32 layerSize = mLayerTexPages ? mLayerTexPages * mFile->getPageSize() : mFile->mSize;
    const Vector<U8> &layerMap = mFile->mLayerMap;
    const U32 pixelCount = layerMap.size();
 
@@ -261,6 +267,27 @@ void TerrainBlock::_updateLayerTexture()
                   mLayerTex.getHeight() == layerSize,
       "TerrainBlock::_updateLayerTexture - The texture size doesn't match the requested size!" );
 
+   if ( mLayerTexPages )
+   {
+      mLayerTexSlots.setSize( mLayerTexPages * mLayerTexPages );
+      for ( S32 i=0; i < mLayerTexSlots.size(); i++ )
+         mLayerTexSlots[i] = -1;
+
+      for ( U32 i=0; i < mFile->mPages.size(); i++ )
+      {
+         if ( mFile->mPages[i].state == TerrainFile::Page::Resident )
+            _claimLayerTexSlot( i );
+      }
+
+      // Drop the cells of the pages which didn't get a slot.
+      if ( mCell )
+         _updateCellPages( RectI( 0, 0, mFile->mSize, mFile->mSize ) );
+
+      return;
+   }
+
+   mLayerTexSlots.clear();
+
    // Update the layer texture.
    GFXLockedRect *lock = mLayerTex.lock();
 
@@ -290,6 +317,136 @@ void TerrainBlock::_updateLayerTexture()
    //mLayerTex->dumpToDisk( "png", "./layerTex.png" );
 }
 
+void TerrainBlock::_updateLayerTexture( const RectI &gridRect )
+{
+   PROFILE_SCOPE( TerrainBlock_updateLayerTextureRect );
+
+   RectI rect( gridRect );
+   if ( !rect.intersect( RectI( 0, 0, mFile->mSize, mFile->mSize ) ) )
+      return;
+
+   if ( !mLayerTexPages )
+   {
+      _writeLayerTexture( rect, rect.point );
+      return;
+   }
+
+   // Only copy the pages which own their slot in the window.
+   const U32 texSize = mLayerTex.getWidth();
+   const S32 x0 = rect.point.x >> mFile->mPageShift;
+   const S32 y0 = rect.point.y >> mFile->mPageShift;
+   const S32 x1 = ( rect.point.x + rect.extent.x - 1 ) >> mFile->mPageShift;
+   const S32 y1 = ( rect.point.y + rect.extent.y - 1 ) >> mFile->mPageShift;
+
+   for ( S32 py = y0; py <= y1; py++ )
+   {
+      for ( S32 px = x0; px <= x1; px++ )
+      {
+         const U32 page = px + py * mFile->mPagesPerSide;
+         if ( mLayerTexSlots[ _getLayerTexSlot( page ) ] != (S32)page )
+            continue;
+
+         RectI pageRect( rect );
+         pageRect.intersect( mFile->_getPageRect( page ) );
+         _writeLayerTexture( pageRect, Point2I( pageRect.point.x % texSize, pageRect.point.y % texSize ) );
+      }
+   }
+}
+
+void TerrainBlock::_writeLayerTexture( const RectI &gridRect, const Point2I &texPos )
+{
+   const S32 layerSize = mFile->mSize;
+
+   RectI texRect( texPos, gridRect.extent );
+   GFXLockedRect *lock = mLayerTex.lock( 0, &texRect );
+
+   for ( S32 y=0; y < gridRect.extent.y; y++ )
+   {
+      U8 *bits = lock->bits + y * lock->pitch;
+      const S32 py = gridRect.point.y + y;
+
+      for ( S32 x=0; x < gridRect.extent.x; x++ )
+      {
+         const S32 px = gridRect.point.x + x;
+         const bool right = px + 1 < layerSize && mFile->isResident( px + 1, py );
+         const bool up = py + 1 < layerSize && mFile->isResident( px, py + 1 );
+
+         // Neighbors off the terrain or in pages which
+         // are not loaded repeat the sample.
+         bits[0] = mFile->getLayerIndex( px, py );
+         bits[1] = right ? mFile->getLayerIndex( px + 1, py ) : bits[0];
+         bits[2] = up ? mFile->getLayerIndex( px, py + 1 ) : bits[0];
+         bits[3] = right && up && mFile->isResident( px + 1, py + 1 ) ? mFile->getLayerIndex( px + 1, py + 1 ) : bits[0];
+
+         bits += 4;
+      }
+   }
+
+   mLayerTex.unlock();
+}
+
+U32 TerrainBlock::_getLayerTexPages() const
+{
+   // Enough to hold the rect _requestPages() keeps loaded
+   // wherever it falls with a spare row and column, so a
+   // page never has to wait on one which is going away.
+   const U32 pageSize = mFile->getPageSize();
+   const U32 span = (U32)mCeil( smPageStreamRadius / mSquareSize ) * 2;
+   return getMin( ( span + pageSize - 1 ) / pageSize + 2, mFile->mPagesPerSide );
+}
+
+U32 TerrainBlock::_getLayerTexSlot( U32 page ) const
+{
+   const U32 px = page % mFile->mPagesPerSide;
+   const U32 py = page / mFile->mPagesPerSide;
+   return ( px % mLayerTexPages ) + ( py % mLayerTexPages ) * mLayerTexPages;
+}
+
+S32 TerrainBlock::_claimLayerTexSlot( U32 page )
+{
+   S32 &owner = mLayerTexSlots[ _getLayerTexSlot( page ) ];
+   const S32 displaced = owner == (S32)page ? -1 : owner;
+   owner = page;
+
+   const U32 texSize = mLayerTex.getWidth();
+   const RectI rect = mFile->_getPageRect( page );
+   _writeLayerTexture( rect, Point2I( rect.point.x % texSize, rect.point.y % texSize ) );
+
+   return displaced;
+}
+
+void TerrainBlock::_claimLayerTexSlots( const RectI &gridRect )
+{
+   if (  !mLayerTexPages ||
+         !gridRect.overlaps( RectI( 0, 0, mFile->mSize, mFile->mSize ) ) )
+      return;
+
+   PROFILE_SCOPE( TerrainBlock_claimLayerTexSlots );
+
+   const S32 maxPt = mFile->mSize - 1;
+   const S32 x0 = mClamp( gridRect.point.x, 0, maxPt ) >> mFile->mPageShift;
+   const S32 y0 = mClamp( gridRect.point.y, 0, maxPt ) >> mFile->mPageShift;
+   const S32 x1 = mClamp( gridRect.point.x + gridRect.extent.x - 1, 0, maxPt ) >> mFile->mPageShift;
+   const S32 y1 = mClamp( gridRect.point.y + gridRect.extent.y - 1, 0, maxPt ) >> mFile->mPageShift;
+
+   for ( S32 py = y0; py <= y1; py++ )
+   {
+      for ( S32 px = x0; px <= x1; px++ )
+      {
+         const U32 page = px + py * mFile->mPagesPerSide;
+         if (  mFile->mPages[page].state != TerrainFile::Page::Resident ||
+               mLayerTexSlots[ _getLayerTexSlot( page ) ] == (S32)page )
+            continue;
+
+         const S32 displaced = _claimLayerTexSlot( page );
+         if ( displaced != -1 )
+            _updateCellPages( mFile->_getPageRect( displaced ) );
+
+         _updateCellPages( mFile->_getPageRect( page ) );
+      }
+   }
+}
+
 bool TerrainBlock::_initBaseShader()
 {
    ShaderData *shaderData = NULL;
@@ -394,8 +551,20 @@ void TerrainBlock::_updateBaseTexture(bool writeToCache)
 
    GFX->clear( GFXClearTarget, ColorI(0,0,0,255), 1.0f, 0 );
 
-   GFX->setTexture( 0, mLayerTex );
-   mBaseShaderConsts->setSafe( mBaseLayerSizeConst, (F32)mLayerTex->getWidth() );      
+   // The layer texture window of a streamed file only holds the
+   // pages around the camera, so its base texture is blended from
+   // a layer texture which repeats the first layer.
+   GFXTexHandle layerTex( mLayerTex );
+   if ( mLayerTexPages )
+   {
+      layerTex.set( 1, 1, GFXFormatB8G8R8A8, &TerrainLayerTexProfile, "" );
+      GFXLockedRect *lock = layerTex.lock();
+      dMemset( lock->bits, 0, 4 );
+      layerTex.unlock();
+   }
+
+   GFX->setTexture( 0, layerTex );
+   mBaseShaderConsts->setSafe( mBaseLayerSizeConst, (F32)layerTex->getWidth() );      
 
    for ( U32 i=0; i < mBaseTextures.size(); i++ )
    {
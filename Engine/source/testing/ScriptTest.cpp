@@ -28,6 +28,7 @@
 #include "math/mMath.h"
 #include "console/script.h"
 #include "console/stringStack.h"
+#include "platform/platformTimer.h"
 #include "gui/buttons/guiIconButtonCtrl.h"
 
 inline ConsoleValue RunScript(const char* str)
@@ -1160,3 +1161,289 @@ TEST_F(ScriptTest, RegressionString)
 
    ASSERT_STREQ(regression2.getString(), "120 20");
 }
+
+TEST_F(ScriptTest, CallSiteCache_Invalidation)
+{
+   // The same call site has to see redefinitions and packages.
+   ConsoleValue first = RunScript(R"(
+      function callSiteTarget() { return 1; }
+      function callSiteCaller() { return callSiteTarget(); }
+      return callSiteCaller();
+   )");
+
+   ASSERT_EQ(first.getInt(), 1);
+
+   ConsoleValue redefined = RunScript(R"(
+      function callSiteTarget() { return 2; }
+      return callSiteCaller();
+   )");
+
+   ASSERT_EQ(redefined.getInt(), 2);
+
+   ConsoleValue packaged = RunScript(R"(
+      package callSitePackage
+      {
+         function callSiteTarget() { return 3; }
+      };
+      activatePackage(callSitePackage);
+      %result = callSiteCaller();
+      deactivatePackage(callSitePackage);
+      return %result @ callSiteCaller();
+   )");
+
+   ASSERT_STREQ(packaged.getString(), "32");
+}
+
+TEST_F(ScriptTest, CallSiteCache_Polymorphic)
+{
+   // More classes through one method call site than the cache holds.
+   ConsoleValue value = RunScript(R"(
+      function CallSiteBase::getValue(%this) { return 1000; }
+      function CallSiteA::getValue(%this) { return 1; }
+      function CallSiteB::getValue(%this) { return 2; }
+      function CallSiteC::getValue(%this) { return 3; }
+      function CallSiteD::getValue(%this) { return 4; }
+      function CallSiteE::getValue(%this) { return 5; }
+      function CallSiteF::getValue(%this) { return 6 + Parent::getValue(%this); }
+
+      %classes = "CallSiteA CallSiteB CallSiteC CallSiteD CallSiteE CallSiteF";
+      for (%i = 0; %i < 6; %i++)
+         %obj[%i] = new ScriptObject() { class = getWord(%classes, %i); superClass = "CallSiteBase"; };
+
+      %sum = 0;
+      for (%pass = 0; %pass < 3; %pass++)
+      {
+         for (%i = 0; %i < 6; %i++)
+            %sum += %obj[%i].getValue();
+      }
+
+      for (%i = 0; %i < 6; %i++)
+         %obj[%i].delete();
+
+      return %sum;
+   )");
+
+   ASSERT_EQ(value.getInt(), 3 * (1 + 2 + 3 + 4 + 5 + 6 + 1000));
+}
+
+TEST_F(ScriptTest, CallSiteCache_Benchmark)
+{
+   RunScript(R"(
+      function benchAdd(%a, %b) { return %a + %b; }
+      function BenchCalls::add(%this, %a, %b) { return %a + %b; }
+      new ScriptObject(BenchCallsObject) { class = "BenchCalls"; };
+   )");
+
+   const char* scripts[][2] =
+   {
+      { "function", "%x = 0; for (%i = 0; %i < 200000; %i++) %x = benchAdd(%x, 1); return %x;" },
+      { "static",   "%x = 0; for (%i = 0; %i < 200000; %i++) %x = BenchCalls::add(0, %x, 1); return %x;" },
+      { "method",   "%o = BenchCallsObject; %x = 0; for (%i = 0; %i < 200000; %i++) %x = %o.add(%x, 1); return %x;" },
+      { "engine",   "%x = 0; for (%i = 0; %i < 200000; %i++) %x = mAbs(%x) + 1; return %x;" },
+   };
+
+   PlatformTimer* timer = PlatformTimer::create();
+   for (U32 i = 0; i < sizeof(scripts) / sizeof(scripts[0]); i++)
+   {
+      timer->reset();
+      ConsoleValue value = RunScript(scripts[i][1]);
+      const S32 ms = timer->getElapsedMs();
+
+      EXPECT_EQ(value.getInt(), 200000) << scripts[i][0];
+      Con::printf("ScriptTest: 200000 %s calls: %5dms", scripts[i][0], ms);
+   }
+   delete timer;
+
+   RunScript("BenchCallsObject.delete();");
+}
+
+TEST_F(ScriptTest, Superinstructions)
+{
+   ConsoleValue locals = RunScript(R"(
+      function superTest(%a, %b)
+      {
+         %r = (%a + %b) @ " " @ (%a - %b) @ " " @ (%a * %b) @ " " @ (%a / %b);
+         return %r @ " " @ (%a < %b) @ (%a > %b) @ (%a <= %b) @ (%a >= %b) @ (%a == %b) @ (%a != %b);
+      }
+      return superTest(8, "2") @ "|" @ superTest("1.5", 0.5);
+   )");
+
+   ASSERT_STREQ(locals.getString(), "10 6 16 4 010101|2 1 0.75 3 010101");
+
+   // The right hand side is a string here, so the fused op takes its slow path.
+   ConsoleValue slowPath = RunScript(R"(
+      %a = 5;
+      return %a * getWord("1 3", 1);
+   )");
+
+   ASSERT_EQ(slowPath.getInt(), 15);
+
+   ConsoleValue globals = RunScript(R"(
+      $superGlobal = 6;
+      %a = 8;
+      return ($superGlobal - %a) @ " " @ ($superGlobal % 4) @ " " @ $superGlobal @ "x";
+   )");
+
+   ASSERT_STREQ(globals.getString(), "-2 2 6x");
+}
+
+TEST_F(ScriptTest, Interpreter_Benchmark)
+{
+   // Build with TORQUE_SCRIPT_NO_COMPUTED_GOTO defined to compare against the
+   // plain switch dispatch.
+   const U32 iterations = 500000;
+   const char* scripts[][2] =
+   {
+      { "local math",  "%x = 0; for (%i = 0; %i < 500000; %i++) %x = %x * 0.5 + %i; return %i;" },
+      { "global load", "$benchG = 3; %x = 0; for (%i = 0; %i < 500000; %i++) %x = %x + $benchG; return %i;" },
+      { "compare",     "%c = 0; for (%i = 0; %i < 500000; %i++) if (%i >= 250000) %c++; return %i;" },
+      { "string",      "%s = \"\"; for (%i = 0; %i < 500000; %i++) %s = %i @ \"x\"; return %i;" },
+   };
+
+   PlatformTimer* timer = PlatformTimer::create();
+   for (U32 i = 0; i < sizeof(scripts) / sizeof(scripts[0]); i++)
+   {
+      timer->reset();
+      ConsoleValue value = RunScript(scripts[i][1]);
+      const S32 ms = getMax(timer->getElapsedMs(), 1);
+
+      EXPECT_EQ(value.getInt(), iterations) << scripts[i][0];
+      Con::printf("ScriptTest: %-11s %5dms, %.2f million iterations/sec", scripts[i][0], ms, iterations / (ms * 1000.0f));
+   }
+   delete timer;
+}
+
+TEST_F(ScriptTest, Optimizer_SemanticEquivalence)
+{
+   const char* scripts[] =
+   {
+      // Constant folding
+      R"(return ((1 + 2) * 3) @ " " @ (7 % 3) @ " " @ (1 << 4) @ " " @ (5 || 0) @ (0 && 3) @ (2 && 3) @ " " @ (!0) @ (~5) @ (!1.5);)",
+      R"(return (1 / 3) @ " " @ (2 - 5) @ " " @ ((2 - 5) % 4) @ " " @ (1 / 0) @ " " @ (0.1 + 0.2) @ " " @ (1 < 2) @ (2.5 >= 3) @ (4 != 4.0);)",
+      R"(return ("a" @ "b") @ ("c" SPC "d") @ ("e" TAB "f") @ ("g" NL "h") @ ("x" @ "y" @ "z");)",
+
+      // Jump threading through nested if/else chains, break and continue
+      R"(
+         function optNested(%n)
+         {
+            %r = "";
+            for (%i = 0; %i < %n; %i++)
+            {
+               if (%i % 3 == 0)
+               {
+                  if (%i % 2 == 0)
+                     %r = %r @ "a";
+                  else
+                     %r = %r @ "b";
+               }
+               else if (%i % 3 == 1)
+                  %r = %r @ "c";
+               else
+               {
+                  if (%i > 7)
+                     break;
+                  continue;
+               }
+               %r = %r @ %i;
+            }
+            return %r;
+         }
+         return optNested(20) @ "|" @ (true ? (false ? 1 : 2) : 3);
+      )",
+
+      // In-place string appends
+      R"(
+         function optAppend()
+         {
+            %s = 5;
+            %s = %s @ "x";
+            %s = %s SPC getWord("a b c", 1) TAB 1.5 NL %s;
+            %t = (%s = %s @ "y");
+            %u = "p";
+            %u = %u @ %u;
+            %u = %u @ (%u @ "q");
+            for (%i = 0; %i < 5; %i++)
+               %v = %v @ %i @ ",";
+            return %s @ "|" @ %t @ "|" @ %u @ "|" @ %v;
+         }
+         return optAppend();
+      )",
+
+      // Dead stores still evaluate their side effects
+      R"(
+         function optSideEffect() { $optCalls++; return 7; }
+         function optDeadStore()
+         {
+            %unused = optSideEffect();
+            %unused2 = 3;
+            return $optCalls;
+         }
+         $optCalls = 0;
+         return optDeadStore() @ optDeadStore();
+      )",
+
+      // Each function body keeps the stores it reads
+      R"(
+         function optReadFirst() { %x = 4; return %x; }
+         $optBetween = 2;
+         function optReadSecond() { %y = optReadFirst(); %x = %y + 1; return %x @ %y; }
+         return optReadSecond();
+      )",
+   };
+
+   for (U32 i = 0; i < sizeof(scripts) / sizeof(scripts[0]); i++)
+   {
+      Con::setIntVariable("$Con::optimizeLevel", 0);
+      ConsoleValue plain = RunScript(scripts[i]);
+      const String expected = plain.getString();
+
+      Con::setIntVariable("$Con::optimizeLevel", 2);
+      ConsoleValue optimized = RunScript(scripts[i]);
+
+      EXPECT_STREQ(optimized.getString(), expected.c_str()) << scripts[i];
+   }
+   Con::setIntVariable("$Con::optimizeLevel", 1);
+
+   ConsoleValue append = RunScript(R"(return optAppend();)");
+   ASSERT_STREQ(append.getString(), "5x b\t1.5\n5xy|5x b\t1.5\n5xy|pppq|0,1,2,3,4,");
+
+   ConsoleValue deadStore = RunScript(R"($optCalls = 0; return optDeadStore();)");
+   ASSERT_EQ(deadStore.getInt(), 1);
+
+   // Separate console snippets share their locals, so a store outside of a
+   // function body is kept even though nothing in its own compile reads it.
+   Con::setIntVariable("$Con::optimizeLevel", 2);
+   RunScript(R"(%optShared = 5;)");
+   ConsoleValue shared = RunScript(R"(return %optShared;)");
+   Con::setIntVariable("$Con::optimizeLevel", 1);
+   ASSERT_EQ(shared.getInt(), 5);
+}
+
+TEST_F(ScriptTest, Optimizer_AppendBenchmark)
+{
+   const char* script = R"(
+      function optBuildString(%n)
+      {
+         %s = "";
+         for (%i = 0; %i < %n; %i++)
+            %s = %s @ "item" SPC %i @ ",";
+         return strlen(%s);
+      }
+      return optBuildString(20000);
+   )";
+
+   PlatformTimer* timer = PlatformTimer::create();
+   S32 lengths[2];
+   for (S32 level = 0; level < 2; level++)
+   {
+      Con::setIntVariable("$Con::optimizeLevel", level);
+
+      timer->reset();
+      lengths[level] = RunScript(script).getInt();
+      Con::printf("ScriptTest: building a %d character string at $Con::optimizeLevel %d: %5dms", lengths[level], level, timer->getElapsedMs());
+   }
+   delete timer;
+   Con::setIntVariable("$Con::optimizeLevel", 1);
+
+   EXPECT_EQ(lengths[0], lengths[1]);
+}
@@ -0,0 +1,119 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "core/frameAllocator.h"
+#include "platform/threads/jobSystem.h"
+#include "platform/platformIntrinsics.h"
+
+FIXTURE(FrameAllocator)
+{
+public:
+   struct FillItem
+   {
+      U32 mId;
+      volatile U32* mNumCorrupted;
+   };
+
+   // Fills a frame allocation with its id, gives other jobs a chance to
+   // run and then checks nobody else wrote to it.
+   static void fillAndCheck(void* data)
+   {
+      FillItem* item = (FillItem*)data;
+      const U32 count = 4096;
+
+      FrameAllocatorMarker mem;
+      U32* values = mem.alloc<U32>(count);
+      for (U32 i = 0; i < count; i++)
+         values[i] = item->mId;
+
+      Platform::sleep(0);
+
+      for (U32 i = 0; i < count; i++)
+      {
+         if (values[i] != item->mId)
+         {
+            dFetchAndAdd(*item->mNumCorrupted, 1);
+            break;
+         }
+      }
+   }
+
+   // Allocates without restoring the watermark.
+   static void leak(void*)
+   {
+      FrameAllocator::alloc(1024);
+   }
+};
+
+TEST_FIX(FrameAllocator, PerThreadArenas)
+{
+   const U32 numItems = 256;
+   volatile U32 numCorrupted = 0;
+
+   FillItem items[numItems];
+   JobSystem& jobs = JobSystem::GLOBAL();
+   JobSystem::JobRef group = jobs.createJob();
+   for (U32 i = 0; i < numItems; i++)
+   {
+      items[i].mId = i;
+      items[i].mNumCorrupted = &numCorrupted;
+      jobs.run(jobs.createJob(&fillAndCheck, &items[i], group));
+   }
+
+   jobs.run(group);
+   jobs.waitForJob(group);
+
+   EXPECT_EQ(dAtomicRead(numCorrupted), 0U);
+}
+
+TEST_FIX(FrameAllocator, WaterMarkRestoredAfterJob)
+{
+   FrameAllocatorMarker mem;
+   mem.alloc(16);
+   const U32 waterMark = FrameAllocator::getWaterMark();
+
+   JobSystem& jobs = JobSystem::GLOBAL();
+   JobSystem::JobRef group = jobs.createJob();
+   for (U32 i = 0; i < 64; i++)
+      jobs.run(jobs.createJob(&leak, NULL, group));
+
+   jobs.run(group);
+   jobs.waitForJob(group);
+
+   // Whatever ran on this thread has been cleaned up.
+   EXPECT_EQ(FrameAllocator::getWaterMark(), waterMark);
+}
+
+TEST_FIX(FrameAllocator, PeakWaterMark)
+{
+   FrameAllocator::resetStats();
+   const U32 start = FrameAllocator::getWaterMark();
+
+   {
+      FrameAllocatorMarker mem;
+      mem.alloc(1000);
+   }
+
+   EXPECT_EQ(FrameAllocator::getWaterMark(), start);
+   EXPECT_GE(FrameAllocator::getMaxFrameAllocation(), start + 1000);
+}
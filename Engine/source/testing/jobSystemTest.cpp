@@ -0,0 +1,201 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "platform/threads/jobSystem.h"
+#include "platform/platformIntrinsics.h"
+#include "core/util/tVector.h"
+
+FIXTURE(JobSystem)
+{
+public:
+   // Sets an element in a result vector to its index.
+   struct TestItem
+   {
+      U32 mIndex;
+      Vector<U32>* mResults;
+   };
+
+   static void setResult(void* data)
+   {
+      TestItem* item = (TestItem*)data;
+      (*item->mResults)[item->mIndex] = item->mIndex;
+   }
+
+   // Records the order in which jobs were executed.
+   struct OrderItem
+   {
+      U32 mId;
+      volatile U32* mCounter;
+      U32 mOrder;
+   };
+
+   static void recordOrder(void* data)
+   {
+      OrderItem* item = (OrderItem*)data;
+
+      // Give the other jobs a chance to run out of order.
+      Platform::sleep(item->mId == 0 ? 50 : 0);
+
+      U32 order;
+      do
+      {
+         order = *item->mCounter;
+      }
+      while (!dCompareAndSwap(*item->mCounter, order, order + 1));
+      item->mOrder = order;
+   }
+
+   static void increment(void* data)
+   {
+      dFetchAndAdd(*(volatile U32*)data, 1);
+   }
+
+   // Spawns children from inside a job and waits on them there.
+   static void spawnAndWait(void* data)
+   {
+      JobSystem& jobs = JobSystem::GLOBAL();
+
+      JobSystem::JobRef group = jobs.createJob();
+      for (U32 i = 0; i < 32; i++)
+         jobs.run(jobs.createJob(&increment, data, group));
+
+      jobs.run(group);
+      jobs.waitForJob(group);
+   }
+};
+
+TEST_FIX(JobSystem, ParentWaitsForChildren)
+{
+   const U32 numItems = 100;
+   Vector<U32> results(__FILE__, __LINE__);
+   results.setSize(numItems);
+
+   Vector<TestItem> items(__FILE__, __LINE__);
+   items.setSize(numItems);
+
+   JobSystem& jobs = JobSystem::GLOBAL();
+   JobSystem::JobRef group = jobs.createJob();
+   for (U32 i = 0; i < numItems; i++)
+   {
+      results[i] = U32(-1);
+      items[i].mIndex = i;
+      items[i].mResults = &results;
+      jobs.run(jobs.createJob(&setResult, &items[i], group));
+   }
+
+   jobs.run(group);
+   jobs.waitForJob(group);
+
+   EXPECT_TRUE(group->isFinished());
+   for (U32 i = 0; i < numItems; i++)
+      EXPECT_EQ(results[i], i) << "result mismatch";
+}
+
+TEST_FIX(JobSystem, Dependencies)
+{
+   // Diamond: 0 -> (1, 2) -> 3.
+   volatile U32 counter = 0;
+   OrderItem items[4];
+   for (U32 i = 0; i < 4; i++)
+   {
+      items[i].mId = i;
+      items[i].mCounter = &counter;
+      items[i].mOrder = U32(-1);
+   }
+
+   JobSystem& jobs = JobSystem::GLOBAL();
+   JobSystem::JobRef job[4];
+   for (U32 i = 0; i < 4; i++)
+      job[i] = jobs.createJob(&recordOrder, &items[i]);
+
+   jobs.addDependency(job[1], job[0]);
+   jobs.addDependency(job[2], job[0]);
+   jobs.addDependency(job[3], job[1]);
+   jobs.addDependency(job[3], job[2]);
+
+   // Run in reverse to make sure nothing starts early.
+   for (S32 i = 3; i >= 0; i--)
+      jobs.run(job[i]);
+
+   jobs.waitForJob(job[3]);
+
+   EXPECT_EQ(items[0].mOrder, 0U);
+   EXPECT_GT(items[1].mOrder, items[0].mOrder);
+   EXPECT_GT(items[2].mOrder, items[0].mOrder);
+   EXPECT_EQ(items[3].mOrder, 3U);
+}
+
+TEST_FIX(JobSystem, WaitInsideJob)
+{
+   const U32 numSpawners = 16;
+   volatile U32 counter = 0;
+
+   JobSystem& jobs = JobSystem::GLOBAL();
+   JobSystem::JobRef group = jobs.createJob();
+   for (U32 i = 0; i < numSpawners; i++)
+      jobs.run(jobs.createJob(&spawnAndWait, (void*)&counter, group));
+
+   jobs.run(group);
+   jobs.waitForJob(group);
+
+   EXPECT_EQ(dAtomicRead(counter), numSpawners * 32);
+}
+
+TEST_FIX(JobSystem, WaitBlocksUntilFinished)
+{
+   // A single slow job and one worker.  The waiting thread either runs
+   // it itself or has nothing to take and blocks until the worker is done.
+   JobSystem jobs("JobSystemTest", 1);
+
+   volatile U32 counter = 0;
+   OrderItem item;
+   item.mId = 0;
+   item.mCounter = &counter;
+   item.mOrder = U32(-1);
+
+   JobSystem::JobRef group = jobs.createJob();
+   jobs.run(jobs.createJob(&recordOrder, &item, group));
+   jobs.run(group);
+   jobs.waitForJob(group);
+
+   EXPECT_TRUE(group->isFinished());
+   EXPECT_EQ(item.mOrder, 0U);
+}
+
+TEST_FIX(JobSystem, RunAfterShutdown)
+{
+   // Without workers the waiting thread runs everything itself.
+   JobSystem jobs("JobSystemTest", 2);
+   jobs.shutdown();
+   EXPECT_EQ(jobs.getNumThreads(), 0U);
+
+   volatile U32 counter = 0;
+   JobSystem::JobRef group = jobs.createJob();
+   for (U32 i = 0; i < 8; i++)
+      jobs.run(jobs.createJob(&increment, (void*)&counter, group));
+
+   jobs.run(group);
+   jobs.waitForJob(group);
+
+   EXPECT_EQ(dAtomicRead(counter), 8U);
+}
@@ -0,0 +1,148 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "platform/platform.h"
+#include "core/volume.h"
+#include "core/stream/fileStream.h"
+#include "ts/tsShape.h"
+#include "ts/tsMesh.h"
+
+FIXTURE(MappedFile)
+{
+public:
+   static const U32 numBytes = 10000;
+   const char *mFileName = "mappedFileTest.bin";
+
+   void SetUp() override
+   {
+      FileStream fs;
+      ASSERT_TRUE(fs.open(mFileName, Torque::FS::File::Write));
+      for (U32 i = 0; i < numBytes; i++)
+         fs.write(U8(i * 7));
+      fs.close();
+   }
+
+   void TearDown() override
+   {
+      dFileDelete(mFileName);
+   }
+};
+
+TEST_FIX(MappedFile, Contents)
+{
+   Torque::FS::MappedFileRef file = Torque::FS::MapFile(mFileName);
+   ASSERT_TRUE(file != NULL);
+   ASSERT_EQ(file->getSize(), (U32)numBytes);
+
+   const U8 *data = file->getData();
+   for (U32 i = 0; i < numBytes; i++)
+      ASSERT_EQ(data[i], U8(i * 7)) << "Wrong byte at " << i;
+}
+
+TEST_FIX(MappedFile, CopyOnWrite)
+{
+   {
+      Torque::FS::MappedFileRef file = Torque::FS::MapFile(mFileName);
+      ASSERT_TRUE(file != NULL);
+      dMemset(file->getData(), 0xFF, file->getSize());
+   }
+
+   Torque::FS::MappedFileRef file = Torque::FS::MapFile(mFileName);
+   ASSERT_TRUE(file != NULL);
+   EXPECT_EQ(file->getData()[1], U8(7))
+      << "Writing to a mapping should not change the file";
+}
+
+TEST_FIX(MappedFile, MissingFile)
+{
+   EXPECT_TRUE(Torque::FS::MapFile("mappedFileTestMissing.bin") == NULL);
+}
+
+TEST(MappedShape, SaveOverItself)
+{
+   const char *srcName = "tools/shapes/unit_sphere.dts";
+   const char *fileName = "mappedShapeTest.dts";
+
+   FileStream srcStream;
+   if (!srcStream.open(srcName, Torque::FS::File::Read))
+      GTEST_SKIP() << "Needs " << srcName;
+
+   // Resave in the current version so the vertex data can be mapped
+   TSShape *src = new TSShape;
+   ASSERT_TRUE(src->read(&srcStream));
+   srcStream.close();
+   {
+      FileStream fs;
+      ASSERT_TRUE(fs.open(fileName, Torque::FS::File::Write));
+      src->write(&fs);
+   }
+   ASSERT_GT(src->mShapeVertexData.size, 0U);
+
+   Vector<U8> expected;
+   expected.setSize(src->mShapeVertexData.size);
+   dMemcpy(expected.address(), src->mShapeVertexData.base, expected.size());
+   delete src;
+
+   Torque::FS::MappedFileRef file = Torque::FS::MapFile(fileName);
+   ASSERT_TRUE(file != NULL);
+   TSShape *shape = new TSShape;
+   ASSERT_TRUE(shape->read(file));
+   file = NULL;
+   EXPECT_TRUE(shape->mMappedFile != NULL) << "Vertex data should be used from the mapping";
+
+   // Writing truncates the file under the mapping
+   TSShape::releaseMappedFiles(fileName);
+   EXPECT_TRUE(shape->mMappedFile == NULL);
+   {
+      FileStream fs;
+      ASSERT_TRUE(fs.open(fileName, Torque::FS::File::Write));
+      shape->write(&fs);
+   }
+
+   ASSERT_EQ(shape->mShapeVertexData.size, (U32)expected.size());
+   EXPECT_EQ(dMemcmp(shape->mShapeVertexData.base, expected.address(), expected.size()), 0);
+
+   U8 *start = shape->mShapeVertexData.base;
+   U8 *end = start + shape->mShapeVertexData.size;
+   for (S32 i = 0; i < shape->meshes.size(); i++)
+   {
+      TSMesh *mesh = shape->meshes[i];
+      if (!mesh || mesh->mVertexData.size() == 0)
+         continue;
+      U8 *ptr = (U8*)mesh->mVertexData.address();
+      EXPECT_TRUE(ptr >= start && ptr < end) << "Mesh " << i << " still points at the old mapping";
+   }
+   delete shape;
+
+   // And the file written over the mapping reads back the same
+   file = Torque::FS::MapFile(fileName);
+   ASSERT_TRUE(file != NULL);
+   TSShape *reread = new TSShape;
+   ASSERT_TRUE(reread->read(file));
+   file = NULL;
+   ASSERT_EQ(reread->mShapeVertexData.size, (U32)expected.size());
+   EXPECT_EQ(dMemcmp(reread->mShapeVertexData.base, expected.address(), expected.size()), 0);
+   delete reread;
+
+   dFileDelete(fileName);
+}
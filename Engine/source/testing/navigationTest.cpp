@@ -0,0 +1,330 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifdef TORQUE_NAVIGATION_ENABLED
+#include "testing/unitTesting.h"
+#include "navigation/navMesh.h"
+#include "navigation/navPathScheduler.h"
+#include "platform/platformTimer.h"
+#include "platform/threads/jobSystem.h"
+#include "console/simSet.h"
+
+/// Rolling ground that gives the navmesh something to chew on.
+class NavMeshTestGround : public SceneObject
+{
+   typedef SceneObject Parent;
+public:
+   bool onAdd()
+   {
+      if (!Parent::onAdd())
+         return false;
+
+      mTypeMask |= StaticObjectType;
+      mObjBox.set(Point3F(-1000.0f, -1000.0f, -10.0f), Point3F(1000.0f, 1000.0f, 10.0f));
+      resetWorldBox();
+      addToScene();
+      return true;
+   }
+
+   void onRemove()
+   {
+      removeFromScene();
+      Parent::onRemove();
+   }
+
+   static F32 getHeight(F32 x, F32 y)
+   {
+      return mSin(x * 0.3f) * mCos(y * 0.2f) * 2.0f + mSin(x * 0.05f + y * 0.07f) * 5.0f;
+   }
+
+   virtual bool buildPolyList(PolyListContext context, AbstractPolyList* polyList, const Box3F& box, const SphereF& sphere)
+   {
+      if (context != PLC_Navigation)
+         return false;
+
+      polyList->setObject(this);
+      polyList->setTransform(&MatrixF::Identity, Point3F(1.0f, 1.0f, 1.0f));
+
+      const F32 step = 0.5f;
+      const S32 minX = mFloor(box.minExtents.x / step), maxX = mCeil(box.maxExtents.x / step);
+      const S32 minY = mFloor(box.minExtents.y / step), maxY = mCeil(box.maxExtents.y / step);
+
+      for (S32 y = minY; y < maxY; y++)
+      {
+         for (S32 x = minX; x < maxX; x++)
+         {
+            const F32 x0 = x * step, x1 = (x + 1) * step;
+            const F32 y0 = y * step, y1 = (y + 1) * step;
+
+            const U32 v0 = polyList->addPoint(Point3F(x0, y1, getHeight(x0, y1)));
+            polyList->addPoint(Point3F(x1, y1, getHeight(x1, y1)));
+            polyList->addPoint(Point3F(x1, y0, getHeight(x1, y0)));
+            polyList->addPoint(Point3F(x0, y0, getHeight(x0, y0)));
+
+            polyList->begin(0, 0);
+            polyList->vertex(v0);
+            polyList->vertex(v0 + 1);
+            polyList->vertex(v0 + 2);
+            polyList->plane(v0, v0 + 1, v0 + 2);
+            polyList->end();
+
+            polyList->begin(0, 1);
+            polyList->vertex(v0 + 2);
+            polyList->vertex(v0 + 3);
+            polyList->vertex(v0);
+            polyList->plane(v0 + 2, v0 + 3, v0);
+            polyList->end();
+         }
+      }
+
+      return true;
+   }
+};
+
+class NavMeshTestVariant : public NavMesh
+{
+public:
+   const dtNavMesh* getDetourMesh() { return getNavMesh(); }
+};
+
+FIXTURE(NavMeshBuild)
+{
+public:
+   SimGroup* mGroup;
+   NavMeshTestVariant* mMesh;
+
+   struct TileResult
+   {
+      S32 x, y;
+      S32 polyCount;
+      Vector<U8> data;
+   };
+
+   void SetUp() override
+   {
+      mGroup = new SimGroup();
+      mGroup->registerObject();
+
+      NavMeshTestGround* ground = new NavMeshTestGround();
+      ground->registerObject();
+      mGroup->addObject(ground);
+
+      mMesh = new NavMeshTestVariant();
+      mMesh->registerObject();
+      mGroup->addObject(mMesh);
+   }
+
+   void TearDown() override
+   {
+      NavPathScheduler::destroy();
+      NavMesh::smTileBuildBatch = 0;
+      mGroup->deleteObject();
+   }
+
+   /// Builds the navmesh over a size x size area and returns the time it took.
+   U32 build(F32 size, S32 batch)
+   {
+      mMesh->setScale(Point3F(size, size, 40.0f));
+      NavMesh::smTileBuildBatch = batch;
+
+      PlatformTimer* timer = PlatformTimer::create();
+      mMesh->build(false);
+      const U32 elapsed = timer->getElapsedMs();
+      delete timer;
+
+      return elapsed;
+   }
+
+   Vector<NavPathScheduler::RequestId> mPlannedIds;
+   Vector<NavPathScheduler::Result> mPlanned;
+
+   void onPlanned(NavPathScheduler::RequestId id, const NavPathScheduler::Result& result)
+   {
+      mPlannedIds.push_back(id);
+      mPlanned.push_back(result);
+   }
+
+   NavPathScheduler::RequestId request(const Point2F& from, const Point2F& to, S32 priority = 0)
+   {
+      dtQueryFilter filter;
+      filter.setIncludeFlags(LinkData(AllFlags).getFlags());
+      return NavPathScheduler::get()->request(mMesh,
+         Point3F(from.x, from.y, NavMeshTestGround::getHeight(from.x, from.y) + 1.0f),
+         Point3F(to.x, to.y, NavMeshTestGround::getHeight(to.x, to.y) + 1.0f),
+         filter, priority, NavPathScheduler::Callback(this, &NavMeshBuildFixture::onPlanned));
+   }
+
+   void getTiles(Vector<TileResult>& tiles)
+   {
+      const dtNavMesh* nm = mMesh->getDetourMesh();
+      for (S32 i = 0; i < nm->getMaxTiles(); i++)
+      {
+         const dtMeshTile* tile = nm->getTile(i);
+         if (!tile->header)
+            continue;
+
+         tiles.increment();
+         TileResult& result = tiles.last();
+         result.x = tile->header->x;
+         result.y = tile->header->y;
+         result.polyCount = tile->header->polyCount;
+         result.data.setSize(tile->dataSize);
+         dMemcpy(result.data.address(), tile->data, tile->dataSize);
+      }
+   }
+};
+
+TEST_FIX(NavMeshBuild, ParallelMatchesSerial)
+{
+   // One tile at a time, through the serial path.
+   build(60.0f, 1);
+   Vector<TileResult> serial;
+   getTiles(serial);
+   ASSERT_GT(serial.size(), 1);
+
+   // Every tile in one batch.
+   build(60.0f, 1000);
+   Vector<TileResult> parallel;
+   getTiles(parallel);
+   ASSERT_EQ(parallel.size(), serial.size());
+
+   const dtNavMesh* nm = mMesh->getDetourMesh();
+   for (S32 i = 0; i < serial.size(); i++)
+   {
+      const TileResult& expected = serial[i];
+      const dtMeshTile* tile = nm->getTileAt(expected.x, expected.y, 0);
+      ASSERT_TRUE(tile != NULL && tile->header != NULL);
+      EXPECT_EQ(tile->header->polyCount, expected.polyCount);
+      ASSERT_EQ(tile->dataSize, expected.data.size());
+      EXPECT_EQ(dMemcmp(tile->data, expected.data.address(), tile->dataSize), 0);
+   }
+}
+
+TEST_FIX(NavMeshBuild, SchedulerPaths)
+{
+   build(60.0f, 0);
+   NavPathScheduler* scheduler = NavPathScheduler::get();
+
+   const Point2F ends[][2] = {
+      { Point2F(-20.0f, -20.0f), Point2F(20.0f, 20.0f) },
+      { Point2F(-20.0f, 20.0f), Point2F(20.0f, -20.0f) },
+      { Point2F(0.0f, -25.0f), Point2F(0.0f, 25.0f) },
+   };
+   const U32 count = sizeof(ends) / sizeof(ends[0]);
+
+   for (U32 i = 0; i < count; i++)
+      request(ends[i][0], ends[i][1]);
+   EXPECT_EQ(scheduler->getStats().queueDepth, count);
+
+   EXPECT_EQ(scheduler->process(1000.0f), count);
+   ASSERT_EQ(mPlanned.size(), count);
+
+   for (U32 i = 0; i < count; i++)
+   {
+      const NavPathScheduler::Result& result = mPlanned[i];
+      ASSERT_TRUE(result.success);
+      ASSERT_GT(result.points.size(), 1);
+      EXPECT_EQ(result.flags.size(), result.points.size());
+      EXPECT_LT((Point2F(result.points.first().x, result.points.first().y) - ends[i][0]).len(), 1.0f);
+      EXPECT_LT((Point2F(result.points.last().x, result.points.last().y) - ends[i][1]).len(), 1.0f);
+      EXPECT_GE(result.length, (ends[i][1] - ends[i][0]).len() - 2.0f);
+   }
+
+   const NavPathScheduler::Stats stats = scheduler->getStats();
+   EXPECT_EQ(stats.queueDepth, 0);
+   EXPECT_EQ(stats.numPlanned, count);
+   EXPECT_EQ(stats.numCacheHits, 0);
+}
+
+TEST_FIX(NavMeshBuild, SchedulerCache)
+{
+   build(60.0f, 0);
+   NavPathScheduler* scheduler = NavPathScheduler::get();
+
+   const Point2F from(-20.0f, -20.0f), to(20.0f, 20.0f);
+   request(from, to);
+   scheduler->process(1000.0f);
+   request(from, to);
+   scheduler->process(1000.0f);
+
+   // The second request reuses the corridor and ends up on the same path.
+   ASSERT_EQ(mPlanned.size(), 2);
+   EXPECT_EQ(scheduler->getStats().numCacheHits, 1);
+   EXPECT_FLOAT_EQ(scheduler->getStats().getCacheHitRate(), 0.5f);
+   ASSERT_EQ(mPlanned[1].points.size(), mPlanned[0].points.size());
+   for (S32 i = 0; i < mPlanned[0].points.size(); i++)
+      EXPECT_TRUE(mPlanned[1].points[i].equal(mPlanned[0].points[i]));
+
+   // Rebuilding the mesh invalidates the corridor.
+   build(60.0f, 0);
+   request(from, to);
+   scheduler->process(1000.0f);
+   ASSERT_EQ(mPlanned.size(), 3);
+   EXPECT_TRUE(mPlanned[2].success);
+   EXPECT_EQ(scheduler->getStats().numCacheHits, 1);
+
+   // And the corridor found on the new mesh is cached in turn.
+   request(from, to);
+   scheduler->process(1000.0f);
+   ASSERT_EQ(mPlanned.size(), 4);
+   EXPECT_TRUE(mPlanned[3].success);
+   EXPECT_EQ(scheduler->getStats().numCacheHits, 2);
+}
+
+TEST_FIX(NavMeshBuild, SchedulerPriority)
+{
+   build(60.0f, 0);
+   NavPathScheduler* scheduler = NavPathScheduler::get();
+
+   const NavPathScheduler::RequestId low = request(Point2F(-20.0f, 0.0f), Point2F(20.0f, 0.0f), 0);
+   const NavPathScheduler::RequestId high = request(Point2F(0.0f, -20.0f), Point2F(0.0f, 20.0f), 5);
+   const NavPathScheduler::RequestId mid = request(Point2F(-20.0f, -20.0f), Point2F(20.0f, 20.0f), 1);
+
+   // Without a budget each call plans just one request, best first.
+   EXPECT_EQ(scheduler->process(0.0f), 1);
+   ASSERT_EQ(mPlannedIds.size(), 1);
+   EXPECT_EQ(mPlannedIds[0], high);
+   EXPECT_EQ(scheduler->getStats().queueDepth, 2);
+
+   EXPECT_EQ(scheduler->process(0.0f), 1);
+   ASSERT_EQ(mPlannedIds.size(), 2);
+   EXPECT_EQ(mPlannedIds[1], mid);
+
+   // Cancelled requests are never planned.
+   scheduler->cancel(low);
+   EXPECT_EQ(scheduler->getStats().queueDepth, 0);
+   EXPECT_EQ(scheduler->process(0.0f), 0);
+   EXPECT_EQ(mPlannedIds.size(), 2);
+}
+
+TEST_FIX(NavMeshBuild, Benchmark)
+{
+   const F32 size = 200.0f;
+   const U32 serialMs = build(size, 1);
+   const U32 parallelMs = build(size, 0);
+
+   Con::printf("NavMesh %.0fx%.0f: %d tiles, serial %5dms, parallel %5dms on %d threads",
+      size, size, mMesh->getDetourMesh()->getMaxTiles(), serialMs, parallelMs,
+      JobSystem::isGlobalRunning() ? JobSystem::GLOBAL().getNumThreads() + 1 : 1);
+}
+
+#endif
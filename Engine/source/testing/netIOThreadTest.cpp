@@ -0,0 +1,147 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "platform/platformNet.h"
+#include "platform/platformTimer.h"
+#include "core/util/journal/process.h"
+#include "console/console.h"
+
+FIXTURE(NetIOThread)
+{
+public:
+   NetAddress mAddress;
+   Vector<U32> mReceived;
+
+   void receive(NetAddress srcAddress, RawData packetData)
+   {
+      // Game packets without a connection are ignored by the
+      // NetInterface, so those are what we send.
+      if (packetData.size != 64 || packetData.data[0] != 0x01)
+         return;
+
+      U32 index;
+      dMemcpy(&index, packetData.data + 1, sizeof(index));
+      mReceived.push_back(index);
+   }
+
+   /// Opens the unreliable port on a free local port.
+   bool openPort(bool useThread)
+   {
+      Con::setBoolVariable("$pref::Net::IOThread", useThread);
+      if (!Net::openPort(0))
+         return false;
+
+      if (Net::getPortAddress(NetAddress::IPAddress, &mAddress) != Net::NoError)
+         return false;
+
+      mAddress.address.ipv4.netNum[0] = 127;
+      mAddress.address.ipv4.netNum[1] = 0;
+      mAddress.address.ipv4.netNum[2] = 0;
+      mAddress.address.ipv4.netNum[3] = 1;
+      return true;
+   }
+
+   /// Sends count packets to ourselves in bursts and returns the time it
+   /// took to receive them.
+   U32 sendPackets(U32 count, U32 burst)
+   {
+      U8 buffer[64];
+      dMemset(buffer, 0, sizeof(buffer));
+      buffer[0] = 0x01;
+
+      mReceived.clear();
+      PlatformTimer *timer = PlatformTimer::create();
+
+      for (U32 sent = 0; sent < count;)
+      {
+         const U32 burstEnd = getMin(sent + burst, count);
+         for (; sent < burstEnd; sent++)
+         {
+            dMemcpy(buffer + 1, &sent, sizeof(sent));
+            Net::sendto(&mAddress, buffer, sizeof(buffer));
+         }
+
+         // Wait for the burst so the socket buffer doesn't overflow.
+         const S32 start = timer->getElapsedMs();
+         while ((U32)mReceived.size() < sent && timer->getElapsedMs() - start < 1000)
+            Process::processEvents();
+      }
+
+      const U32 elapsed = timer->getElapsedMs();
+      delete timer;
+      return elapsed;
+   }
+
+   void SetUp() override
+   {
+      Net::getPacketReceiveEvent().notify(this, &NetIOThreadFixture::receive);
+   }
+
+   void TearDown() override
+   {
+      Net::getPacketReceiveEvent().remove(this, &NetIOThreadFixture::receive);
+      Net::closePort();
+      Con::setBoolVariable("$pref::Net::IOThread", false);
+   }
+};
+
+TEST_FIX(NetIOThread, Loopback)
+{
+   for (U32 useThread = 0; useThread < 2; useThread++)
+   {
+      ASSERT_TRUE(openPort(useThread));
+
+      const U32 count = 1000;
+      sendPackets(count, 100);
+
+      // Every packet arrives exactly once.
+      ASSERT_EQ(mReceived.size(), count);
+      Vector<bool> seen;
+      seen.setSize(count);
+      dMemset(seen.address(), 0, count * sizeof(bool));
+      for (U32 i = 0; i < count; i++)
+      {
+         ASSERT_LT(mReceived[i], count);
+         EXPECT_FALSE(seen[mReceived[i]]);
+         seen[mReceived[i]] = true;
+      }
+
+      Net::closePort();
+   }
+}
+
+TEST_FIX(NetIOThread, Benchmark)
+{
+   const U32 count = 100000;
+   for (U32 useThread = 0; useThread < 2; useThread++)
+   {
+      ASSERT_TRUE(openPort(useThread));
+
+      const U32 ms = sendPackets(count, 256);
+      Con::printf("Net %-9s: %d of %d packets in %4dms, %d packets/s",
+         useThread ? "IO thread" : "direct", mReceived.size(), count, ms, ms ? mReceived.size() * 1000 / ms : 0);
+
+      EXPECT_GT(mReceived.size(), 0);
+      Net::closePort();
+   }
+}
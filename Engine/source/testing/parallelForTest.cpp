@@ -0,0 +1,225 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "platform/threads/parallelFor.h"
+#include "platform/threads/thread.h"
+#include "platform/platformCPUCount.h"
+#include "platform/platformTimer.h"
+#include "gfx/bitmap/imageUtils.h"
+#include "gfx/bitmap/gBitmap.h"
+#include "gfx/bitmap/ddsFile.h"
+#include "math/mPoint2.h"
+#include "math/mRandom.h"
+#include "console/console.h"
+#include "squish/squish.h"
+
+TEST(ParallelFor, CoversRange)
+{
+   const U32 counts[] = { 1, 7, 1000, 100003 };
+   const U32 grains[] = { 1, 16, 5000 };
+
+   for (U32 c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+   {
+      for (U32 g = 0; g < sizeof(grains) / sizeof(grains[0]); g++)
+      {
+         const U32 begin = 3;
+         const U32 end = begin + counts[c];
+
+         Vector<U32> hits;
+         hits.setSize(end);
+         dMemset(hits.address(), 0, hits.memSize());
+
+         // Chunks don't overlap, so no need for atomics.
+         parallelFor(begin, end, grains[g], [&](U32 start, U32 stop)
+         {
+            for (U32 i = start; i < stop; i++)
+               hits[i]++;
+         });
+
+         for (U32 i = 0; i < end; i++)
+            EXPECT_EQ(hits[i], i < begin ? 0U : 1U) << "count " << counts[c] << ", grain " << grains[g] << ", index " << i;
+      }
+   }
+
+   // Empty ranges never call fn.
+   bool called = false;
+   parallelFor(5, 5, 1, [&](U32, U32) { called = true; });
+   EXPECT_FALSE(called);
+}
+
+TEST(ParallelFor, SerialFallback)
+{
+   const dsize_t caller = ThreadManager::getCurrentThreadId();
+   U32 numCalls = 0;
+   bool sameThread = true;
+
+   parallelFor(0, 100, 100, [&](U32 start, U32 end)
+   {
+      numCalls++;
+      sameThread &= (ThreadManager::getCurrentThreadId() == caller);
+      EXPECT_EQ(start, 0U);
+      EXPECT_EQ(end, 100U);
+   });
+
+   EXPECT_EQ(numCalls, 1U);
+   EXPECT_TRUE(sameThread);
+}
+
+TEST(ParallelFor, Reduce)
+{
+   const U32 count = 100000;
+
+   const U64 sum = parallelReduce(0, count, 64, U64(0),
+      [](U32 start, U32 end)
+      {
+         U64 partial = 0;
+         for (U32 i = start; i < end; i++)
+            partial += i;
+         return partial;
+      },
+      [](U64 a, U64 b) { return a + b; });
+
+   EXPECT_EQ(sum, U64(count) * (count - 1) / 2);
+
+   // Partial results are combined in index order.
+   const Point2I range = parallelReduce(0, count, 64, Point2I(0, 0),
+      [](U32 start, U32 end) { return Point2I(start, end); },
+      [](const Point2I& a, const Point2I& b)
+      {
+         return (a.y == b.x) ? Point2I(a.x, b.y) : Point2I(-1, -1);
+      });
+
+   EXPECT_EQ(range.x, 0);
+   EXPECT_EQ(range.y, S32(count));
+}
+
+TEST(ParallelFor, DDSCompress)
+{
+   // ImageUtil::ddsCompress splits the mips into bands on the job system.
+   // The result has to match compressing each mip in one go.
+   const U32 size = 1024;
+
+   GBitmap bmp(size, size, true, GFXFormatR8G8B8A8);
+   MRandomLCG random(1);
+   U8 *bits = bmp.getWritableBits();
+   for (U32 i = 0; i < size * size * 4; i++)
+      bits[i] = random.randI(0, 255);
+   bmp.extrudeMipLevels();
+
+   DDSFile *dds = DDSFile::createDDSFileFromGBitmap(&bmp);
+   ASSERT_TRUE(dds != NULL);
+   ASSERT_EQ(dds->mMipMapCount, bmp.getNumMipLevels());
+
+   PlatformTimer *timer = PlatformTimer::create();
+
+   Vector< Vector<U8> > reference;
+   reference.setSize(bmp.getNumMipLevels());
+   for (U32 mip = 0; mip < bmp.getNumMipLevels(); mip++)
+   {
+      reference[mip].setSize(squish::GetStorageRequirements(bmp.getWidth(mip), bmp.getHeight(mip), squish::kDxt5));
+      ImageUtil::rawCompress(bmp.getBits(mip), reference[mip].address(),
+         bmp.getWidth(mip), bmp.getHeight(mip), GFXFormatBC3);
+   }
+   const S32 serialMs = timer->getElapsedMs();
+
+   timer->reset();
+   ASSERT_TRUE(ImageUtil::ddsCompress(dds, GFXFormatBC3));
+   const S32 ms = timer->getElapsedMs();
+
+   EXPECT_EQ(dds->mFormat, GFXFormatBC3);
+   for (U32 mip = 0; mip < bmp.getNumMipLevels(); mip++)
+   {
+      EXPECT_EQ(dMemcmp(dds->mSurfaces.last()->mMips[mip], reference[mip].address(), reference[mip].size()), 0)
+         << "mip " << mip;
+   }
+
+   Con::printf("ParallelFor: DXT5 %dx%d with mips serial: %5dms, ddsCompress on %d threads: %5dms",
+      size, size, serialMs, JobSystem::isGlobalRunning() ? JobSystem::GLOBAL().getNumThreads() + 1 : 1, ms);
+
+   delete timer;
+   delete dds;
+}
+
+TEST(ParallelFor, CompressBenchmark)
+{
+   // DXT compress a 1024x1024 image in the same 64 row bands
+   // ImageUtil::ddsCompress uses and compare 1 to N threads.
+   const S32 size = 1024;
+   const S32 bandRows = 64;
+   const U32 numBands = size / bandRows;
+   const S32 flags = squish::kDxt5;
+
+   Vector<U8> src;
+   src.setSize(size * size * 4);
+   MRandomLCG random(1);
+   for (S32 i = 0; i < src.size(); i++)
+      src[i] = random.randI(0, 255);
+
+   Vector<U8> reference;
+   reference.setSize(squish::GetStorageRequirements(size, size, flags));
+   ImageUtil::rawCompress(src.address(), reference.address(), size, size, GFXFormatBC3);
+
+   Vector<U8> dst;
+   dst.setSize(reference.size());
+
+   U32 numLogical = 0;
+   U32 numCores = 0;
+   CPUInfo::CPUCount(numLogical, numCores);
+   const U32 maxThreads = getMin(getMax(numLogical, numCores), 16U);
+
+   PlatformTimer *timer = PlatformTimer::create();
+   S32 serialMs = 0;
+
+   for (U32 numThreads = 1; numThreads <= maxThreads; numThreads++)
+   {
+      // A private job system per count so the global one is
+      // left alone.  A single thread is the serial fallback.
+      JobSystem jobs("Benchmark", getMax(numThreads - 1, 1U));
+      const U32 grain = (numThreads == 1) ? numBands : 1;
+
+      dMemset(dst.address(), 0, dst.size());
+
+      timer->reset();
+      parallelFor(jobs, 0, numBands, grain, [&](U32 start, U32 end)
+      {
+         for (U32 i = start; i < end; i++)
+         {
+            const S32 y = i * bandRows;
+            ImageUtil::rawCompress(src.address() + y * size * 4,
+               dst.address() + squish::GetStorageRequirements(size, y, flags),
+               size, bandRows, GFXFormatBC3);
+         }
+      });
+      const S32 ms = timer->getElapsedMs();
+
+      if (numThreads == 1)
+         serialMs = ms;
+
+      EXPECT_EQ(dMemcmp(dst.address(), reference.address(), dst.size()), 0) << numThreads << " threads";
+
+      Con::printf("ParallelFor: DXT5 %dx%d on %2d threads: %5dms (%.2fx)",
+         size, size, numThreads, ms, ms > 0 ? F32(serialMs) / F32(ms) : 0.0f);
+   }
+
+   delete timer;
+}
@@ -0,0 +1,251 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "T3D/fx/particleEmitter.h"
+#include "T3D/fx/particleBatch.h"
+#include "math/mRandom.h"
+
+/// Exposes ParticleEmitter::updateKeyData() as the reference for the keys.
+class ParticleBatchTestEmitter : public ParticleEmitter
+{
+public:
+   using ParticleEmitter::updateKeyData;
+};
+
+FIXTURE(ParticleBatch)
+{
+public:
+   // Not a multiple of the SIMD width so there are padding lanes.
+   static const U32 numParts = 37;
+
+   ParticleData mData;
+   Vector<Particle> mParts;
+
+   void SetUp() override
+   {
+      MRandomLCG rand(1234);
+
+      const F32 times[ParticleData::PDC_NUM_KEYS] = { 0.0f, 0.1f, 0.25f, 0.4f, 0.5f, 0.7f, 0.9f, 1.0f };
+      for (U32 i = 0; i < ParticleData::PDC_NUM_KEYS; i++)
+      {
+         mData.times[i] = times[i];
+         mData.colors[i].set(rand.randF(), rand.randF(), rand.randF(), rand.randF());
+         mData.sizes[i] = rand.randF(0.1f, 4.0f);
+      }
+      mData.sizeBias = 1.5f;
+      mData.dragCoefficient = 0.3f;
+      mData.windCoefficient = 0.5f;
+      mData.gravityCoefficient = 0.2f;
+
+      mParts.setSize(numParts);
+      for (U32 i = 0; i < numParts; i++)
+      {
+         Particle &part = mParts[i];
+         dMemset(&part, 0, sizeof(Particle));
+
+         part.dataBlock = &mData;
+         part.pos_local.set(rand.randF(-10.0f, 10.0f), rand.randF(-10.0f, 10.0f), rand.randF(-10.0f, 10.0f));
+         part.vel.set(rand.randF(-5.0f, 5.0f), rand.randF(-5.0f, 5.0f), rand.randF(-5.0f, 5.0f));
+         part.acc = part.vel * 0.25f;
+         part.totalLifetime = 1000 + rand.randI(0, 1000);
+         part.currentAge = rand.randI(0, part.totalLifetime);
+         part.color.set(1.0f, 1.0f, 1.0f, 1.0f);
+         part.size = 1.0f;
+      }
+   }
+
+   /// Fills a batch with all the test particles.
+   void fillBatch(ParticleBatch &batch)
+   {
+      batch.setCount(0);
+      for (U32 i = 0; i < numParts; i++)
+      {
+         batch.add(&mParts[i]);
+         batch.age[i] = (F32)mParts[i].currentAge / (F32)mParts[i].totalLifetime;
+      }
+   }
+};
+
+TEST_FIX(ParticleBatch, AddRemove)
+{
+   ParticleBatch batch;
+   fillBatch(batch);
+
+   EXPECT_EQ(batch.count, numParts);
+   EXPECT_EQ(batch.dataBlock, &mData);
+
+   // Take out every third particle.
+   for (U32 i = 0; i < numParts; i += 3)
+      batch.remove(&mParts[i]);
+
+   // Removing it twice does nothing.
+   batch.remove(&mParts[0]);
+
+   EXPECT_EQ(batch.count, numParts - (numParts + 2) / 3);
+
+   for (U32 i = 0; i < numParts; i++)
+   {
+      const Particle &part = mParts[i];
+      EXPECT_EQ(batch.contains(&part), i % 3 != 0);
+      if (!batch.contains(&part))
+         continue;
+
+      // The lanes that moved took their state with them.
+      const U32 lane = part.batchIndex;
+      EXPECT_EQ(batch.posX[lane], part.pos_local.x);
+      EXPECT_EQ(batch.velY[lane], part.vel.y);
+      EXPECT_EQ(batch.accZ[lane], part.acc.z);
+   }
+
+   // The padding is cleared.
+   for (U32 i = batch.count; i < batch.getPaddedCount(); i++)
+   {
+      EXPECT_TRUE(batch.parts[i] == NULL);
+      EXPECT_EQ(batch.velX[i], 0.0f);
+   }
+
+   // A particle with another datablock makes the batch mixed until it
+   // runs empty.
+   ParticleData other;
+   Particle extra = mParts[0];
+   extra.dataBlock = &other;
+   batch.add(&extra);
+   EXPECT_TRUE(batch.dataBlock == NULL);
+
+   batch.setCount(0);
+   batch.add(&mParts[0]);
+   EXPECT_EQ(batch.dataBlock, &mData);
+}
+
+TEST_FIX(ParticleBatch, Integrate)
+{
+   const F32 dt = 0.032f;
+   const Point3F wind(1.0f, -2.0f, 0.5f);
+
+   ParticleBatch scalar, sse;
+   fillBatch(scalar);
+   integrateParticles_C(scalar, dt, wind);
+
+#ifdef PARTICLE_BATCH_SSE
+   fillBatch(sse);
+   integrateParticles_SSE(sse, dt, wind);
+#endif
+
+   for (U32 i = 0; i < numParts; i++)
+   {
+      // The per particle update the kernels replace.
+      const Particle &part = mParts[i];
+      Point3F a = part.acc;
+      a -= part.vel * mData.dragCoefficient;
+      a += wind * mData.windCoefficient;
+      a.z += -9.81f * mData.gravityCoefficient;
+
+      const Point3F vel = part.vel + a * dt;
+      const Point3F pos = part.pos_local + vel * dt;
+
+      EXPECT_NEAR(scalar.velX[i], vel.x, 1e-5f);
+      EXPECT_NEAR(scalar.velY[i], vel.y, 1e-5f);
+      EXPECT_NEAR(scalar.velZ[i], vel.z, 1e-5f);
+      EXPECT_NEAR(scalar.posX[i], pos.x, 1e-5f);
+      EXPECT_NEAR(scalar.posY[i], pos.y, 1e-5f);
+      EXPECT_NEAR(scalar.posZ[i], pos.z, 1e-5f);
+
+#ifdef PARTICLE_BATCH_SSE
+      EXPECT_NEAR(sse.velX[i], vel.x, 1e-5f);
+      EXPECT_NEAR(sse.velY[i], vel.y, 1e-5f);
+      EXPECT_NEAR(sse.velZ[i], vel.z, 1e-5f);
+      EXPECT_NEAR(sse.posX[i], pos.x, 1e-5f);
+      EXPECT_NEAR(sse.posY[i], pos.y, 1e-5f);
+      EXPECT_NEAR(sse.posZ[i], pos.z, 1e-5f);
+#endif
+   }
+}
+
+TEST_FIX(ParticleBatch, Keys)
+{
+   ParticleEmitterData emitterData;
+   emitterData.particleDataBlocks.push_back(&mData);
+
+   ParticleBatchTestEmitter emitter;
+   ASSERT_TRUE(emitter.onNewDataBlock(&emitterData, false));
+
+   F32 emitterSizes[ParticleData::PDC_NUM_KEYS];
+   LinearColorF emitterColors[ParticleData::PDC_NUM_KEYS];
+   MRandomLCG rand(4321);
+   for (U32 i = 0; i < ParticleData::PDC_NUM_KEYS; i++)
+   {
+      emitterSizes[i] = rand.randF(0.5f, 2.0f);
+      emitterColors[i].set(rand.randF(), rand.randF(), rand.randF(), rand.randF());
+   }
+   emitter.setSizes(emitterSizes);
+   emitter.setColors(emitterColors);
+
+   // Datablock keys, then emitter keys with all the fades.
+   for (U32 pass = 0; pass < 2; pass++)
+   {
+      const bool useEmitter = pass == 1;
+      emitterData.useEmitterColors = useEmitter;
+      emitterData.useEmitterSizes = useEmitter;
+      emitterData.fade_color = useEmitter;
+      emitterData.fade_alpha = useEmitter;
+      emitterData.fade_size = useEmitter;
+      emitter.setFadeAmount(useEmitter ? 0.6f : 1.0f);
+
+      ParticleKeyTable keys;
+      keys.set(&mData,
+         useEmitter ? emitterColors : NULL,
+         useEmitter ? emitterSizes : NULL,
+         useEmitter ? 0.6f : 1.0f,
+         useEmitter ? 0.6f : 1.0f,
+         useEmitter ? 0.6f : 1.0f);
+
+      ParticleBatch scalar, sse;
+      fillBatch(scalar);
+      interpolateParticleKeys_C(scalar, keys);
+
+#ifdef PARTICLE_BATCH_SSE
+      fillBatch(sse);
+      interpolateParticleKeys_SSE(sse, keys);
+#endif
+
+      for (U32 i = 0; i < numParts; i++)
+      {
+         Particle part = mParts[i];
+         emitter.updateKeyData(&part);
+
+         EXPECT_NEAR(scalar.colorR[i], part.color.red, 1e-4f) << "pass " << pass << ", particle " << i;
+         EXPECT_NEAR(scalar.colorG[i], part.color.green, 1e-4f);
+         EXPECT_NEAR(scalar.colorB[i], part.color.blue, 1e-4f);
+         EXPECT_NEAR(scalar.colorA[i], part.color.alpha, 1e-4f);
+         EXPECT_NEAR(scalar.size[i], part.size, 1e-4f);
+
+#ifdef PARTICLE_BATCH_SSE
+         EXPECT_NEAR(sse.colorR[i], part.color.red, 1e-4f) << "pass " << pass << ", particle " << i;
+         EXPECT_NEAR(sse.colorG[i], part.color.green, 1e-4f);
+         EXPECT_NEAR(sse.colorB[i], part.color.blue, 1e-4f);
+         EXPECT_NEAR(sse.colorA[i], part.color.alpha, 1e-4f);
+         EXPECT_NEAR(sse.size[i], part.size, 1e-4f);
+#endif
+      }
+   }
+}
@@ -0,0 +1,182 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "T3D/fx/particleDepthSort.h"
+#include "platform/platformTimer.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+#include "math/mRandom.h"
+
+FIXTURE(ParticleDepthSort)
+{
+public:
+   Vector<SortParticle> mParts;
+
+   /// Fills mParts with count particles at random depths.  The particle
+   /// pointers are just tags so we can check nothing was lost.
+   void fill(U32 count, U32 seed = 1234)
+   {
+      MRandomLCG rand(seed);
+
+      mParts.setSize(count);
+      for (U32 i = 0; i < count; i++)
+      {
+         mParts[i].p = (Particle*)(uintptr_t)(i + 1);
+         mParts[i].k = rand.randF(-100.0f, 100.0f);
+      }
+   }
+
+   /// Nudges every depth a little, like a frame of camera or particle motion.
+   void jitter(F32 amount, U32 seed = 4321)
+   {
+      MRandomLCG rand(seed);
+      for (U32 i = 0; i < mParts.size(); i++)
+         mParts[i].k += rand.randF(-amount, amount);
+   }
+
+   /// Returns the sum of the tags, which must survive sorting.
+   U64 tagSum() const
+   {
+      U64 sum = 0;
+      for (U32 i = 0; i < mParts.size(); i++)
+         sum += (uintptr_t)mParts[i].p;
+      return sum;
+   }
+
+   /// Checks far to near order allowing for the given key tolerance.
+   void expectSorted(F32 tolerance)
+   {
+      for (U32 i = 1; i < mParts.size(); i++)
+         ASSERT_GE(mParts[i-1].k + tolerance, mParts[i].k) << "at " << i;
+   }
+};
+
+TEST_FIX(ParticleDepthSort, Radix)
+{
+   fill(5000);
+   const U64 sum = tagSum();
+
+   ParticleDepthSort::radixSort(mParts.address(), mParts.size());
+
+   // Keys are quantized to 16 bits over the 200 unit range.
+   expectSorted(200.0f / 65535.0f);
+   EXPECT_EQ(tagSum(), sum);
+}
+
+TEST_FIX(ParticleDepthSort, RadixStable)
+{
+   fill(1000);
+   for (U32 i = 0; i < mParts.size(); i++)
+      mParts[i].k = (i % 2) ? 1.0f : 0.0f;
+
+   ParticleDepthSort::radixSort(mParts.address(), mParts.size());
+
+   // The far half comes first and each half keeps its input order.
+   for (U32 i = 1; i < mParts.size(); i++)
+   {
+      if (mParts[i-1].k == mParts[i].k)
+         EXPECT_LT((uintptr_t)mParts[i-1].p, (uintptr_t)mParts[i].p);
+   }
+   EXPECT_EQ(mParts.first().k, 1.0f);
+   EXPECT_EQ(mParts.last().k, 0.0f);
+}
+
+TEST_FIX(ParticleDepthSort, InsertionGivesUp)
+{
+   fill(1000);
+   EXPECT_FALSE(ParticleDepthSort::insertionSort(mParts.address(), mParts.size(), mParts.size()));
+
+   fill(1000);
+   dQsort(mParts.address(), mParts.size(), sizeof(SortParticle), cmpSortParticles);
+   EXPECT_TRUE(ParticleDepthSort::insertionSort(mParts.address(), mParts.size(), 0));
+}
+
+TEST_FIX(ParticleDepthSort, Coherent)
+{
+   fill(5000);
+   dQsort(mParts.address(), mParts.size(), sizeof(SortParticle), cmpSortParticles);
+   jitter(0.05f);
+   const U64 sum = tagSum();
+
+   // Nearly sorted input is finished exactly by the insertion pass.
+   ParticleDepthSort::coherentSort(mParts.address(), mParts.size());
+   expectSorted(0.0f);
+   EXPECT_EQ(tagSum(), sum);
+
+   // Unsorted input falls back to the radix sort.
+   fill(5000);
+   ParticleDepthSort::coherentSort(mParts.address(), mParts.size());
+   expectSorted(200.0f / 65535.0f);
+   EXPECT_EQ(tagSum(), sum);
+}
+
+TEST_FIX(ParticleDepthSort, Benchmark)
+{
+   const U32 counts[] = { 1000, 10000, 100000 };
+   PlatformTimer *timer = PlatformTimer::create();
+
+   for (U32 c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+   {
+      const U32 count = counts[c];
+      const U32 iterations = 2000000 / count;
+
+      Vector<SortParticle> source;
+      fill(count);
+      source = mParts;
+
+      timer->reset();
+      for (U32 i = 0; i < iterations; i++)
+      {
+         mParts = source;
+         dQsort(mParts.address(), mParts.size(), sizeof(SortParticle), cmpSortParticles);
+      }
+      const S32 qsortMs = timer->getElapsedMs();
+
+      timer->reset();
+      for (U32 i = 0; i < iterations; i++)
+      {
+         mParts = source;
+         ParticleDepthSort::radixSort(mParts.address(), mParts.size());
+      }
+      const S32 radixMs = timer->getElapsedMs();
+
+      // Last frame's order with a frame's worth of motion.
+      dQsort(source.address(), source.size(), sizeof(SortParticle), cmpSortParticles);
+      mParts = source;
+      jitter(0.05f);
+      source = mParts;
+
+      timer->reset();
+      for (U32 i = 0; i < iterations; i++)
+      {
+         mParts = source;
+         ParticleDepthSort::coherentSort(mParts.address(), mParts.size());
+      }
+      const S32 coherentMs = timer->getElapsedMs();
+
+      Con::printf("ParticleDepthSort: %6d particles x %4d: qsort %5dms, radix %5dms, coherent %5dms",
+         count, iterations, qsortMs, radixMs, coherentMs);
+   }
+
+   delete timer;
+}
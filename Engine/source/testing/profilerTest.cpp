@@ -25,6 +25,8 @@
 #ifdef TORQUE_ENABLE_PROFILER
 #include "testing/unitTesting.h"
 #include "platform/profiler.h"
+#include "platform/threads/threadPool.h"
+#include "core/stream/fileStream.h"
 
 TEST(Profiler, ProfileStartEnd)
 {
@@ -44,4 +46,53 @@ TEST(Profiler, ProfileScope)
    // Do work and return whenever you want.
 }
 
+struct ProfilerTraceTestItem : public ThreadPool::WorkItem
+{
+protected:
+   virtual void execute()
+   {
+      PROFILE_SCOPE(ProfilerTraceTestWorker);
+      Platform::sleep(1);
+   }
+};
+
+TEST(Profiler, TraceThreads)
+{
+   const char* fileName = "profilerTraceTest.json";
+
+   gProfiler->startTrace();
+   {
+      PROFILE_SCOPE(ProfilerTraceTestMain);
+
+      ThreadPool* pool = &ThreadPool::GLOBAL();
+      for (U32 i = 0; i < 8; i++)
+      {
+         ThreadSafeRef<ProfilerTraceTestItem> item(new ProfilerTraceTestItem);
+         pool->queueWorkItem(item);
+      }
+      pool->waitForAllItems();
+   }
+   ASSERT_TRUE(gProfiler->stopTrace(fileName));
+   EXPECT_FALSE(gProfiler->isTracing());
+
+   FileStream fs;
+   ASSERT_TRUE(fs.open(fileName, Torque::FS::File::Read));
+   const U32 size = fs.getStreamSize();
+   char* data = new char[size + 1];
+   fs.read(size, data);
+   data[size] = 0;
+   fs.close();
+   dFileDelete(fileName);
+
+   // Both the main thread and the pool workers show up in the timeline.
+   EXPECT_TRUE(dStrstr(data, "\"traceEvents\"") != NULL);
+   EXPECT_TRUE(dStrstr(data, "Main Thread") != NULL);
+   EXPECT_TRUE(dStrstr(data, "\"name\":\"ProfilerTraceTestMain\",\"ph\":\"B\"") != NULL);
+   EXPECT_TRUE(dStrstr(data, "\"name\":\"ProfilerTraceTestMain\",\"ph\":\"E\"") != NULL);
+   EXPECT_TRUE(dStrstr(data, "\"name\":\"ProfilerTraceTestWorker\",\"ph\":\"B\"") != NULL);
+   EXPECT_TRUE(dStrstr(data, "\"name\":\"ProfilerTraceTestWorker\",\"ph\":\"E\"") != NULL);
+
+   delete [] data;
+}
+
 #endif
@@ -0,0 +1,148 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "renderInstance/renderBinManager.h"
+#include "platform/platformTimer.h"
+#include "console/console.h"
+#include "core/util/tVector.h"
+#include "math/mRandom.h"
+
+FIXTURE(RenderBinSort)
+{
+public:
+   typedef RenderBinManager::MainSortElem MainSortElem;
+
+   Vector<MainSortElem> mElems;
+
+   /// Fills mElems with count elements using keys from a small set of
+   /// depths and keys2 from a small set of state hints, like a real bin.
+   /// The inst pointers are just tags recording the input order.
+   void fill(U32 count, U32 numKeys, U32 numKeys2, U32 seed = 1234)
+   {
+      MRandomLCG rand(seed);
+
+      mElems.setSize(count);
+      for (U32 i = 0; i < count; i++)
+      {
+         mElems[i].inst = (RenderInst*)(uintptr_t)(i + 1);
+         mElems[i].key = rand.randI(0, numKeys - 1);
+         mElems[i].key2 = rand.randI(0, numKeys2 - 1);
+      }
+   }
+
+   /// Checks key descending, key2 ascending and input order within
+   /// equal keys.
+   void expectSorted()
+   {
+      for (U32 i = 1; i < mElems.size(); i++)
+      {
+         const MainSortElem &a = mElems[i-1];
+         const MainSortElem &b = mElems[i];
+
+         ASSERT_GE(a.key, b.key) << "at " << i;
+         if (a.key == b.key)
+         {
+            ASSERT_LE(a.key2, b.key2) << "at " << i;
+            if (a.key2 == b.key2)
+               ASSERT_LT((uintptr_t)a.inst, (uintptr_t)b.inst) << "at " << i;
+         }
+      }
+   }
+};
+
+TEST_FIX(RenderBinSort, MatchesQSort)
+{
+   const U32 counts[] = { 0, 1, 7, 32, 33, 1000, 20000 };
+
+   for (U32 c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+   {
+      fill(counts[c], 50, 20);
+
+      Vector<MainSortElem> expected = mElems;
+      dQsort(expected.address(), expected.size(), sizeof(MainSortElem), RenderBinManager::cmpKeyFunc);
+
+      RenderBinManager::sortElements(mElems.address(), mElems.size());
+      expectSorted();
+
+      ASSERT_EQ(mElems.size(), expected.size());
+      for (U32 i = 0; i < mElems.size(); i++)
+      {
+         EXPECT_EQ(mElems[i].key, expected[i].key) << "at " << i;
+         EXPECT_EQ(mElems[i].key2, expected[i].key2) << "at " << i;
+      }
+   }
+}
+
+TEST_FIX(RenderBinSort, FullRangeKeys)
+{
+   // Distance keys are float bits and state hints can use the high
+   // bit, both of which are compared unsigned.
+   MRandomLCG rand(42);
+   fill(5000, 1, 1);
+   for (U32 i = 0; i < mElems.size(); i++)
+   {
+      F32 dist = rand.randF(0.0f, 10000.0f);
+      mElems[i].key = *((U32*)&dist);
+      mElems[i].key2 = rand.randI() | ((i & 1) ? 0x80000000 : 0);
+   }
+
+   RenderBinManager::sortElements(mElems.address(), mElems.size());
+   expectSorted();
+}
+
+TEST_FIX(RenderBinSort, Benchmark)
+{
+   const U32 counts[] = { 1000, 10000, 100000 };
+   PlatformTimer *timer = PlatformTimer::create();
+
+   for (U32 c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+   {
+      const U32 count = counts[c];
+      const U32 iterations = 2000000 / count;
+
+      Vector<MainSortElem> source;
+      fill(count, count / 4, 64);
+      source = mElems;
+
+      timer->reset();
+      for (U32 i = 0; i < iterations; i++)
+      {
+         mElems = source;
+         dQsort(mElems.address(), mElems.size(), sizeof(MainSortElem), RenderBinManager::cmpKeyFunc);
+      }
+      const S32 qsortMs = timer->getElapsedMs();
+
+      timer->reset();
+      for (U32 i = 0; i < iterations; i++)
+      {
+         mElems = source;
+         RenderBinManager::sortElements(mElems.address(), mElems.size());
+      }
+      const S32 radixMs = timer->getElapsedMs();
+
+      Con::printf("RenderBinSort: %6d elements x %4d: qsort %5dms, radix %5dms",
+         count, iterations, qsortMs, radixMs);
+   }
+
+   delete timer;
+}
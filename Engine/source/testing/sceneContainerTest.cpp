@@ -9,8 +9,13 @@
 #include "math/mMath.h"
 #include "console/stringStack.h"
 #include "scene/sceneContainer.h"
+#include "scene/sceneManager.h"
+#include "scene/culling/sceneCullingState.h"
 #include "T3D/missionMarker.h"
 #include "collision/clippedPolyList.h"
+#include "math/mRandom.h"
+#include "platform/platformTimer.h"
+#include "platform/threads/jobSystem.h"
 
 
 using ::testing::Matcher;
@@ -605,6 +610,9 @@ public:
    bool mReturnCastRay;
    RayInfo mRayInfo;
 
+   /// Report where the ray enters the world box as the hit
+   bool mHitWorldBox;
+
    bool onAdd()
    {
       if (Parent::onAdd())
@@ -616,6 +624,7 @@ public:
          mNumCastRayRenderedCalls = 0;
          mReturnCastRay = false;
          mRayInfo = {};
+         mHitWorldBox = false;
 
          if (mAddCallback)
             mAddCallback();
@@ -650,6 +659,12 @@ public:
    virtual bool castRay(const Point3F& start, const Point3F& end, RayInfo* info)
    {
       mNumCastRayCalls++;
+      if (mHitWorldBox)
+      {
+         info->object = this;
+         return mWorldBox.collideLine(start, end, &info->t, &info->normal);
+      }
+
       if (!mReturnCastRay)
          return false;
 
@@ -679,6 +694,10 @@ public:
    {
       mWorldBox = box;
    }
+
+   /// The key is set on every object a container query looks at
+   U32 getSeqKey() const { return getContainerSeqKey(); }
+   void resetSeqKey() { setContainerSeqKey(0); }
 };
 
 class SceneContainerTest : public ::testing::Test
@@ -1444,3 +1463,421 @@ TEST_F(SceneContainerTest, getBinRange)
 
 
 
+
+/// Compares the bin grid and quadtree on a large randomly populated map
+class SceneContainerIndexTest : public ::testing::Test
+{
+protected:
+
+   SceneContainer mContainer;
+   Vector<SceneObjectTestVariant*> mObjects;
+   Vector<Box3F> mBoxQueries;
+   Vector<Point3F> mRayQueries;
+
+   /// Fills an 8km map, mostly with small objects and a few big ones
+   void populate(U32 numObjects, U32 numQueries)
+   {
+      MRandomLCG rand(1234);
+
+      gEditingMission = true;
+      for (U32 i = 0; i < numObjects; i++)
+      {
+         F32 size;
+         const U32 kind = rand.randI(0, 99);
+         if (kind < 80)
+            size = rand.randF(1.0f, 10.0f);
+         else if (kind < 95)
+            size = rand.randF(50.0f, 200.0f);
+         else
+            size = rand.randF(300.0f, 1500.0f);
+
+         Point3F center(rand.randF(0.0f, 8192.0f), rand.randF(0.0f, 8192.0f), rand.randF(0.0f, 100.0f));
+         Point3F extent(size * 0.5f, size * 0.5f, size * 0.25f);
+
+         SceneObjectTestVariant* obj = new SceneObjectTestVariant;
+         obj->registerObject();
+         obj->setTypeMask(MarkerObjectType);
+         obj->setWorldBox(Box3F(center - extent, center + extent));
+         mContainer.addObject(obj);
+         mObjects.push_back(obj);
+      }
+      gEditingMission = false;
+
+      for (U32 i = 0; i < numQueries; i++)
+      {
+         Point3F center(rand.randF(0.0f, 8192.0f), rand.randF(0.0f, 8192.0f), 50.0f);
+         Point3F extent(rand.randF(10.0f, 100.0f), rand.randF(10.0f, 100.0f), 100.0f);
+         mBoxQueries.push_back(Box3F(center - extent, center + extent));
+
+         Point3F dir(rand.randF(-1.0f, 1.0f), rand.randF(-1.0f, 1.0f), rand.randF(-0.1f, 0.1f));
+         dir.normalizeSafe();
+         mRayQueries.push_back(center);
+         mRayQueries.push_back(center + dir * rand.randF(50.0f, 1000.0f));
+      }
+   }
+
+   void TearDown() override
+   {
+      for (U32 i = 0; i < mObjects.size(); i++)
+      {
+         mContainer.removeObject(mObjects[i]);
+         mObjects[i]->deleteObject();
+      }
+      mObjects.clear();
+   }
+
+   /// Number of objects the last query looked at
+   U32 countCandidates()
+   {
+      U32 count = 0;
+      for (U32 i = 0; i < mObjects.size(); i++)
+      {
+         if (mObjects[i]->getSeqKey() != 0)
+            count++;
+         mObjects[i]->resetSeqKey();
+      }
+      return count;
+   }
+
+   /// Fills rays from mRayQueries
+   void getRayBatch(Vector<SceneContainer::RayQuery>& rays)
+   {
+      rays.clear();
+      for (U32 i = 0; i < mRayQueries.size(); i += 2)
+      {
+         rays.increment();
+         rays.last().start = mRayQueries[i];
+         rays.last().end = mRayQueries[i + 1];
+         rays.last().mask = MarkerObjectType;
+         rays.last().info = RayInfo();
+      }
+   }
+
+   /// Culling state for a camera at the south edge of the map looking north,
+   /// culling against the frustum only
+   SceneCullingState* createCullingState()
+   {
+      MatrixF camera(true);
+      camera.setPosition(Point3F(4096.0f, -100.0f, 50.0f));
+
+      Frustum frustum;
+      frustum.set(false, M_HALFPI_F, 16.0f / 9.0f, 0.1f, 3000.0f, camera);
+
+      MatrixF worldView = camera;
+      worldView.inverse();
+
+      const bool disableZoneCulling = SceneCullingState::smDisableZoneCulling;
+      SceneCullingState::smDisableZoneCulling = true;
+      SceneCullingState* state = new SceneCullingState(gClientSceneGraph,
+         SceneCameraState(RectI(0, 0, 1280, 720), frustum, worldView, MatrixF(true)));
+      SceneCullingState::smDisableZoneCulling = disableZoneCulling;
+
+      return state;
+   }
+
+   /// Culls the first count objects, returning how many are left
+   U32 cullObjects(const SceneCullingState* state, U32 count, S32 batchThreshold, Vector<SceneObject*>& outObjects)
+   {
+      outObjects.setSize(count);
+      for (U32 i = 0; i < count; i++)
+         outObjects[i] = mObjects[i];
+
+      const S32 threshold = SceneCullingState::smBatchCullThreshold;
+      SceneCullingState::smBatchCullThreshold = batchThreshold;
+      const U32 numLeft = state->cullObjects(outObjects.address(), count);
+      SceneCullingState::smBatchCullThreshold = threshold;
+
+      outObjects.setSize(numLeft);
+      return numLeft;
+   }
+
+   U32 countCastRayCalls()
+   {
+      U32 count = 0;
+      for (U32 i = 0; i < mObjects.size(); i++)
+      {
+         count += mObjects[i]->mNumCastRayCalls;
+         mObjects[i]->mNumCastRayCalls = 0;
+      }
+      return count;
+   }
+};
+
+TEST_F(SceneContainerIndexTest, quadtreeMatchesBins)
+{
+   populate(2000, 200);
+
+   const U32 numRays = mRayQueries.size() / 2;
+   Vector<SceneObject*> found[2][200];
+   U32 castRayCalls[2][200];
+
+   const SceneContainer::SpatialIndexType types[] = { SceneContainer::BinGrid, SceneContainer::LooseQuadtree };
+   for (U32 t = 0; t < 2; t++)
+   {
+      mContainer.setSpatialIndex(types[t]);
+
+      for (U32 i = 0; i < mBoxQueries.size(); i++)
+      {
+         mContainer.findObjectList(mBoxQueries[i], MarkerObjectType, &found[t][i]);
+         std::sort(found[t][i].begin(), found[t][i].end());
+      }
+
+      // Nothing reports a hit, so every object whose box the ray crosses is tested
+      countCastRayCalls();
+      for (U32 i = 0; i < numRays; i++)
+      {
+         RayInfo info;
+         mContainer.castRay(mRayQueries[i * 2], mRayQueries[i * 2 + 1], MarkerObjectType, &info);
+         castRayCalls[t][i] = countCastRayCalls();
+      }
+   }
+
+   for (U32 i = 0; i < mBoxQueries.size(); i++)
+   {
+      ASSERT_EQ(found[0][i].size(), found[1][i].size()) << "Box query " << i;
+      for (U32 j = 0; j < found[0][i].size(); j++)
+         EXPECT_EQ(found[0][i][j], found[1][i][j]);
+   }
+
+   for (U32 i = 0; i < numRays; i++)
+      EXPECT_EQ(castRayCalls[0][i], castRayCalls[1][i]) << "Ray query " << i;
+}
+
+TEST_F(SceneContainerIndexTest, batchMatchesSingle)
+{
+   populate(2000, 200);
+
+   // Some objects report hits so the closest one has to be picked
+   for (U32 i = 0; i < mObjects.size(); i += 3)
+      mObjects[i]->mHitWorldBox = true;
+
+   Vector<SceneContainer::RayQuery> rays;
+   getRayBatch(rays);
+
+   // Run the batches on the calling thread and on the job system
+   const S32 parallelThreshold = SceneContainer::smBatchParallelThreshold;
+   const S32 thresholds[] = { S32_MAX, 0 };
+
+   const SceneContainer::SpatialIndexType types[] = { SceneContainer::BinGrid, SceneContainer::LooseQuadtree };
+   for (U32 p = 0; p < 2; p++)
+   for (U32 t = 0; t < 2; t++)
+   {
+      SceneContainer::smBatchParallelThreshold = thresholds[p];
+      mContainer.setSpatialIndex(types[t]);
+
+      Vector<SceneObject*> found[200];
+      Vector<SceneObject*> batchFound[200];
+      mContainer.findObjectLists(mBoxQueries.address(), mBoxQueries.size(), MarkerObjectType, batchFound);
+
+      for (U32 i = 0; i < mBoxQueries.size(); i++)
+      {
+         mContainer.findObjectList(mBoxQueries[i], MarkerObjectType, &found[i]);
+         std::sort(found[i].begin(), found[i].end());
+         std::sort(batchFound[i].begin(), batchFound[i].end());
+
+         ASSERT_EQ(found[i].size(), batchFound[i].size()) << "Box query " << i << ", threshold " << thresholds[p];
+         for (U32 j = 0; j < found[i].size(); j++)
+            EXPECT_EQ(found[i][j], batchFound[i][j]);
+      }
+
+      for (U32 i = 0; i < rays.size(); i++)
+         rays[i].info = RayInfo();
+      mContainer.castRays(rays.address(), rays.size());
+
+      for (U32 i = 0; i < rays.size(); i++)
+      {
+         RayInfo info;
+         const bool hit = mContainer.castRay(rays[i].start, rays[i].end, MarkerObjectType, &info);
+
+         ASSERT_EQ(hit, rays[i].hit) << "Ray query " << i << ", threshold " << thresholds[p];
+         if (hit)
+         {
+            EXPECT_EQ(info.object, rays[i].info.object) << "Ray query " << i;
+            EXPECT_FLOAT_EQ(info.t, rays[i].info.t) << "Ray query " << i;
+         }
+      }
+   }
+
+   SceneContainer::smBatchParallelThreshold = parallelThreshold;
+}
+
+TEST_F(SceneContainerIndexTest, batchCullMatchesSingle)
+{
+   populate(10000, 0);
+
+   SceneCullingState* state = createCullingState();
+
+   // Cull everything east of x = 5000 with an extra plane
+   PlaneF extraPlane(Point3F(5000.0f, 0.0f, 0.0f), Point3F(-1.0f, 0.0f, 0.0f));
+   state->setExtraPlanesCull(PlaneSetF(&extraPlane, 1));
+
+   Vector<SceneObject*> single;
+   Vector<SceneObject*> batched;
+   cullObjects(state, mObjects.size(), 0, single);
+   cullObjects(state, mObjects.size(), 1, batched);
+
+   EXPECT_GT(single.size(), 0);
+   EXPECT_LT(single.size(), mObjects.size());
+
+   // Culling keeps the order so the lists should be identical
+   ASSERT_EQ(single.size(), batched.size());
+   for (U32 i = 0; i < single.size(); i++)
+      EXPECT_EQ(single[i], batched[i]);
+
+   delete state;
+}
+
+TEST_F(SceneContainerIndexTest, batchCullOverThreshold)
+{
+   populate(1000, 0);
+
+   SceneCullingState* state = createCullingState();
+
+   const S32 threshold = SceneCullingState::smBatchCullThreshold;
+   ASSERT_GT(threshold, 0);
+   const U32 count = threshold * 4;
+
+   Vector<SceneObject*> single;
+   cullObjects(state, count, 0, single);
+   EXPECT_GT(single.size(), 0);
+   EXPECT_LT(single.size(), count);
+
+   // Over the default threshold with the job system...
+   Vector<SceneObject*> batched;
+   cullObjects(state, count, threshold, batched);
+   ASSERT_EQ(single.size(), batched.size());
+   for (U32 i = 0; i < single.size(); i++)
+      EXPECT_EQ(single[i], batched[i]);
+
+   // ...and without one, where the bulk tests run on this thread
+   const bool hadJobSystem = JobSystem::isGlobalRunning();
+   if (hadJobSystem)
+      JobSystem::GlobalJobSystem::deleteSingleton();
+
+   Vector<SceneObject*> serial;
+   cullObjects(state, count, threshold, serial);
+
+   if (hadJobSystem)
+      JobSystem::GlobalJobSystem::createSingleton();
+
+   ASSERT_EQ(single.size(), serial.size());
+   for (U32 i = 0; i < single.size(); i++)
+      EXPECT_EQ(single[i], serial[i]);
+
+   delete state;
+}
+
+TEST_F(SceneContainerIndexTest, quadtreeMoveObject)
+{
+   populate(100, 0);
+   mContainer.setSpatialIndex(SceneContainer::LooseQuadtree);
+
+   SceneObjectTestVariant* obj = mObjects[0];
+   const Box3F moved(Point3F(-100, -100, 0), Point3F(-90, -90, 10));
+   obj->setWorldBox(moved);
+   mContainer.checkBins(obj);
+
+   Vector<SceneObject*> found;
+   mContainer.findObjectList(moved, MarkerObjectType, &found);
+   ASSERT_EQ(found.size(), 1);
+   EXPECT_EQ(found[0], obj);
+
+   // Outside of the tree, so it should be in the root
+   EXPECT_EQ(obj->getContainerLookupInfo().mListHandle, 1);
+
+   obj->mReturnCastRay = true;
+   obj->mRayInfo.t = 0.5f;
+   obj->mRayInfo.object = obj;
+
+   RayInfo info;
+   EXPECT_TRUE(mContainer.castRay(Point3F(-95, -200, 5), Point3F(-95, 0, 5), MarkerObjectType, &info));
+   EXPECT_EQ(info.object, obj);
+}
+
+TEST_F(SceneContainerIndexTest, benchmark)
+{
+   populate(10000, 2000);
+   PlatformTimer *timer = PlatformTimer::create();
+
+   Vector<SceneContainer::RayQuery> rays;
+   getRayBatch(rays);
+
+   const SceneContainer::SpatialIndexType types[] = { SceneContainer::BinGrid, SceneContainer::LooseQuadtree };
+   const char* names[] = { "BinGrid", "LooseQuadtree" };
+
+   for (U32 t = 0; t < 2; t++)
+   {
+      mContainer.setSpatialIndex(types[t]);
+
+      Vector<SceneObject*> found;
+      timer->reset();
+      for (U32 i = 0; i < mBoxQueries.size(); i++)
+      {
+         found.clear();
+         mContainer.findObjectList(mBoxQueries[i], MarkerObjectType, &found);
+      }
+      const S32 boxMs = timer->getElapsedMs();
+
+      RayInfo info;
+      timer->reset();
+      for (U32 i = 0; i < mRayQueries.size(); i += 2)
+         mContainer.castRay(mRayQueries[i], mRayQueries[i + 1], MarkerObjectType, &info);
+      const S32 rayMs = timer->getElapsedMs();
+
+      Vector<SceneObject*> batchFound[2000];
+      timer->reset();
+      mContainer.findObjectLists(mBoxQueries.address(), mBoxQueries.size(), MarkerObjectType, batchFound);
+      mContainer.castRays(rays.address(), rays.size());
+      const S32 batchMs = timer->getElapsedMs();
+
+      // Count the objects each query looked at outside of the timing
+      countCandidates();
+      U32 boxCandidates = 0;
+      for (U32 i = 0; i < mBoxQueries.size(); i++)
+      {
+         found.clear();
+         mContainer.findObjectList(mBoxQueries[i], MarkerObjectType, &found);
+         boxCandidates += countCandidates();
+      }
+
+      U32 rayCandidates = 0;
+      for (U32 i = 0; i < mRayQueries.size(); i += 2)
+      {
+         mContainer.castRay(mRayQueries[i], mRayQueries[i + 1], MarkerObjectType, &info);
+         rayCandidates += countCandidates();
+      }
+
+      Con::printf("SceneContainer %-13s: %d boxes %4dms %9d candidates, %d rays %4dms %9d candidates, batched %4dms",
+         names[t], mBoxQueries.size(), boxMs, boxCandidates, mRayQueries.size() / 2, rayMs, rayCandidates, batchMs);
+   }
+
+   delete timer;
+}
+
+TEST_F(SceneContainerIndexTest, cullBenchmark)
+{
+   populate(100000, 0);
+
+   SceneCullingState* state = createCullingState();
+   PlatformTimer *timer = PlatformTimer::create();
+
+   const U32 counts[] = { 10000, 100000 };
+   for (U32 c = 0; c < 2; c++)
+   {
+      Vector<SceneObject*> objects;
+
+      timer->reset();
+      const U32 numLeft = cullObjects(state, counts[c], 0, objects);
+      const S32 singleMs = timer->getElapsedMs();
+
+      timer->reset();
+      cullObjects(state, counts[c], 1, objects);
+      const S32 batchedMs = timer->getElapsedMs();
+
+      Con::printf("SceneCullingState %6d objects, %6d visible: %4dms, batched %4dms",
+         counts[c], numLeft, singleMs, batchedMs);
+   }
+
+   delete timer;
+   delete state;
+}
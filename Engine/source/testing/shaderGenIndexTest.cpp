@@ -0,0 +1,185 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "platform/platform.h"
+#include "shaderGen/shaderGen.h"
+#include "gfx/gfxDevice.h"
+
+/// Exposes the shader index of a ShaderGen that isn't the singleton and
+/// keeps its index file out of the shader cache.
+class ShaderGenIndexTester : public ShaderGen
+{
+public:
+   typedef ShaderGen Parent;
+
+   using ShaderGen::IndexEntry;
+   using ShaderGen::mIndex;
+   using ShaderGen::mProcShaders;
+   using ShaderGen::_loadIndex;
+   using ShaderGen::_saveIndex;
+   using ShaderGen::_appendToIndex;
+   using ShaderGen::_getFeatureSignature;
+
+   /// Keys prewarmShaders() tried to create a shader for.
+   Vector<String> mCreated;
+
+   ShaderGenIndexTester(const char *indexPath)
+   {
+      mIndexPath = indexPath;
+      mUseIndex = true;
+      setFileEnding("hlsl");
+   }
+
+   GFXShader* _createFromIndex(const String &cacheKey, const IndexEntry &entry, const Vector<String> &samplers) override
+   {
+      mCreated.push_back(cacheKey);
+      return Parent::_createFromIndex(cacheKey, entry, samplers);
+   }
+
+   static IndexEntry makeEntry(U64 featureSignature, U32 seed)
+   {
+      IndexEntry entry;
+      entry.featureSignature = featureSignature;
+      entry.pixVersion = 3.0f + seed;
+      entry.macros.push_back(GFXShaderMacro("TORQUE_SHADERGEN"));
+      entry.macros.push_back(GFXShaderMacro("SEED", String::ToString(seed)));
+      entry.samplers.push_back(String::ToString("sampler%d", seed));
+      entry.instancing.increment();
+      entry.instancing.last().semantic = "TEXCOORD";
+      entry.instancing.last().type = seed;
+      entry.instancing.last().index = seed + 1;
+      entry.instancing.last().stream = 1;
+      return entry;
+   }
+};
+
+FIXTURE(ShaderGenIndex)
+{
+public:
+   const char *mFileName = "shaderGenIndexTest.bin";
+
+   void SetUp() override
+   {
+      dFileDelete(mFileName);
+   }
+
+   void TearDown() override
+   {
+      dFileDelete(mFileName);
+   }
+};
+
+TEST_FIX(ShaderGenIndex, RoundTrip)
+{
+   ASSERT_TRUE(GFXDevice::devicePresent());
+
+   ShaderGenIndexTester writer(mFileName);
+   for (U32 i = 0; i < 10; i++)
+      writer.mIndex[String::ToString("key%d", i)] = ShaderGenIndexTester::makeEntry(100 + i, i);
+   ASSERT_TRUE(writer._saveIndex());
+
+   // Entries added later are appended
+   writer._appendToIndex("appended", ShaderGenIndexTester::makeEntry(5, 42));
+
+   ShaderGenIndexTester reader(mFileName);
+   reader._loadIndex();
+   ASSERT_EQ(reader.mIndex.size(), 11U);
+
+   for (U32 i = 0; i < 11; i++)
+   {
+      const String key = (i < 10) ? String::ToString("key%d", i) : String("appended");
+      const ShaderGenIndexTester::IndexEntry expected = (i < 10) ? ShaderGenIndexTester::makeEntry(100 + i, i) : ShaderGenIndexTester::makeEntry(5, 42);
+
+      ASSERT_TRUE(reader.mIndex.contains(key)) << key.c_str();
+      const ShaderGenIndexTester::IndexEntry &entry = reader.mIndex[key];
+      EXPECT_EQ(entry.featureSignature, expected.featureSignature);
+      EXPECT_EQ(entry.pixVersion, expected.pixVersion);
+
+      ASSERT_EQ(entry.macros.size(), expected.macros.size());
+      for (S32 j = 0; j < entry.macros.size(); j++)
+      {
+         EXPECT_STREQ(entry.macros[j].name.c_str(), expected.macros[j].name.c_str());
+         EXPECT_STREQ(entry.macros[j].value.c_str(), expected.macros[j].value.c_str());
+      }
+
+      ASSERT_EQ(entry.samplers.size(), expected.samplers.size());
+      EXPECT_STREQ(entry.samplers[0].c_str(), expected.samplers[0].c_str());
+
+      ASSERT_EQ(entry.instancing.size(), expected.instancing.size());
+      EXPECT_STREQ(entry.instancing[0].semantic.c_str(), expected.instancing[0].semantic.c_str());
+      EXPECT_EQ(entry.instancing[0].type, expected.instancing[0].type);
+      EXPECT_EQ(entry.instancing[0].index, expected.instancing[0].index);
+      EXPECT_EQ(entry.instancing[0].stream, expected.instancing[0].stream);
+   }
+}
+
+TEST_FIX(ShaderGenIndex, Compact)
+{
+   ASSERT_TRUE(GFXDevice::devicePresent());
+
+   ShaderGenIndexTester writer(mFileName);
+   for (U32 i = 0; i < 4; i++)
+      writer.mIndex[String::ToString("key%d", i)] = ShaderGenIndexTester::makeEntry(1, i);
+   ASSERT_TRUE(writer._saveIndex());
+   const S32 compactSize = Platform::getFileSize(mFileName);
+
+   // Regenerating the same shaders appends them again
+   for (U32 n = 0; n < 3; n++)
+   {
+      for (U32 i = 0; i < 4; i++)
+         writer._appendToIndex(String::ToString("key%d", i), ShaderGenIndexTester::makeEntry(1, i));
+   }
+   EXPECT_GT(Platform::getFileSize(mFileName), compactSize);
+
+   // Loading drops the replaced records from the file
+   ShaderGenIndexTester reader(mFileName);
+   reader._loadIndex();
+   EXPECT_EQ(reader.mIndex.size(), 4U);
+   EXPECT_EQ(Platform::getFileSize(mFileName), compactSize);
+
+   ShaderGenIndexTester reloaded(mFileName);
+   reloaded._loadIndex();
+   EXPECT_EQ(reloaded.mIndex.size(), 4U);
+}
+
+TEST_FIX(ShaderGenIndex, PrewarmSkipsStale)
+{
+   ASSERT_TRUE(GFXDevice::devicePresent());
+
+   ShaderGenIndexTester gen(mFileName);
+   const U64 signature = gen._getFeatureSignature();
+
+   // Current entries whose generated files are gone, and entries
+   // generated with a different set of features
+   gen.mIndex["current"] = ShaderGenIndexTester::makeEntry(signature, 0);
+   gen.mIndex["otherFeatures"] = ShaderGenIndexTester::makeEntry(signature + 1, 1);
+   gen.mIndex["otherFeatures2"] = ShaderGenIndexTester::makeEntry(~signature, 2);
+
+   EXPECT_EQ(gen.prewarmShaders(), 0U);
+
+   // Only the entry for the current features was tried, and the
+   // missing files kept it from being created
+   ASSERT_EQ(gen.mCreated.size(), 1U);
+   EXPECT_STREQ(gen.mCreated[0].c_str(), "current");
+   EXPECT_FALSE(gen.mProcShaders.contains("current"));
+}
@@ -0,0 +1,142 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "core/stringTable.h"
+#include "platform/threads/parallelFor.h"
+#include "platform/threads/jobSystem.h"
+#include "platform/platformTimer.h"
+#include "console/console.h"
+
+TEST(StringTableTest, CaseFolding)
+{
+   // Long enough to have whole words and a tail.
+   const char* lower = "stringtabletest_casefolding@[`{";
+   const char* mixed = "StringTableTest_CaseFolding@[`{";
+   const char* upper = "STRINGTABLETEST_CASEFOLDING@[`{";
+
+   EXPECT_EQ(_StringTable::hashString(lower), _StringTable::hashString(upper));
+   EXPECT_EQ(_StringTable::hashStringn(mixed, 9), _StringTable::hashString("STRINGTAB"));
+   EXPECT_NE(_StringTable::hashString("StringTableTest@"), _StringTable::hashString("StringTableTest`"));
+
+   StringTableEntry first = StringTable->insert(mixed);
+   EXPECT_EQ(StringTable->insert(lower), first);
+   EXPECT_EQ(StringTable->lookup(upper), first);
+   EXPECT_EQ(StringTable->lookupn(upper, dStrlen(upper)), first);
+   EXPECT_EQ(StringTable->lookupn(upper, 9), (StringTableEntry)NULL);
+
+   // A case sensitive insert adds a new entry, but case insensitive
+   // lookups still find the first.
+   StringTableEntry exact = StringTable->insert(upper, true);
+   EXPECT_NE(exact, first);
+   EXPECT_STREQ(exact, upper);
+   EXPECT_EQ(StringTable->lookup(upper, true), exact);
+   EXPECT_EQ(StringTable->lookup(upper), first);
+
+   // That still holds once the table has grown.
+   StringTable->resize(100000);
+   EXPECT_EQ(StringTable->lookup(lower), first);
+   EXPECT_EQ(StringTable->lookup(upper, true), exact);
+
+   EXPECT_EQ(StringTable->insertn(mixed, 9), StringTable->insert("stringtab"));
+   EXPECT_EQ(StringTable->insert(""), StringTable->EmptyString());
+}
+
+TEST(StringTableTest, Concurrent)
+{
+   // Strings are never removed from the table, so keep this small.
+   const U32 count = 10000;
+   const U32 numThreads = JobSystem::isGlobalRunning() ? JobSystem::GLOBAL().getNumThreads() + 1 : 1;
+   const U32 numTasks = getMax(numThreads, 4U);
+
+   Vector<String> strings;
+   for (U32 i = 0; i < count; i++)
+      strings.push_back(String::ToString("StringTableConcurrent_%d", i));
+
+   Vector<StringTableEntry> results;
+   results.setSize(count * numTasks);
+
+   // Every task adds every string, each starting at a different place,
+   // and reads back strings the others are adding.
+   parallelFor(0, numTasks, 1, [&](U32 start, U32 end)
+   {
+      for (U32 task = start; task < end; task++)
+      {
+         for (U32 i = 0; i < count; i++)
+         {
+            const U32 index = (i + task * count / numTasks) % count;
+            results[task * count + index] = StringTable->insert(strings[index]);
+
+            StringTableEntry other = StringTable->lookup(strings[(index + count / 2) % count]);
+            if (other)
+            {
+               EXPECT_STREQ(other, strings[(index + count / 2) % count].c_str());
+            }
+         }
+      }
+   });
+
+   for (U32 i = 0; i < count; i++)
+   {
+      StringTableEntry entry = results[i];
+      ASSERT_STREQ(entry, strings[i].c_str());
+      EXPECT_EQ(StringTable->lookup(strings[i]), entry);
+      for (U32 task = 1; task < numTasks; task++)
+         ASSERT_EQ(results[task * count + i], entry) << "string " << i << ", task " << task;
+   }
+}
+
+TEST(StringTableTest, Benchmark)
+{
+   // The strings stay in the table for the rest of the run.
+   const U32 count = 20000;
+   const U32 numLookups = 2000000;
+
+   Vector<String> strings;
+   for (U32 i = 0; i < count; i++)
+      strings.push_back(String::ToString("StringTableBenchmark_%d_%x", i, i * 2654435761U));
+
+   PlatformTimer* timer = PlatformTimer::create();
+   for (U32 i = 0; i < count; i++)
+      StringTable->insert(strings[i]);
+   const U32 insertMs = timer->getElapsedMs();
+
+   timer->reset();
+   U32 found = 0;
+   for (U32 i = 0; i < numLookups; i++)
+      found += StringTable->lookup(strings[i % count]) != NULL;
+   const U32 lookupMs = timer->getElapsedMs();
+   EXPECT_EQ(found, numLookups);
+
+   const U32 numThreads = JobSystem::isGlobalRunning() ? JobSystem::GLOBAL().getNumThreads() + 1 : 1;
+   timer->reset();
+   parallelFor(0, numLookups, 10000, [&](U32 start, U32 end)
+   {
+      for (U32 i = start; i < end; i++)
+         StringTable->lookup(strings[i % count]);
+   });
+   const U32 parallelMs = timer->getElapsedMs();
+   delete timer;
+
+   Con::printf("StringTable: %d inserts %5dms, %d lookups %5dms serial, %5dms on %d threads",
+      count, insertMs, numLookups, lookupMs, parallelMs, numThreads);
+}
@@ -0,0 +1,208 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "terrain/terrFile.h"
+#include "gfx/bitmap/gBitmap.h"
+#include "core/util/endian.h"
+
+static U32 sPageSignalCount = 0;
+
+static void countPageSignal( const RectI &rect )
+{
+   sPageSignalCount++;
+}
+
+FIXTURE(TerrainStreaming)
+{
+public:
+   static const U32 smSize = 512;
+
+   String mFileName;
+   TerrainFile *mFlat;
+   TerrainFile *mStreamed;
+
+   bool mStreamPages;
+   S32 mEvictTime;
+
+   void SetUp() override
+   {
+      mFlat = NULL;
+      mStreamed = NULL;
+      mStreamPages = TerrainFile::smStreamPages;
+      mEvictTime = TerrainFile::smPageEvictTime;
+
+      // Some hills with a few layers and a hole.
+      GBitmap heightMap( smSize, smSize, false, GFXFormatL16 );
+      U16 *bits = (U16*)heightMap.getWritableBits();
+
+      Vector<U8> layerMap;
+      layerMap.setSize( smSize * smSize );
+
+      for ( U32 y = 0; y < smSize; y++ )
+      {
+         for ( U32 x = 0; x < smSize; x++ )
+         {
+            const F32 height = ( mSin( x * 0.05f ) * mCos( y * 0.03f ) + 1.0f ) * 0.5f;
+            bits[ x + y * smSize ] = convertHostToBEndian( (U16)( height * U16_MAX ) );
+
+            const bool hole = x >= 300 && x < 310 && y >= 20 && y < 30;
+            layerMap[ x + y * smSize ] = hole ? U8_MAX : ( x / 16 + y / 16 ) % 3;
+         }
+      }
+
+      TerrainFile file;
+      file.import( heightMap, 256.0f, layerMap, Vector<String>() );
+
+      mFileName = "terrainStreamingTest.ter";
+      ASSERT_TRUE( file.save( mFileName.c_str() ) );
+
+      TerrainFile::smStreamPages = false;
+      mFlat = TerrainFile::load( mFileName );
+      TerrainFile::smStreamPages = true;
+      mStreamed = TerrainFile::load( mFileName );
+
+      ASSERT_TRUE( mFlat != NULL );
+      ASSERT_TRUE( mStreamed != NULL );
+   }
+
+   void TearDown() override
+   {
+      SAFE_DELETE( mFlat );
+      SAFE_DELETE( mStreamed );
+
+      TerrainFile::smStreamPages = mStreamPages;
+      TerrainFile::smPageEvictTime = mEvictTime;
+
+      dFileDelete( mFileName );
+   }
+
+   /// Expects the grid squares of the page at x, y to 
+   /// match the ones built from the whole terrain.
+   void expectPageGrid( U32 x, U32 y )
+   {
+      const U32 pageSize = mStreamed->getPageSize();
+
+      for ( U32 level = 0; ( 1U << level ) < pageSize; level++ )
+      {
+         for ( U32 sy = y; sy < y + pageSize; sy += 1 << level )
+         {
+            for ( U32 sx = x; sx < x + pageSize; sx += 1 << level )
+            {
+               const TerrainSquare *a = mFlat->findSquare( level, sx, sy );
+               const TerrainSquare *b = mStreamed->findSquare( level, sx, sy );
+               ASSERT_EQ( a->minHeight, b->minHeight );
+               ASSERT_EQ( a->maxHeight, b->maxHeight );
+               ASSERT_EQ( a->flags, b->flags );
+            }
+         }
+      }
+   }
+};
+
+TEST_FIX(TerrainStreaming, HeaderOnly)
+{
+   EXPECT_FALSE( mFlat->isStreamed() );
+   EXPECT_TRUE( mStreamed->isStreamed() );
+   EXPECT_EQ( mStreamed->getPageSize(), TerrainFile::PAGE_SIZE );
+
+   // Nothing is loaded so it all reads as a hole.
+   EXPECT_FALSE( mStreamed->isResident( 0, 0 ) );
+   EXPECT_FALSE( mStreamed->isAnyResident( RectI( 0, 0, smSize, smSize ) ) );
+   EXPECT_EQ( mStreamed->getLayerIndex( 10, 10 ), U8_MAX );
+   EXPECT_TRUE( mStreamed->findSquare( 0, 10, 10 )->flags & TerrainSquare::Empty );
+
+   // The levels above the pages come with the header.
+   EXPECT_EQ( mStreamed->getMaxHeight(), mFlat->getMaxHeight() );
+   for ( U32 level = 8; level <= 9; level++ )
+   {
+      const TerrainSquare *a = mFlat->findSquare( level, 300, 20 );
+      const TerrainSquare *b = mStreamed->findSquare( level, 300, 20 );
+      EXPECT_EQ( a->minHeight, b->minHeight );
+      EXPECT_EQ( a->maxHeight, b->maxHeight );
+      EXPECT_EQ( a->flags, b->flags );
+   }
+
+   // Streamed files can't be saved.
+   EXPECT_FALSE( mStreamed->save( mFileName.c_str() ) );
+}
+
+TEST_FIX(TerrainStreaming, LoadPages)
+{
+   sPageSignalCount = 0;
+   mStreamed->getPageSignal().notify( &countPageSignal );
+
+   mStreamed->requestPages( RectI( 0, 0, 1, 1 ) );
+   mStreamed->requestPages( RectI( 300, 20, 1, 1 ) );
+   mStreamed->flushPageLoads();
+   EXPECT_EQ( sPageSignalCount, 2U );
+
+   EXPECT_TRUE( mStreamed->isResident( RectI( 0, 0, smSize, 256 ) ) );
+   EXPECT_FALSE( mStreamed->isResident( RectI( 0, 0, smSize, smSize ) ) );
+   EXPECT_FALSE( mStreamed->isResident( 0, 256 ) );
+
+   // The loaded pages match the flat file, including the
+   // border samples shared with the pages which are not loaded.
+   for ( U32 y = 0; y <= 256; y++ )
+   {
+      for ( U32 x = 0; x < smSize; x++ )
+      {
+         ASSERT_EQ( mStreamed->getHeight( x, y ), mFlat->getHeight( x, y ) );
+         if ( y < 256 )
+         {
+            ASSERT_EQ( mStreamed->getLayerIndex( x, y ), mFlat->getLayerIndex( x, y ) );
+         }
+      }
+   }
+
+   expectPageGrid( 0, 0 );
+   expectPageGrid( 256, 0 );
+
+   // The hole is there too.
+   EXPECT_TRUE( mStreamed->findSquare( 0, 305, 25 )->flags & TerrainSquare::Empty );
+   EXPECT_FALSE( mStreamed->findSquare( 0, 200, 25 )->flags & TerrainSquare::Empty );
+
+   mStreamed->getPageSignal().remove( &countPageSignal );
+}
+
+TEST_FIX(TerrainStreaming, EvictPages)
+{
+   mStreamed->requestPages( RectI( 0, 0, 1, 1 ) );
+   mStreamed->flushPageLoads();
+   ASSERT_TRUE( mStreamed->isResident( 0, 0 ) );
+
+   // Pages stay loaded while they are requested.
+   TerrainFile::smPageEvictTime = 60000;
+   mStreamed->updatePages();
+   EXPECT_TRUE( mStreamed->isResident( 0, 0 ) );
+
+   TerrainFile::smPageEvictTime = 0;
+   mStreamed->updatePages();
+   EXPECT_FALSE( mStreamed->isResident( 0, 0 ) );
+   EXPECT_EQ( mStreamed->getHeight( 10, 10 ), 0 );
+   EXPECT_TRUE( mStreamed->findSquare( 0, 10, 10 )->flags & TerrainSquare::Empty );
+
+   // They load again on the next request.
+   mStreamed->requestPages( RectI( 0, 0, 1, 1 ) );
+   mStreamed->flushPageLoads();
+   EXPECT_EQ( mStreamed->getHeight( 10, 10 ), mFlat->getHeight( 10, 10 ) );
+}
@@ -0,0 +1,130 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "gfx/gfxDevice.h"
+#include "gfx/gfxTextureManager.h"
+#include "gfx/gfxTextureProfile.h"
+#include "gfx/bitmap/gBitmap.h"
+#include "core/stream/fileStream.h"
+#include "platform/platformTimer.h"
+#include "platform/threads/threadPool.h"
+
+FIXTURE(TextureAsyncLoad)
+{
+public:
+   Vector<String> mFiles;
+
+   /// Writes a width x height png and returns its name.
+   String writeTexture(U32 index, U32 width, U32 height)
+   {
+      String fileName = String::ToString("asyncTextureTest%d.png", index);
+
+      GBitmap bmp(width, height, false, GFXFormatR8G8B8A8);
+      bmp.fill(ColorI(255, 0, 0, 255));
+
+      FileStream fs;
+      EXPECT_TRUE(fs.open(fileName, Torque::FS::File::Write));
+      EXPECT_TRUE(bmp.writeBitmap("png", fs));
+      fs.close();
+
+      mFiles.push_back(fileName);
+      return fileName;
+   }
+
+   void TearDown() override
+   {
+      TEXMGR->flushAsyncLoads();
+      TEXMGR->cleanupCache();
+
+      for (S32 i = 0; i < mFiles.size(); i++)
+         dFileDelete(mFiles[i]);
+   }
+};
+
+TEST_FIX(TextureAsyncLoad, Placeholder)
+{
+   const String fileName = writeTexture(0, 64, 32);
+
+   GFXTexHandle tex;
+   ASSERT_TRUE(tex.setAsync(fileName, &GFXStaticTextureProfile, "TextureAsyncLoad"));
+
+   // The handle is valid right away and a second request
+   // gets the same placeholder.
+   EXPECT_TRUE(TEXMGR->isTextureLoading(tex));
+   EXPECT_EQ(tex->getBitmapWidth(), 4);
+   EXPECT_EQ(tex->getBitmapHeight(), 4);
+   EXPECT_EQ(TEXMGR->createTextureAsync(fileName, &GFXStaticTextureProfile), tex.getPointer());
+
+   // Once flushed the same object holds the real texture.
+   GFXTextureObject *obj = tex;
+   TEXMGR->flushAsyncLoads();
+   EXPECT_FALSE(TEXMGR->isTextureLoading(tex));
+   EXPECT_EQ(tex.getPointer(), obj);
+   EXPECT_EQ(tex->getBitmapWidth(), 64);
+   EXPECT_EQ(tex->getBitmapHeight(), 32);
+   EXPECT_FALSE(tex->getPath().isEmpty());
+}
+
+TEST_FIX(TextureAsyncLoad, UploadBudget)
+{
+   const U32 count = 4;
+
+   Vector<GFXTexHandle> texs;
+   for (U32 i = 0; i < count; i++)
+   {
+      texs.push_back(GFXTexHandle());
+      ASSERT_TRUE(texs.last().setAsync(writeTexture(i, 16, 16), &GFXStaticTextureProfile, "TextureAsyncLoad"));
+   }
+
+   // With no budget each frame still uploads one texture,
+   // in the order they were requested.
+   PlatformTimer *timer = PlatformTimer::create();
+   U32 done = 0;
+   while (done < count && timer->getElapsedMs() < 10000)
+   {
+      const U32 uploaded = TEXMGR->processAsyncLoads(0);
+      ASSERT_LE(uploaded, 1);
+
+      if (uploaded)
+      {
+         EXPECT_FALSE(TEXMGR->isTextureLoading(texs[done]));
+         EXPECT_EQ(texs[done]->getBitmapWidth(), 16);
+         done++;
+
+         // Later requests wait their turn even if they decoded first.
+         for (U32 i = done; i < count; i++)
+            EXPECT_TRUE(TEXMGR->isTextureLoading(texs[i])) << "texture " << i;
+      }
+      else
+         Platform::sleep(1);
+   }
+   delete timer;
+
+   EXPECT_EQ(done, count);
+
+   // A budget larger than all of them uploads them in one go.
+   for (U32 i = 0; i < count; i++)
+      texs[i].setAsync(writeTexture(count + i, 16, 16), &GFXStaticTextureProfile, "TextureAsyncLoad");
+   ThreadPool::GLOBAL().waitForAllItems();
+   EXPECT_EQ(TEXMGR->processAsyncLoads(U32_MAX), count);
+}
@@ -0,0 +1,151 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2014 GarageGames, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "testing/unitTesting.h"
+#include "ts/tsMesh.h"
+#include "ts/tsMeshIntrinsics.h"
+#include "ts/arch/tsMeshIntrinsics.arch.h"
+#include "math/mMatrix.h"
+#include "math/mRandom.h"
+
+extern void skin_verts_bulk_C(const TSSkinMesh::BatchData &batch, const MatrixF * __restrict const boneTransforms, U8 * __restrict const outPtr, const dsize_t outStride);
+
+FIXTURE(TSSkinMeshIntrinsics)
+{
+public:
+   static const U32 numBones = 12;
+   static const U32 numVerts = 512;
+
+   TSSkinMesh::BatchData mBatch;
+   Vector<MatrixF> mBones;
+   Vector<TSMesh::__TSMeshVertexBase> mExpected;
+
+   void SetUp() override
+   {
+      MRandomLCG rand(1234);
+
+      mBones.setSize(numBones);
+      for (U32 i = 0; i < numBones; i++)
+      {
+         EulerF rot(rand.randF(-M_PI_F, M_PI_F), rand.randF(-M_PI_F, M_PI_F), rand.randF(-M_PI_F, M_PI_F));
+         Point3F pos(rand.randF(-10.0f, 10.0f), rand.randF(-10.0f, 10.0f), rand.randF(-10.0f, 10.0f));
+         mBones[i] = MatrixF(rot, pos);
+      }
+
+      mBatch.initialVerts.setSize(numVerts);
+      mBatch.initialNorms.setSize(numVerts);
+      mBatch.vertexBatchOperations.setSize(numVerts);
+      for (U32 i = 0; i < numVerts; i++)
+      {
+         mBatch.initialVerts[i].set(rand.randF(-5.0f, 5.0f), rand.randF(-5.0f, 5.0f), rand.randF(-5.0f, 5.0f));
+         mBatch.initialNorms[i].set(rand.randF(-1.0f, 1.0f), rand.randF(-1.0f, 1.0f), rand.randF(-1.0f, 1.0f));
+         mBatch.initialNorms[i].normalizeSafe();
+
+         TSSkinMesh::BatchData::BatchedVertex &op = mBatch.vertexBatchOperations[i];
+         op = TSSkinMesh::BatchData::BatchedVertex();
+         op.vertexIndex = i;
+         op.transformCount = rand.randI(1, 4);
+
+         F32 totalWeight = 0.0f;
+         for (S32 j = 0; j < op.transformCount; j++)
+         {
+            op.transform[j].transformIndex = rand.randI(0, numBones - 1);
+            op.transform[j].weight = rand.randF(0.1f, 1.0f);
+            totalWeight += op.transform[j].weight;
+         }
+         for (S32 j = 0; j < op.transformCount; j++)
+            op.transform[j].weight /= totalWeight;
+      }
+
+      mBatch.flattenBatchOperations();
+      mBatch.initialized = true;
+
+      // Reference results from the per vertex scalar path.
+      mExpected.setSize(numVerts);
+      for (U32 i = 0; i < numVerts; i++)
+      {
+         const TSSkinMesh::BatchData::BatchedVertex &op = mBatch.vertexBatchOperations[i];
+         Point3F skinnedVert(Point3F::Zero), skinnedNorm(Point3F::Zero), srcVtx, srcNrm;
+         for (S32 j = 0; j < op.transformCount; j++)
+         {
+            const MatrixF &mat = mBones[op.transform[j].transformIndex];
+            mat.mulP(mBatch.initialVerts[op.vertexIndex], &srcVtx);
+            skinnedVert += srcVtx * op.transform[j].weight;
+            mat.mulV(mBatch.initialNorms[op.vertexIndex], &srcNrm);
+            skinnedNorm += srcNrm * op.transform[j].weight;
+         }
+         mExpected[op.vertexIndex].vert(skinnedVert);
+         mExpected[op.vertexIndex].normal(skinnedNorm);
+      }
+   }
+
+   void checkKernel(void (*kernel)(const TSSkinMesh::BatchData &, const MatrixF * __restrict const, U8 * __restrict const, const dsize_t))
+   {
+      Vector<TSMesh::__TSMeshVertexBase> result;
+      result.setSize(numVerts);
+      dMemset(result.address(), 0, result.memSize());
+
+      kernel(mBatch, mBones.address(), (U8*)result.address(), sizeof(TSMesh::__TSMeshVertexBase));
+
+      for (U32 i = 0; i < numVerts; i++)
+      {
+         EXPECT_NEAR(result[i].vert().x, mExpected[i].vert().x, 1e-4f) << "vertex " << i;
+         EXPECT_NEAR(result[i].vert().y, mExpected[i].vert().y, 1e-4f) << "vertex " << i;
+         EXPECT_NEAR(result[i].vert().z, mExpected[i].vert().z, 1e-4f) << "vertex " << i;
+         EXPECT_NEAR(result[i].normal().x, mExpected[i].normal().x, 1e-5f) << "normal " << i;
+         EXPECT_NEAR(result[i].normal().y, mExpected[i].normal().y, 1e-5f) << "normal " << i;
+         EXPECT_NEAR(result[i].normal().z, mExpected[i].normal().z, 1e-5f) << "normal " << i;
+      }
+   }
+};
+
+TEST_FIX(TSSkinMeshIntrinsics, FlattenBatch)
+{
+   EXPECT_EQ(mBatch.soaVertexIndex.size(), numVerts);
+   EXPECT_EQ(mBatch.soaInfluenceStart.size(), numVerts + 1);
+   EXPECT_EQ(mBatch.soaTransformIndex.size(), mBatch.soaInfluenceStart.last());
+   EXPECT_EQ(mBatch.soaWeight.size(), mBatch.soaInfluenceStart.last());
+
+   for (U32 i = 0; i < numVerts; i++)
+      EXPECT_EQ(mBatch.soaInfluenceStart[i + 1] - mBatch.soaInfluenceStart[i], mBatch.vertexBatchOperations[i].transformCount);
+}
+
+TEST_FIX(TSSkinMeshIntrinsics, SkinC)
+{
+   checkKernel(skin_verts_bulk_C);
+}
+
+#if (defined( TORQUE_CPU_X86 ) || defined( TORQUE_CPU_X64 ))
+TEST_FIX(TSSkinMeshIntrinsics, SkinSSE)
+{
+   if (!(Platform::SystemInfo.processor.properties & CPU_PROP_SSE))
+      return;
+
+   checkKernel(skin_verts_bulk_SSE);
+}
+#endif
+
+TEST_FIX(TSSkinMeshIntrinsics, SkinDispatched)
+{
+   ASSERT_TRUE(skin_verts_bulk != NULL);
+   checkKernel(skin_verts_bulk);
+}
@@ -26,6 +26,7 @@
 #if (defined( TORQUE_CPU_X86 ) || defined( TORQUE_CPU_X64 )) 
 # // x86 CPU family implementations
 extern void zero_vert_normal_bulk_SSE(const dsize_t count, U8 * __restrict const outPtr, const dsize_t outStride);
+extern void skin_verts_bulk_SSE(const TSSkinMesh::BatchData &batch, const MatrixF * __restrict const boneTransforms, U8 * __restrict const outPtr, const dsize_t outStride);
 #
 #else
 # // Other CPU types go here...
@@ -67,4 +67,64 @@ void zero_vert_normal_bulk_SSE(const dsize_t count, U8 * __restrict const outPtr
 
 //------------------------------------------------------------------------------
 
+static inline void _store_point3f(Point3F &p, const __m128 v)
+{
+   _mm_storel_pi(reinterpret_cast<__m64 *>(&p.x), v);
+   _mm_store_ss(&p.z, _mm_movehl_ps(v, v));
+}
+
+void skin_verts_bulk_SSE(const TSSkinMesh::BatchData &batch, const MatrixF * __restrict const boneTransforms, U8 * __restrict const outPtr, const dsize_t outStride)
+{
+   const Point3F *inVerts = batch.initialVerts.address();
+   const Point3F *inNorms = batch.initialNorms.address();
+   const S32 *vertexIndex = batch.soaVertexIndex.address();
+   const U32 *influenceStart = batch.soaInfluenceStart.address();
+   const S32 *transformIndex = batch.soaTransformIndex.address();
+   const F32 *weight = batch.soaWeight.address();
+
+   const S32 count = batch.soaVertexIndex.size();
+   for(S32 i = 0; i < count; i++)
+   {
+      const S32 vidx = vertexIndex[i];
+
+      // Blend the rows of the influencing bone transforms.  Skinning is linear
+      // so transforming by the blended matrix is the same as blending the
+      // individually transformed points.
+      __m128 row0 = _mm_setzero_ps();
+      __m128 row1 = _mm_setzero_ps();
+      __m128 row2 = _mm_setzero_ps();
+      __m128 row3 = _mm_setzero_ps();
+
+      for(U32 j = influenceStart[i]; j < influenceStart[i + 1]; j++)
+      {
+         const F32 *m = boneTransforms[transformIndex[j]];
+         const __m128 w = _mm_set1_ps(weight[j]);
+
+         row0 = _mm_add_ps(row0, _mm_mul_ps(w, _mm_loadu_ps(m)));
+         row1 = _mm_add_ps(row1, _mm_mul_ps(w, _mm_loadu_ps(m + 4)));
+         row2 = _mm_add_ps(row2, _mm_mul_ps(w, _mm_loadu_ps(m + 8)));
+      }
+
+      // Columns of the blended matrix; row3 becomes the translation.
+      _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+      const Point3F &v = inVerts[vidx];
+      const Point3F &n = inNorms[vidx];
+
+      __m128 pos = _mm_add_ps(_mm_mul_ps(row0, _mm_set1_ps(v.x)), row3);
+      pos = _mm_add_ps(pos, _mm_mul_ps(row1, _mm_set1_ps(v.y)));
+      pos = _mm_add_ps(pos, _mm_mul_ps(row2, _mm_set1_ps(v.z)));
+
+      __m128 nrm = _mm_mul_ps(row0, _mm_set1_ps(n.x));
+      nrm = _mm_add_ps(nrm, _mm_mul_ps(row1, _mm_set1_ps(n.y)));
+      nrm = _mm_add_ps(nrm, _mm_mul_ps(row2, _mm_set1_ps(n.z)));
+
+      TSMesh::__TSMeshVertexBase *outElem = reinterpret_cast<TSMesh::__TSMeshVertexBase *>(outPtr + outStride * vidx);
+      _store_point3f(outElem->_vert, pos);
+      _store_point3f(outElem->_normal, nrm);
+   }
+}
+
+//------------------------------------------------------------------------------
+
 #endif // TORQUE_CPU_X86
\ No newline at end of file
@@ -779,13 +779,11 @@ TSShape* assimpLoadShape(const Torque::Path &path)
    // if so, use that instead.
    if (AssimpShapeLoader::canLoadCachedDTS(path))
    {
-      FileStream cachedStream;
-      cachedStream.open(cachedPath.getFullPath(), Torque::FS::File::Read);
-      if (cachedStream.getStatus() == Stream::Ok)
+      Torque::FS::MappedFileRef cachedFile = Torque::FS::MapFile(cachedPath);
+      if (cachedFile != NULL)
       {
          TSShape *shape = new TSShape;
-         bool readSuccess = shape->read(&cachedStream);
-         cachedStream.close();
+         bool readSuccess = shape->read(cachedFile);
 
          if (readSuccess)
          {
@@ -823,6 +821,8 @@ TSShape* assimpLoadShape(const Torque::Path &path)
       Con::printf("[ASSIMP] Shape created successfully.");
 
       // Cache the model to a DTS file for faster loading next time.
+      // A shape loaded from the old cached file may still be mapping it.
+      TSShape::releaseMappedFiles(cachedPath);
       FileStream dtsStream;
       if (dtsStream.open(cachedPath.getFullPath(), Torque::FS::File::Write))
       {
@@ -661,13 +661,11 @@ TSShape* loadColladaShape(const Torque::Path &path)
    // if so, use that instead.
    if (ColladaShapeLoader::canLoadCachedDTS(path))
    {
-      FileStream cachedStream;
-      cachedStream.open(cachedPath.getFullPath(), Torque::FS::File::Read);
-      if (cachedStream.getStatus() == Stream::Ok)
+      Torque::FS::MappedFileRef cachedFile = Torque::FS::MapFile(cachedPath);
+      if (cachedFile != NULL)
       {
          TSShape *shape = new TSShape;
-         bool readSuccess = shape->read(&cachedStream);
-         cachedStream.close();
+         bool readSuccess = shape->read(cachedFile);
 
          if (readSuccess)
          {
@@ -725,6 +723,8 @@ TSShape* loadColladaShape(const Torque::Path &path)
       {
 #ifndef DAE2DTS_TOOL
          // Cache the Collada model to a DTS file for faster loading next time.
+         // A shape loaded from the old cached file may still be mapping it.
+         TSShape::releaseMappedFiles(cachedPath);
          FileStream dtsStream;
          
          if (dtsStream.open(cachedPath.getFullPath(), Torque::FS::File::Write))
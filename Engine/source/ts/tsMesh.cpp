@@ -1211,7 +1211,7 @@ TSMesh::~TSMesh()
 // TSSkinMesh methods
 //-----------------------------------------------------
 
-void TSSkinMesh::updateSkinBuffer( const Vector<MatrixF> &transforms, U8* buffer )
+void TSSkinMesh::updateSkinBuffer( const Vector<MatrixF> &transforms, U8* buffer, Vector<MatrixF> &boneTransforms )
 {
    PROFILE_SCOPE(TSSkinMesh_UpdateSkinBuffer);
 
@@ -1222,62 +1222,28 @@ void TSSkinMesh::updateSkinBuffer( const Vector<MatrixF> &transforms, U8* buffer
 
    const MatrixF *matrices = NULL;
 
-   static Vector<MatrixF> sBoneTransforms;
-   sBoneTransforms.setSize(batchData.nodeIndex.size());
+   boneTransforms.setSize(batchData.nodeIndex.size());
 
    // set up bone transforms
    PROFILE_START(TSSkinMesh_UpdateTransforms);
    for (S32 i = 0; i < batchData.nodeIndex.size(); i++)
    {
       S32 node = batchData.nodeIndex[i];
-      sBoneTransforms[i].mul(transforms[node], batchData.initialTransforms[i]);
+      boneTransforms[i].mul(transforms[node], batchData.initialTransforms[i]);
    }
 
-   matrices = &sBoneTransforms[0];
+   matrices = boneTransforms.address();
    PROFILE_END();
 
-   const Point3F *inVerts = batchData.initialVerts.address();
-   const Point3F *inNorms = batchData.initialNorms.address();
-
-   AssertFatal(inVerts, "Something went wrong, verts should be valid");
+   AssertFatal(batchData.initialVerts.address(), "Something went wrong, verts should be valid");
 
    U8 *dest = buffer + mVertOffset;
    if (!dest)
       return;
 
-   Point3F srcVtx, srcNrm;
-
    AssertFatal(batchData.vertexBatchOperations.size() == batchData.initialVerts.size(), "Assumption failed!");
 
-   Point3F skinnedVert;
-   Point3F skinnedNorm;
-
-   for (Vector<BatchData::BatchedVertex>::const_iterator itr = batchData.vertexBatchOperations.begin();
-      itr != batchData.vertexBatchOperations.end(); itr++)
-   {
-      const BatchData::BatchedVertex &curVert = *itr;
-
-      skinnedVert.zero();
-      skinnedNorm.zero();
-
-      for (S32 tOp = 0; tOp < curVert.transformCount; tOp++)
-      {
-         const BatchData::TransformOp &transformOp = curVert.transform[tOp];
-
-         const MatrixF& deltaTransform = matrices[transformOp.transformIndex];
-
-         deltaTransform.mulP(inVerts[curVert.vertexIndex], &srcVtx);
-         skinnedVert += (srcVtx * transformOp.weight);
-
-         deltaTransform.mulV(inNorms[curVert.vertexIndex], &srcNrm);
-         skinnedNorm += srcNrm * transformOp.weight;
-      }
-
-      // Assign results 
-      __TSMeshVertexBase *dvert = (__TSMeshVertexBase*)(dest + (mVertSize * curVert.vertexIndex));
-      dvert->vert(skinnedVert);
-      dvert->normal(skinnedNorm);
-   }
+   skin_verts_bulk(batchData, matrices, dest, mVertSize);
 }
 
 void TSSkinMesh::updateSkinBones( const Vector<MatrixF> &transforms, Vector<MatrixF>& destTransforms )
@@ -1425,6 +1391,7 @@ void TSSkinMesh::createSkinBatchData()
    }
 
    batchData.vertexBatchOperations.set(batchOperations.address(), batchOperations.size());
+   batchData.flattenBatchOperations();
 
    U32 maxValue = 0;
    for (U32 i = 0; i<batchData.vertexBatchOperations.size(); i++)
@@ -1434,6 +1401,35 @@ void TSSkinMesh::createSkinBatchData()
    maxBones = maxValue;
 }
 
+void TSSkinMesh::BatchData::flattenBatchOperations()
+{
+   const U32 numOps = vertexBatchOperations.size();
+
+   U32 numInfluences = 0;
+   for (U32 i = 0; i < numOps; i++)
+      numInfluences += vertexBatchOperations[i].transformCount;
+
+   soaVertexIndex.setSize(numOps);
+   soaInfluenceStart.setSize(numOps + 1);
+   soaTransformIndex.setSize(numInfluences);
+   soaWeight.setSize(numInfluences);
+
+   U32 curInfluence = 0;
+   for (U32 i = 0; i < numOps; i++)
+   {
+      const BatchedVertex &op = vertexBatchOperations[i];
+      soaVertexIndex[i] = op.vertexIndex;
+      soaInfluenceStart[i] = curInfluence;
+
+      for (S32 j = 0; j < op.transformCount; j++, curInfluence++)
+      {
+         soaTransformIndex[curInfluence] = op.transform[j].transformIndex;
+         soaWeight[curInfluence] = op.transform[j].weight;
+      }
+   }
+   soaInfluenceStart[numOps] = curInfluence;
+}
+
 void TSSkinMesh::setupVertexTransforms()
 {
    AssertFatal(mVertexData.vertSize() == mVertSize, "vert size mismatch");
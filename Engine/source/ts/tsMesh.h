@@ -531,6 +531,20 @@ public:
       Vector<BatchedVertex> vertexBatchOperations;
       /// @}
 
+      /// @name Flattened batch
+      /// Structure-of-arrays copy of vertexBatchOperations used by the bulk
+      /// skinning kernels (see tsMeshIntrinsics.h).  The influences of batch
+      /// entry i are [influenceStart[i], influenceStart[i+1]).
+      /// @{
+      Vector<S32> soaVertexIndex;
+      Vector<U32> soaInfluenceStart;
+      Vector<S32> soaTransformIndex;
+      Vector<F32> soaWeight;
+
+      /// Rebuild the flattened batch from vertexBatchOperations.
+      void flattenBatchOperations();
+      /// @}
+
       // # = num bones
       Vector<S32> nodeIndex;
       Vector<MatrixF> initialTransforms;
@@ -581,7 +595,10 @@ public:
    BatchData batchData;
 
    /// set verts and normals...
-   void updateSkinBuffer( const Vector<MatrixF> &transforms, U8 *buffer );
+   ///
+   /// @param boneTransforms  Scratch storage for the per bone skinning matrices.
+   ///                        Callers on different threads must pass distinct vectors.
+   void updateSkinBuffer( const Vector<MatrixF> &transforms, U8 *buffer, Vector<MatrixF> &boneTransforms );
 
    /// update bone transforms for this mesh
    void updateSkinBones( const Vector<MatrixF> &transforms, Vector<MatrixF>& destTransforms );
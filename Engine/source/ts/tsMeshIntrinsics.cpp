@@ -26,6 +26,7 @@
 
 
 void (*zero_vert_normal_bulk)(const dsize_t count, U8 * __restrict const outPtr, const dsize_t outStride) = NULL;
+void (*skin_verts_bulk)(const TSSkinMesh::BatchData &batch, const MatrixF * __restrict const boneTransforms, U8 * __restrict const outPtr, const dsize_t outStride) = NULL;
 
 //------------------------------------------------------------------------------
 // Default C++ Implementations (pretty slow)
@@ -46,6 +47,43 @@ void zero_vert_normal_bulk_C(const dsize_t count, U8 * __restrict const outPtr,
    }
 }
 
+void skin_verts_bulk_C(const TSSkinMesh::BatchData &batch, const MatrixF * __restrict const boneTransforms, U8 * __restrict const outPtr, const dsize_t outStride)
+{
+   const Point3F *inVerts = batch.initialVerts.address();
+   const Point3F *inNorms = batch.initialNorms.address();
+   const S32 *vertexIndex = batch.soaVertexIndex.address();
+   const U32 *influenceStart = batch.soaInfluenceStart.address();
+   const S32 *transformIndex = batch.soaTransformIndex.address();
+   const F32 *weight = batch.soaWeight.address();
+
+   Point3F srcVtx, srcNrm;
+   Point3F skinnedVert, skinnedNorm;
+
+   const S32 count = batch.soaVertexIndex.size();
+   for(S32 i = 0; i < count; i++)
+   {
+      const S32 vidx = vertexIndex[i];
+
+      skinnedVert.zero();
+      skinnedNorm.zero();
+
+      for(U32 j = influenceStart[i]; j < influenceStart[i + 1]; j++)
+      {
+         const MatrixF &deltaTransform = boneTransforms[transformIndex[j]];
+
+         deltaTransform.mulP(inVerts[vidx], &srcVtx);
+         skinnedVert += srcVtx * weight[j];
+
+         deltaTransform.mulV(inNorms[vidx], &srcNrm);
+         skinnedNorm += srcNrm * weight[j];
+      }
+
+      TSMesh::__TSMeshVertexBase *outElem = reinterpret_cast<TSMesh::__TSMeshVertexBase *>(outPtr + outStride * vidx);
+      outElem->vert(skinnedVert);
+      outElem->normal(skinnedNorm);
+   }
+}
+
 //------------------------------------------------------------------------------
 // Initializer.
 //------------------------------------------------------------------------------
@@ -58,12 +96,14 @@ MODULE_BEGIN( TSMeshIntrinsics )
    {
       // Assign defaults (C++ versions)
       zero_vert_normal_bulk = zero_vert_normal_bulk_C;
+      skin_verts_bulk = skin_verts_bulk_C;
 
       // Find the best implementation for the current CPU
       if(Platform::SystemInfo.processor.properties & CPU_PROP_SSE)
       {
          #if (defined( TORQUE_CPU_X86 ) || defined( TORQUE_CPU_X64 )) 
             zero_vert_normal_bulk = zero_vert_normal_bulk_SSE;
+            skin_verts_bulk = skin_verts_bulk_SSE;
          #endif
       }
    }
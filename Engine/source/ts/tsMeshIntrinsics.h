@@ -33,5 +33,17 @@ extern void (*zero_vert_normal_bulk)
                            U8 * __restrict const outPtr, 
                            const dsize_t outStride);
 
+/// Skin the vertex positions and normals of a skin mesh batch.
+///
+/// @param batch          Initialized batch data of the skin mesh
+/// @param boneTransforms Bone transforms, indexed by the batch transform indices
+/// @param outPtr         Pointer to the mesh's first vertex in a TSMesh aligned vertex buffer
+/// @param outStride      Size, in bytes, of one entry in the vertex buffer
+extern void (*skin_verts_bulk)
+                          (const TSSkinMesh::BatchData &batch,
+                           const MatrixF * __restrict const boneTransforms,
+                           U8 * __restrict const outPtr,
+                           const dsize_t outStride);
+
 #endif
 
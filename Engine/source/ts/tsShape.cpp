@@ -36,6 +36,8 @@
 #include "math/mathIO.h"
 #include "core/util/endian.h"
 #include "core/stream/fileStream.h"
+#include "core/stream/memStream.h"
+#include "platform/threads/mutex.h"
 #include "core/fileObject.h"
 
 #ifdef TORQUE_COLLADA
@@ -47,7 +49,7 @@ extern TSShape* assimpLoadShape(const Torque::Path &path);
 #endif
 
 /// most recent version -- this is the version we write
-S32 TSShape::smVersion = 28;
+S32 TSShape::smVersion = 29;
 /// the version currently being read...valid only during a read
 S32 TSShape::smReadVersion = -1;
 const U32 TSShape::smMostRecentExporterVersion = DTS_EXPORTER_CURRENT_VERSION;
@@ -64,6 +66,10 @@ S32 TSShape::smNumSkipLoadDetails = 0;
 
 bool TSShape::smInitOnRead = true;
 bool TSShape::smUseHardwareSkinning = true;
+
+/// Shapes whose vertex data points into a mapped file.
+static Vector<TSShape*> sMappedShapes;
+static Mutex sMappedShapesMutex;
 U32 TSShape::smMaxSkinBones = 70;
 
 
@@ -123,6 +129,13 @@ TSShape::TSShape()
 
 TSShape::~TSShape()
 {
+   if (mMappedFile != NULL)
+   {
+      MutexHandle handle;
+      handle.lock(&sMappedShapesMutex);
+      sMappedShapes.remove(this);
+   }
+
    delete materialList;
 
    S32 i;
@@ -1484,9 +1497,21 @@ void TSShape::assembleShape()
       AssertFatal(mVertexSize == mBasicVertexFormat.vertexSize, "vertex size mismatch");
 
       vboSize = tsalloc.get32();
+      if (TSShape::smReadVersion >= 29)
+      {
+         // Skip the padding that aligns the vertex data in the file
+         S32 pad = tsalloc.get32();
+         tsalloc.getPointer8(pad);
+      }
       vboData = tsalloc.getPointer8(vboSize);
 
-      if (tsalloc.getBuffer() && vboSize > 0)
+      if (tsalloc.getBuffer() && vboSize > 0 && mMappedFile != NULL && ((uintptr_t)vboData & 15) == 0)
+      {
+         // Use the vertex data where it lies in the mapped file
+         mShapeVertexData.set(vboData, vboSize, true, false);
+         mShapeVertexData.vertexDataReady = true;
+      }
+      else if (tsalloc.getBuffer() && vboSize > 0)
       {
          U8 *vertexData = (U8*)dMalloc_aligned(vboSize, 16);
          dMemcpy(vertexData, vboData, vboSize);
@@ -1683,6 +1708,9 @@ void TSShape::assembleShape()
    alphaOut.set(ptr32,numDetails);
 }
 
+/// Offset of the vertex data in the 8 bit buffer, set by disassembleShape()
+static S32 sVertexDataOffset8 = -1;
+
 void TSShape::disassembleShape()
 {
    S32 i;
@@ -1794,6 +1822,16 @@ void TSShape::disassembleShape()
       mBasicVertexFormat.writeAlloc(&tsalloc);
 
       tsalloc.set32(mShapeVertexData.size);
+      if (TSShape::smVersion >= 29)
+      {
+         // Start the vertex data on a dword so write() can put it on a
+         // 16 byte boundary in the file for mapped reads
+         S32 pad = (4 - (tsalloc.getBufferSize8() & 3)) & 3;
+         tsalloc.set32(pad);
+         for (S32 j = 0; j < pad; j++)
+            tsalloc.set8(0);
+         sVertexDataOffset8 = tsalloc.getBufferSize8();
+      }
       tsalloc.copyToBuffer8((S8*)mShapeVertexData.base, mShapeVertexData.size);
    }
 
@@ -1866,13 +1904,19 @@ bool TSShape::canWriteOldFormat() const
 
 void TSShape::write(Stream * s, bool saveOldFormat)
 {
+   // The stream may well be the file we were mapped from
+   releaseMappedFile();
+
    S32 currentVersion = smVersion;
    if (saveOldFormat)
       smVersion = 24;
 
+   U32 startPos = s->getPosition();
+
    // write version
    s->write(smVersion | (mExporterVersion<<16));
 
+   sVertexDataOffset8 = -1;
    tsalloc.setWrite();
    disassembleShape();
 
@@ -1892,10 +1936,22 @@ void TSShape::write(Stream * s, bool saveOldFormat)
       size8 += 4;
    size8 >>= 2;
 
+   // pad the end of the 16 bit buffer so the vertex data lands on a 16
+   // byte boundary in the file (the version and 3 sizes take 16 bytes)
+   S32 pad16 = 0;
+   if (sVertexDataOffset8 >= 0)
+   {
+      U32 vertexPos = startPos + 16 + (size32 + size16) * 4 + sVertexDataOffset8;
+      while (pad16 < 4 && ((vertexPos + pad16 * 4) & 15) != 0)
+         pad16++;
+      if (pad16 == 4)
+         pad16 = 0;
+   }
+
    S32 sizeMemBuffer, start16, start8;
-   sizeMemBuffer = size32 + size16 + size8;
+   sizeMemBuffer = size32 + size16 + pad16 + size8;
    start16 = size32;
-   start8 = start16+size16;
+   start8 = start16+size16+pad16;
 
    // in dwords -- write will properly endian-flip.
    s->write(sizeMemBuffer);
@@ -1908,6 +1964,8 @@ void TSShape::write(Stream * s, bool saveOldFormat)
    // now write buffers
    s->write(size32*4,buffer32);
    s->write(size16*4,buffer16);
+   for (S32 i=0; i<pad16; i++)
+      s->write(S32(0));
    s->write(size8 *4,buffer8);
 
    // write sequences - write will properly endian-flip.
@@ -1930,6 +1988,97 @@ void TSShape::write(Stream * s, bool saveOldFormat)
 //-------------------------------------------------
 
 bool TSShape::read(Stream * s)
+{
+   return _read(s, NULL);
+}
+
+bool TSShape::read(const Torque::FS::MappedFileRef &file)
+{
+   MemStream stream(file->getSize(), file->getData(), true, false);
+
+   mMappedFile = file;
+   bool ret = _read(&stream, file->getData());
+
+   // Only hold on to the mapping if the vertex data lives in it
+   if (!ret || mShapeVertexData.base == NULL || mShapeVertexData.ownsData)
+   {
+      mMappedFile = NULL;
+   }
+   else
+   {
+      MutexHandle handle;
+      handle.lock(&sMappedShapesMutex);
+      sMappedShapes.push_back(this);
+   }
+
+   return ret;
+}
+
+void TSShape::releaseMappedFile()
+{
+   if (mMappedFile == NULL)
+      return;
+
+   U8 *mapStart = mMappedFile->getData();
+   U8 *mapEnd = mapStart + mMappedFile->getSize();
+   U8 *oldBase = mShapeVertexData.base;
+
+   if (oldBase >= mapStart && oldBase < mapEnd)
+   {
+      U8 *vertexData = (U8*)dMalloc_aligned(mShapeVertexData.size, 16);
+      dMemcpy(vertexData, oldBase, mShapeVertexData.size);
+
+      // Point the meshes at the copy
+      for (S32 i = 0; i < meshes.size(); i++)
+      {
+         TSMesh *mesh = meshes[i];
+         if (!mesh)
+            continue;
+
+         U8 *ptr = (U8*)mesh->mVertexData.address();
+         if (ptr < oldBase || ptr >= oldBase + mShapeVertexData.size)
+            continue;
+
+         mesh->mVertexData.set(vertexData + (ptr - oldBase), mesh->mVertexData.vertSize(),
+            mesh->mVertexData.size(), mesh->mVertexData.getColorOffset(),
+            mesh->mVertexData.getBoneOffset(), false);
+      }
+
+      bool ready = mShapeVertexData.vertexDataReady;
+      mShapeVertexData.set(vertexData, mShapeVertexData.size);
+      mShapeVertexData.vertexDataReady = ready;
+   }
+
+   MutexHandle handle;
+   handle.lock(&sMappedShapesMutex);
+   sMappedShapes.remove(this);
+   mMappedFile = NULL;
+}
+
+void TSShape::releaseMappedFiles(const Torque::Path &path)
+{
+   Torque::FS::FileNodeRef node = Torque::FS::GetFileNode(path);
+   if (node == NULL)
+      return;
+
+   const Torque::Path name = node->getName();
+
+   Vector<TSShape*> shapes;
+   {
+      MutexHandle handle;
+      handle.lock(&sMappedShapesMutex);
+      for (S32 i = 0; i < sMappedShapes.size(); i++)
+      {
+         if (sMappedShapes[i]->mMappedFile->getPath() == name)
+            shapes.push_back(sMappedShapes[i]);
+      }
+   }
+
+   for (S32 i = 0; i < shapes.size(); i++)
+      shapes[i]->releaseMappedFile();
+}
+
+bool TSShape::_read(Stream * s, U8 *mappedData)
 {
    // read version - read handles endian-flip
    s->read(&smReadVersion);
@@ -1970,8 +2119,24 @@ bool TSShape::read(Stream * s)
          return false;
       }
 
-      S32 * tmp = new S32[sizeMemBuffer];
-      s->read(sizeof(S32)*sizeMemBuffer,(U8*)tmp);
+      S32 * tmp;
+      if (mappedData)
+      {
+         // use the buffers where they lie
+         U32 pos = s->getPosition();
+         if (sizeMemBuffer > (s->getStreamSize() - pos) / sizeof(S32))
+         {
+            Con::errorf(ConsoleLogEntry::General, "Error: bad shape file.");
+            return false;
+         }
+         tmp = (S32*)(mappedData + pos);
+         s->setPosition(pos + sizeof(S32)*sizeMemBuffer);
+      }
+      else
+      {
+         tmp = new S32[sizeMemBuffer];
+         s->read(sizeof(S32)*sizeMemBuffer,(U8*)tmp);
+      }
       memBuffer32 = tmp;
       memBuffer16 = (S16*)(tmp+startU16);
       memBuffer8  = (S8*)(tmp+startU8);
@@ -2011,7 +2176,8 @@ bool TSShape::read(Stream * s)
    assembleShape(); // copy to buffer
    AssertFatal(tsalloc.getSize()==mShapeDataSize,"TSShape::read: shape data buffer size mis-calculated");
 
-   delete [] memBuffer32;
+   if (!mappedData)
+      delete [] memBuffer32;
 
    if (smInitOnRead)
    {
@@ -2169,16 +2335,15 @@ template<> void *Resource<TSShape>::create(const Torque::Path &path)
 
    if ( extension.equal( "dts", String::NoCase ) )
    {
-      FileStream stream;
-      stream.open( path.getFullPath(), Torque::FS::File::Read );
-      if ( stream.getStatus() != Stream::Ok )
+      Torque::FS::MappedFileRef file = Torque::FS::MapFile( path );
+      if ( file == NULL )
       {
          Con::errorf( "Resource<TSShape>::create - Could not open '%s'", path.getFullPath().c_str() );
          return NULL;
       }
 
       ret = new TSShape;
-      readSuccess = ret->read(&stream);
+      readSuccess = ret->read(file);
    }
    else if ( extension.equal( "dae", String::NoCase ) || extension.equal( "kmz", String::NoCase ) )
    {
@@ -2191,15 +2356,14 @@ template<> void *Resource<TSShape>::create(const Torque::Path &path)
       Torque::Path cachedPath = path;
       cachedPath.setExtension("cached.dts");
        
-      FileStream stream;
-      stream.open( cachedPath.getFullPath(), Torque::FS::File::Read );
-      if ( stream.getStatus() != Stream::Ok )
+      Torque::FS::MappedFileRef file = Torque::FS::MapFile( cachedPath );
+      if ( file == NULL )
       {
          Con::errorf( "Resource<TSShape>::create - Could not open '%s'", cachedPath.getFullPath().c_str() );
          return NULL;
       }
       ret = new TSShape;
-      readSuccess = ret->read(&stream);
+      readSuccess = ret->read(file);
 #endif
    }
    else
@@ -35,6 +35,9 @@
 #ifndef _TSSHAPEALLOC_H_
 #include "ts/tsShapeAlloc.h"
 #endif
+#ifndef _VOLUME_H_
+#include "core/volume.h"
+#endif
 
 
 #define DTS_EXPORTER_CURRENT_VERSION 124
@@ -56,16 +59,18 @@ struct TSShapeVertexArray
    U8 *base;
    U32 size;
    bool vertexDataReady;
+   bool ownsData;
 
-   TSShapeVertexArray() : base(NULL), size(0), vertexDataReady(false) {}
+   TSShapeVertexArray() : base(NULL), size(0), vertexDataReady(false), ownsData(true) {}
    virtual ~TSShapeVertexArray() { set(NULL, 0); }
 
-   virtual void set(void *b, U32 s, bool autoFree = true)
+   virtual void set(void *b, U32 s, bool autoFree = true, bool nowOwnsData = true)
    {
-      if (base && autoFree)
+      if (base && autoFree && ownsData)
          dFree_aligned(base);
       base = reinterpret_cast<U8 *>(b);
       size = s;
+      ownsData = nowOwnsData;
    }
 };
 
@@ -407,6 +412,9 @@ class TSShape
    U32 mShapeDataSize;
 
 
+   /// The file this shape was read from if mShapeVertexData points into it.
+   Torque::FS::MappedFileRef mMappedFile;
+
    // Processed vertex data
    TSShapeVertexArray mShapeVertexData;
    TSVertexBufferHandle mShapeVertexBuffer;
@@ -606,6 +614,23 @@ class TSShape
    bool canWriteOldFormat() const;
    void write(Stream *, bool saveOldFormat=false);
    bool read(Stream *);
+
+   /// Reads the shape straight out of a mapped file. Vertex data from
+   /// version 29 and later shapes is used in place instead of copied.
+   bool read(const Torque::FS::MappedFileRef &file);
+
+   /// Moves vertex data that still lives in the mapped file into memory
+   /// owned by the shape and lets go of the mapping. Must be called before
+   /// the file the shape was read from is rewritten.
+   void releaseMappedFile();
+
+   /// Calls releaseMappedFile() on every shape mapped from the given file.
+   static void releaseMappedFiles(const Torque::Path &path);
+
+   /// Shared by both read() variants. If mappedData is set it is the
+   /// start of the data behind the stream, and the shape buffers are
+   /// used from it directly.
+   bool _read(Stream *s, U8 *mappedData);
    void readOldShape(Stream * s, S32 * &, S16 * &, S8 * &, S32 &, S32 &, S32 &);
    void writeName(Stream *, S32 nameIndex);
    S32  readName(Stream *, bool addName);
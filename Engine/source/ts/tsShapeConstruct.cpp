@@ -750,6 +750,9 @@ DefineTSShapeConstructorMethod(saveShape, void, (const char* filename), ,
    char filenameBuf[1024];
    Con::expandScriptFilename(filenameBuf, sizeof(filenameBuf), filename);
 
+   // Opening the file truncates it, so nothing may still be using its mapping
+   TSShape::releaseMappedFiles(filenameBuf);
+
    FileStream* dtsStream = new FileStream;
    if (dtsStream->open(filenameBuf, Torque::FS::File::Write))
    {
@@ -38,6 +38,8 @@
 #include "gfx/primBuilder.h"
 #include "gfx/gfxDrawUtil.h"
 #include "core/module.h"
+#include "platform/threads/thread.h"
+#include "platform/threads/jobSystem.h"
 
 MODULE_BEGIN( TSShapeInstance )
 
@@ -75,6 +77,20 @@ MODULE_BEGIN( TSShapeInstance )
          "@brief Enables mesh instancing on non-skin meshes that have less that this count of verts.\n"
          "The default value is 2000.  Higher values can degrade performance.\n"
          "@ingroup Rendering\n" );
+
+      Con::addVariable("$pref::TS::parallelSkinning", TypeBool, &TSShapeInstance::smParallelSkinning,
+         "@brief Enables skinning all visible software skinned shapes of a render pass "
+         "together on the thread pool.\n"
+         "Has no effect when hardware skinning is used.  The default value is true.\n"
+         "@see $pref::TS::parallelSkinningMinInstances\n"
+         "@ingroup Rendering\n" );
+
+      Con::addVariable("$pref::TS::parallelSkinningMinInstances", TypeS32, &TSShapeInstance::smParallelSkinningMinInstances,
+         "@brief Minimum number of software skinned shapes in a render pass before the "
+         "skinning is spread over the thread pool.\n"
+         "The default value is 4.\n"
+         "@see $pref::TS::parallelSkinning\n"
+         "@ingroup Rendering\n" );
    }
 
 MODULE_END;
@@ -88,6 +104,12 @@ F32                           TSShapeInstance::smLastScreenErrorTolerance = 0.0f
 F32                           TSShapeInstance::smLastScaledDistance = 0.0f;
 F32                           TSShapeInstance::smLastPixelSize = 0.0f;
 
+bool                          TSShapeInstance::smParallelSkinning = true;
+S32                           TSShapeInstance::smParallelSkinningMinInstances = 4;
+U32                           TSShapeInstance::smSkinningBatchDepth = 0;
+Vector<TSShapeInstance::SkinJob> TSShapeInstance::smSkinJobs(__FILE__, __LINE__);
+Vector<MatrixF>               TSShapeInstance::smBoneTransforms(__FILE__, __LINE__);
+
 Vector<QuatF>                 TSShapeInstance::smNodeCurrentRotations(__FILE__, __LINE__);
 Vector<Point3F>               TSShapeInstance::smNodeCurrentTranslations(__FILE__, __LINE__);
 Vector<F32>                   TSShapeInstance::smNodeCurrentUniformScales(__FILE__, __LINE__);
@@ -142,6 +164,10 @@ TSShapeInstance::TSShapeInstance( TSShape *shape, bool loadMaterials )
 
 TSShapeInstance::~TSShapeInstance()
 {
+   // Don't leave a dangling pointer in an open skinning batch.
+   if ( mSkinJobIndex >= 0 )
+      smSkinJobs[mSkinJobIndex].shapeInstance = NULL;
+
    mMeshObjects.clear();
 
    while (mThreadList.size())
@@ -172,6 +198,7 @@ void TSShapeInstance::buildInstanceData(TSShape * _shape, bool loadMaterials)
    mMaterialList = NULL;
    mOwnMaterialList = false;
    mUseOwnBuffer = false;
+   mSkinJobIndex = -1;
 
    //
    mData = 0;
@@ -550,20 +577,19 @@ void TSShapeInstance::render( const TSRenderState &rdata, S32 dl, F32 intraDL )
          mShape->getVertexBuffer(*realBuffer, GFXBufferTypeDynamic);
       }
 
-      if (bufferNeedsUpdate(od, start, end))
+      if (smSkinningBatchDepth > 0 && smParallelSkinning)
+      {
+         // Skinned with the rest of the batch before anything is drawn.
+         if (mSkinJobIndex >= 0 || bufferNeedsUpdate(od, start, end))
+            _queueSkinJob(od, start, end);
+      }
+      else if (bufferNeedsUpdate(od, start, end))
       {
          U8 *buffer = realBuffer->lock();
          if (!buffer)
             return;
 
-         // Base vertex data
-         dMemcpy(buffer, mShape->mShapeVertexData.base, mShape->mShapeVertexData.size);
-
-         // Apply skinned verts (where applicable)
-         for (i = start; i < end; i++)
-         {
-            mMeshObjects[i].updateVertexBuffer(od, buffer);
-         }
+         _skinVertexData(od, start, end, buffer, smBoneTransforms);
 
          realBuffer->unlock();
       }
@@ -579,6 +605,173 @@ void TSShapeInstance::render( const TSRenderState &rdata, S32 dl, F32 intraDL )
    }
 }
 
+void TSShapeInstance::_skinVertexData(S32 objectDetail, S32 start, S32 end, U8 *buffer, Vector<MatrixF> &boneTransforms)
+{
+   // Base vertex data
+   dMemcpy(buffer, mShape->mShapeVertexData.base, mShape->mShapeVertexData.size);
+
+   // Apply skinned verts (where applicable)
+   for (S32 i = start; i < end; i++)
+   {
+      mMeshObjects[i].updateVertexBuffer(objectDetail, buffer, boneTransforms);
+   }
+}
+
+void TSShapeInstance::_queueSkinJob(S32 objectDetail, S32 start, S32 end)
+{
+   // If we're already queued in this batch the last render wins, just
+   // like it would when skinning inline.
+   if (mSkinJobIndex < 0)
+   {
+      mSkinJobIndex = smSkinJobs.size();
+      smSkinJobs.increment();
+   }
+
+   SkinJob &job = smSkinJobs[mSkinJobIndex];
+   job.shapeInstance = this;
+   job.objectDetail = objectDetail;
+   job.start = start;
+   job.end = end;
+
+   // Mark the meshes as updated now, as updateVertexBuffer() would,
+   // so the mesh render doesn't treat the skin as dirty.
+   const U32 currTime = Sim::getCurrentTime();
+   for (S32 i = start; i < end; i++)
+   {
+      MeshObjectInstance &meshObj = mMeshObjects[i];
+      if (meshObj.forceHidden || meshObj.visible <= 0.01f)
+         continue;
+
+      TSMesh *mesh = meshObj.getMesh(objectDetail);
+      if (mesh && mesh->getMeshType() == TSMesh::SkinMeshType)
+         meshObj.mLastTime = currTime;
+   }
+}
+
+void TSShapeInstance::beginSkinningBatch()
+{
+   AssertFatal(ThreadManager::isMainThread(), "TSShapeInstance::beginSkinningBatch - Must be called from the main thread!");
+   smSkinningBatchDepth++;
+}
+
+void TSShapeInstance::endSkinningBatch()
+{
+   AssertFatal(smSkinningBatchDepth > 0, "TSShapeInstance::endSkinningBatch - Unbalanced skinning batch!");
+   smSkinningBatchDepth--;
+
+   // Flush on every end, not just the outermost, since a nested
+   // batch is about to draw what it queued.
+   if (!smSkinJobs.empty())
+      _flushSkinJobs();
+}
+
+/// A contiguous range of queued instances skinned by one job.
+/// Each range owns its skinning scratch.
+struct TSSkinJobRange
+{
+   U32 start;
+   U32 end;
+   Vector<MatrixF> boneTransforms;
+};
+
+void TSShapeInstance::_skinJobRange(void *data)
+{
+   TSSkinJobRange *range = (TSSkinJobRange *)data;
+   for (U32 i = range->start; i < range->end; i++)
+   {
+      const SkinJob &job = smSkinJobs[i];
+      TSShapeInstance *inst = job.shapeInstance;
+      if (!inst)
+         continue;
+
+      inst->_skinVertexData(job.objectDetail, job.start, job.end, inst->mSkinnedVertexData.address(), range->boneTransforms);
+   }
+}
+
+void TSShapeInstance::_flushSkinJobs()
+{
+   PROFILE_SCOPE(TSShapeInstance_FlushSkinJobs);
+
+   const U32 numJobs = smSkinJobs.size();
+
+   if ((S32)numJobs < smParallelSkinningMinInstances || !JobSystem::isGlobalRunning())
+   {
+      // Not worth the hand off, or nothing to hand it to, so
+      // skin straight into the vertex buffers.
+      for (U32 i = 0; i < numJobs; i++)
+      {
+         const SkinJob &job = smSkinJobs[i];
+         TSShapeInstance *inst = job.shapeInstance;
+         if (!inst)
+            continue;
+
+         inst->mSkinJobIndex = -1;
+
+         U8 *buffer = inst->mSoftwareVertexBuffer.lock();
+         if (!buffer)
+            continue;
+
+         inst->_skinVertexData(job.objectDetail, job.start, job.end, buffer, smBoneTransforms);
+         inst->mSoftwareVertexBuffer.unlock();
+      }
+
+      smSkinJobs.clear();
+      return;
+   }
+
+   for (U32 i = 0; i < numJobs; i++)
+   {
+      TSShapeInstance *inst = smSkinJobs[i].shapeInstance;
+      if (inst)
+         inst->mSkinnedVertexData.setSize(inst->mShape->mShapeVertexData.size);
+   }
+
+   // Split the batch into a few ranges per thread so uneven
+   // vertex counts still balance out.
+   JobSystem &jobs = JobSystem::GLOBAL();
+   const U32 numRanges = getMin(numJobs, (jobs.getNumThreads() + 1) * 4);
+   const U32 jobsPerRange = (numJobs + numRanges - 1) / numRanges;
+
+   // The ranges keep their scratch between frames.
+   static Vector<TSSkinJobRange> sRanges;
+   if (sRanges.size() < numRanges)
+      sRanges.setSize(numRanges);
+
+   PROFILE_START(TSShapeInstance_FlushSkinJobs_Skin);
+   JobSystem::JobRef group = jobs.createJob();
+   for (U32 i = 0, r = 0; i < numJobs; i += jobsPerRange, r++)
+   {
+      sRanges[r].start = i;
+      sRanges[r].end = getMin(i + jobsPerRange, numJobs);
+      jobs.run(jobs.createJob(&_skinJobRange, &sRanges[r], group));
+   }
+   jobs.run(group);
+   jobs.waitForJob(group);
+   PROFILE_END();
+
+   // Buffers can only be locked from the main thread, so upload
+   // the skinned copies here one at a time.
+   PROFILE_START(TSShapeInstance_FlushSkinJobs_Upload);
+   for (U32 i = 0; i < numJobs; i++)
+   {
+      TSShapeInstance *inst = smSkinJobs[i].shapeInstance;
+      if (!inst)
+         continue;
+
+      inst->mSkinJobIndex = -1;
+
+      U8 *buffer = inst->mSoftwareVertexBuffer.lock();
+      if (!buffer)
+         continue;
+
+      dMemcpy(buffer, inst->mSkinnedVertexData.address(), inst->mSkinnedVertexData.size());
+      inst->mSoftwareVertexBuffer.unlock();
+   }
+   PROFILE_END();
+
+   smSkinJobs.clear();
+}
+
 bool TSShapeInstance::bufferNeedsUpdate(S32 objectDetail, S32 start, S32 end)
 {
    // run through the meshes
@@ -769,7 +962,7 @@ void TSShapeInstance::ObjectInstance::render( S32, TSVertexBufferHandle &vb, TSM
    AssertFatal(0,"TSShapeInstance::ObjectInstance::render:  no default render method.");
 }
 
-void TSShapeInstance::ObjectInstance::updateVertexBuffer( S32 objectDetail, U8 *buffer )
+void TSShapeInstance::ObjectInstance::updateVertexBuffer( S32 objectDetail, U8 *buffer, Vector<MatrixF> &boneTransforms )
 {
    AssertFatal(0, "TSShapeInstance::ObjectInstance::updateVertexBuffer:  no default vertex buffer update method.");
 }
@@ -839,7 +1032,7 @@ void TSShapeInstance::MeshObjectInstance::render(  S32 objectDetail,
    GFX->popWorldMatrix();
 }
 
-void TSShapeInstance::MeshObjectInstance::updateVertexBuffer(S32 objectDetail, U8 *buffer)
+void TSShapeInstance::MeshObjectInstance::updateVertexBuffer(S32 objectDetail, U8 *buffer, Vector<MatrixF> &boneTransforms)
 {
    PROFILE_SCOPE(TSShapeInstance_MeshObjectInstance_updateVertexBuffer);
 
@@ -853,7 +1046,7 @@ void TSShapeInstance::MeshObjectInstance::updateVertexBuffer(S32 objectDetail, U
    // Update the buffer here
    if (mesh->getMeshType() == TSMesh::SkinMeshType)
    {
-      static_cast<TSSkinMesh*>(mesh)->updateSkinBuffer(*mTransforms, buffer);
+      static_cast<TSSkinMesh*>(mesh)->updateSkinBuffer(*mTransforms, buffer, boneTransforms);
    }
 
    mLastTime = Sim::getCurrentTime();
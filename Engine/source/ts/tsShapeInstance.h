@@ -134,7 +134,8 @@ class TSShapeInstance
       virtual void render( S32 objectDetail, TSVertexBufferHandle &vb, TSMaterialList *, TSRenderState &rdata, F32 alpha, const char *meshName );
 
      /// Updates the vertex buffer data for this mesh (used for software skinning)
-      virtual void updateVertexBuffer( S32 objectDetail, U8 *buffer );
+     /// @param boneTransforms  Scratch storage for the skinning matrices.
+      virtual void updateVertexBuffer( S32 objectDetail, U8 *buffer, Vector<MatrixF> &boneTransforms );
       virtual bool bufferNeedsUpdate( S32 objectDetail );
      /// @}
 
@@ -178,7 +179,7 @@ class TSShapeInstance
 
       void render( S32 objectDetail, TSVertexBufferHandle &vb, TSMaterialList *, TSRenderState &rdata, F32 alpha, const char *meshName );
 
-      void updateVertexBuffer( S32 objectDetail, U8 *buffer );
+      void updateVertexBuffer( S32 objectDetail, U8 *buffer, Vector<MatrixF> &boneTransforms );
 
       bool bufferNeedsUpdate(S32 objectDetail);
 
@@ -283,6 +284,13 @@ protected:
    /// Vertex buffer used for software skinning this instance
    TSVertexBufferHandle mSoftwareVertexBuffer;
 
+   /// CPU copy of the software skinned vertices, filled by the skinning
+   /// batch workers and uploaded to mSoftwareVertexBuffer afterwards.
+   Vector<U8> mSkinnedVertexData;
+
+   /// Index of this instance in the pending skinning batch or -1.
+   S32 mSkinJobIndex;
+
    bool            mOwnMaterialList; ///< Does this own the material list pointer?
    bool            mUseOwnBuffer; ///< Force using our own copy of the vertex buffer
 
@@ -477,6 +485,29 @@ protected:
    /// only way to get a visible detail)
    static S32 smNumSkipRenderDetails;
 
+   /// @name Parallel Software Skinning
+   /// While a skinning batch is open, software skinned instances are not
+   /// skinned as they render but queued and skinned together on the
+   /// thread pool when the batch ends.
+   /// @{
+
+   /// If false every instance is skinned inline as it renders.
+   static bool smParallelSkinning;
+
+   /// Batches with fewer queued instances than this are skinned
+   /// on the main thread.
+   static S32 smParallelSkinningMinInstances;
+
+   /// Opens a skinning batch.  Batches may be nested.
+   static void beginSkinningBatch();
+
+   /// Closes a skinning batch, skinning and uploading all queued
+   /// instances.  This must be called before any of the queued
+   /// instances are drawn.
+   static void endSkinningBatch();
+
+   /// @}
+
    /// For debugging / metrics.
    static F32 smLastScreenErrorTolerance;
    static F32 smLastScaledDistance;
@@ -506,6 +537,39 @@ protected:
 
    bool bufferNeedsUpdate(S32 objectDetail, S32 start, S32 end);
 
+   protected:
+
+   struct SkinJob
+   {
+      TSShapeInstance *shapeInstance;
+      S32 objectDetail;
+      S32 start;
+      S32 end;
+   };
+
+   /// Instances queued in the open skinning batch.
+   static Vector<SkinJob> smSkinJobs;
+
+   /// Nesting depth of beginSkinningBatch() calls.
+   static U32 smSkinningBatchDepth;
+
+   /// Skinning matrices scratch used on the main thread.
+   static Vector<MatrixF> smBoneTransforms;
+
+   /// Writes the base and skinned vertices of meshes [start,end) to buffer.
+   void _skinVertexData( S32 objectDetail, S32 start, S32 end, U8 *buffer, Vector<MatrixF> &boneTransforms );
+
+   /// Queues this instance into the open skinning batch.
+   void _queueSkinJob( S32 objectDetail, S32 start, S32 end );
+
+   /// Skins and uploads all queued instances.
+   static void _flushSkinJobs();
+
+   /// JobSystem entry point skinning a range of smSkinJobs.
+   static void _skinJobRange( void *data );
+
+   public:
+
    void animate() { animate( mCurrentDetailLevel ); }
    void animate(S32 dl);
    void animateNodes(S32 ss);